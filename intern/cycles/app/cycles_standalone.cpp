@@ -391,6 +391,8 @@ static void options_parse(int argc, const char **argv)
   ArgParse ap;
   bool help = false, debug = false, version = false;
   int verbosity = 1;
+  int checkpoint_interval = (int)options.session_params.checkpoint_interval;
+  bool resume = false;
 
   ap.options("Usage: cycles [options] file.xml",
              "%*",
@@ -431,6 +433,15 @@ static void options_parse(int argc, const char **argv)
              "--tile-height %d",
              &options.session_params.tile_size.y,
              "Tile height in pixels",
+             "--checkpoint %s",
+             &options.session_params.checkpoint_path,
+             "In background mode, file path to periodically save render progress to",
+             "--checkpoint-interval %d",
+             &checkpoint_interval,
+             "Seconds between saving checkpoints",
+             "--resume",
+             &resume,
+             "Continue rendering from the checkpoint file, if it exists",
              "--list-devices",
              &list,
              "List information about all available devices",
@@ -529,6 +540,23 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
+  else if (checkpoint_interval <= 0) {
+    fprintf(stderr, "Invalid checkpoint interval: %d\n", checkpoint_interval);
+    exit(EXIT_FAILURE);
+  }
+  else if (resume && options.session_params.checkpoint_path == "") {
+    fprintf(stderr, "No checkpoint file path specified to resume from\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Checkpoints store the full frame, which is only kept around in background mode. */
+  if (!options.session_params.background) {
+    options.session_params.checkpoint_path = "";
+  }
+  options.session_params.checkpoint_interval = checkpoint_interval;
+  options.session_params.checkpoint_scene_file = options.filepath;
+  options.session_params.checkpoint_resume = resume &&
+                                             path_exists(options.session_params.checkpoint_path);
 
   /* For smoother Viewport */
   options.session_params.start_resolution = 64;
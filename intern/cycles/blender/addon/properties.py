@@ -290,6 +290,50 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Light Tree\nPick lights based on their estimated contribution to the shaded point, "
+        "rather than their size, which reduces noise in scenes with many lights. "
+        "Not used when sampling all lights, CPU only",
+        default=False,
+    )
+    use_adaptive_sampling: BoolProperty(
+        name="Adaptive Sampling",
+        description="Adaptive Sampling\nStop sampling pixels once their noise is below the threshold, "
+        "spending the remaining samples on noisy parts of the image. Only used for final renders "
+        "without progressive refine",
+        default=False,
+    )
+    adaptive_threshold: FloatProperty(
+        name="Adaptive Sampling Threshold",
+        description="Adaptive Sampling Threshold\nNoise level below which pixels stop receiving samples, "
+        "lower values give less noise but take longer to render",
+        min=0.0001, max=1.0,
+        soft_min=0.001, soft_max=0.1,
+        default=0.01,
+        precision=4,
+    )
+    adaptive_min_samples: IntProperty(
+        name="Adaptive Min Samples",
+        description="Adaptive Min Samples\nMinimum number of samples every pixel receives before its noise "
+        "is tested, zero uses the square root of the number of samples",
+        min=0, max=4096,
+        default=0,
+    )
+    use_guiding: BoolProperty(
+        name="Path Guiding",
+        description="Path Guiding\nLearn where indirect light comes from while rendering, and send more "
+        "diffuse and glossy bounces in those directions. Helps interiors lit through small openings. "
+        "Only used by the CPU with the Path Tracing integrator",
+        default=False,
+    )
+    guiding_memory: IntProperty(
+        name="Path Guiding Memory",
+        description="Path Guiding Memory\nMemory in megabytes used to store the learned light, "
+        "more memory gives finer spatial detail",
+        min=1, max=4096,
+        default=64,
+    )
 
     caustics_reflective: BoolProperty(
         name="Reflective Caustics",
@@ -537,6 +581,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Use Hair BVH\nUse special type BVH optimized for hair (uses more ram but renders faster)",
         default=True,
     )
+    debug_use_compressed_bvh: BoolProperty(
+        name="Use Compressed BVH",
+        description="Use Compressed BVH\nStore BVH node bounds with reduced precision: less memory, slightly slower render",
+        default=False,
+    )
     debug_bvh_time_steps: IntProperty(
         name="BVH Time Steps",
         description="BVH Time Steps\nSplit BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -651,6 +700,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Texture Cache\nRead image textures on demand in tiles of the needed resolution, instead of loading full images into memory before rendering (CPU only)",
+        default=False,
+    )
+
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Texture Cache Size\nMaximum memory used by the texture cache in megabytes, least recently used tiles are freed when the limit is exceeded",
+        default=1024,
+        min=16, max=1048576,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
@@ -1196,6 +1258,12 @@ class CyclesRenderLayerSettings(bpy.types.PropertyGroup):
         default=False,
         update=update_render_passes,
     )
+    pass_debug_sample_count: BoolProperty(
+        name="Debug Sample Count",
+        description="Debug Sample Count\nNumber of samples each pixel received with adaptive sampling",
+        default=False,
+        update=update_render_passes,
+    )
     use_pass_volume_direct: BoolProperty(
         name="Volume Direct",
         description="Volume Direct\nDeliver direct volumetric scattering pass",
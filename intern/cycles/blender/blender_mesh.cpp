@@ -912,6 +912,36 @@ static void sync_mesh_fluid_motion(BL::Object &b_ob, Scene *scene, Mesh *mesh)
   }
 }
 
+/* Mesh conversion in progress, see BlenderSync::sync_mesh_task. */
+struct MeshSyncTask {
+  MeshSyncTask(Mesh *mesh, BL::Object &b_ob)
+      : mesh(mesh),
+        b_ob(b_ob),
+        b_mesh(PointerRNA_NULL),
+        sync_surface(false),
+        sync_hair(false),
+        frame(0)
+  {
+  }
+
+  Mesh *mesh;
+  BL::Object b_ob;
+  BL::Mesh b_mesh;
+  bool sync_surface;
+  bool sync_hair;
+  int frame;
+
+  /* Data of the previous sync, to detect if the BVH needs to be rebuilt. Compares curve_keys
+   * rather than strands in order to handle quick hair adjustments in dynamic BVH - other
+   * methods could probably do this better. */
+  array<float3> oldverts;
+  array<int> oldtriangles;
+  array<Mesh::SubdFace> oldsubd_faces;
+  array<int> oldsubd_face_corners;
+  array<float3> oldcurve_keys;
+  array<float> oldcurve_radius;
+};
+
 Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
                              BL::Object &b_ob,
                              BL::Object &b_ob_instance,
@@ -954,14 +984,12 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
     requested_geometry_flags |= Mesh::GEOMETRY_CURVES;
   }
   Mesh *mesh;
+  bool positions_only = false;
 
   if (!mesh_map.sync(&mesh, key)) {
-    /* if transform was applied to mesh, need full update */
-    if (object_updated && mesh->transform_applied)
-      ;
     /* test if shaders changed, these can be object level so mesh
      * does not get tagged for recalc */
-    else if (mesh->used_shaders != used_shaders)
+    if (mesh->used_shaders != used_shaders)
       ;
     else if (requested_geometry_flags != mesh->geometry_flags)
       ;
@@ -974,7 +1002,13 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
         if (shader->need_update_mesh)
           attribute_recalc = true;
 
-      if (!attribute_recalc)
+      if (attribute_recalc)
+        ;
+      /* if transform was applied to mesh, the object space positions need
+       * to be restored, the rest of the mesh data did not change */
+      else if (object_updated && mesh->transform_applied)
+        positions_only = true;
+      else
         return mesh;
     }
   }
@@ -987,20 +1021,19 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
 
   mesh_synced.insert(mesh);
 
+  if (positions_only && sync_mesh_positions(b_depsgraph, b_ob, mesh)) {
+    return mesh;
+  }
+
   /* create derived mesh */
-  array<int> oldtriangles;
-  array<Mesh::SubdFace> oldsubd_faces;
-  array<int> oldsubd_face_corners;
-  oldtriangles.steal_data(mesh->triangles);
-  oldsubd_faces.steal_data(mesh->subd_faces);
-  oldsubd_face_corners.steal_data(mesh->subd_face_corners);
+  MeshSyncTask *task = new MeshSyncTask(mesh, b_ob);
 
-  /* compares curve_keys rather than strands in order to handle quick hair
-   * adjustments in dynamic BVH - other methods could probably do this better*/
-  array<float3> oldcurve_keys;
-  array<float> oldcurve_radius;
-  oldcurve_keys.steal_data(mesh->curve_keys);
-  oldcurve_radius.steal_data(mesh->curve_radius);
+  task->oldverts.steal_data(mesh->verts);
+  task->oldtriangles.steal_data(mesh->triangles);
+  task->oldsubd_faces.steal_data(mesh->subd_faces);
+  task->oldsubd_face_corners.steal_data(mesh->subd_face_corners);
+  task->oldcurve_keys.steal_data(mesh->curve_keys);
+  task->oldcurve_radius.steal_data(mesh->curve_radius);
 
   mesh->clear();
   mesh->used_shaders = used_shaders;
@@ -1019,42 +1052,161 @@ Mesh *BlenderSync::sync_mesh(BL::Depsgraph &b_depsgraph,
     /* For some reason, meshes do not need this... */
     bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
 
-    BL::Mesh b_mesh = object_to_mesh(
+    /* A mesh converted by an earlier task for the same object data would be freed by
+     * converting it again, finish those first. */
+    void *b_ob_data_ptr = b_ob_data.ptr.data;
+    if (geometry_task_data.find(b_ob_data_ptr) != geometry_task_data.end()) {
+      wait_mesh_tasks();
+    }
+
+    task->b_mesh = object_to_mesh(
         b_data, b_ob, b_depsgraph, need_undeformed, mesh->subdivision_type);
 
-    if (b_mesh) {
-      /* Sync mesh itself. */
-      if (view_layer.use_surfaces && show_self) {
-        if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-          create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders, dicing_rate, max_subdivisions);
-        else
-          create_mesh(scene, mesh, b_mesh, used_shaders, false);
+    if (task->b_mesh) {
+      task->sync_surface = view_layer.use_surfaces && show_self;
+      task->sync_hair = view_layer.use_hair && show_particles &&
+                        mesh->subdivision_type == Mesh::SUBDIVISION_NONE;
+      task->frame = b_scene.frame_current();
+      geometry_task_data.insert(b_ob_data_ptr);
+    }
+  }
+  mesh->geometry_flags = requested_geometry_flags;
 
-        create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-      }
+  /* The mesh is always updated, the rest of the tagging is done once converted. */
+  mesh->tag_update_attributes(scene);
 
-      /* Sync hair curves. */
-      if (view_layer.use_hair && show_particles &&
-          mesh->subdivision_type == Mesh::SUBDIVISION_NONE) {
-        sync_curves(mesh, b_mesh, b_ob, false);
-      }
+  /* Instances are temporary copies of their object that only live during this iteration
+   * of the depsgraph, so they are converted right away. */
+  if (b_ob.ptr.data != b_ob_instance.ptr.data) {
+    sync_mesh_task(task);
+    sync_mesh_finish(task);
+  }
+  else {
+    geometry_pool.push(function_bind(&BlenderSync::sync_mesh_task, this, task));
+    geometry_tasks.push_back(task);
+  }
+
+  return mesh;
+}
 
-      free_object_to_mesh(b_data, b_ob, b_mesh);
+/* Conversion of the Blender mesh into Cycles mesh data, which only reads Blender data and
+ * writes into its own mesh, so it runs in a task pool for meshes of different objects. */
+void BlenderSync::sync_mesh_task(MeshSyncTask *task)
+{
+  Mesh *mesh = task->mesh;
+
+  if (!task->b_mesh || !task->sync_surface) {
+    return;
+  }
+
+  if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+    create_subd_mesh(scene,
+                     mesh,
+                     task->b_ob,
+                     task->b_mesh,
+                     mesh->used_shaders,
+                     dicing_rate,
+                     max_subdivisions);
+  else
+    create_mesh(scene, mesh, task->b_mesh, mesh->used_shaders, false);
+
+  create_mesh_volume_attributes(scene, task->b_ob, mesh, task->frame);
+}
+
+/* Sync what is left of a converted mesh, on the sync thread. Hair uses the particle
+ * system API which isn't thread safe, and the converted mesh is freed here. */
+void BlenderSync::sync_mesh_finish(MeshSyncTask *task)
+{
+  Mesh *mesh = task->mesh;
+
+  if (task->b_mesh) {
+    /* Sync hair curves. */
+    if (task->sync_hair) {
+      sync_curves(mesh, task->b_mesh, task->b_ob, false);
     }
+
+    free_object_to_mesh(b_data, task->b_ob, task->b_mesh);
   }
-  mesh->geometry_flags = requested_geometry_flags;
 
   /* fluid motion */
-  sync_mesh_fluid_motion(b_ob, scene, mesh);
+  sync_mesh_fluid_motion(task->b_ob, scene, mesh);
 
   /* tag update */
-  bool rebuild = (oldtriangles != mesh->triangles) || (oldsubd_faces != mesh->subd_faces) ||
-                 (oldsubd_face_corners != mesh->subd_face_corners) ||
-                 (oldcurve_keys != mesh->curve_keys) || (oldcurve_radius != mesh->curve_radius);
+  bool rebuild = (task->oldtriangles != mesh->triangles) ||
+                 (task->oldsubd_faces != mesh->subd_faces) ||
+                 (task->oldsubd_face_corners != mesh->subd_face_corners) ||
+                 (task->oldcurve_keys != mesh->curve_keys) ||
+                 (task->oldcurve_radius != mesh->curve_radius);
 
-  mesh->tag_update(scene, rebuild);
+  /* When only attributes like UV maps or vertex colors changed, the BVH can be kept. The
+   * control mesh of subdivision surfaces does not tell if the tessellation changed. */
+  if (rebuild || task->oldverts != mesh->verts ||
+      mesh->subdivision_type != Mesh::SUBDIVISION_NONE) {
+    mesh->tag_update(scene, rebuild);
+  }
 
-  return mesh;
+  delete task;
+}
+
+void BlenderSync::wait_mesh_tasks()
+{
+  geometry_pool.wait_work();
+
+  /* Finish meshes in the order they were synced, so the result doesn't depend on scheduling. */
+  foreach (MeshSyncTask *task, geometry_tasks) {
+    sync_mesh_finish(task);
+  }
+  geometry_tasks.clear();
+  geometry_task_data.clear();
+}
+
+/* Fast update for a mesh that had the object transform applied, when only the object
+ * transform changed. Reading back the vertex positions is enough, all other mesh data
+ * including normals is stored in object space. Returns false if a full sync is needed. */
+bool BlenderSync::sync_mesh_positions(BL::Depsgraph &b_depsgraph, BL::Object &b_ob, Mesh *mesh)
+{
+  /* Curves have the transform applied to their radius, subdivision, displacement and motion
+   * blur generate positions of their own. */
+  if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE || mesh->num_curves() ||
+      mesh->has_true_displacement() ||
+      mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION)) {
+    return false;
+  }
+  if (object_fluid_domain_find(b_ob)) {
+    return false;
+  }
+
+  BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_depsgraph, false, Mesh::SUBDIVISION_NONE);
+  if (!b_mesh) {
+    return false;
+  }
+
+  const bool synced = (b_mesh.vertices.length() == mesh->verts.size());
+  if (synced) {
+    BL::Mesh::vertices_iterator v;
+    size_t i = 0;
+    for (b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v) {
+      mesh->verts[i++] = get_float3(v->co());
+    }
+  }
+
+  free_object_to_mesh(b_data, b_ob, b_mesh);
+
+  if (!synced) {
+    return false;
+  }
+
+  mesh->transform_applied = false;
+  mesh->transform_negative_scaled = false;
+  mesh->transform_normal = transform_identity();
+
+  /* Derived from the positions, recomputed on device update. */
+  mesh->attributes.remove(ATTR_STD_FACE_NORMAL);
+  mesh->attributes.remove(ATTR_STD_POSITION_UNDISPLACED);
+
+  mesh->tag_update(scene, false);
+
+  return true;
 }
 
 void BlenderSync::sync_mesh_motion(BL::Depsgraph &b_depsgraph,
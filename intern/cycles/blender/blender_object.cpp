@@ -557,6 +557,9 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph, float motion_time)
     cancel = progress.get_cancel();
   }
 
+  /* Finish mesh data computed in parallel with the object loop. */
+  wait_mesh_tasks();
+
   progress.set_sync_status("");
 
   if (!cancel && !motion) {
@@ -29,6 +29,7 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -47,6 +48,7 @@ class ViewLayer;
 class Shader;
 class ShaderGraph;
 class ShaderNode;
+struct MeshSyncTask;
 
 class BlenderSync {
  public:
@@ -126,6 +128,10 @@ class BlenderSync {
                   bool object_updated,
                   bool show_self,
                   bool show_particles);
+  void sync_mesh_task(MeshSyncTask *task);
+  void sync_mesh_finish(MeshSyncTask *task);
+  void wait_mesh_tasks();
+  bool sync_mesh_positions(BL::Depsgraph &b_depsgraph, BL::Object &b_ob, Mesh *mesh);
   void sync_curves(
       Mesh *mesh, BL::Mesh &b_mesh, BL::Object &b_ob, bool motion, int motion_step = 0);
   Object *sync_object(BL::Depsgraph &b_depsgraph,
@@ -181,6 +187,9 @@ class BlenderSync {
   set<Mesh *> mesh_synced;
   set<Mesh *> mesh_motion_synced;
   set<float> motion_times;
+  TaskPool geometry_pool;
+  vector<MeshSyncTask *> geometry_tasks;
+  set<void *> geometry_task_data;
   void *world_map;
   bool world_recalc;
 
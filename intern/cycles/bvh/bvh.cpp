@@ -32,6 +32,7 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_map.h"
 #include "util/util_progress.h"
 
 CCL_NAMESPACE_BEGIN
@@ -274,35 +275,43 @@ void BVH::pack_triangle(int idx, float4 tri_verts[3])
 void BVH::pack_primitives()
 {
   const size_t tidx_size = pack.prim_index.size();
+  /* Assign vertex storage to triangle primitives. Spatial splits and time steps create multiple
+   * references to the same triangle, these share their vertices. */
+  const bool use_shared_triangles = params.use_spatial_split ||
+                                    params.num_motion_triangle_steps > 0;
+  unordered_map<uint64_t, uint> shared_triangles;
   size_t num_prim_triangles = 0;
-  /* Count number of triangles primitives in BVH. */
+  pack.prim_tri_index.clear();
+  pack.prim_tri_index.resize(tidx_size);
   for (unsigned int i = 0; i < tidx_size; i++) {
-    if ((pack.prim_index[i] != -1)) {
-      if ((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
-        ++num_prim_triangles;
+    if ((pack.prim_index[i] != -1) && (pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
+      if (use_shared_triangles) {
+        const uint64_t key = ((uint64_t)pack.prim_object[i] << 32) | (uint)pack.prim_index[i];
+        const auto shared = shared_triangles.insert(std::make_pair(key, 3 * num_prim_triangles));
+        if (!shared.second) {
+          pack.prim_tri_index[i] = shared.first->second;
+          continue;
+        }
       }
+      pack.prim_tri_index[i] = 3 * num_prim_triangles;
+      ++num_prim_triangles;
+    }
+    else {
+      pack.prim_tri_index[i] = -1;
     }
   }
   /* Reserve size for arrays. */
-  pack.prim_tri_index.clear();
-  pack.prim_tri_index.resize(tidx_size);
   pack.prim_tri_verts.clear();
   pack.prim_tri_verts.resize(num_prim_triangles * 3);
   pack.prim_visibility.clear();
   pack.prim_visibility.resize(tidx_size);
   /* Fill in all the arrays. */
-  size_t prim_triangle_index = 0;
   for (unsigned int i = 0; i < tidx_size; i++) {
     if (pack.prim_index[i] != -1) {
       int tob = pack.prim_object[i];
       Object *ob = objects[tob];
       if ((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
-        pack_triangle(i, (float4 *)&pack.prim_tri_verts[3 * prim_triangle_index]);
-        pack.prim_tri_index[i] = 3 * prim_triangle_index;
-        ++prim_triangle_index;
-      }
-      else {
-        pack.prim_tri_index[i] = -1;
+        pack_triangle(i, (float4 *)&pack.prim_tri_verts[pack.prim_tri_index[i]]);
       }
       pack.prim_visibility[i] = ob->visibility_for_tracing();
       if (pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
@@ -310,12 +319,58 @@ void BVH::pack_primitives()
       }
     }
     else {
-      pack.prim_tri_index[i] = -1;
       pack.prim_visibility[i] = 0;
     }
   }
 }
 
+/* Compressed Nodes */
+
+void BVH::quantize_child_bounds(const BoundBox *bounds,
+                                const int num,
+                                const int width,
+                                float3 *origin,
+                                float3 *scale,
+                                uchar *quantized)
+{
+  BoundBox node_bounds = BoundBox::empty;
+  for (int i = 0; i < num; i++) {
+    node_bounds.grow(bounds[i]);
+  }
+  if (!node_bounds.valid()) {
+    node_bounds = BoundBox(make_float3(0.0f, 0.0f, 0.0f));
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float node_min = node_bounds.min[axis];
+    const float node_max = node_bounds.max[axis];
+    /* Bounds are decoded as origin + quantized * scale in single precision, possibly with fused
+     * multiply-add. Pad by a few ulps of the largest magnitude involved, so rounding differences
+     * never make the decoded bounds smaller than the actual ones. */
+    const float margin = max(8.0f * FLT_EPSILON * max(fabsf(node_min), fabsf(node_max)), 1e-30f);
+    const float axis_origin = node_min - 2.0f * margin;
+    const float axis_scale = (float)(((double)node_max + 2.0 * margin - axis_origin) / 255.0 *
+                                     (1.0 + 2.0 * FLT_EPSILON));
+
+    for (int i = 0; i < width; i++) {
+      int quantized_min = 255, quantized_max = 0;
+      if (i < num) {
+        const double child_min = (double)bounds[i].min[axis] - margin;
+        const double child_max = (double)bounds[i].max[axis] + margin;
+        quantized_min = (int)floor((child_min - axis_origin) / axis_scale);
+        quantized_max = (int)ceil((child_max - axis_origin) / axis_scale);
+        quantized_min = clamp(quantized_min, 0, 255);
+        quantized_max = clamp(quantized_max, 0, 255);
+      }
+      quantized[(axis * 2 + 0) * width + i] = (uchar)quantized_min;
+      quantized[(axis * 2 + 1) * width + i] = (uchar)quantized_max;
+    }
+
+    (*origin)[axis] = axis_origin;
+    (*scale)[axis] = axis_scale;
+  }
+}
+
 /* Pack Instances */
 
 void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
@@ -508,6 +563,10 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
             nsize_bbox = (use_qbvh) ? BVH_UNALIGNED_QNODE_SIZE - 1 : 0;
           }
         }
+        else if ((use_obvh || use_qbvh) && (bvh_nodes[i].w & BVH_NODE_COMPRESSED)) {
+          nsize = (use_obvh) ? BVH_COMPRESSED_ONODE_SIZE : BVH_COMPRESSED_QNODE_SIZE;
+          nsize_bbox = nsize - 1;
+        }
         else {
           if (use_obvh) {
             nsize = BVH_ONODE_SIZE;
@@ -104,6 +104,16 @@ class BVH {
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
 
+  /* Quantize child bounds of a compressed node to 8 bits relative to their union.
+   * Quantized bounds are stored per plane (min x, max x, min y, max y, min z, max z),
+   * with one byte for each of the width children. Children past num get empty bounds. */
+  static void quantize_child_bounds(const BoundBox *bounds,
+                                    const int num,
+                                    const int width,
+                                    float3 *origin,
+                                    float3 *scale,
+                                    uchar *quantized);
+
   /* for subclasses to implement */
   virtual void pack_nodes(const BVHNode *root) = 0;
   virtual void refit_nodes() = 0;
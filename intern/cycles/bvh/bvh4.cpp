@@ -154,8 +154,14 @@ void BVH4::pack_aligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, i
     bounds[i] = en[i].node->bounds;
     child[i] = en[i].encodeIdx();
   }
-  pack_aligned_node(
-      e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  if (params.use_compressed_nodes) {
+    pack_compressed_node(
+        e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  }
+  else {
+    pack_aligned_node(
+        e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  }
 }
 
 void BVH4::pack_aligned_node(int idx,
@@ -206,6 +212,40 @@ void BVH4::pack_aligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_QNODE_SIZE);
 }
 
+void BVH4::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+  float4 data[BVH_COMPRESSED_QNODE_SIZE];
+  memset(data, 0, sizeof(data));
+
+  data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+  data[0].y = time_from;
+  data[0].z = time_to;
+  data[0].w = __uint_as_float(BVH_NODE_COMPRESSED);
+
+  /* Child bounds relative to the node bounds, one 32 bit word with four
+   * children for each plane. Unused children get empty bounds.
+   */
+  float3 origin, scale;
+  uchar quantized[6 * 4];
+  quantize_child_bounds(bounds, num, 4, &origin, &scale, quantized);
+
+  data[1] = float3_to_float4(origin);
+  data[2] = float3_to_float4(scale);
+  memcpy(&data[3], quantized, sizeof(quantized));
+
+  for (int i = 0; i < num; i++) {
+    data[5][i] = __int_as_float(child[i]);
+  }
+
+  memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_COMPRESSED_QNODE_SIZE);
+}
+
 void BVH4::pack_unaligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num)
 {
   Transform aligned_space[4];
@@ -300,14 +340,16 @@ void BVH4::pack_nodes(const BVHNode *root)
   const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
   assert(num_leaf_nodes <= num_nodes);
   const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+  const size_t aligned_node_size = (params.use_compressed_nodes) ? BVH_COMPRESSED_QNODE_SIZE :
+                                                                   BVH_QNODE_SIZE;
   size_t node_size;
   if (params.use_unaligned_nodes) {
     const size_t num_unaligned_nodes = root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
     node_size = (num_unaligned_nodes * BVH_UNALIGNED_QNODE_SIZE) +
-                (num_inner_nodes - num_unaligned_nodes) * BVH_QNODE_SIZE;
+                (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
   }
   else {
-    node_size = num_inner_nodes * BVH_QNODE_SIZE;
+    node_size = num_inner_nodes * aligned_node_size;
   }
   /* Resize arrays. */
   pack.nodes.clear();
@@ -330,7 +372,7 @@ void BVH4::pack_nodes(const BVHNode *root)
   }
   else {
     stack.push_back(BVHStackEntry(root, nextNodeIdx));
-    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_QNODE_SIZE : BVH_QNODE_SIZE;
+    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_QNODE_SIZE : aligned_node_size;
   }
 
   while (stack.size()) {
@@ -357,7 +399,8 @@ void BVH4::pack_nodes(const BVHNode *root)
         }
         else {
           idx = nextNodeIdx;
-          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_QNODE_SIZE : BVH_QNODE_SIZE;
+          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_QNODE_SIZE :
+                                                        aligned_node_size;
         }
         stack.push_back(BVHStackEntry(children[i], idx));
       }
@@ -409,10 +452,14 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
   else {
     int4 *data = &pack.nodes[idx];
     bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+    bool is_compressed = (data[0].w & BVH_NODE_COMPRESSED) != 0;
     int4 c;
     if (is_unaligned) {
       c = data[13];
     }
+    else if (is_compressed) {
+      c = data[5];
+    }
     else {
       c = data[7];
     }
@@ -436,6 +483,9 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
       pack_unaligned_node(
           idx, aligned_space, child_bbox, &c[0], visibility, 0.0f, 1.0f, num_nodes);
     }
+    else if (is_compressed) {
+      pack_compressed_node(idx, child_bbox, &c[0], visibility, 0.0f, 1.0f, num_nodes);
+    }
     else {
       pack_aligned_node(idx, child_bbox, &c[0], visibility, 0.0f, 1.0f, num_nodes);
     }
@@ -184,8 +184,14 @@ void BVH8::pack_aligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, i
     bounds[i] = en[i].node->bounds;
     child[i] = en[i].encodeIdx();
   }
-  pack_aligned_node(
-      e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  if (params.use_compressed_nodes) {
+    pack_compressed_node(
+        e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  }
+  else {
+    pack_aligned_node(
+        e.idx, bounds, child, e.node->visibility, e.node->time_from, e.node->time_to, num);
+  }
 }
 
 void BVH8::pack_aligned_node(int idx,
@@ -236,6 +242,44 @@ void BVH8::pack_aligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_ONODE_SIZE);
 }
 
+void BVH8::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+  float8 data[BVH_COMPRESSED_ONODE_SIZE / 2];
+  memset(data, 0, sizeof(data));
+
+  /* Child bounds relative to the node bounds, two 32 bit words with eight
+   * children for each plane. Unused children get empty bounds.
+   */
+  float3 origin, scale;
+  uchar quantized[6 * 8];
+  quantize_child_bounds(bounds, num, 8, &origin, &scale, quantized);
+
+  data[0].a = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+  data[0].b = time_from;
+  data[0].c = time_to;
+  data[0].d = __uint_as_float(BVH_NODE_COMPRESSED);
+  data[0].e = origin.x;
+  data[0].f = origin.y;
+  data[0].g = origin.z;
+
+  memcpy(&data[1], quantized, sizeof(quantized));
+  data[2].e = scale.x;
+  data[2].f = scale.y;
+  data[2].g = scale.z;
+
+  for (int i = 0; i < num; i++) {
+    data[3][i] = __int_as_float(child[i]);
+  }
+
+  memcpy(&pack.nodes[idx], data, sizeof(float4) * BVH_COMPRESSED_ONODE_SIZE);
+}
+
 void BVH8::pack_unaligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num)
 {
   Transform aligned_space[8];
@@ -330,14 +374,16 @@ void BVH8::pack_nodes(const BVHNode *root)
   const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
   assert(num_leaf_nodes <= num_nodes);
   const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+  const size_t aligned_node_size = (params.use_compressed_nodes) ? BVH_COMPRESSED_ONODE_SIZE :
+                                                                   BVH_ONODE_SIZE;
   size_t node_size;
   if (params.use_unaligned_nodes) {
     const size_t num_unaligned_nodes = root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
     node_size = (num_unaligned_nodes * BVH_UNALIGNED_ONODE_SIZE) +
-                (num_inner_nodes - num_unaligned_nodes) * BVH_ONODE_SIZE;
+                (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
   }
   else {
-    node_size = num_inner_nodes * BVH_ONODE_SIZE;
+    node_size = num_inner_nodes * aligned_node_size;
   }
   /* Resize arrays. */
   pack.nodes.clear();
@@ -360,7 +406,7 @@ void BVH8::pack_nodes(const BVHNode *root)
   }
   else {
     stack.push_back(BVHStackEntry(root, nextNodeIdx));
-    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : BVH_ONODE_SIZE;
+    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : aligned_node_size;
   }
 
   while (stack.size()) {
@@ -386,7 +432,8 @@ void BVH8::pack_nodes(const BVHNode *root)
         }
         else {
           idx = nextNodeIdx;
-          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE : BVH_ONODE_SIZE;
+          nextNodeIdx += children[i]->has_unaligned() ? BVH_UNALIGNED_ONODE_SIZE :
+                                                        aligned_node_size;
         }
         stack.push_back(BVHStackEntry(children[i], idx));
       }
@@ -491,6 +538,7 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
   else {
     float8 *data = (float8 *)&pack.nodes[idx];
     bool is_unaligned = (__float_as_uint(data[0].a) & PATH_RAY_NODE_UNALIGNED) != 0;
+    bool is_compressed = (__float_as_uint(data[0].d) & BVH_NODE_COMPRESSED) != 0;
     /* Refit inner node, set bbox from children. */
     BoundBox child_bbox[8] = {BoundBox::empty,
                               BoundBox::empty,
@@ -505,7 +553,7 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     int num_nodes = 0;
 
     for (int i = 0; i < 8; ++i) {
-      child[i] = __float_as_int(data[(is_unaligned) ? 13 : 7][i]);
+      child[i] = __float_as_int(data[(is_unaligned) ? 13 : (is_compressed) ? 3 : 7][i]);
 
       if (child[i] != 0) {
         refit_node((child[i] < 0) ? -child[i] - 1 : child[i],
@@ -530,6 +578,9 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
       pack_unaligned_node(
           idx, aligned_space, child_bbox, child, visibility, 0.0f, 1.0f, num_nodes);
     }
+    else if (is_compressed) {
+      pack_compressed_node(idx, child_bbox, child, visibility, 0.0f, 1.0f, num_nodes);
+    }
     else {
       pack_aligned_node(idx, child_bbox, child, visibility, 0.0f, 1.0f, num_nodes);
     }
@@ -48,6 +48,7 @@ class Progress;
 #define BVH_ONODE_SIZE 16
 #define BVH_ONODE_LEAF_SIZE 1
 #define BVH_UNALIGNED_ONODE_SIZE 28
+#define BVH_COMPRESSED_ONODE_SIZE 8
 
 /* BVH8
  *
@@ -77,6 +78,14 @@ class BVH8 : public BVH {
                          const float time_to,
                          const int num);
 
+  void pack_compressed_node(int idx,
+                            const BoundBox *bounds,
+                            const int *child,
+                            const uint visibility,
+                            const float time_from,
+                            const float time_to,
+                            const int num);
+
   void pack_unaligned_inner(const BVHStackEntry &e, const BVHStackEntry *en, int num);
   void pack_unaligned_node(int idx,
                            const Transform *aligned_space,
@@ -77,6 +77,12 @@ class BVHParams {
    */
   bool use_unaligned_nodes;
 
+  /* Store child bounds of aligned inner nodes quantized relative to the
+   * parent node, to reduce memory usage of the tree.
+   * Only used for BVH4 and BVH8 layouts.
+   */
+  bool use_compressed_nodes;
+
   /* Split time range to this number of steps and create leaf node for each
    * of this time steps.
    *
@@ -119,6 +125,7 @@ class BVHParams {
     top_level = false;
     bvh_layout = BVH_LAYOUT_BVH2;
     use_unaligned_nodes = false;
+    use_compressed_nodes = false;
 
     primitive_mask = PRIMITIVE_ALL;
 
@@ -356,6 +356,18 @@ class Device {
     return NULL;
   }
 
+  /* images read on demand through the texture cache, only for CPU device */
+  virtual void *texture_cache_memory()
+  {
+    return NULL;
+  }
+
+  /* incident radiance learned for path guiding, only for CPU device */
+  virtual void *path_guiding_memory()
+  {
+    return NULL;
+  }
+
   /* load/compile kernels, must be called before adding tasks */
   virtual bool load_kernels(const DeviceRequestedFeatures & /*requested_features*/)
   {
@@ -34,6 +34,8 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernels/cpu/kernel_cpu_path_guiding.h"
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
 
 #include "kernel/filter/filter.h"
 
@@ -168,11 +170,22 @@ class CPUDevice : public Device {
   OSLGlobals osl_globals;
 #endif
 
+  TextureCacheGlobals texture_cache_globals;
+  PathGuidingGlobals path_guiding_globals;
+
   bool use_split_kernel;
 
   DeviceRequestedFeatures requested_features;
 
   KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int)> path_trace_kernel;
+  KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int)>
+      adaptive_stopping_kernel;
+  KernelFunctions<bool (*)(KernelGlobals *, float *, int, int, int, int, int)>
+      adaptive_filter_x_kernel;
+  KernelFunctions<bool (*)(KernelGlobals *, float *, int, int, int, int, int)>
+      adaptive_filter_y_kernel;
+  KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int)>
+      adaptive_adjust_samples_kernel;
   KernelFunctions<void (*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>
       convert_to_half_float_kernel;
   KernelFunctions<void (*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>
@@ -258,6 +271,10 @@ class CPUDevice : public Device {
         texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name##_kernel(KERNEL_FUNCTIONS(name))
         REGISTER_KERNEL(path_trace),
+        REGISTER_KERNEL(adaptive_stopping),
+        REGISTER_KERNEL(adaptive_filter_x),
+        REGISTER_KERNEL(adaptive_filter_y),
+        REGISTER_KERNEL(adaptive_adjust_samples),
         REGISTER_KERNEL(convert_to_half_float),
         REGISTER_KERNEL(convert_to_byte),
         REGISTER_KERNEL(shader),
@@ -284,6 +301,8 @@ class CPUDevice : public Device {
 #ifdef WITH_OSL
     kernel_globals.osl = &osl_globals;
 #endif
+    kernel_globals.texture_cache = &texture_cache_globals;
+    kernel_globals.path_guiding = &path_guiding_globals;
     use_split_kernel = DebugFlags().cpu.split_kernel;
     if (use_split_kernel) {
       VLOG(1) << "Will be using split kernel.";
@@ -500,6 +519,16 @@ class CPUDevice : public Device {
 #endif
   }
 
+  void *texture_cache_memory()
+  {
+    return &texture_cache_globals;
+  }
+
+  void *path_guiding_memory()
+  {
+    return &path_guiding_globals;
+  }
+
   void thread_run(DeviceTask *task)
   {
     if (task->type == DeviceTask::RENDER) {
@@ -813,9 +842,51 @@ class CPUDevice : public Device {
     return true;
   }
 
+  /* Flag converged pixels of the tile, returns false once all pixels have converged. */
+  bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile, int num_samples)
+  {
+    float *render_buffer = (float *)tile.buffer;
+
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        adaptive_stopping_kernel()(
+            kg, render_buffer, num_samples, x, y, tile.offset, tile.stride);
+      }
+    }
+
+    bool any = false;
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      any |= adaptive_filter_x_kernel()(
+          kg, render_buffer, y, tile.x, tile.w, tile.offset, tile.stride);
+    }
+    for (int x = tile.x; x < tile.x + tile.w; x++) {
+      any |= adaptive_filter_y_kernel()(
+          kg, render_buffer, x, tile.y, tile.h, tile.offset, tile.stride);
+    }
+
+    return any;
+  }
+
+  /* Scale pixels which stopped early to the number of samples of the tile. */
+  void adaptive_sampling_post_adjust(KernelGlobals *kg, RenderTile &tile, int num_samples)
+  {
+    float *render_buffer = (float *)tile.buffer;
+
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        adaptive_adjust_samples_kernel()(
+            kg, render_buffer, num_samples, x, y, tile.offset, tile.stride);
+      }
+    }
+  }
+
   void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
   {
     const bool use_coverage = kernel_data.film.cryptomatte_passes & CRYPT_ACCURATE;
+    /* Progressive refine renders tiles in several passes, which the scaling of converged
+     * pixels does not support, so all pixels get the full number of samples there. */
+    const bool use_adaptive_sampling = kernel_data.film.pass_adaptive_aux_buffer &&
+                                       !task.need_finish_queue;
 
     scoped_timer timer(&tile.buffers->render_time);
 
@@ -848,11 +919,26 @@ class CPUDevice : public Device {
 
       tile.sample = sample + 1;
 
+      /* The buffers only hold the samples rendered since the start sample of the tile. */
+      const int num_samples = tile.sample - start_sample;
+      if (use_adaptive_sampling && num_samples >= kernel_data.integrator.adaptive_min_samples &&
+          (num_samples % kernel_data.integrator.adaptive_step) == 0) {
+        if (!adaptive_sampling_filter(kg, tile, num_samples)) {
+          /* All pixels converged, count the skipped samples so progress stays consistent. */
+          tile.sample = end_sample;
+          task.update_progress(&tile, tile.w * tile.h * (end_sample - sample));
+          break;
+        }
+      }
+
       task.update_progress(&tile, tile.w * tile.h);
     }
     if (use_coverage) {
       coverage.finalize();
     }
+    if (use_adaptive_sampling) {
+      adaptive_sampling_post_adjust(kg, tile, tile.sample - start_sample);
+    }
   }
 
   void denoise(DenoisingTask &denoising, RenderTile &tile)
@@ -1192,11 +1278,26 @@ int2 CPUSplitKernel::split_kernel_local_size()
   return make_int2(1, 1);
 }
 
-int2 CPUSplitKernel::split_kernel_global_size(device_memory & /*kg*/,
-                                              device_memory & /*data*/,
+int2 CPUSplitKernel::split_kernel_global_size(device_memory &kg,
+                                              device_memory &data,
                                               DeviceTask * /*task*/)
 {
-  return make_int2(1, 1);
+  /* Keep a batch of paths in flight per thread, so every kernel stage runs over many rays
+   * and shader evaluation gets rays sorted by shader. The split state is allocated for each
+   * render thread, so the batch is kept small: the state of one path is about 6.5KB with 4
+   * closures and 18KB with 64. A 32x32 batch fills half of a SHADER_SORT_BLOCK_SIZE block,
+   * which is all a single sort pass can group, for 7-9MB per thread in typical scenes.
+   * Larger batches don't sort better and only stream more memory through the caches. */
+  const uint64_t max_buffer_size = 16 * 1024 * 1024;
+  const size_t max_elements = max_elements_for_max_buffer_size(kg, data, max_buffer_size);
+
+  int size = 32;
+  while (size > 1 && (size_t)(size * size) > max_elements) {
+    size >>= 1;
+  }
+
+  VLOG(1) << "Global size: (" << size << ", " << size << ").";
+  return make_int2(size, size);
 }
 
 uint64_t CPUSplitKernel::state_buffer_size(device_memory &kernel_globals,
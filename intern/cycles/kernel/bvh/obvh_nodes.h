@@ -230,6 +230,64 @@ ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict s1,
   }
 }
 
+/* Compressed axis-aligned nodes intersection */
+
+#ifdef __KERNEL_AVX2__
+ccl_device_inline avxf obvh_compressed_node_plane(KernelGlobals *ccl_restrict kg,
+                                                  const int node_addr,
+                                                  const int plane)
+{
+  const int axis = plane >> 1;
+  const float origin = kernel_tex_fetch(__bvh_nodes, node_addr + 1)[axis];
+  const float scale = kernel_tex_fetch(__bvh_nodes, node_addr + 5)[axis];
+  /* Expand 8 bit bounds of the eight children to 32 bit integers. */
+  const ssei quantized = kernel_tex_fetch_ssei(__bvh_nodes, node_addr + 2 + (plane >> 1));
+  const __m128i bounds = (plane & 1) ? _mm_unpackhi_epi64(quantized, quantized) :
+                                       quantized.m128;
+  return avxf(origin) + avxf(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bounds))) * avxf(scale);
+}
+#endif
+
+ccl_device_inline int obvh_compressed_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                     const avxf &isect_near,
+                                                     const avxf &isect_far,
+#ifdef __KERNEL_AVX2__
+                                                     const avx3f &org_idir,
+#else
+                                                     const avx3f &org,
+#endif
+                                                     const avx3f &idir,
+                                                     const int near_x,
+                                                     const int near_y,
+                                                     const int near_z,
+                                                     const int far_x,
+                                                     const int far_y,
+                                                     const int far_z,
+                                                     const int node_addr,
+                                                     avxf *ccl_restrict dist)
+{
+#ifdef __KERNEL_AVX2__
+  const avxf tnear_x = msub(
+      obvh_compressed_node_plane(kg, node_addr, near_x), idir.x, org_idir.x);
+  const avxf tnear_y = msub(
+      obvh_compressed_node_plane(kg, node_addr, near_y), idir.y, org_idir.y);
+  const avxf tnear_z = msub(
+      obvh_compressed_node_plane(kg, node_addr, near_z), idir.z, org_idir.z);
+  const avxf tfar_x = msub(obvh_compressed_node_plane(kg, node_addr, far_x), idir.x, org_idir.x);
+  const avxf tfar_y = msub(obvh_compressed_node_plane(kg, node_addr, far_y), idir.y, org_idir.y);
+  const avxf tfar_z = msub(obvh_compressed_node_plane(kg, node_addr, far_z), idir.z, org_idir.z);
+
+  const avxf tnear = max4(tnear_x, tnear_y, tnear_z, isect_near);
+  const avxf tfar = min4(tfar_x, tfar_y, tfar_z, isect_far);
+  const avxb vmask = tnear <= tfar;
+  int mask = (int)movemask(vmask);
+  *dist = tnear;
+  return mask;
+#else
+  return 0;
+#endif
+}
+
 /* Axis-aligned nodes intersection */
 
 ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -250,6 +308,27 @@ ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg
                                                   const int node_addr,
                                                   avxf *ccl_restrict dist)
 {
+  const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+  if (__float_as_uint(node.w) & BVH_NODE_COMPRESSED) {
+    return obvh_compressed_node_intersect(kg,
+                                          isect_near,
+                                          isect_far,
+#ifdef __KERNEL_AVX2__
+                                          org_idir,
+#else
+                                          org,
+#endif
+                                          idir,
+                                          near_x,
+                                          near_y,
+                                          near_z,
+                                          far_x,
+                                          far_y,
+                                          far_z,
+                                          node_addr,
+                                          dist);
+  }
+
   const int offset = node_addr + 2;
 #ifdef __KERNEL_AVX2__
   const avxf tnear_x = msub(
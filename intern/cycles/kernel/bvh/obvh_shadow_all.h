@@ -136,13 +136,15 @@ ccl_device bool BVH_FUNCTION_FULL_NAME(OBVH)(KernelGlobals *kg,
 
         if (child_mask != 0) {
           avxf cnodes;
+          if (__float_as_uint(inodes.w) & BVH_NODE_COMPRESSED) {
+            cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr + 6);
+          }
 #if BVH_FEATURE(BVH_HAIR)
-          if (__float_as_uint(inodes.x) & PATH_RAY_NODE_UNALIGNED) {
+          else if (__float_as_uint(inodes.x) & PATH_RAY_NODE_UNALIGNED) {
             cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr + 26);
           }
-          else
 #endif
-          {
+          else {
             cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr + 14);
           }
 
@@ -125,6 +125,76 @@ ccl_device_inline void qbvh_stack_sort(QBVHStackItem *ccl_restrict s1,
   }
 }
 
+/* Compressed axis-aligned nodes intersection */
+
+ccl_device_inline ssef qbvh_compressed_node_plane(KernelGlobals *ccl_restrict kg,
+                                                  const int node_addr,
+                                                  const int plane)
+{
+  const int axis = plane >> 1;
+  const float origin = kernel_tex_fetch(__bvh_nodes, node_addr + 1)[axis];
+  const float scale = kernel_tex_fetch(__bvh_nodes, node_addr + 2)[axis];
+  const float4 quantized = kernel_tex_fetch(__bvh_nodes, node_addr + 3 + (plane >> 2));
+  /* Expand 8 bit bounds of the four children to 32 bit integers. */
+  const __m128i zero = _mm_setzero_si128();
+  __m128i bounds = _mm_cvtsi32_si128(__float_as_int(quantized[plane & 3]));
+  bounds = _mm_unpacklo_epi8(bounds, zero);
+  bounds = _mm_unpacklo_epi16(bounds, zero);
+  return ssef(origin) + ssef(bounds) * ssef(scale);
+}
+
+ccl_device_inline int qbvh_compressed_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                     const ssef &isect_near,
+                                                     const ssef &isect_far,
+#ifdef __KERNEL_AVX2__
+                                                     const sse3f &org_idir,
+#else
+                                                     const sse3f &org,
+#endif
+                                                     const sse3f &idir,
+                                                     const int near_x,
+                                                     const int near_y,
+                                                     const int near_z,
+                                                     const int far_x,
+                                                     const int far_y,
+                                                     const int far_z,
+                                                     const int node_addr,
+                                                     ssef *ccl_restrict dist)
+{
+#ifdef __KERNEL_AVX2__
+  const ssef tnear_x = msub(
+      qbvh_compressed_node_plane(kg, node_addr, near_x), idir.x, org_idir.x);
+  const ssef tnear_y = msub(
+      qbvh_compressed_node_plane(kg, node_addr, near_y), idir.y, org_idir.y);
+  const ssef tnear_z = msub(
+      qbvh_compressed_node_plane(kg, node_addr, near_z), idir.z, org_idir.z);
+  const ssef tfar_x = msub(qbvh_compressed_node_plane(kg, node_addr, far_x), idir.x, org_idir.x);
+  const ssef tfar_y = msub(qbvh_compressed_node_plane(kg, node_addr, far_y), idir.y, org_idir.y);
+  const ssef tfar_z = msub(qbvh_compressed_node_plane(kg, node_addr, far_z), idir.z, org_idir.z);
+#else
+  const ssef tnear_x = (qbvh_compressed_node_plane(kg, node_addr, near_x) - org.x) * idir.x;
+  const ssef tnear_y = (qbvh_compressed_node_plane(kg, node_addr, near_y) - org.y) * idir.y;
+  const ssef tnear_z = (qbvh_compressed_node_plane(kg, node_addr, near_z) - org.z) * idir.z;
+  const ssef tfar_x = (qbvh_compressed_node_plane(kg, node_addr, far_x) - org.x) * idir.x;
+  const ssef tfar_y = (qbvh_compressed_node_plane(kg, node_addr, far_y) - org.y) * idir.y;
+  const ssef tfar_z = (qbvh_compressed_node_plane(kg, node_addr, far_z) - org.z) * idir.z;
+#endif
+
+#ifdef __KERNEL_SSE41__
+  const ssef tnear = maxi(maxi(tnear_x, tnear_y), maxi(tnear_z, isect_near));
+  const ssef tfar = mini(mini(tfar_x, tfar_y), mini(tfar_z, isect_far));
+  const sseb vmask = cast(tnear) > cast(tfar);
+  int mask = (int)movemask(vmask) ^ 0xf;
+#else
+  const ssef tnear = max4(isect_near, tnear_x, tnear_y, tnear_z);
+  const ssef tfar = min4(isect_far, tfar_x, tfar_y, tfar_z);
+  const sseb vmask = tnear <= tfar;
+  int mask = (int)movemask(vmask);
+#endif
+  *dist = tnear;
+  return mask;
+}
+
 /* Axis-aligned nodes intersection */
 
 // ccl_device_inline int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -146,6 +216,27 @@ static int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
                                        const int node_addr,
                                        ssef *ccl_restrict dist)
 {
+  const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+  if (__float_as_uint(node.w) & BVH_NODE_COMPRESSED) {
+    return qbvh_compressed_node_intersect(kg,
+                                          isect_near,
+                                          isect_far,
+#ifdef __KERNEL_AVX2__
+                                          org_idir,
+#else
+                                          org,
+#endif
+                                          idir,
+                                          near_x,
+                                          near_y,
+                                          near_z,
+                                          far_x,
+                                          far_y,
+                                          far_z,
+                                          node_addr,
+                                          dist);
+  }
+
   const int offset = node_addr + 1;
 #ifdef __KERNEL_AVX2__
   const ssef tnear_x = msub(
@@ -54,7 +54,8 @@ ccl_device_inline AttributeDescriptor attribute_not_found()
 
 ccl_device_inline uint object_attribute_map_offset(KernelGlobals *kg, int object)
 {
-  return kernel_tex_fetch(__objects, object).attribute_map_offset;
+  const int mesh = kernel_tex_fetch(__objects, object).mesh;
+  return kernel_tex_fetch(__object_meshes, mesh).attribute_map_offset;
 }
 
 ccl_device_inline AttributeDescriptor find_attribute(KernelGlobals *kg,
@@ -65,8 +65,19 @@ ccl_device_inline Transform object_fetch_motion_pass_transform(KernelGlobals *kg
                                                                int object,
                                                                enum ObjectVectorTransform type)
 {
-  int offset = object * OBJECT_MOTION_PASS_SIZE + (int)type;
-  return kernel_tex_fetch(__object_motion_pass, offset);
+  /* Transforms are only stored for objects with motion, for others the motion is the
+   * same as the object transform, applied in object or world space. */
+  int object_flag = kernel_tex_fetch(__object_flag, object);
+  if (object_flag & SD_OBJECT_MOTION_PASS) {
+    int offset = kernel_tex_fetch(__objects, object).motion_offset + (int)type;
+    return kernel_tex_fetch(__object_motion_pass, offset);
+  }
+  else if (object_flag & SD_OBJECT_HAS_VERTEX_MOTION) {
+    return object_fetch_transform(kg, object, OBJECT_TRANSFORM);
+  }
+  else {
+    return transform_identity();
+  }
 }
 
 /* Motion blurred object transformations */
@@ -295,14 +306,16 @@ ccl_device_inline float3 object_dupli_uv(KernelGlobals *kg, int object)
 ccl_device_inline void object_motion_info(
     KernelGlobals *kg, int object, int *numsteps, int *numverts, int *numkeys)
 {
+  const int mesh = kernel_tex_fetch(__objects, object).mesh;
+
   if (numkeys) {
-    *numkeys = kernel_tex_fetch(__objects, object).numkeys;
+    *numkeys = kernel_tex_fetch(__object_meshes, mesh).numkeys;
   }
 
   if (numsteps)
     *numsteps = kernel_tex_fetch(__objects, object).numsteps;
   if (numverts)
-    *numverts = kernel_tex_fetch(__objects, object).numverts;
+    *numverts = kernel_tex_fetch(__object_meshes, mesh).numverts;
 }
 
 /* Offset to an objects patch map */
@@ -312,7 +325,8 @@ ccl_device_inline uint object_patch_map_offset(KernelGlobals *kg, int object)
   if (object == OBJECT_NONE)
     return 0;
 
-  return kernel_tex_fetch(__objects, object).patch_map_offset;
+  const int mesh = kernel_tex_fetch(__objects, object).mesh;
+  return kernel_tex_fetch(__object_meshes, mesh).patch_map_offset;
 }
 
 /* Pass ID for shader */
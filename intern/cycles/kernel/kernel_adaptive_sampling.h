@@ -0,0 +1,205 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_ADAPTIVE_SAMPLING_H__
+#define __KERNEL_ADAPTIVE_SAMPLING_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Besides the combined pass, every second sample of a pixel is accumulated into the auxiliary
+ * buffer. The
+ * difference between the two estimates gives a per pixel error, as in section 2.1 of
+ * "A Hierarchical Automatic Stopping Condition for Monte Carlo Global Illumination",
+ * Dammertz et al. 2009. Converged pixels are flagged in the fourth component of the
+ * auxiliary buffer and are skipped by the path tracing kernels. */
+
+ccl_device_inline bool kernel_adaptive_pixel_converged(KernelGlobals *kg,
+                                                       ccl_global float *buffer)
+{
+  if (kernel_data.film.pass_adaptive_aux_buffer == 0) {
+    return false;
+  }
+  return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f;
+}
+
+/* Flag the pixel as converged when its error estimate drops below the noise threshold. Pixels
+ * un-flagged by the filter resume at a later sample than others, so the estimates use the
+ * sample count of the pixel itself rather than that of the tile. */
+ccl_device void kernel_do_adaptive_stopping(KernelGlobals *kg, ccl_global float *buffer)
+{
+  ccl_global float4 *aux = (ccl_global float4 *)(buffer +
+                                                  kernel_data.film.pass_adaptive_aux_buffer);
+  if (aux->w != 0.0f) {
+    return;
+  }
+
+  /* The auxiliary buffer holds every second sample of the pixel. */
+  const int num_samples = (int)buffer[kernel_data.film.pass_sample_count];
+  const int num_aux_samples = num_samples / 2;
+  if (num_aux_samples == 0) {
+    return;
+  }
+
+  const float3 I = make_float3(buffer[0], buffer[1], buffer[2]) / (float)num_samples;
+  const float3 A = make_float3(aux->x, aux->y, aux->z) / (float)num_aux_samples;
+
+  /* Small epsilon avoids division by zero for black pixels, which converge immediately. */
+  const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+                      sqrtf(max(I.x + I.y + I.z, 0.0f) + 1e-4f);
+
+  if (error < kernel_data.integrator.adaptive_threshold) {
+    aux->w = 1.0f;
+  }
+}
+
+/* Un-flag converged pixels next to pixels which still need samples, so the sampling density
+ * changes gradually and noise does not end in hard edges. Runs over one row or column of the
+ * tile given the buffer of its first pixel and the stride between pixels, returns true if any
+ * of the pixels still needs samples. */
+ccl_device bool kernel_do_adaptive_filter(KernelGlobals *kg,
+                                          ccl_global float *buffer,
+                                          int num_pixels,
+                                          int pixel_stride)
+{
+  const int pass_stride = kernel_data.film.pass_stride;
+  const int offset = kernel_data.film.pass_adaptive_aux_buffer + 3;
+
+  bool any = false;
+  bool prev = false;
+
+  for (int i = 0; i < num_pixels; i++) {
+    ccl_global float *flag = buffer + i * pixel_stride * pass_stride + offset;
+
+    if (*flag == 0.0f) {
+      any = true;
+      if (i > 0 && !prev) {
+        *(flag - pixel_stride * pass_stride) = 0.0f;
+      }
+      prev = true;
+    }
+    else {
+      if (prev) {
+        *flag = 0.0f;
+      }
+      prev = false;
+    }
+  }
+
+  return any;
+}
+
+/* Scale the passes of a pixel which stopped early, so it matches pixels which received all
+ * num_samples samples. Passes only written on the first sample are left untouched. */
+ccl_device void kernel_adaptive_post_adjust(KernelGlobals *kg,
+                                            ccl_global float *buffer,
+                                            int num_samples)
+{
+  const float pixel_samples = buffer[kernel_data.film.pass_sample_count];
+  if (pixel_samples <= 0.0f || pixel_samples >= num_samples) {
+    return;
+  }
+
+  const float scale = num_samples / pixel_samples;
+
+  *(ccl_global float4 *)buffer *= scale;
+
+  ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+  aux[0] *= scale;
+  aux[1] *= scale;
+  aux[2] *= scale;
+
+#ifdef __PASSES__
+  const int flag = kernel_data.film.pass_flag;
+  const int light_flag = kernel_data.film.light_pass_flag;
+
+  if (flag & PASSMASK(NORMAL)) {
+    *(ccl_global float3 *)(buffer + kernel_data.film.pass_normal) *= scale;
+  }
+  if (flag & PASSMASK(UV)) {
+    *(ccl_global float3 *)(buffer + kernel_data.film.pass_uv) *= scale;
+  }
+  if (flag & PASSMASK(MOTION)) {
+    *(ccl_global float4 *)(buffer + kernel_data.film.pass_motion) *= scale;
+    buffer[kernel_data.film.pass_motion_weight] *= scale;
+  }
+
+  if (kernel_data.film.use_light_pass) {
+#  define SCALE_LIGHT_PASS(type, offset) \
+    if (light_flag & PASSMASK(type)) { \
+      *(ccl_global float3 *)(buffer + kernel_data.film.offset) *= scale; \
+    }
+    SCALE_LIGHT_PASS(DIFFUSE_INDIRECT, pass_diffuse_indirect);
+    SCALE_LIGHT_PASS(GLOSSY_INDIRECT, pass_glossy_indirect);
+    SCALE_LIGHT_PASS(TRANSMISSION_INDIRECT, pass_transmission_indirect);
+    SCALE_LIGHT_PASS(SUBSURFACE_INDIRECT, pass_subsurface_indirect);
+    SCALE_LIGHT_PASS(VOLUME_INDIRECT, pass_volume_indirect);
+    SCALE_LIGHT_PASS(DIFFUSE_DIRECT, pass_diffuse_direct);
+    SCALE_LIGHT_PASS(GLOSSY_DIRECT, pass_glossy_direct);
+    SCALE_LIGHT_PASS(TRANSMISSION_DIRECT, pass_transmission_direct);
+    SCALE_LIGHT_PASS(SUBSURFACE_DIRECT, pass_subsurface_direct);
+    SCALE_LIGHT_PASS(VOLUME_DIRECT, pass_volume_direct);
+    SCALE_LIGHT_PASS(EMISSION, pass_emission);
+    SCALE_LIGHT_PASS(BACKGROUND, pass_background);
+    SCALE_LIGHT_PASS(AO, pass_ao);
+    SCALE_LIGHT_PASS(DIFFUSE_COLOR, pass_diffuse_color);
+    SCALE_LIGHT_PASS(GLOSSY_COLOR, pass_glossy_color);
+    SCALE_LIGHT_PASS(TRANSMISSION_COLOR, pass_transmission_color);
+    SCALE_LIGHT_PASS(SUBSURFACE_COLOR, pass_subsurface_color);
+#  undef SCALE_LIGHT_PASS
+
+    if (light_flag & PASSMASK(SHADOW)) {
+      *(ccl_global float4 *)(buffer + kernel_data.film.pass_shadow) *= scale;
+    }
+    if (light_flag & PASSMASK(MIST)) {
+      buffer[kernel_data.film.pass_mist] *= scale;
+    }
+  }
+
+  if (kernel_data.film.cryptomatte_passes) {
+    /* Only scale the weights of the ID/weight pairs. */
+    const int num_types = ((kernel_data.film.cryptomatte_passes & CRYPT_OBJECT) ? 1 : 0) +
+                          ((kernel_data.film.cryptomatte_passes & CRYPT_MATERIAL) ? 1 : 0) +
+                          ((kernel_data.film.cryptomatte_passes & CRYPT_ASSET) ? 1 : 0);
+    const int num_slots = num_types * kernel_data.film.cryptomatte_depth * 2;
+    ccl_global float *cryptomatte_buffer = buffer + kernel_data.film.pass_cryptomatte;
+    for (int i = 0; i < num_slots; i++) {
+      cryptomatte_buffer[i * 2 + 1] *= scale;
+    }
+  }
+#endif /* __PASSES__ */
+
+#ifdef __DENOISING_FEATURES__
+  /* All denoising features are sums of samples or of their squares. */
+  if (kernel_data.film.pass_denoising_data) {
+    ccl_global float *denoising_buffer = buffer + kernel_data.film.pass_denoising_data;
+    for (int i = 0; i < DENOISING_PASS_SIZE_BASE; i++) {
+      denoising_buffer[i] *= scale;
+    }
+    if (kernel_data.film.pass_denoising_clean) {
+      ccl_global float *clean_buffer = buffer + kernel_data.film.pass_denoising_clean;
+      for (int i = 0; i < DENOISING_PASS_SIZE_CLEAN; i++) {
+        clean_buffer[i] *= scale;
+      }
+    }
+  }
+#endif /* __DENOISING_FEATURES__ */
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_ADAPTIVE_SAMPLING_H__ */
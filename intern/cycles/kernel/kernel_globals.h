@@ -45,6 +45,9 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #  endif
 
+struct TextureCacheGlobals;
+struct PathGuidingGlobals;
+
 typedef unordered_map<float, float> CoverageMap;
 
 struct Intersection;
@@ -64,6 +67,12 @@ typedef struct KernelGlobals {
   OSLThreadData *osl_tdata;
 #  endif
 
+  /* Images read on demand through the texture cache, shared by all threads. */
+  TextureCacheGlobals *texture_cache;
+
+  /* Incident radiance learned for path guiding, shared by all threads. */
+  PathGuidingGlobals *path_guiding;
+
   /* **** Run-time data ****  */
 
   /* Heap-allocated storage for transparent shadows intersections. */
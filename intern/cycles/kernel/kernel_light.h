@@ -178,6 +178,183 @@ ccl_device float lamp_light_pdf(KernelGlobals *kg, const float3 Ng, const float3
   return t * t / cos_pi;
 }
 
+/* Light Tree
+ *
+ * Picks lights and emissive triangles proportional to an estimate of their contribution to
+ * the shading point, based on the bounds, orientation and energy stored in the tree nodes.
+ * Distant and background lights have no position and are picked uniformly with a fixed
+ * probability instead. */
+
+#ifdef __LIGHT_TREE__
+ccl_device float light_tree_node_importance(KernelGlobals *kg, float3 P, int node)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+
+  if (knode->energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float3 bbox_min = make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]);
+  const float3 bbox_max = make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]);
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float radius_squared = 0.25f * len_squared(bbox_max - bbox_min);
+
+  /* Clamp the distance to the size of the node, to avoid huge importance for nearby nodes. */
+  const float3 centroid_to_P = P - centroid;
+  const float distance_squared = max(len_squared(centroid_to_P), radius_squared);
+
+  const bool inside = (P.x >= bbox_min.x && P.y >= bbox_min.y && P.z >= bbox_min.z &&
+                       P.x <= bbox_max.x && P.y <= bbox_max.y && P.z <= bbox_max.z);
+  float cos_theta_prime = 1.0f;
+
+  if (!inside && knode->theta_o < M_PI_F) {
+    /* Smallest angle between the emitter normals and the direction to the shading point. */
+    const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+    const float3 D = centroid_to_P * (1.0f / sqrtf(distance_squared));
+    const float theta = fast_acosf(clamp(dot(axis, D), -1.0f, 1.0f));
+    const float theta_u = fast_asinf(min(sqrtf(radius_squared / distance_squared), 1.0f));
+    const float theta_prime = max(theta - knode->theta_o - theta_u, 0.0f);
+
+    if (theta_prime >= knode->theta_e) {
+      return 0.0f;
+    }
+    cos_theta_prime = fast_cosf(theta_prime);
+  }
+
+  return knode->energy * cos_theta_prime / distance_squared;
+}
+
+/* Returns the light distribution index of the picked emitter, or -1 if no emitter can
+ * contribute to the shading point. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu)
+{
+  float r = *randu;
+
+  const int num_distant = kernel_data.integrator.light_tree_num_distant;
+  if (num_distant) {
+    const float distant_pdf = num_distant * kernel_data.integrator.light_tree_distant_pdf;
+    if (r < distant_pdf || kernel_data.integrator.light_tree_num_nodes == 0) {
+      r *= num_distant / distant_pdf;
+      const int distant = min((int)r, num_distant - 1);
+      *randu = min(r - distant, 1.0f - FLT_EPSILON);
+      const int node = kernel_data.integrator.light_tree_num_nodes + distant;
+      return ~kernel_tex_fetch(__light_tree_nodes, node).child;
+    }
+    r = (r - distant_pdf) / (1.0f - distant_pdf);
+  }
+
+  int node = 0;
+  int child = kernel_tex_fetch(__light_tree_nodes, node).child;
+
+  while (child >= 0) {
+    const float importance_left = light_tree_node_importance(kg, P, node + 1);
+    const float importance_right = light_tree_node_importance(kg, P, child);
+    const float importance_total = importance_left + importance_right;
+
+    if (importance_total == 0.0f) {
+      return -1;
+    }
+
+    /* Rescale to reuse the random number at the next level. */
+    const float probability_left = importance_left / importance_total;
+    if (r < probability_left) {
+      r = r / probability_left;
+      node = node + 1;
+    }
+    else {
+      r = (r - probability_left) / (1.0f - probability_left);
+      node = child;
+    }
+    r = min(r, 1.0f - FLT_EPSILON);
+
+    child = kernel_tex_fetch(__light_tree_nodes, node).child;
+  }
+
+  *randu = r;
+  return ~child;
+}
+
+/* Probability of light_tree_sample picking the emitter at the given distribution index. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int distribution_index)
+{
+  const uint emitter_node = kernel_tex_fetch(__light_tree_emitter_node, distribution_index);
+
+  if (emitter_node == LIGHT_TREE_NONE) {
+    return 0.0f;
+  }
+
+  const int num_nodes = kernel_data.integrator.light_tree_num_nodes;
+  const float distant_pdf = kernel_data.integrator.light_tree_distant_pdf;
+
+  if (emitter_node >= (uint)num_nodes) {
+    return distant_pdf;
+  }
+
+  float pdf = 1.0f - kernel_data.integrator.light_tree_num_distant * distant_pdf;
+  int node = (int)emitter_node;
+
+  while (node != 0) {
+    const int parent = kernel_tex_fetch(__light_tree_nodes, node).parent;
+    const int left = parent + 1;
+    const int right = kernel_tex_fetch(__light_tree_nodes, parent).child;
+    const float importance_left = light_tree_node_importance(kg, P, left);
+    const float importance_right = light_tree_node_importance(kg, P, right);
+    const float importance_total = importance_left + importance_right;
+
+    if (importance_total == 0.0f) {
+      return 0.0f;
+    }
+
+    pdf *= ((node == left) ? importance_left : importance_right) / importance_total;
+    node = parent;
+  }
+
+  return pdf;
+}
+#endif
+
+/* Probability of picking the lamp when sampling one light at random from P. */
+ccl_device_inline float lamp_light_select_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    /* Lamps follow the triangles in the light distribution. */
+    const int num_triangles = kernel_data.integrator.num_distribution -
+                              kernel_data.integrator.num_all_lights;
+    return light_tree_pdf(kg, P, num_triangles + lamp);
+  }
+#endif
+  return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of picking the background light, which does not depend on the position. */
+ccl_device_inline float background_light_select_pdf(KernelGlobals *kg)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    return kernel_data.integrator.light_tree_distant_pdf;
+  }
+#endif
+  return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of picking the triangle when sampling one light at random from P, area is the
+ * area of the triangle the light distribution was built with. */
+ccl_device_inline float triangle_light_select_pdf(
+    KernelGlobals *kg, int object, int prim, float3 P, float area)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    const uint offset = kernel_tex_fetch(__light_tree_object_offset, object);
+    if (offset == LIGHT_TREE_NONE) {
+      return 0.0f;
+    }
+    return light_tree_pdf(kg, P, offset + kernel_tex_fetch(__light_tree_tri_rank, prim));
+  }
+#endif
+  return area * kernel_data.integrator.pdf_triangles;
+}
+
 /* Background Light */
 
 #ifdef __BACKGROUND_MIS__
@@ -527,7 +704,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
        * If map sampling is possible, it would be used instead,
        * otherwise fallback sampling is used. */
       if (portal_sampling_pdf == 1.0f) {
-        return kernel_data.integrator.pdf_lights / M_4PI_F;
+        return background_light_select_pdf(kg) / M_4PI_F;
       }
       else {
         /* Force map sampling. */
@@ -539,7 +716,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
     /* Evaluate PDF of sampling this direction by map sampling. */
     map_pdf = background_map_pdf(kg, direction) * (1.0f - portal_sampling_pdf);
   }
-  return (portal_pdf + map_pdf) * kernel_data.integrator.pdf_lights;
+  return (portal_pdf + map_pdf) * background_light_select_pdf(kg);
 }
 #endif
 
@@ -661,7 +838,7 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_select_pdf(kg, lamp, P);
 
   return (ls->pdf > 0.0f);
 }
@@ -799,7 +976,7 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= lamp_light_select_pdf(kg, lamp, P);
 
   return true;
 }
@@ -838,12 +1015,12 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
-                                                const float3 Ng,
+/* Converts a pdf over the triangle area to a pdf over solid angle. */
+ccl_device_inline float triangle_light_pdf_area(const float3 Ng,
                                                 const float3 I,
-                                                float t)
+                                                float t,
+                                                float pdf)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -868,10 +1045,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float3 N = cross(e0, e1);
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
 
+  /* sd contains the point on the light source
+   * calculate Px, the point that we're shading */
+  const float3 Px = sd->P + sd->I * t;
+
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
-    /* sd contains the point on the light source
-     * calculate Px, the point that we're shading */
-    const float3 Px = sd->P + sd->I * t;
     const float3 v0_p = V[0] - Px;
     const float3 v1_p = V[1] - Px;
     const float3 v2_p = V[2] - Px;
@@ -899,25 +1077,25 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       else {
         area = 0.5f * len(N);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = triangle_light_select_pdf(kg, sd->object, sd->prim, Px, area);
       return pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+    const float area = 0.5f * len(N);
+    if (UNLIKELY(area == 0.0f)) {
+      return 0.0f;
+    }
+    /* scale the PDF.
+     * area = the area the sample was taken from
+     * area_pre = the are from which the light distribution was calculated from */
+    float area_pre = area;
     if (has_motion) {
-      const float area = 0.5f * len(N);
-      if (UNLIKELY(area == 0.0f)) {
-        return 0.0f;
-      }
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
       triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      pdf = pdf * area_pre / area;
+      area_pre = triangle_area(V[0], V[1], V[2]);
     }
-    return pdf;
+    const float pdf = triangle_light_select_pdf(kg, sd->object, sd->prim, Px, area_pre) / area;
+    return triangle_light_pdf_area(sd->Ng, sd->I, t, pdf);
   }
 }
 
@@ -1052,7 +1230,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
         triangle_world_space_vertices(kg, object, prim, -1.0f, V);
         area = triangle_area(V[0], V[1], V[2]);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = triangle_light_select_pdf(kg, object, prim, P, area);
       ls->pdf = pdf / solid_angle;
     }
   }
@@ -1066,15 +1244,20 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-    if (has_motion && area != 0.0f) {
-      /* scale the PDF.
-       * area = the area the sample was taken from
-       * area_pre = the are from which pdf_triangles was calculated from */
+    if (UNLIKELY(area == 0.0f)) {
+      ls->pdf = 0.0f;
+      return;
+    }
+    /* scale the PDF.
+     * area = the area the sample was taken from
+     * area_pre = the are from which the light distribution was calculated from */
+    float area_pre = area;
+    if (has_motion) {
       triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
-      ls->pdf = ls->pdf * area_pre / area;
+      area_pre = triangle_area(V[0], V[1], V[2]);
     }
+    const float pdf = triangle_light_select_pdf(kg, object, prim, P, area_pre) / area;
+    ls->pdf = triangle_light_pdf_area(ls->Ng, -ls->D, ls->t, pdf);
     ls->u = u;
     ls->v = v;
   }
@@ -1129,7 +1312,19 @@ ccl_device_noinline bool light_sample(
     KernelGlobals *kg, float randu, float randv, float time, float3 P, int bounce, LightSample *ls)
 {
   /* sample index */
-  int index = light_distribution_sample(kg, &randu);
+  int index;
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    index = light_tree_sample(kg, P, &randu);
+    if (index < 0) {
+      return false;
+    }
+  }
+  else
+#endif
+  {
+    index = light_distribution_sample(kg, &randu);
+  }
 
   /* fetch light data */
   const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution,
@@ -405,6 +405,18 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 
   kernel_write_pass_float4(buffer, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
+  if (kernel_data.film.pass_adaptive_aux_buffer) {
+    /* Every second sample of the pixel also goes into the auxiliary buffer, for the adaptive
+     * sampling error estimate. Counted per pixel, since pixels skip samples while converged.
+     * The fourth component holds the convergence flag and is left untouched. */
+    const int pixel_sample = (int)buffer[kernel_data.film.pass_sample_count];
+    if (pixel_sample & 1) {
+      kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+                               make_float4(L_sum.x, L_sum.y, L_sum.z, 0.0f));
+    }
+    kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+  }
+
   kernel_write_light_passes(kg, buffer, L);
 
 #ifdef __DENOISING_FEATURES__
@@ -31,6 +31,7 @@
 #include "kernel/kernel_shader.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #if defined(__VOLUME__) || defined(__SUBSURFACE__)
 #  include "kernel/kernel_volume.h"
@@ -45,6 +46,7 @@
 #include "kernel/kernel_emission.h"
 #include "kernel/kernel_path_common.h"
 #include "kernel/kernel_path_surface.h"
+#include "kernel/kernel_path_guiding.h"
 #include "kernel/kernel_path_volume.h"
 #include "kernel/kernel_path_subsurface.h"
 
@@ -519,6 +521,11 @@ ccl_device_forceinline void kernel_path_integrate(KernelGlobals *kg,
   /* Shader data memory used for both volumes and surfaces, saves stack space. */
   ShaderData sd;
 
+#  ifdef __PATH_GUIDING__
+  PathGuidingRecord guiding_record;
+  path_guiding_record_init(&guiding_record);
+#  endif
+
 #  ifdef __SUBSURFACE__
   SubsurfaceIndirectRays ss_indirect;
   kernel_path_subsurface_init_indirect(&ss_indirect);
@@ -618,10 +625,21 @@ ccl_device_forceinline void kernel_path_integrate(KernelGlobals *kg,
 #  endif
 
       /* compute direct lighting and next bounce */
+#  ifdef __PATH_GUIDING__
+      if (!kernel_path_guiding_surface_bounce(
+              kg, &sd, &throughput, state, L, ray, &guiding_record))
+        break;
+#  else
       if (!kernel_path_surface_bounce(kg, &sd, &throughput, state, &L->state, ray))
         break;
+#  endif
     }
 
+#  ifdef __PATH_GUIDING__
+    /* Train path guiding with the radiance found after each bounce. */
+    kernel_path_guiding_record_path(kg, &guiding_record, L);
+#  endif
+
 #  ifdef __SUBSURFACE__
     /* Trace indirect subsurface rays by restarting the loop. this uses less
      * stack memory than invoking kernel_path_indirect.
@@ -647,6 +665,10 @@ ccl_device void kernel_path_trace(
 
   buffer += index * pass_stride;
 
+  if (kernel_adaptive_pixel_converged(kg, buffer)) {
+    return;
+  }
+
   /* Initialize random numbers and sample ray. */
   uint rng_hash;
   Ray ray;
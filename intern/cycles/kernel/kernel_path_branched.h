@@ -521,6 +521,10 @@ ccl_device void kernel_branched_path_trace(
 
   buffer += index * pass_stride;
 
+  if (kernel_adaptive_pixel_converged(kg, buffer)) {
+    return;
+  }
+
   /* initialize random numbers and ray */
   uint rng_hash;
   Ray ray;
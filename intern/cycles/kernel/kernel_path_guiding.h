@@ -0,0 +1,335 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_PATH_GUIDING_H__
+#define __KERNEL_PATH_GUIDING_H__
+
+#ifdef __PATH_GUIDING__
+#  include "kernel/kernels/cpu/kernel_cpu_path_guiding.h"
+#  include "util/util_atomic.h"
+#endif
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __PATH_GUIDING__
+
+/* Path Guiding
+ *
+ * Surface bounces pick their direction from a mixture of the BSDF and the incident radiance
+ * learned in the grid cell containing the shading point, similar to "Practical Path Guiding
+ * for Efficient Light-Transport Simulation", Müller et al. 2017. Every path records its
+ * bounces and adds the radiance it found back into the grid once it terminates, so guiding
+ * improves while rendering.
+ *
+ * Throughput is divided by the pdf of the mixture, which covers everything the BSDF can
+ * sample, so the result stays unbiased however poorly the grid is trained. Lamp MIS keeps
+ * weighting with the BSDF pdf alone, on both the light and BSDF side, so the weights still
+ * sum to one. */
+
+#  define PATH_GUIDING_MAX_VERTICES 8
+
+typedef struct PathGuidingVertex {
+  /* Path radiance and throughput after the bounce at this vertex. */
+  float3 L_sum;
+  float3 throughput;
+  /* Pdf of the sampled direction, and where to record its radiance. */
+  float pdf;
+  int cell;
+  int bin;
+} PathGuidingVertex;
+
+typedef struct PathGuidingRecord {
+  PathGuidingVertex vertex[PATH_GUIDING_MAX_VERTICES];
+  int num_vertices;
+} PathGuidingRecord;
+
+/* Snapshot of the directional histogram of one cell, so sampling and pdf evaluation see the
+ * same distribution while other threads keep adding to the grid. */
+typedef struct PathGuidingDistribution {
+  float bins[PATH_GUIDING_DIRECTION_BINS];
+  float total;
+} PathGuidingDistribution;
+
+ccl_device_inline void path_guiding_record_init(PathGuidingRecord *record)
+{
+  record->num_vertices = 0;
+}
+
+ccl_device_inline int path_guiding_cell_index(KernelGlobals *kg, float3 P)
+{
+  const int res_x = kernel_data.integrator.guiding_resolution_x;
+  const int res_y = kernel_data.integrator.guiding_resolution_y;
+  const int res_z = kernel_data.integrator.guiding_resolution_z;
+  const float inv_cell_size = kernel_data.integrator.guiding_inv_cell_size;
+
+  const int x = clamp(
+      (int)((P.x - kernel_data.integrator.guiding_min_x) * inv_cell_size), 0, res_x - 1);
+  const int y = clamp(
+      (int)((P.y - kernel_data.integrator.guiding_min_y) * inv_cell_size), 0, res_y - 1);
+  const int z = clamp(
+      (int)((P.z - kernel_data.integrator.guiding_min_z) * inv_cell_size), 0, res_z - 1);
+
+  return x + res_x * (y + res_y * z);
+}
+
+/* Equal area cylindrical mapping, cos(theta) along one axis and phi along the other. */
+ccl_device_inline int path_guiding_direction_bin(float3 D)
+{
+  const float u = 0.5f * (D.z + 1.0f);
+  float phi = atan2f(D.y, D.x);
+  if (phi < 0.0f) {
+    phi += M_2PI_F;
+  }
+  const float v = phi * M_1_2PI_F;
+
+  const int x = clamp((int)(u * PATH_GUIDING_DIRECTION_RES), 0, PATH_GUIDING_DIRECTION_RES - 1);
+  const int y = clamp((int)(v * PATH_GUIDING_DIRECTION_RES), 0, PATH_GUIDING_DIRECTION_RES - 1);
+
+  return x + y * PATH_GUIDING_DIRECTION_RES;
+}
+
+ccl_device_inline float3 path_guiding_bin_direction(int bin, float randu, float randv)
+{
+  const int x = bin % PATH_GUIDING_DIRECTION_RES;
+  const int y = bin / PATH_GUIDING_DIRECTION_RES;
+
+  const float cos_theta = 2.0f * (x + randu) / PATH_GUIDING_DIRECTION_RES - 1.0f;
+  const float sin_theta = safe_sqrtf(1.0f - cos_theta * cos_theta);
+  const float phi = M_2PI_F * (y + randv) / PATH_GUIDING_DIRECTION_RES;
+
+  return make_float3(sin_theta * cosf(phi), sin_theta * sinf(phi), cos_theta);
+}
+
+ccl_device bool path_guiding_distribution_load(KernelGlobals *kg,
+                                               int cell_index,
+                                               PathGuidingDistribution *distribution)
+{
+  const PathGuidingCell *cell = &kg->path_guiding->cells[cell_index];
+
+  if (cell->num_samples < (uint)kernel_data.integrator.guiding_min_samples) {
+    return false;
+  }
+
+  float total = 0.0f;
+  for (int i = 0; i < PATH_GUIDING_DIRECTION_BINS; i++) {
+    distribution->bins[i] = cell->bins[i];
+    total += distribution->bins[i];
+  }
+  distribution->total = total;
+
+  return total > 0.0f;
+}
+
+ccl_device_inline float path_guiding_distribution_pdf(const PathGuidingDistribution *distribution,
+                                                      float3 D)
+{
+  /* All bins cover a solid angle of 4 * pi / PATH_GUIDING_DIRECTION_BINS. */
+  const float bin_pdf = distribution->bins[path_guiding_direction_bin(D)] / distribution->total;
+  return bin_pdf * (PATH_GUIDING_DIRECTION_BINS * 0.25f * M_1_PI_F);
+}
+
+ccl_device float3 path_guiding_distribution_sample(const PathGuidingDistribution *distribution,
+                                                   float randu,
+                                                   float randv,
+                                                   float *pdf)
+{
+  /* Pick a bin proportional to its radiance, reusing the remainder of the random number for
+   * the position inside the bin. */
+  float target = randu * distribution->total;
+  int bin = 0;
+
+  for (; bin < PATH_GUIDING_DIRECTION_BINS - 1; bin++) {
+    if (target < distribution->bins[bin]) {
+      break;
+    }
+    target -= distribution->bins[bin];
+  }
+
+  /* Rounding may leave us on an empty bin at the end, fall back to the last non-empty one. */
+  while (bin > 0 && distribution->bins[bin] == 0.0f) {
+    bin--;
+    target = distribution->bins[bin];
+  }
+
+  const float bin_u = clamp(target / distribution->bins[bin], 0.0f, 1.0f - 1e-6f);
+  const float3 D = path_guiding_bin_direction(bin, bin_u, randv);
+
+  *pdf = distribution->bins[bin] / distribution->total *
+         (PATH_GUIDING_DIRECTION_BINS * 0.25f * M_1_PI_F);
+  return D;
+}
+
+/* Guiding needs the BSDF pdf for arbitrary directions, which singular closures do not have. */
+ccl_device_inline bool path_guiding_shader_supported(const ShaderData *sd)
+{
+  if (!(sd->flag & SD_BSDF_HAS_EVAL) || (sd->flag & SD_BSSRDF)) {
+    return false;
+  }
+
+  for (int i = 0; i < sd->num_closure; i++) {
+    const ShaderClosure *sc = &sd->closure[i];
+    if (CLOSURE_IS_BSDF_SINGULAR(sc->type)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Sum of all radiance accumulated by the path so far, in whichever passes it went. */
+ccl_device_inline float3 path_guiding_radiance_sum(const PathRadiance *L)
+{
+#  ifdef __PASSES__
+  if (L->use_light_pass) {
+    return L->emission + L->direct_emission + L->indirect + L->direct_diffuse +
+           L->direct_glossy + L->direct_transmission + L->direct_subsurface + L->direct_scatter;
+  }
+#  endif
+  return L->emission;
+}
+
+ccl_device bool kernel_path_guiding_surface_bounce(KernelGlobals *kg,
+                                                   ShaderData *sd,
+                                                   ccl_addr_space float3 *throughput,
+                                                   ccl_addr_space PathState *state,
+                                                   PathRadiance *L,
+                                                   ccl_addr_space Ray *ray,
+                                                   PathGuidingRecord *record)
+{
+  if (!kernel_data.integrator.use_guiding || !(sd->flag & SD_BSDF) ||
+      (state->flag & PATH_RAY_SHADOW_CATCHER) || record->num_vertices == PATH_GUIDING_MAX_VERTICES ||
+      !path_guiding_shader_supported(sd)) {
+    return kernel_path_surface_bounce(kg, sd, throughput, state, &L->state, ray);
+  }
+
+  PROFILING_INIT(kg, PROFILING_SURFACE_BOUNCE);
+
+  /* Only guide once the cell has seen enough paths, BSDF sampling alone trains it. */
+  const int cell = path_guiding_cell_index(kg, sd->P);
+  PathGuidingDistribution distribution;
+  const float guiding_fraction = path_guiding_distribution_load(kg, cell, &distribution) ?
+                                     kernel_data.integrator.guiding_fraction :
+                                     0.0f;
+
+  float bsdf_pdf, guiding_pdf = 0.0f;
+  BsdfEval bsdf_eval;
+  float3 bsdf_omega_in;
+  differential3 bsdf_domega_in;
+  float bsdf_u, bsdf_v;
+  path_state_rng_2D(kg, state, PRNG_BSDF_U, &bsdf_u, &bsdf_v);
+  int label;
+
+  if (bsdf_u < guiding_fraction) {
+    /* Sample learned incident radiance. */
+    bsdf_omega_in = path_guiding_distribution_sample(
+        &distribution, bsdf_u / guiding_fraction, bsdf_v, &guiding_pdf);
+    /* Bounce counts and ray visibility follow the closure that dominates in this direction. */
+    label = shader_bsdf_eval_pdf(kg, sd, bsdf_omega_in, &bsdf_eval, &bsdf_pdf);
+    bsdf_domega_in = differential3_zero();
+  }
+  else {
+    /* Sample BSDF. */
+    bsdf_u = (bsdf_u - guiding_fraction) / (1.0f - guiding_fraction);
+    label = shader_bsdf_sample(
+        kg, sd, bsdf_u, bsdf_v, &bsdf_eval, &bsdf_omega_in, &bsdf_domega_in, &bsdf_pdf);
+
+    if (guiding_fraction > 0.0f && bsdf_pdf != 0.0f) {
+      guiding_pdf = path_guiding_distribution_pdf(&distribution, bsdf_omega_in);
+    }
+  }
+
+  if (bsdf_pdf == 0.0f || bsdf_eval_is_zero(&bsdf_eval))
+    return false;
+
+  /* modify throughput with the pdf of the mixture */
+  const float pdf = guiding_fraction * guiding_pdf + (1.0f - guiding_fraction) * bsdf_pdf;
+  path_radiance_bsdf_bounce(kg, &L->state, throughput, &bsdf_eval, pdf, state->bounce, label);
+
+  /* record vertex for training */
+  PathGuidingVertex *vertex = &record->vertex[record->num_vertices++];
+  vertex->L_sum = path_guiding_radiance_sum(L);
+  vertex->throughput = *throughput;
+  vertex->pdf = pdf;
+  vertex->cell = cell;
+  vertex->bin = path_guiding_direction_bin(bsdf_omega_in);
+
+  /* set labels, lamp MIS uses the BSDF pdf alone */
+  state->ray_pdf = bsdf_pdf;
+#  ifdef __LAMP_MIS__
+  state->ray_t = 0.0f;
+#  endif
+  state->min_ray_pdf = fminf(bsdf_pdf, state->min_ray_pdf);
+
+  /* update path state */
+  path_state_next(kg, state, label);
+
+  /* setup ray */
+  ray->P = ray_offset(sd->P, (label & LABEL_TRANSMIT) ? -sd->Ng : sd->Ng);
+  ray->D = normalize(bsdf_omega_in);
+
+  if (state->bounce == 0)
+    ray->t -= sd->ray_length; /* clipping works through transparent */
+  else
+    ray->t = FLT_MAX;
+
+#  ifdef __RAY_DIFFERENTIALS__
+  ray->dP = sd->dP;
+  ray->dD = bsdf_domega_in;
+#  endif
+
+#  ifdef __VOLUME__
+  /* enter/exit volume */
+  if (label & LABEL_TRANSMIT)
+    kernel_volume_stack_enter_exit(kg, sd, state->volume_stack);
+#  endif
+  return true;
+}
+
+/* Add the radiance found by the path to the grid. For every recorded vertex, radiance
+ * accumulated after it divided by the throughput at that point is the incident radiance from
+ * the sampled direction. Dividing by the pdf makes the bins estimate radiance integrated over
+ * their solid angle, independent of how directions were sampled. */
+ccl_device void kernel_path_guiding_record_path(KernelGlobals *kg,
+                                                PathGuidingRecord *record,
+                                                const PathRadiance *L)
+{
+  if (record->num_vertices == 0) {
+    return;
+  }
+
+  const float3 L_sum = path_guiding_radiance_sum(L);
+
+  for (int i = 0; i < record->num_vertices; i++) {
+    const PathGuidingVertex *vertex = &record->vertex[i];
+    PathGuidingCell *cell = &kg->path_guiding->cells[vertex->cell];
+
+    const float3 L_incident = safe_divide_color(L_sum - vertex->L_sum, vertex->throughput);
+    const float value = average(L_incident) / vertex->pdf;
+
+    if (value > 0.0f && isfinite_safe(value)) {
+      atomic_add_and_fetch_float(&cell->bins[vertex->bin], value);
+    }
+    atomic_fetch_and_add_uint32(&cell->num_samples, 1);
+  }
+
+  record->num_vertices = 0;
+}
+
+#endif /* __PATH_GUIDING__ */
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_PATH_GUIDING_H__ */
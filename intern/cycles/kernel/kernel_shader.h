@@ -656,6 +656,64 @@ ccl_device_inline
   }
 }
 
+/* Evaluate all BSDF closures and their combined sampling pdf for a direction that was not
+ * sampled from the BSDF, without multiple importance sampling weights. Returns the label of
+ * the closure contributing most in that direction, as if it had sampled the direction. */
+ccl_device_inline int shader_bsdf_eval_pdf(KernelGlobals *kg,
+                                           ShaderData *sd,
+                                           const float3 omega_in,
+                                           BsdfEval *eval,
+                                           float *pdf)
+{
+  PROFILING_INIT(kg, PROFILING_CLOSURE_EVAL);
+
+  bsdf_eval_init(
+      eval, NBUILTIN_CLOSURES, make_float3(0.0f, 0.0f, 0.0f), kernel_data.film.use_light_pass);
+
+  const ShaderClosure *dominant_sc = NULL;
+  float dominant_contribution = 0.0f;
+  float sum_pdf = 0.0f, sum_sample_weight = 0.0f;
+
+  for (int i = 0; i < sd->num_closure; i++) {
+    const ShaderClosure *sc = &sd->closure[i];
+
+    if (CLOSURE_IS_BSDF(sc->type)) {
+      float bsdf_pdf = 0.0f;
+      float3 closure_eval = bsdf_eval(kg, sd, sc, omega_in, &bsdf_pdf);
+
+      if (bsdf_pdf != 0.0f) {
+        closure_eval *= sc->weight;
+        bsdf_eval_accum(eval, sc->type, closure_eval, 1.0f);
+        sum_pdf += bsdf_pdf * sc->sample_weight;
+
+        const float contribution = average(closure_eval);
+        if (contribution > dominant_contribution) {
+          dominant_contribution = contribution;
+          dominant_sc = sc;
+        }
+      }
+
+      sum_sample_weight += sc->sample_weight;
+    }
+  }
+
+  *pdf = (sum_sample_weight > 0.0f) ? sum_pdf / sum_sample_weight : 0.0f;
+
+  if (dominant_sc == NULL) {
+    return LABEL_NONE;
+  }
+
+  /* Diffuse closures, translucent and the diffuse part of BSSRDFs label as diffuse, all
+   * other closures with an eval are microfacet or similar glossy lobes. */
+  const int type = dominant_sc->type;
+  const int label = (CLOSURE_IS_BSDF_DIFFUSE(type) || type == CLOSURE_BSDF_TRANSLUCENT_ID ||
+                     CLOSURE_IS_BSDF_BSSRDF(type)) ?
+                        LABEL_DIFFUSE :
+                        LABEL_GLOSSY;
+
+  return label | ((dot(sd->Ng, omega_in) > 0.0f) ? LABEL_REFLECT : LABEL_TRANSMIT);
+}
+
 ccl_device_inline const ShaderClosure *shader_bsdf_pick(ShaderData *sd, float *randu)
 {
   /* Note the sampling here must match shader_bssrdf_pick,
@@ -59,6 +59,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_NONE (~0)
 #define PRIM_NONE (~0)
 #define LAMP_NONE (~0)
+#define LIGHT_TREE_NONE (~0u)
 #define ID_NONE (0.0f)
 
 #define VOLUME_STACK_SIZE 32
@@ -113,6 +114,7 @@ CCL_NAMESPACE_BEGIN
 #  define __TRANSPARENT_SHADOWS__
 #  define __BACKGROUND_MIS__
 #  define __LAMP_MIS__
+#  define __LIGHT_TREE__
 #  define __CAMERA_MOTION__
 #  define __OBJECT_MOTION__
 #  define __HAIR__
@@ -136,6 +138,7 @@ CCL_NAMESPACE_BEGIN
 #  endif
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+#  define __PATH_GUIDING__
 #endif /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -365,6 +368,8 @@ typedef enum PassType {
 #endif
   PASS_RENDER_TIME,
   PASS_CRYPTOMATTE,
+  PASS_ADAPTIVE_AUX_BUFFER,
+  PASS_SAMPLE_COUNT,
   PASS_CATEGORY_MAIN_END = 31,
 
   PASS_MIST = 32,
@@ -913,11 +918,13 @@ enum ShaderDataObjectFlag {
   SD_OBJECT_SHADOW_CATCHER = (1 << 7),
   /* object has volume attributes */
   SD_OBJECT_HAS_VOLUME_ATTRIBUTES = (1 << 8),
+  /* Has transforms stored for the motion pass. */
+  SD_OBJECT_MOTION_PASS = (1 << 9),
 
   SD_OBJECT_FLAGS = (SD_OBJECT_HOLDOUT_MASK | SD_OBJECT_MOTION | SD_OBJECT_TRANSFORM_APPLIED |
                      SD_OBJECT_NEGATIVE_SCALE_APPLIED | SD_OBJECT_HAS_VOLUME |
                      SD_OBJECT_INTERSECTS_VOLUME | SD_OBJECT_SHADOW_CATCHER |
-                     SD_OBJECT_HAS_VOLUME_ATTRIBUTES)
+                     SD_OBJECT_HAS_VOLUME_ATTRIBUTES | SD_OBJECT_MOTION_PASS)
 };
 
 typedef ccl_addr_space struct ShaderData {
@@ -1221,6 +1228,10 @@ typedef struct KernelFilm {
   int pass_denoising_data;
   int pass_denoising_clean;
   int denoising_flags;
+  int pass_sample_count;
+
+  int pass_adaptive_aux_buffer;
+  int pad1, pad2;
 
   /* XYZ to rendering color space transform. float4 instead of float3 to
    * ensure consistent padding/alignment across devices. */
@@ -1325,7 +1336,29 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2, pad3;
+  /* light tree */
+  int use_light_tree;
+  int light_tree_num_nodes;
+  int light_tree_num_distant;
+  float light_tree_distant_pdf;
+
+  /* adaptive sampling */
+  int adaptive_min_samples;
+  int adaptive_step;
+  float adaptive_threshold;
+
+  /* path guiding */
+  int use_guiding;
+  int guiding_min_samples;
+  float guiding_fraction;
+  int guiding_resolution_x;
+  int guiding_resolution_y;
+  int guiding_resolution_z;
+  float guiding_min_x;
+  float guiding_min_y;
+  float guiding_min_z;
+  float guiding_inv_cell_size;
+  int pad1, pad2;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1340,6 +1373,12 @@ typedef enum KernelBVHLayout {
   BVH_LAYOUT_ALL = (unsigned int)(-1),
 } KernelBVHLayout;
 
+/* Flags stored in the w component of the first element of QBVH and OBVH inner nodes. */
+typedef enum KernelBVHNodeFlag {
+  /* Child bounds are quantized to 8 bits relative to the bounds of the node. */
+  BVH_NODE_COMPRESSED = (1 << 0),
+} KernelBVHNodeFlag;
+
 typedef struct KernelBVH {
   /* Own BVH */
   int root;
@@ -1411,21 +1450,27 @@ typedef struct KernelObject {
   float dupli_generated[3];
   float dupli_uv[2];
 
-  int numkeys;
   int numsteps;
-  int numverts;
-
-  uint patch_map_offset;
-  uint attribute_map_offset;
+  /* Index into the mesh records, shared by all instances of the same mesh. */
+  int mesh;
   uint motion_offset;
-  uint pad1;
 
   float cryptomatte_object;
   float cryptomatte_asset;
-  float pad2, pad3;
+  float pad1, pad2;
 } KernelObject;
 static_assert_align(KernelObject, 16);
 
+/* Mesh data that is the same for all objects instancing the mesh. */
+typedef struct KernelObjectMesh {
+  int numkeys;
+  int numverts;
+
+  uint patch_map_offset;
+  uint attribute_map_offset;
+} KernelObjectMesh;
+static_assert_align(KernelObjectMesh, 16);
+
 typedef struct KernelSpotLight {
   float radius;
   float invarea;
@@ -1488,6 +1533,23 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+typedef struct KernelLightTreeNode {
+  /* Bounds and total energy of all emitters below the node. */
+  float bbox_min[3];
+  float energy;
+  float bbox_max[3];
+  /* Emitter normals are within theta_o of the axis, light is emitted within theta_e of them. */
+  float theta_o;
+  float axis[3];
+  float theta_e;
+  /* Inner nodes store the index of their second child, the first child directly follows the
+   * node. Leaves store the bitwise negated light distribution index of their emitter. */
+  int child;
+  int parent;
+  int pad1, pad2;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
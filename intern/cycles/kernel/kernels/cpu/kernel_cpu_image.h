@@ -17,6 +17,8 @@
 #ifndef __KERNEL_CPU_IMAGE_H__
 #define __KERNEL_CPU_IMAGE_H__
 
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
+
 CCL_NAMESPACE_BEGIN
 
 template<typename T> struct TextureInterpolator {
@@ -466,8 +468,83 @@ template<typename T> struct TextureInterpolator {
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
+/* Texture Cache */
+
+ccl_device_inline const TextureCacheImage *kernel_tex_image_cached(KernelGlobals *kg, int id)
+{
+  const TextureCacheGlobals *texture_cache = kg->texture_cache;
+  if (texture_cache == NULL || id >= (int)texture_cache->images.size()) {
+    return NULL;
+  }
+
+  const TextureCacheImage &image = texture_cache->images[id];
+  return (image.handle) ? &image : NULL;
+}
+
+/* Filtered lookup in an image read through the texture cache. The texture coordinate
+ * derivatives select the MIP level, zero derivatives read from the full resolution image. */
+ccl_device float4 kernel_tex_image_interp_cached(
+    KernelGlobals *kg, const TextureCacheImage *image, float x, float y, float2 dx, float2 dy)
+{
+  OIIO::TextureOpt options;
+
+  switch (image->interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = OIIO::TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = OIIO::TextureOpt::InterpBicubic;
+      break;
+    case INTERPOLATION_SMART:
+      options.interpmode = OIIO::TextureOpt::InterpSmartBicubic;
+      break;
+    default:
+      options.interpmode = OIIO::TextureOpt::InterpBilinear;
+      break;
+  }
+
+  switch (image->extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapPeriodic;
+      break;
+  }
+
+  /* Cycles images have their origin at the bottom, OpenImageIO images at the top. */
+  const int channels = min(image->channels, 4);
+  float result[4];
+  if (!kg->texture_cache->texture_system->texture(
+          image->handle, NULL, options, x, 1.0f - y, dx.x, -dx.y, dy.x, -dy.y, channels, result)) {
+    return make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+  }
+
+  /* Expand to RGBA the same way as images loaded into device memory. */
+  switch (channels) {
+    case 1:
+      return make_float4(result[0], result[0], result[0], 1.0f);
+    case 2:
+      return make_float4(result[0], result[0], result[0], result[1]);
+    case 3:
+      return make_float4(result[0], result[1], result[2], 1.0f);
+    default:
+      return make_float4(result[0], result[1], result[2], result[3]);
+  }
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
+  const TextureCacheImage *cached_image = kernel_tex_image_cached(kg, id);
+  if (cached_image) {
+    const float2 zero = make_float2(0.0f, 0.0f);
+    return kernel_tex_image_interp_cached(kg, cached_image, x, y, zero, zero);
+  }
+
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
   switch (kernel_tex_type(id)) {
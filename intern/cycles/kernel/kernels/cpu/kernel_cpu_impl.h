@@ -92,6 +92,56 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(
 #  endif /* KERNEL_STUB */
 }
 
+/* Adaptive Sampling */
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(
+    KernelGlobals *kg, float *buffer, int sample, int x, int y, int offset, int stride)
+{
+#  ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+#  else
+  /* Pixels track their own sample count, the sample of the tile is not needed. */
+  (void)sample;
+  kernel_do_adaptive_stopping(kg,
+                              buffer + (offset + x + y * stride) * kernel_data.film.pass_stride);
+#  endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(
+    KernelGlobals *kg, float *buffer, int y, int start_x, int width, int offset, int stride)
+{
+#  ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, adaptive_filter_x);
+  return false;
+#  else
+  return kernel_do_adaptive_filter(
+      kg, buffer + (offset + start_x + y * stride) * kernel_data.film.pass_stride, width, 1);
+#  endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(
+    KernelGlobals *kg, float *buffer, int x, int start_y, int height, int offset, int stride)
+{
+#  ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, adaptive_filter_y);
+  return false;
+#  else
+  return kernel_do_adaptive_filter(
+      kg, buffer + (offset + x + start_y * stride) * kernel_data.film.pass_stride, height, stride);
+#  endif /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(
+    KernelGlobals *kg, float *buffer, int sample, int x, int y, int offset, int stride)
+{
+#  ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#  else
+  kernel_adaptive_post_adjust(
+      kg, buffer + (offset + x + y * stride) * kernel_data.film.pass_stride, sample);
+#  endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_CPU_PATH_GUIDING_H__
+#define __KERNEL_CPU_PATH_GUIDING_H__
+
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Path Guiding
+ *
+ * Incident radiance learned while rendering, stored in a regular grid over the scene bounds
+ * with a directional histogram per cell. Directions are mapped to the histogram with an equal
+ * area cylindrical mapping, so all bins cover the same solid angle. The grid is written by all
+ * render threads at once through atomics. Only supported by the CPU device. */
+
+#define PATH_GUIDING_DIRECTION_RES 8
+#define PATH_GUIDING_DIRECTION_BINS (PATH_GUIDING_DIRECTION_RES * PATH_GUIDING_DIRECTION_RES)
+
+struct PathGuidingCell {
+  /* Incident radiance integrated over each directional bin. */
+  float bins[PATH_GUIDING_DIRECTION_BINS];
+  /* Number of path vertices recorded in this cell. */
+  uint num_samples;
+};
+
+struct PathGuidingGlobals {
+  vector<PathGuidingCell> cells;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_CPU_PATH_GUIDING_H__ */
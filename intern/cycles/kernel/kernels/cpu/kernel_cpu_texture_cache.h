@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_CPU_TEXTURE_CACHE_H__
+#define __KERNEL_CPU_TEXTURE_CACHE_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util/util_texture.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Image files which are not loaded into device memory, but are read on demand through the
+ * OpenImageIO texture system. Tiles of the MIP level matching the ray footprint are loaded
+ * when first accessed, and least recently used tiles are evicted when the cache exceeds its
+ * memory limit. Only supported by the CPU device. */
+
+struct TextureCacheImage {
+  TextureCacheImage()
+      : handle(NULL),
+        channels(0),
+        interpolation(INTERPOLATION_LINEAR),
+        extension(EXTENSION_REPEAT)
+  {
+  }
+
+  OIIO::TextureSystem::TextureHandle *handle;
+  int channels;
+  InterpolationType interpolation;
+  ExtensionType extension;
+};
+
+struct TextureCacheGlobals {
+  TextureCacheGlobals() : texture_system(NULL)
+  {
+  }
+
+  OIIO::TextureSystem *texture_system;
+
+  /* Indexed by flattened image slot, images without handle are stored in device memory. */
+  vector<TextureCacheImage> images;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_CPU_TEXTURE_CACHE_H__ */
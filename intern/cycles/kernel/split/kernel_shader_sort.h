@@ -54,7 +54,6 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
   }
   ccl_barrier(CCL_LOCAL_MEM_FENCE);
 
-  /* skip sorting for cpu split kernel */
 #  ifdef __KERNEL_OPENCL__
 
   /* bitonic sort */
@@ -77,6 +76,44 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
       }
     }
   }
+#  elif defined(__KERNEL_CPU__)
+
+  /* On the CPU a single thread owns the whole block, so do a bottom-up stable merge sort.
+   * Only the occupied part of the block is sorted, the padding stays at the end. */
+  int num_sort = min((int)(qsize - offset), SHADER_SORT_BLOCK_SIZE);
+  ccl_local ushort *temp_index = &locals->local_index_temp[0];
+
+  for (int width = 1; width < num_sort; width <<= 1) {
+    for (int start = 0; start < num_sort; start += 2 * width) {
+      int mid = min(start + width, num_sort);
+      int end = min(start + 2 * width, num_sort);
+      int i = start, j = mid, k = start;
+
+      while (i < mid && j < end) {
+        temp_index[k++] = (local_value[local_index[j]] < local_value[local_index[i]]) ?
+                              local_index[j++] :
+                              local_index[i++];
+      }
+      while (i < mid) {
+        temp_index[k++] = local_index[i++];
+      }
+      while (j < end) {
+        temp_index[k++] = local_index[j++];
+      }
+    }
+
+    ccl_local ushort *swap_index = local_index;
+    local_index = temp_index;
+    temp_index = swap_index;
+  }
+
+  /* Copy back if the last pass ended in the scratch buffer, which has no padding. */
+  if (local_index != &locals->local_index[0]) {
+    for (int i = 0; i < num_sort; i++) {
+      locals->local_index[i] = local_index[i];
+    }
+    local_index = &locals->local_index[0];
+  }
 #  endif /* __KERNEL_OPENCL__ */
 
   /* copy to destination */
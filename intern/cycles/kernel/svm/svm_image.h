@@ -16,9 +16,8 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint flags)
+ccl_device float4 svm_image_texture_flags(KernelGlobals *kg, int id, float4 r, uint flags)
 {
-  float4 r = kernel_tex_image_interp(kg, id, x, y);
   const float alpha = r.w;
 
   if ((flags & NODE_IMAGE_ALPHA_UNASSOCIATE) && alpha != 1.0f && alpha != 0.0f) {
@@ -37,6 +36,32 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
   return r;
 }
 
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint flags)
+{
+  return svm_image_texture_flags(kg, id, kernel_tex_image_interp(kg, id, x, y), flags);
+}
+
+#ifdef __KERNEL_CPU__
+/* Texture coordinate derivatives are not propagated through shader nodes, they are only known
+ * when the image is mapped with the unmodified default UV map. Any other vector gets zero
+ * derivatives, which samples the full resolution image. */
+ccl_device void svm_image_uv_derivatives(
+    KernelGlobals *kg, ShaderData *sd, uint flags, float2 *dx, float2 *dy)
+{
+  *dx = make_float2(0.0f, 0.0f);
+  *dy = make_float2(0.0f, 0.0f);
+
+  if (!(flags & NODE_IMAGE_DEFAULT_UV)) {
+    return;
+  }
+
+  const AttributeDescriptor desc = find_attribute(kg, sd, ATTR_STD_UV);
+  if (desc.offset != ATTR_STD_NOT_FOUND) {
+    primitive_surface_attribute_float2(kg, sd, desc, dx, dy);
+  }
+}
+#endif
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
@@ -63,7 +88,22 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
   else {
     tex_co = make_float2(co.x, co.y);
   }
-  float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, flags);
+
+  float4 f;
+#ifdef __KERNEL_CPU__
+  const TextureCacheImage *cached_image = kernel_tex_image_cached(kg, id);
+  if (cached_image && node.w == NODE_IMAGE_PROJ_FLAT) {
+    /* Filter over the ray footprint, so only tiles of the matching MIP level get loaded. */
+    float2 dx, dy;
+    svm_image_uv_derivatives(kg, sd, flags, &dx, &dy);
+    f = kernel_tex_image_interp_cached(kg, cached_image, tex_co.x, tex_co.y, dx, dy);
+    f = svm_image_texture_flags(kg, id, f, flags);
+  }
+  else
+#endif
+  {
+    f = svm_image_texture(kg, id, tex_co.x, tex_co.y, flags);
+  }
 
   if (stack_valid(out_offset))
     stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -20,6 +20,8 @@
 #include "render/scene.h"
 #include "render/stats.h"
 
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
+
 #include "util/util_foreach.h"
 #include "util/util_image_impl.h"
 #include "util/util_logging.h"
@@ -799,6 +801,12 @@ void ImageManager::device_load_image(
     img->mem = NULL;
   }
 
+  /* Images read on demand through the texture cache are not loaded into device memory. */
+  if (device_load_image_cached(device, scene, type, slot)) {
+    img->need_load = false;
+    return;
+  }
+
   /* Create new texture. */
   if (type == IMAGE_DATA_TYPE_FLOAT4) {
     device_vector<float4> *tex_img = new device_vector<float4>(
@@ -967,7 +975,7 @@ void ImageManager::device_load_image(
   img->need_load = false;
 }
 
-void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
+void ImageManager::device_free_image(Device *device, ImageDataType type, int slot)
 {
   Image *img = images[type][slot];
 
@@ -979,6 +987,8 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 #endif
     }
 
+    device_free_image_cached(device, type, slot);
+
     if (img->mem) {
       thread_scoped_lock device_lock(device_mutex);
       delete img->mem;
@@ -990,6 +1000,120 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
   }
 }
 
+/* Texture cache
+ *
+ * Image files can be read on demand by the CPU device, loading only the tiles and MIP levels
+ * that are accessed during rendering. Images which need colorspace conversion or alpha
+ * handling at load time, and builtin images without a file, are still loaded into device
+ * memory. */
+
+static bool image_use_texture_cache(ImageManager::Image *img, Scene *scene)
+{
+  if (scene->params.texture_cache_size <= 0 || scene->params.texture_limit > 0) {
+    return false;
+  }
+  if (img->builtin_data || !path_exists(img->filename) || path_is_directory(img->filename)) {
+    return false;
+  }
+
+  const ImageMetaData &metadata = img->metadata;
+  if (metadata.depth > 1 || !(metadata.channels >= 1 && metadata.channels <= 4)) {
+    return false;
+  }
+  if (!(metadata.colorspace == u_colorspace_raw || metadata.colorspace == u_colorspace_srgb)) {
+    return false;
+  }
+
+  /* The texture system always associates alpha, same as the default for loaded images. */
+  const bool has_alpha = (metadata.channels == 2 || metadata.channels == 4);
+  return !has_alpha || image_associate_alpha(img);
+}
+
+bool ImageManager::device_load_image_cached(Device *device,
+                                            Scene *scene,
+                                            ImageDataType type,
+                                            int slot)
+{
+  TextureCacheGlobals *texture_cache = (TextureCacheGlobals *)device->texture_cache_memory();
+  if (texture_cache == NULL) {
+    return false;
+  }
+
+  Image *img = images[type][slot];
+  if (!image_use_texture_cache(img, scene)) {
+    device_free_image_cached(device, type, slot);
+    return false;
+  }
+
+  OIIO::TextureSystem *texture_system;
+  {
+    thread_scoped_lock device_lock(device_mutex);
+    if (texture_cache->texture_system == NULL) {
+      /* Not shared with OSL, so the memory limit only applies to this cache. */
+      texture_cache->texture_system = OIIO::TextureSystem::create(false);
+      texture_cache->texture_system->attribute("automip", 1);
+      texture_cache->texture_system->attribute("autotile", 64);
+    }
+    texture_system = texture_cache->texture_system;
+    texture_system->attribute("max_memory_MB", (float)scene->params.texture_cache_size);
+  }
+
+  /* The file may have changed since it was last read. */
+  ustring filename(img->filename);
+  texture_system->invalidate(filename);
+
+  OIIO::TextureSystem::TextureHandle *handle = texture_system->get_texture_handle(filename);
+  if (handle == NULL) {
+    device_free_image_cached(device, type, slot);
+    return false;
+  }
+
+  thread_scoped_lock device_lock(device_mutex);
+  const size_t flat_slot = type_index_to_flattened_slot(slot, type);
+  if (texture_cache->images.size() <= flat_slot) {
+    texture_cache->images.resize(flat_slot + 1);
+  }
+
+  TextureCacheImage &cached_image = texture_cache->images[flat_slot];
+  cached_image.handle = handle;
+  cached_image.channels = img->metadata.channels;
+  cached_image.interpolation = img->interpolation;
+  cached_image.extension = img->extension;
+
+  VLOG(1) << "Reading image " << img->filename << " on demand through the texture cache.";
+
+  return true;
+}
+
+void ImageManager::device_free_image_cached(Device *device, ImageDataType type, int slot)
+{
+  TextureCacheGlobals *texture_cache = (TextureCacheGlobals *)device->texture_cache_memory();
+  if (texture_cache == NULL) {
+    return;
+  }
+
+  thread_scoped_lock device_lock(device_mutex);
+  const size_t flat_slot = type_index_to_flattened_slot(slot, type);
+  if (flat_slot < texture_cache->images.size() && texture_cache->images[flat_slot].handle) {
+    texture_cache->texture_system->invalidate(ustring(images[type][slot]->filename));
+    texture_cache->images[flat_slot] = TextureCacheImage();
+  }
+}
+
+void ImageManager::device_free_texture_cache(Device *device)
+{
+  TextureCacheGlobals *texture_cache = (TextureCacheGlobals *)device->texture_cache_memory();
+  if (texture_cache == NULL || texture_cache->texture_system == NULL) {
+    return;
+  }
+
+  VLOG(1) << "Texture cache statistics:\n" << texture_cache->texture_system->getstats();
+
+  OIIO::TextureSystem::destroy(texture_cache->texture_system);
+  texture_cache->texture_system = NULL;
+  texture_cache->images.clear();
+}
+
 void ImageManager::device_update(Device *device, Scene *scene, Progress &progress)
 {
   if (!need_update) {
@@ -1092,6 +1216,8 @@ void ImageManager::device_free(Device *device)
     }
     images[type].clear();
   }
+
+  device_free_texture_cache(device);
 }
 
 void ImageManager::collect_statistics(RenderStats *stats)
@@ -1099,7 +1225,8 @@ void ImageManager::collect_statistics(RenderStats *stats)
   for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     foreach (const Image *image, images[type]) {
       stats->image.textures.add_entry(
-          NamedSizeEntry(path_filename(image->filename), image->mem->memory_size()));
+          NamedSizeEntry(path_filename(image->filename),
+                         (image->mem) ? image->mem->memory_size() : 0));
     }
   }
 }
@@ -186,6 +186,10 @@ class ImageManager {
   void device_load_image(
       Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress);
   void device_free_image(Device *device, ImageDataType type, int slot);
+
+  bool device_load_image_cached(Device *device, Scene *scene, ImageDataType type, int slot);
+  void device_free_image_cached(Device *device, ImageDataType type, int slot);
+  void device_free_texture_cache(Device *device);
 };
 
 CCL_NAMESPACE_END
@@ -19,12 +19,16 @@
 #include "render/integrator.h"
 #include "render/film.h"
 #include "render/light.h"
+#include "render/object.h"
 #include "render/scene.h"
 #include "render/shader.h"
 #include "render/sobol.h"
 
+#include "kernel/kernels/cpu/kernel_cpu_path_guiding.h"
+
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
+#include "util/util_logging.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -67,6 +71,13 @@ NODE_DEFINE(Integrator)
   SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
   SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
   SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+  SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+  SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+  SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
+
+  SOCKET_BOOLEAN(use_guiding, "Use Path Guiding", false);
+  SOCKET_INT(guiding_memory, "Path Guiding Memory", 64);
 
   static NodeEnum method_enum;
   method_enum.insert("path", PATH);
@@ -92,6 +103,10 @@ Integrator::~Integrator()
 
 void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 {
+  /* Learned radiance is only valid for the scene it was learned in, so restart training
+   * on any scene update, even when the integrator itself did not change. */
+  device_update_guiding(device, dscene, scene);
+
   if (!need_update)
     return;
 
@@ -171,6 +186,17 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
   kintegrator->sampling_pattern = sampling_pattern;
   kintegrator->aa_samples = aa_samples;
 
+  /* Adaptive sampling is enabled by the film passes, convergence is tested every few samples.
+   * The step must be even for the error estimate, which compares against every second sample.
+   * Without explicit minimum, pixels get at least the square root of the sample count. */
+  kintegrator->adaptive_step = 4;
+  kintegrator->adaptive_min_samples = (adaptive_min_samples > 0) ?
+                                          adaptive_min_samples :
+                                          max(4, (int)sqrtf((float)aa_samples));
+  kintegrator->adaptive_min_samples = (int)align_up(kintegrator->adaptive_min_samples,
+                                                    kintegrator->adaptive_step);
+  kintegrator->adaptive_threshold = adaptive_threshold;
+
   if (light_sampling_threshold > 0.0f) {
     kintegrator->light_inv_rr_threshold = 1.0f / light_sampling_threshold;
   }
@@ -220,11 +246,83 @@ void Integrator::device_free(Device *, DeviceScene *dscene)
   dscene->sobol_directions.free();
 }
 
+void Integrator::device_update_guiding(Device *device, DeviceScene *dscene, Scene *scene)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  PathGuidingGlobals *guiding = (PathGuidingGlobals *)device->path_guiding_memory();
+
+  kintegrator->use_guiding = false;
+
+  /* Only the CPU device path tracing kernel supports guiding. */
+  if (guiding == NULL) {
+    return;
+  }
+
+  BoundBox bounds = BoundBox::empty;
+  if (use_guiding && method == PATH && guiding_memory > 0) {
+    foreach (Object *object, scene->objects) {
+      if (object->bounds.valid()) {
+        bounds.grow(object->bounds);
+      }
+    }
+  }
+
+  if (!bounds.valid()) {
+    guiding->cells.free_memory();
+    return;
+  }
+
+  /* Cubic cells, as many as fit in the memory budget. Flat scenes still get a few cells
+   * along their thinnest axis. */
+  const size_t max_cells = max(
+      (size_t)guiding_memory * 1024 * 1024 / sizeof(PathGuidingCell), (size_t)1);
+  const float3 size = max(bounds.size(), make_float3(1e-3f * max3(bounds.size()) + 1e-6f));
+  float cell_size = cbrtf(size.x * size.y * size.z / max_cells);
+
+  int3 resolution;
+  for (;;) {
+    resolution = make_int3(max((int)ceilf(size.x / cell_size), 1),
+                           max((int)ceilf(size.y / cell_size), 1),
+                           max((int)ceilf(size.z / cell_size), 1));
+    if ((size_t)resolution.x * resolution.y * resolution.z <= max_cells) {
+      break;
+    }
+    cell_size *= 1.05f;
+  }
+
+  const size_t num_cells = (size_t)resolution.x * resolution.y * resolution.z;
+  guiding->cells.clear();
+  guiding->cells.resize(num_cells);
+
+  VLOG(1) << "Path guiding grid: " << resolution.x << "x" << resolution.y << "x" << resolution.z
+          << " cells, " << string_human_readable_size(num_cells * sizeof(PathGuidingCell))
+          << ".";
+
+  kintegrator->use_guiding = true;
+  kintegrator->guiding_min_samples = 2 * PATH_GUIDING_DIRECTION_BINS;
+  kintegrator->guiding_fraction = 0.5f;
+  kintegrator->guiding_resolution_x = resolution.x;
+  kintegrator->guiding_resolution_y = resolution.y;
+  kintegrator->guiding_resolution_z = resolution.z;
+  kintegrator->guiding_min_x = bounds.min.x;
+  kintegrator->guiding_min_y = bounds.min.y;
+  kintegrator->guiding_min_z = bounds.min.z;
+  kintegrator->guiding_inv_cell_size = 1.0f / cell_size;
+}
+
 bool Integrator::modified(const Integrator &integrator)
 {
   return !Node::equals(integrator);
 }
 
+bool Integrator::light_tree_enabled() const
+{
+  if (method == BRANCHED_PATH && (sample_all_lights_direct || sample_all_lights_indirect)) {
+    return false;
+  }
+  return use_light_tree;
+}
+
 void Integrator::tag_update(Scene *scene)
 {
   foreach (Shader *shader, scene->shaders) {
@@ -73,6 +73,14 @@ class Integrator : public Node {
   bool sample_all_lights_indirect;
   float light_sampling_threshold;
 
+  bool use_light_tree;
+
+  float adaptive_threshold;
+  int adaptive_min_samples;
+
+  bool use_guiding;
+  int guiding_memory;
+
   enum Method {
     BRANCHED_PATH = 0,
     PATH = 1,
@@ -91,8 +99,12 @@ class Integrator : public Node {
 
   void device_update(Device *device, DeviceScene *dscene, Scene *scene);
   void device_free(Device *device, DeviceScene *dscene);
+  void device_update_guiding(Device *device, DeviceScene *dscene, Scene *scene);
 
   bool modified(const Integrator &integrator);
+
+  /* Light tree sampling picks a single light, it is not used when sampling all lights. */
+  bool light_tree_enabled() const;
   void tag_update(Scene *scene);
 };
 
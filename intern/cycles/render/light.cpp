@@ -20,12 +20,14 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
 #include "render/scene.h"
 #include "render/shader.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_path.h"
@@ -257,7 +259,7 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
-void LightManager::device_update_distribution(Device *,
+void LightManager::device_update_distribution(Device *device,
                                               DeviceScene *dscene,
                                               Scene *scene,
                                               Progress &progress)
@@ -310,6 +312,28 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* Light tree emitters, and lookup from object and triangle to light distribution index.
+   * Only the CPU kernels are compiled with light tree support. */
+  const bool use_light_tree = scene->integrator->light_tree_enabled() &&
+                              device->info.type == DEVICE_CPU;
+  vector<LightTreeEmitter> tree_emitters;
+  vector<int> tree_distant;
+  uint *tree_object_offset = NULL;
+  uint *tree_tri_rank = NULL;
+  float tree_triangle_energy = 0.0f, tree_lamp_energy = 0.0f;
+
+  if (use_light_tree) {
+    size_t num_scene_triangles = 0;
+    foreach (Mesh *mesh, scene->meshes) {
+      num_scene_triangles = max(num_scene_triangles, mesh->tri_offset + mesh->num_triangles());
+    }
+
+    tree_emitters.reserve(num_distribution);
+    tree_object_offset = dscene->light_tree_object_offset.alloc(max(scene->objects.size(), (size_t)1));
+    tree_tri_rank = dscene->light_tree_tri_rank.alloc(max(num_scene_triangles, (size_t)1));
+    memset(tree_tri_rank, 0, sizeof(uint) * dscene->light_tree_tri_rank.size());
+  }
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -319,9 +343,16 @@ void LightManager::device_update_distribution(Device *,
       return;
 
     if (!object_usable_as_light(object)) {
+      if (use_light_tree) {
+        tree_object_offset[j] = LIGHT_TREE_NONE;
+      }
       j++;
       continue;
     }
+
+    if (use_light_tree) {
+      tree_object_offset[j] = offset;
+    }
     /* Sum area. */
     Mesh *mesh = object->mesh;
     bool transform_applied = mesh->transform_applied;
@@ -347,6 +378,7 @@ void LightManager::device_update_distribution(Device *,
     }
 
     size_t mesh_num_triangles = mesh->num_triangles();
+    uint tri_rank = 0;
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->shader[i];
       Shader *shader = (shader_index < mesh->used_shaders.size()) ?
@@ -360,6 +392,10 @@ void LightManager::device_update_distribution(Device *,
         distribution[offset].mesh_light.object_id = object_id;
         offset++;
 
+        if (use_light_tree) {
+          tree_tri_rank[i + mesh->tri_offset] = tri_rank++;
+        }
+
         Mesh::Triangle t = mesh->get_triangle(i);
         if (!t.valid(&mesh->verts[0])) {
           continue;
@@ -374,7 +410,23 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree && area > 0.0f) {
+          /* Mesh emission is two sided, so light can leave in any direction: the normal cone
+           * covers the whole sphere and each side emits over a hemisphere. */
+          LightTreeEmitter emitter;
+          emitter.bbox.grow(p1);
+          emitter.bbox.grow(p2);
+          emitter.bbox.grow(p3);
+          emitter.orientation = LightTreeOrientation(
+              normalize(cross(p2 - p1, p3 - p1)), M_PI_F, M_PI_2_F);
+          emitter.energy = area;
+          emitter.distribution_index = offset - 1;
+          tree_emitters.push_back(emitter);
+          tree_triangle_energy += area;
+        }
       }
     }
 
@@ -398,6 +450,18 @@ void LightManager::device_update_distribution(Device *,
     distribution[offset].lamp.size = light->size;
     totarea += lightarea;
 
+    if (use_light_tree) {
+      if (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+        tree_distant.push_back(offset);
+      }
+      else {
+        LightTreeEmitter emitter = light_tree_emitter(light);
+        emitter.distribution_index = offset;
+        tree_emitters.push_back(emitter);
+        tree_lamp_energy += emitter.energy;
+      }
+    }
+
     if (light->type == LIGHT_DISTANT) {
       use_lamp_mis |= (light->angle > 0.0f && light->use_mis);
     }
@@ -474,6 +538,22 @@ void LightManager::device_update_distribution(Device *,
     /* CDF */
     dscene->light_distribution.copy_to_device();
 
+    /* Light tree */
+    if (use_light_tree) {
+      device_update_light_tree(dscene,
+                               tree_emitters,
+                               tree_distant,
+                               num_distribution,
+                               tree_triangle_energy,
+                               tree_lamp_energy);
+    }
+    else {
+      kintegrator->use_light_tree = false;
+      kintegrator->light_tree_num_nodes = 0;
+      kintegrator->light_tree_num_distant = 0;
+      kintegrator->light_tree_distant_pdf = 0.0f;
+    }
+
     /* Portals */
     if (num_portals > 0) {
       kintegrator->portal_offset = light_index;
@@ -498,10 +578,114 @@ void LightManager::device_update_distribution(Device *,
     kintegrator->portal_offset = 0;
     kintegrator->portal_pdf = 0.0f;
 
+    dscene->light_tree_object_offset.free();
+    dscene->light_tree_tri_rank.free();
+
+    kintegrator->use_light_tree = false;
+    kintegrator->light_tree_num_nodes = 0;
+    kintegrator->light_tree_num_distant = 0;
+    kintegrator->light_tree_distant_pdf = 0.0f;
+
     kfilm->pass_shadow_scale = 1.0f;
   }
 }
 
+/* Bounds, orientation and energy of a light with finite position. */
+LightTreeEmitter LightManager::light_tree_emitter(Light *light)
+{
+  LightTreeEmitter emitter;
+  emitter.energy = fabsf(average(light->strength));
+
+  if (light->type == LIGHT_AREA) {
+    const float3 axisu = light->axisu * (light->sizeu * light->size);
+    const float3 axisv = light->axisv * (light->sizev * light->size);
+    for (int i = 0; i < 4; i++) {
+      const float u = (i & 1) ? 0.5f : -0.5f;
+      const float v = (i & 2) ? 0.5f : -0.5f;
+      emitter.bbox.grow(light->co + axisu * u + axisv * v);
+    }
+    /* Area lights emit on one side only. */
+    emitter.orientation = LightTreeOrientation(safe_normalize(light->dir), 0.0f, M_PI_2_F);
+  }
+  else {
+    emitter.bbox.grow(light->co, light->size);
+
+    if (light->type == LIGHT_SPOT) {
+      emitter.orientation = LightTreeOrientation(
+          safe_normalize(light->dir), 0.0f, min(0.5f * light->spot_angle, M_PI_F));
+    }
+    else {
+      emitter.orientation = LightTreeOrientation(
+          make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+    }
+  }
+
+  return emitter;
+}
+
+void LightManager::device_update_light_tree(DeviceScene *dscene,
+                                            vector<LightTreeEmitter> &emitters,
+                                            const vector<int> &distant,
+                                            size_t num_distribution,
+                                            float triangle_energy,
+                                            float lamp_energy)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+  /* Shaders are not evaluated here, so the emitted power of triangles is unknown. Scale their
+   * energy so triangles and lamps get the same share overall as with the distribution, and
+   * leave it to the tree to pick the most relevant ones within each. */
+  if (triangle_energy > 0.0f && lamp_energy > 0.0f) {
+    const float scale = lamp_energy / triangle_energy;
+    foreach (LightTreeEmitter &emitter, emitters) {
+      if (emitter.distribution_index < (int)num_distribution - kintegrator->num_all_lights) {
+        emitter.energy *= scale;
+      }
+    }
+  }
+
+  LightTree tree(emitters, num_distribution);
+
+  const vector<KernelLightTreeNode> &tree_nodes = tree.get_nodes();
+  const vector<uint> &tree_emitter_nodes = tree.get_emitter_nodes();
+  const size_t num_nodes = tree_nodes.size();
+  const size_t num_distant = distant.size();
+
+  /* Distant lights are stored as leaves after the tree. */
+  KernelLightTreeNode *nodes = dscene->light_tree_nodes.alloc(max(num_nodes + num_distant, (size_t)1));
+  uint *emitter_nodes = dscene->light_tree_emitter_node.alloc(max(num_distribution, (size_t)1));
+
+  std::copy(tree_nodes.begin(), tree_nodes.end(), nodes);
+  std::copy(tree_emitter_nodes.begin(), tree_emitter_nodes.end(), emitter_nodes);
+
+  for (size_t i = 0; i < num_distant; i++) {
+    KernelLightTreeNode &knode = nodes[num_nodes + i];
+    memset(&knode, 0, sizeof(knode));
+    knode.child = ~distant[i];
+    knode.parent = -1;
+    emitter_nodes[distant[i]] = num_nodes + i;
+  }
+
+  kintegrator->use_light_tree = true;
+  kintegrator->light_tree_num_nodes = num_nodes;
+  kintegrator->light_tree_num_distant = num_distant;
+  /* Distant lights are picked as often as each one of them was a single local light. */
+  if (num_distant) {
+    kintegrator->light_tree_distant_pdf = 1.0f / (num_distant + ((num_nodes) ? 1 : 0));
+  }
+  else {
+    kintegrator->light_tree_distant_pdf = 0.0f;
+  }
+
+  VLOG(1) << "Light tree built with " << num_nodes << " nodes and " << num_distant
+          << " distant lights.";
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_emitter_node.copy_to_device();
+  dscene->light_tree_object_offset.copy_to_device();
+  dscene->light_tree_tri_rank.copy_to_device();
+}
+
 static void background_cdf(
     int start, int end, int res_x, int res_y, const vector<float3> *pixels, float2 *cond_cdf)
 {
@@ -933,6 +1117,10 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitter_node.free();
+  dscene->light_tree_object_offset.free();
+  dscene->light_tree_tri_rank.free();
   dscene->lights.free();
   dscene->light_background_marginal_cdf.free();
   dscene->light_background_conditional_cdf.free();
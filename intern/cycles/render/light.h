@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceScene;
+struct LightTreeEmitter;
 class Object;
 class Progress;
 class Scene;
@@ -116,6 +117,12 @@ class LightManager {
                                   DeviceScene *dscene,
                                   Scene *scene,
                                   Progress &progress);
+  void device_update_light_tree(DeviceScene *dscene,
+                                vector<LightTreeEmitter> &emitters,
+                                const vector<int> &distant,
+                                size_t num_distribution,
+                                float triangle_energy,
+                                float lamp_energy);
   void device_update_background(Device *device,
                                 DeviceScene *dscene,
                                 Scene *scene,
@@ -125,6 +132,9 @@ class LightManager {
   /* Check whether light manager can use the object as a light-emissive. */
   bool object_usable_as_light(Object *object);
 
+  /* Light tree bounds of lights with a finite position. */
+  LightTreeEmitter light_tree_emitter(Light *light);
+
   struct IESSlot {
     IESFile ies;
     uint hash;
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of buckets along each axis for binned splits. */
+#define LIGHT_TREE_NUM_BUCKETS 12
+/* Beyond this depth nodes are split in the middle, to bound the depth of degenerate trees. */
+#define LIGHT_TREE_MAX_SAOH_DEPTH 48
+
+/* Orientation Bounds
+ *
+ * Based on "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Conty Estevez and Kulla, 2018. */
+
+float LightTreeOrientation::measure() const
+{
+  const float theta_w = min(theta_o + theta_e, M_PI_F);
+  const float cos_theta_o = cosf(theta_o);
+  const float sin_theta_o = sinf(theta_o);
+
+  return M_2PI_F * (1.0f - cos_theta_o) +
+         M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                     2.0f * theta_o * sin_theta_o + cos_theta_o);
+}
+
+LightTreeOrientation LightTreeOrientation::merge(const LightTreeOrientation &a_,
+                                                 const LightTreeOrientation &b_)
+{
+  const bool swap = (b_.theta_o > a_.theta_o);
+  const LightTreeOrientation &a = swap ? b_ : a_;
+  const LightTreeOrientation &b = swap ? a_ : b_;
+
+  const float theta_d = safe_acosf(dot(a.axis, b.axis));
+  const float theta_e = max(a.theta_e, b.theta_e);
+
+  /* Bounds of b are fully contained in bounds of a. */
+  if (min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    return LightTreeOrientation(a.axis, a.theta_o, theta_e);
+  }
+
+  const float theta_o = 0.5f * (a.theta_o + theta_d + b.theta_o);
+  if (theta_o >= M_PI_F) {
+    return LightTreeOrientation(a.axis, M_PI_F, theta_e);
+  }
+
+  /* Rotate the axis of a towards b, so the cone just covers both. */
+  const float theta_r = theta_o - a.theta_o;
+  float3 ortho = b.axis - a.axis * dot(a.axis, b.axis);
+  if (len_squared(ortho) < 1e-12f) {
+    /* Opposite axes, any perpendicular direction will do. */
+    float3 unused;
+    make_orthonormals(a.axis, &ortho, &unused);
+  }
+  else {
+    ortho = normalize(ortho);
+  }
+  const float3 axis = a.axis * cosf(theta_r) + ortho * sinf(theta_r);
+
+  return LightTreeOrientation(normalize(axis), theta_o, theta_e);
+}
+
+/* Light Tree */
+
+LightTree::LightTree(vector<LightTreeEmitter> &emitters, int num_distribution)
+    : emitters(emitters)
+{
+  emitter_nodes.resize(num_distribution, LIGHT_TREE_NONE);
+
+  if (emitters.empty()) {
+    return;
+  }
+
+  nodes.reserve(2 * emitters.size() - 1);
+  recursive_build(0, emitters.size(), -1, 0);
+}
+
+int LightTree::recursive_build(int begin, int end, int parent, int depth)
+{
+  BoundBox bbox = BoundBox::empty;
+  BoundBox centroid_bounds = BoundBox::empty;
+  LightTreeOrientation orientation;
+  bool has_orientation = false;
+  float energy = 0.0f;
+
+  for (int i = begin; i < end; i++) {
+    const LightTreeEmitter &emitter = emitters[i];
+
+    bbox.grow(emitter.bbox);
+    centroid_bounds.grow(emitter.centroid());
+    energy += emitter.energy;
+
+    /* Emitters without energy are never picked, so they should not widen the bounds. */
+    if (emitter.energy > 0.0f) {
+      orientation = has_orientation ?
+                        LightTreeOrientation::merge(orientation, emitter.orientation) :
+                        emitter.orientation;
+      has_orientation = true;
+    }
+  }
+
+  const int node_index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  int child;
+  if (end - begin == 1) {
+    const int distribution_index = emitters[begin].distribution_index;
+    emitter_nodes[distribution_index] = node_index;
+    child = ~distribution_index;
+  }
+  else {
+    int mid = begin;
+    if (depth < LIGHT_TREE_MAX_SAOH_DEPTH) {
+      mid = find_split(begin, end, centroid_bounds, bbox, orientation);
+    }
+
+    if (mid <= begin || mid >= end) {
+      /* No useful split found, split in the middle along the largest axis. */
+      const float3 extent = centroid_bounds.size();
+      const int dim = (extent.x >= extent.y && extent.x >= extent.z) ?
+                          0 :
+                          (extent.y >= extent.z) ? 1 : 2;
+      mid = (begin + end) / 2;
+      std::nth_element(emitters.begin() + begin,
+                       emitters.begin() + mid,
+                       emitters.begin() + end,
+                       [dim](const LightTreeEmitter &a, const LightTreeEmitter &b) {
+                         return a.centroid()[dim] < b.centroid()[dim];
+                       });
+    }
+
+    recursive_build(begin, mid, node_index, depth + 1);
+    child = recursive_build(mid, end, node_index, depth + 1);
+  }
+
+  KernelLightTreeNode &knode = nodes[node_index];
+  knode.bbox_min[0] = bbox.min.x;
+  knode.bbox_min[1] = bbox.min.y;
+  knode.bbox_min[2] = bbox.min.z;
+  knode.energy = energy;
+  knode.bbox_max[0] = bbox.max.x;
+  knode.bbox_max[1] = bbox.max.y;
+  knode.bbox_max[2] = bbox.max.z;
+  knode.theta_o = orientation.theta_o;
+  knode.axis[0] = orientation.axis.x;
+  knode.axis[1] = orientation.axis.y;
+  knode.axis[2] = orientation.axis.z;
+  knode.theta_e = orientation.theta_e;
+  knode.child = child;
+  knode.parent = parent;
+
+  return node_index;
+}
+
+/* Binned split using the surface area orientation heuristic, returns the index of the first
+ * emitter in the second child, or begin if no split was found. */
+int LightTree::find_split(int begin,
+                          int end,
+                          const BoundBox &centroid_bounds,
+                          const BoundBox &bbox,
+                          const LightTreeOrientation &orientation)
+{
+  struct Bucket {
+    BoundBox bbox;
+    LightTreeOrientation orientation;
+    float energy;
+    int count;
+
+    Bucket() : bbox(BoundBox::empty), energy(0.0f), count(0)
+    {
+    }
+
+    void add(const BoundBox &other_bbox,
+             const LightTreeOrientation &other_orientation,
+             float other_energy,
+             int other_count)
+    {
+      bbox.grow(other_bbox);
+      if (other_energy > 0.0f) {
+        orientation = (energy > 0.0f) ?
+                          LightTreeOrientation::merge(orientation, other_orientation) :
+                          other_orientation;
+      }
+      energy += other_energy;
+      count += other_count;
+    }
+
+    float cost() const
+    {
+      return (count) ? energy * orientation.measure() * bbox.area() : 0.0f;
+    }
+  };
+
+  const float3 extent = centroid_bounds.size();
+  const float max_extent = max3(extent);
+  const float node_cost = orientation.measure() * bbox.area();
+
+  float best_cost = FLT_MAX;
+  int best_dim = -1;
+  int best_bucket = 0;
+
+  for (int dim = 0; dim < 3; dim++) {
+    if (extent[dim] == 0.0f) {
+      continue;
+    }
+
+    Bucket buckets[LIGHT_TREE_NUM_BUCKETS];
+    const float inv_extent = 1.0f / extent[dim];
+
+    for (int i = begin; i < end; i++) {
+      const LightTreeEmitter &emitter = emitters[i];
+      const float t = (emitter.centroid()[dim] - centroid_bounds.min[dim]) * inv_extent;
+      const int b = clamp((int)(t * LIGHT_TREE_NUM_BUCKETS), 0, LIGHT_TREE_NUM_BUCKETS - 1);
+      buckets[b].add(emitter.bbox, emitter.orientation, emitter.energy, 1);
+    }
+
+    /* Sweep from the right to get costs of all right sides, then from the left. */
+    float right_cost[LIGHT_TREE_NUM_BUCKETS];
+    Bucket right;
+    for (int b = LIGHT_TREE_NUM_BUCKETS - 1; b > 0; b--) {
+      right.add(buckets[b].bbox, buckets[b].orientation, buckets[b].energy, buckets[b].count);
+      right_cost[b] = right.count ? right.cost() : -1.0f;
+    }
+
+    /* Penalize splits along thin axes, which tend to produce elongated nodes. */
+    const float regularization = max_extent * inv_extent;
+
+    Bucket left;
+    for (int b = 1; b < LIGHT_TREE_NUM_BUCKETS; b++) {
+      left.add(buckets[b - 1].bbox,
+               buckets[b - 1].orientation,
+               buckets[b - 1].energy,
+               buckets[b - 1].count);
+      if (left.count == 0 || right_cost[b] < 0.0f) {
+        continue;
+      }
+
+      float cost = regularization * (left.cost() + right_cost[b]);
+      if (node_cost > 0.0f) {
+        cost /= node_cost;
+      }
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_dim = dim;
+        best_bucket = b;
+      }
+    }
+  }
+
+  if (best_dim == -1) {
+    return begin;
+  }
+
+  const float min = centroid_bounds.min[best_dim];
+  const float inv_extent = 1.0f / extent[best_dim];
+  LightTreeEmitter *middle = std::partition(
+      &emitters[0] + begin, &emitters[0] + end, [&](const LightTreeEmitter &emitter) {
+        const float t = (emitter.centroid()[best_dim] - min) * inv_extent;
+        const int b = clamp((int)(t * LIGHT_TREE_NUM_BUCKETS), 0, LIGHT_TREE_NUM_BUCKETS - 1);
+        return b < best_bucket;
+      });
+
+  return middle - &emitters[0];
+}
+
+CCL_NAMESPACE_END
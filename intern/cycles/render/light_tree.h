@@ -0,0 +1,105 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds on the directions in which light is emitted. Emitter normals lie within theta_o of
+ * the axis, and light leaves the emitter within theta_e of its normal. */
+struct LightTreeOrientation {
+  float3 axis;
+  float theta_o;
+  float theta_e;
+
+  LightTreeOrientation() : axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f)
+  {
+  }
+
+  LightTreeOrientation(const float3 &axis, float theta_o, float theta_e)
+      : axis(axis), theta_o(theta_o), theta_e(theta_e)
+  {
+  }
+
+  /* Measure of the solid angle covered by the bounds, used by the build heuristic. */
+  float measure() const;
+
+  static LightTreeOrientation merge(const LightTreeOrientation &a,
+                                    const LightTreeOrientation &b);
+};
+
+/* Light or emissive triangle with finite position, as seen by the light tree. */
+struct LightTreeEmitter {
+  BoundBox bbox;
+  LightTreeOrientation orientation;
+  float energy;
+  /* Index into the light distribution, which stores the light or triangle. */
+  int distribution_index;
+
+  LightTreeEmitter() : bbox(BoundBox::empty), energy(0.0f), distribution_index(0)
+  {
+  }
+
+  float3 centroid() const
+  {
+    return bbox.center();
+  }
+};
+
+/* Bounding volume hierarchy over emitters, storing bounds, orientation and energy of its
+ * emitters in every node, so the kernel can pick emitters proportional to their estimated
+ * contribution to a shading point.
+ *
+ * Nodes are laid out depth first: the first child of an inner node directly follows it. */
+class LightTree {
+ public:
+  LightTree(vector<LightTreeEmitter> &emitters, int num_distribution);
+
+  const vector<KernelLightTreeNode> &get_nodes() const
+  {
+    return nodes;
+  }
+
+  /* Node index for every light distribution index, LIGHT_TREE_NONE for emitters which are
+   * not part of the tree. */
+  const vector<uint> &get_emitter_nodes() const
+  {
+    return emitter_nodes;
+  }
+
+ protected:
+  int recursive_build(int begin, int end, int parent, int depth);
+  int find_split(int begin,
+                 int end,
+                 const BoundBox &centroid_bounds,
+                 const BoundBox &bbox,
+                 const LightTreeOrientation &orientation);
+
+  vector<LightTreeEmitter> &emitters;
+  vector<KernelLightTreeNode> nodes;
+  vector<uint> emitter_nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
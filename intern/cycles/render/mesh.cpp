@@ -414,6 +414,7 @@ Mesh::Mesh() : Node(node_type)
 {
   need_update = true;
   need_update_rebuild = false;
+  need_update_bvh = true;
   transform_applied = false;
   transform_negative_scaled = false;
   transform_normal = transform_identity();
@@ -433,6 +434,8 @@ Mesh::Mesh() : Node(node_type)
 
   attr_map_offset = 0;
 
+  object_mesh_index = 0;
+
   num_subd_verts = 0;
 
   attributes.triangle_mesh = this;
@@ -1013,7 +1016,9 @@ void Mesh::compute_bvh(
 
   compute_bounds();
 
-  if (need_build_bvh()) {
+  /* Displacement shaders may depend on attributes, so their geometry can change even when
+   * only attributes were updated. */
+  if (need_build_bvh() && (!bvh || need_update_bvh || has_true_displacement())) {
     string msg = "Updating Mesh BVH ";
     if (name == "")
       msg += string_printf("%u/%u", (uint)(n + 1), (uint)total);
@@ -1040,6 +1045,7 @@ void Mesh::compute_bvh(
                                                       device->get_bvh_layout_mask());
       bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                     params->use_bvh_unaligned_nodes;
+      bparams.use_compressed_nodes = params->use_bvh_compressed_nodes;
       bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
       bparams.num_motion_curve_steps = params->num_bvh_time_steps;
       bparams.bvh_type = params->bvh_type;
@@ -1054,21 +1060,28 @@ void Mesh::compute_bvh(
 
   need_update = false;
   need_update_rebuild = false;
+  need_update_bvh = false;
 }
 
 void Mesh::tag_update(Scene *scene, bool rebuild)
 {
-  need_update = true;
+  need_update_bvh = true;
 
   if (rebuild) {
     need_update_rebuild = true;
     scene->light_manager->need_update = true;
   }
-  else {
-    foreach (Shader *shader, used_shaders)
-      if (shader->has_surface_emission)
-        scene->light_manager->need_update = true;
-  }
+
+  tag_update_attributes(scene);
+}
+
+void Mesh::tag_update_attributes(Scene *scene)
+{
+  need_update = true;
+
+  foreach (Shader *shader, used_shaders)
+    if (shader->has_surface_emission)
+      scene->light_manager->need_update = true;
 
   scene->mesh_manager->need_update = true;
   scene->object_manager->need_update = true;
@@ -1898,6 +1911,7 @@ void MeshManager::device_update_bvh(Device *device,
   bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
   bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                 scene->params.use_bvh_unaligned_nodes;
+  bparams.use_compressed_nodes = scene->params.use_bvh_compressed_nodes;
   bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
   bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
   bparams.bvh_type = scene->params.bvh_type;
@@ -2310,6 +2324,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
   dscene->attributes_float2.free();
   dscene->attributes_float3.free();
   dscene->attributes_uchar4.free();
+  dscene->object_meshes.free();
 
 #ifdef WITH_OSL
   OSLGlobals *og = (OSLGlobals *)device->osl_memory();
@@ -252,6 +252,8 @@ class Mesh : public Node {
   /* Update Flags */
   bool need_update;
   bool need_update_rebuild;
+  /* Positions or topology changed, only attributes changed otherwise. */
+  bool need_update_bvh;
 
   /* BVH */
   BVH *bvh;
@@ -268,6 +270,10 @@ class Mesh : public Node {
 
   size_t attr_map_offset;
 
+  /* Index of the mesh record shared by all objects instancing this mesh. Gets set in
+   * ObjectManager::device_update. */
+  int object_mesh_index;
+
   size_t num_subd_verts;
 
   /* Functions */
@@ -315,6 +321,7 @@ class Mesh : public Node {
   bool need_attribute(Scene *scene, ustring name);
 
   void tag_update(Scene *scene, bool rebuild);
+  void tag_update_attributes(Scene *scene);
 
   bool has_motion_blur() const;
   bool has_true_displacement() const;
@@ -291,6 +291,27 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
   ShaderNode::attributes(shader, attributes);
 }
 
+/* Vector input is the default UV map without mapping, so its derivatives are known to the
+ * kernel and can be used to filter the image. */
+static bool image_vector_is_default_uv(ShaderInput *vector_in, TextureMapping &tex_mapping)
+{
+  if (!tex_mapping.skip() || vector_in->link == NULL) {
+    return false;
+  }
+
+  ShaderOutput *link = vector_in->link;
+  if (link->parent->type == TextureCoordinateNode::node_type) {
+    const TextureCoordinateNode *texco = (const TextureCoordinateNode *)link->parent;
+    return link->name() == "UV" && !texco->from_dupli;
+  }
+  else if (link->parent->type == UVMapNode::node_type) {
+    const UVMapNode *uvmap = (const UVMapNode *)link->parent;
+    return uvmap->attribute.empty() && !uvmap->from_dupli;
+  }
+
+  return false;
+}
+
 void ImageTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
@@ -330,6 +351,9 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
         flags |= NODE_IMAGE_ALPHA_UNASSOCIATE;
       }
     }
+    if (image_vector_is_default_uv(vector_in, tex_mapping)) {
+      flags |= NODE_IMAGE_DEFAULT_UV;
+    }
 
     if (projection != NODE_IMAGE_PROJ_BOX) {
       compiler.add_node(NODE_TEX_IMAGE,
@@ -438,31 +438,26 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   }
 
   if (state->need_motion == Scene::MOTION_PASS) {
-    /* Clear motion array if there is no actual motion. */
-    ob->update_motion();
-
-    /* Compute motion transforms. */
-    Transform tfm_pre, tfm_post;
+    /* Compute motion transforms. Without motion these are the object transform or
+     * identity, which the kernel derives from the object flags instead of storing
+     * them for every instance. */
     if (ob->use_motion()) {
-      tfm_pre = ob->motion[0];
-      tfm_post = ob->motion[ob->motion.size() - 1];
-    }
-    else {
-      tfm_pre = tfm;
-      tfm_post = tfm;
-    }
+      Transform tfm_pre = ob->motion[0];
+      Transform tfm_post = ob->motion[ob->motion.size() - 1];
+
+      /* Motion transformations, is world/object space depending if mesh
+       * comes with deformed position in object space, or if we transform
+       * the shading point in world space. */
+      if (!mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION)) {
+        tfm_pre = tfm_pre * itfm;
+        tfm_post = tfm_post * itfm;
+      }
 
-    /* Motion transformations, is world/object space depending if mesh
-     * comes with deformed position in object space, or if we transform
-     * the shading point in world space. */
-    if (!mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION)) {
-      tfm_pre = tfm_pre * itfm;
-      tfm_post = tfm_post * itfm;
+      kobject.motion_offset = state->motion_offset[ob->index];
+      object_motion_pass[kobject.motion_offset + 0] = tfm_pre;
+      object_motion_pass[kobject.motion_offset + 1] = tfm_post;
+      flag |= SD_OBJECT_MOTION_PASS;
     }
-
-    int motion_pass_offset = ob->index * OBJECT_MOTION_PASS_SIZE;
-    object_motion_pass[motion_pass_offset + 0] = tfm_pre;
-    object_motion_pass[motion_pass_offset + 1] = tfm_post;
   }
   else if (state->need_motion == Scene::MOTION_BLUR) {
     if (ob->use_motion()) {
@@ -480,14 +475,11 @@ void ObjectManager::device_update_object_transform(UpdateObjectTransformState *s
   kobject.dupli_generated[0] = ob->dupli_generated[0];
   kobject.dupli_generated[1] = ob->dupli_generated[1];
   kobject.dupli_generated[2] = ob->dupli_generated[2];
-  kobject.numkeys = mesh->curve_keys.size();
   kobject.dupli_uv[0] = ob->dupli_uv[0];
   kobject.dupli_uv[1] = ob->dupli_uv[1];
   int totalsteps = mesh->motion_steps;
   kobject.numsteps = (totalsteps - 1) / 2;
-  kobject.numverts = mesh->verts.size();
-  kobject.patch_map_offset = 0;
-  kobject.attribute_map_offset = 0;
+  kobject.mesh = mesh->object_mesh_index;
   uint32_t hash_name = util_murmur_hash3(ob->name.c_str(), ob->name.length(), 0);
   uint32_t hash_asset = util_murmur_hash3(ob->asset_name.c_str(), ob->asset_name.length(), 0);
   kobject.cryptomatte_object = util_hash_to_float(hash_name);
@@ -555,8 +547,23 @@ void ObjectManager::device_update_transforms(DeviceScene *dscene, Scene *scene,
   state.object_motion_pass = NULL;
 
   if (state.need_motion == Scene::MOTION_PASS) {
-    state.object_motion_pass = dscene->object_motion_pass.alloc(OBJECT_MOTION_PASS_SIZE *
-                                                                scene->objects.size());
+    /* Set object offsets into global object motion pass array, only objects
+     * with motion store their transforms. */
+    uint *motion_offsets = state.motion_offset.resize(scene->objects.size());
+    uint motion_offset = 0;
+
+    foreach (Object *ob, scene->objects) {
+      *motion_offsets = motion_offset;
+      motion_offsets++;
+
+      /* Clear motion array if there is no actual motion. */
+      ob->update_motion();
+      if (ob->use_motion()) {
+        motion_offset += OBJECT_MOTION_PASS_SIZE;
+      }
+    }
+
+    state.object_motion_pass = dscene->object_motion_pass.alloc(motion_offset);
   }
   else if (state.need_motion == Scene::MOTION_BLUR) {
     /* Set object offsets into global object motion array. */
@@ -642,6 +649,12 @@ void ObjectManager::device_update(Device *device,
     object->index = index++;
   }
 
+  /* Assign mesh record IDs, filled in by device_update_mesh_offsets. */
+  index = 0;
+  foreach (Mesh *mesh, scene->meshes) {
+    mesh->object_mesh_index = index++;
+  }
+
   /* set object transform matrices, before applying static transforms */
   progress.set_status("Updating Objects", "Copying Transformations to device");
   device_update_transforms(dscene, scene, progress);
@@ -734,33 +747,26 @@ void ObjectManager::device_update_mesh_offsets(Device *, DeviceScene *dscene, Sc
     return;
   }
 
-  KernelObject *kobjects = dscene->objects.data();
+  /* Mesh data is stored once per mesh and shared by all objects instancing it,
+   * so this does not grow with the number of instances. */
+  KernelObjectMesh *kmeshes = dscene->object_meshes.alloc(scene->meshes.size());
 
-  bool update = false;
+  foreach (Mesh *mesh, scene->meshes) {
+    KernelObjectMesh &kmesh = kmeshes[mesh->object_mesh_index];
 
-  foreach (Object *object, scene->objects) {
-    Mesh *mesh = object->mesh;
+    kmesh.numkeys = mesh->curve_keys.size();
+    kmesh.numverts = mesh->verts.size();
+    kmesh.patch_map_offset = 0;
+    kmesh.attribute_map_offset = mesh->attr_map_offset;
 
     if (mesh->patch_table) {
-      uint patch_map_offset = 2 * (mesh->patch_table_offset + mesh->patch_table->total_size() -
-                                   mesh->patch_table->num_nodes * PATCH_NODE_SIZE) -
-                              mesh->patch_offset;
-
-      if (kobjects[object->index].patch_map_offset != patch_map_offset) {
-        kobjects[object->index].patch_map_offset = patch_map_offset;
-        update = true;
-      }
-    }
-
-    if (kobjects[object->index].attribute_map_offset != mesh->attr_map_offset) {
-      kobjects[object->index].attribute_map_offset = mesh->attr_map_offset;
-      update = true;
+      kmesh.patch_map_offset = 2 * (mesh->patch_table_offset + mesh->patch_table->total_size() -
+                                    mesh->patch_table->num_nodes * PATCH_NODE_SIZE) -
+                               mesh->patch_offset;
     }
   }
 
-  if (update) {
-    dscene->objects.copy_to_device();
-  }
+  dscene->object_meshes.copy_to_device();
 }
 
 void ObjectManager::device_free(Device *, DeviceScene *dscene)
@@ -60,6 +60,7 @@ DeviceScene::DeviceScene(Device *device)
       curve_keys(device, "__curve_keys", MEM_TEXTURE),
       patches(device, "__patches", MEM_TEXTURE),
       objects(device, "__objects", MEM_TEXTURE),
+      object_meshes(device, "__object_meshes", MEM_TEXTURE),
       object_motion_pass(device, "__object_motion_pass", MEM_TEXTURE),
       object_motion(device, "__object_motion", MEM_TEXTURE),
       object_flag(device, "__object_flag", MEM_TEXTURE),
@@ -73,6 +74,10 @@ DeviceScene::DeviceScene(Device *device)
       lights(device, "__lights", MEM_TEXTURE),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+      light_tree_emitter_node(device, "__light_tree_emitter_node", MEM_TEXTURE),
+      light_tree_object_offset(device, "__light_tree_object_offset", MEM_TEXTURE),
+      light_tree_tri_rank(device, "__light_tree_tri_rank", MEM_TEXTURE),
       particles(device, "__particles", MEM_TEXTURE),
       svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
       shaders(device, "__shaders", MEM_TEXTURE),
@@ -14,11 +14,13 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <limits.h>
 
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "device/device.h"
 #include "render/graph.h"
 #include "render/integrator.h"
@@ -33,12 +35,21 @@
 #include "util/util_function.h"
 #include "util/util_logging.h"
 #include "util/util_math.h"
+#include "util/util_md5.h"
 #include "util/util_opengl.h"
+#include "util/util_path.h"
 #include "util/util_task.h"
 #include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Checkpoint file layout: magic, header of ints, scene hash as hex digits, then the render
+ * buffer as floats. */
+static const char CHECKPOINT_MAGIC[8] = {'C', 'Y', 'C', 'L', 'C', 'K', 'P', 'T'};
+static const int CHECKPOINT_VERSION = 2;
+static const int CHECKPOINT_HEADER_SIZE = 12;
+static const int CHECKPOINT_HASH_SIZE = 32;
+
 /* Note about  preserve_tile_device option for tile manager:
  * progressive refine and viewport rendering does requires tiles to
  * always be allocated for the same device
@@ -77,6 +88,8 @@ Session::Session(const SessionParams &params_)
 
   reset_time = 0.0;
   last_update_time = 0.0;
+  last_checkpoint_time = 0.0;
+  checkpoint_restored = false;
 
   delayed_reset.do_reset = false;
   delayed_reset.samples = 0;
@@ -214,6 +227,14 @@ void Session::run_gpu()
 
   progress.set_render_start_time();
 
+  /* Buffers were already reset from the main thread, see reset_gpu(). */
+  if (params.checkpoint_resume) {
+    thread_scoped_lock buffers_lock(buffers_mutex);
+    read_checkpoint();
+  }
+
+  last_checkpoint_time = time_dt();
+
   while (!progress.get_cancel()) {
     /* advance to next tile */
     bool no_tiles = !tile_manager.next();
@@ -328,6 +349,8 @@ void Session::run_gpu()
 
       if (progress.get_cancel())
         break;
+
+      update_checkpoint();
     }
   }
 
@@ -556,8 +579,14 @@ void Session::run_cpu()
 
     reset_(delayed_reset.params, delayed_reset.samples);
     delayed_reset.do_reset = false;
+
+    if (params.checkpoint_resume) {
+      read_checkpoint();
+    }
   }
 
+  last_checkpoint_time = time_dt();
+
   while (!progress.get_cancel()) {
     /* advance to next tile */
     bool no_tiles = !tile_manager.next();
@@ -678,6 +707,10 @@ void Session::run_cpu()
         progress.set_error(device->error_message());
 
       tiles_written = update_progressive_refine(progress.get_cancel());
+
+      if (!no_tiles && !progress.get_cancel()) {
+        update_checkpoint();
+      }
     }
 
     progress.set_update();
@@ -1007,9 +1040,14 @@ void Session::update_status_time(bool show_pause, bool show_done)
 
 void Session::render()
 {
-  /* Clear buffers. */
+  /* Clear buffers, unless they were just restored from a checkpoint. */
   if (buffers && tile_manager.state.sample == tile_manager.range_start_sample) {
-    buffers->zero();
+    if (checkpoint_restored) {
+      checkpoint_restored = false;
+    }
+    else {
+      buffers->zero();
+    }
   }
 
   /* Add path trace task. */
@@ -1113,6 +1151,194 @@ bool Session::update_progressive_refine(bool cancel)
   return write;
 }
 
+void Session::update_checkpoint()
+{
+  /* Only full resolution passes of progressive rendering leave all pixels with the same
+   * number of samples, which is all the sampler needs to continue. */
+  if (params.checkpoint_path.empty() || !buffers || !params.progressive ||
+      tile_manager.state.resolution_divider != params.pixel_size) {
+    return;
+  }
+
+  const int num_samples = tile_manager.state.sample + tile_manager.state.num_samples;
+  if (num_samples <= 0) {
+    return;
+  }
+
+  /* Always write the last pass, so the render can be continued with more samples. */
+  double current_time = time_dt();
+  if (!tile_manager.done() && current_time - last_checkpoint_time < params.checkpoint_interval) {
+    return;
+  }
+
+  scoped_timer timer;
+  write_checkpoint(num_samples);
+  progress.add_skip_time(timer, params.background);
+
+  last_checkpoint_time = time_dt();
+}
+
+/* Hash of the scene file and of the settings given outside of it that change the render
+ * result. Computed once, the scene does not change during a background render. */
+string Session::checkpoint_scene_hash()
+{
+  if (checkpoint_hash.empty()) {
+    MD5Hash md5;
+
+    if (!params.checkpoint_scene_file.empty() && !md5.append_file(params.checkpoint_scene_file)) {
+      fprintf(stderr,
+              "Cycles checkpoint: failed to read scene file %s for hashing.\n",
+              params.checkpoint_scene_file.c_str());
+    }
+
+    /* Node::hash() of other nodes includes pointers to nodes, which differ between runs. */
+    scene->film->hash(md5);
+
+    checkpoint_hash = md5.get_hex();
+    assert(checkpoint_hash.size() == CHECKPOINT_HASH_SIZE);
+  }
+
+  return checkpoint_hash;
+}
+
+bool Session::write_checkpoint(int num_samples)
+{
+  BufferParams &buffer_params = buffers->params;
+  const int pass_stride = buffer_params.get_passes_size();
+  const size_t size = (size_t)buffer_params.width * buffer_params.height * pass_stride;
+
+  if (!buffers->copy_from_device()) {
+    return false;
+  }
+
+  const int header[CHECKPOINT_HEADER_SIZE] = {CHECKPOINT_VERSION,
+                                              buffer_params.width,
+                                              buffer_params.height,
+                                              buffer_params.full_x,
+                                              buffer_params.full_y,
+                                              buffer_params.full_width,
+                                              buffer_params.full_height,
+                                              pass_stride,
+                                              num_samples,
+                                              scene->integrator->seed,
+                                              scene->integrator->sampling_pattern,
+                                              tile_manager.num_samples};
+  const string scene_hash = checkpoint_scene_hash();
+
+  /* Write to a temporary file first, so an interrupted write never replaces the previous
+   * checkpoint with an incomplete one. */
+  const string temp_path = params.checkpoint_path + ".tmp";
+  path_create_directories(temp_path);
+
+  FILE *f = path_fopen(temp_path, "wb");
+  if (!f) {
+    fprintf(stderr, "Cycles checkpoint: failed to open %s for writing.\n", temp_path.c_str());
+    return false;
+  }
+
+  bool ok = fwrite(CHECKPOINT_MAGIC, sizeof(char), 8, f) == 8 &&
+            fwrite(header, sizeof(int), CHECKPOINT_HEADER_SIZE, f) == CHECKPOINT_HEADER_SIZE &&
+            fwrite(scene_hash.c_str(), sizeof(char), CHECKPOINT_HASH_SIZE, f) ==
+                CHECKPOINT_HASH_SIZE &&
+            fwrite(buffers->buffer.data(), sizeof(float), size, f) == size;
+  ok = (fclose(f) == 0) && ok;
+
+#ifdef _WIN32
+  /* Rename does not replace existing files on Windows. */
+  if (ok) {
+    path_remove(params.checkpoint_path);
+  }
+#endif
+
+  if (!ok || rename(temp_path.c_str(), params.checkpoint_path.c_str()) != 0) {
+    fprintf(stderr, "Cycles checkpoint: failed to write %s.\n", params.checkpoint_path.c_str());
+    path_remove(temp_path);
+    return false;
+  }
+
+  VLOG(1) << "Wrote checkpoint with " << num_samples << " samples to "
+          << params.checkpoint_path << ".";
+
+  return true;
+}
+
+bool Session::read_checkpoint()
+{
+  if (!buffers) {
+    return false;
+  }
+
+  FILE *f = path_fopen(params.checkpoint_path, "rb");
+  if (!f) {
+    fprintf(stderr,
+            "Cycles checkpoint: failed to open %s, rendering from the start.\n",
+            params.checkpoint_path.c_str());
+    return false;
+  }
+
+  BufferParams &buffer_params = buffers->params;
+  const int pass_stride = buffer_params.get_passes_size();
+  const size_t size = (size_t)buffer_params.width * buffer_params.height * pass_stride;
+
+  const Integrator *integrator = scene->integrator;
+  const string scene_hash = checkpoint_scene_hash();
+  char magic[8];
+  int header[CHECKPOINT_HEADER_SIZE];
+  char hash[CHECKPOINT_HASH_SIZE];
+
+  /* Sample indices must line up with the interrupted render, so only accept checkpoints of
+   * the exact same buffer layout, scene and random sequence. */
+  bool ok = fread(magic, sizeof(char), 8, f) == 8 &&
+            memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0 &&
+            fread(header, sizeof(int), CHECKPOINT_HEADER_SIZE, f) == CHECKPOINT_HEADER_SIZE &&
+            header[0] == CHECKPOINT_VERSION && header[1] == buffer_params.width &&
+            header[2] == buffer_params.height && header[3] == buffer_params.full_x &&
+            header[4] == buffer_params.full_y && header[5] == buffer_params.full_width &&
+            header[6] == buffer_params.full_height && header[7] == pass_stride && header[8] > 0 &&
+            header[9] == integrator->seed && header[10] == integrator->sampling_pattern &&
+            fread(hash, sizeof(char), CHECKPOINT_HASH_SIZE, f) == CHECKPOINT_HASH_SIZE &&
+            memcmp(hash, scene_hash.c_str(), CHECKPOINT_HASH_SIZE) == 0;
+
+  /* Correlated multi-jitter patterns depend on the total number of samples, Sobol sequences
+   * don't, so those renders can be continued with more samples. */
+  if (integrator->sampling_pattern == SAMPLING_PATTERN_CMJ) {
+    ok = ok && header[11] == tile_manager.num_samples;
+  }
+  else {
+    ok = ok && header[8] <= tile_manager.num_samples;
+  }
+
+  ok = ok && fread(buffers->buffer.data(), sizeof(float), size, f) == size;
+  fclose(f);
+
+  if (!ok) {
+    fprintf(stderr,
+            "Cycles checkpoint: %s does not match this render, rendering from the start.\n",
+            params.checkpoint_path.c_str());
+    buffers->zero();
+    return false;
+  }
+
+  buffers->buffer.copy_to_device();
+
+  /* Continue as if the pass for the last sample in the checkpoint just finished. The sample
+   * index is all the sampler needs to continue with the same random sequence. */
+  const int num_samples = header[8];
+  tile_manager.range_start_sample = num_samples;
+  tile_manager.state.sample = num_samples - 1;
+  tile_manager.state.num_samples = 1;
+  tile_manager.state.resolution_divider = params.pixel_size;
+
+  progress.add_samples((uint64_t)buffer_params.width * buffer_params.height * num_samples,
+                       num_samples);
+  checkpoint_restored = true;
+
+  VLOG(1) << "Resuming from checkpoint with " << num_samples << " samples from "
+          << params.checkpoint_path << ".";
+
+  return true;
+}
+
 void Session::device_free()
 {
   scene->device_free();
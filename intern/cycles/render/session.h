@@ -72,6 +72,15 @@ class SessionParams {
 
   ShadingSystem shadingsystem;
 
+  /* Progressive renders write their buffers to checkpoint_path every checkpoint_interval
+   * seconds, and with checkpoint_resume continue from the samples found in that file. */
+  string checkpoint_path;
+  double checkpoint_interval;
+  bool checkpoint_resume;
+  /* Scene description file, its contents are part of the hash that ties a checkpoint to
+   * the scene it was rendered from. */
+  string checkpoint_scene_file;
+
   function<bool(const uchar *pixels, int width, int height, int channels)> write_render_cb;
 
   SessionParams()
@@ -102,6 +111,9 @@ class SessionParams {
 
     shadingsystem = SHADINGSYSTEM_SVM;
     tile_order = TILE_CENTER;
+
+    checkpoint_interval = 300.0;
+    checkpoint_resume = false;
   }
 
   bool modified(const SessionParams &params)
@@ -221,6 +233,15 @@ class Session {
   double last_update_time;
   bool update_progressive_refine(bool cancel);
 
+  /* checkpoints */
+  double last_checkpoint_time;
+  bool checkpoint_restored;
+  void update_checkpoint();
+  bool write_checkpoint(int num_samples);
+  bool read_checkpoint();
+  string checkpoint_scene_hash();
+  string checkpoint_hash;
+
   DeviceRequestedFeatures get_requested_device_features();
 
   /* ** Split kernel routines ** */
@@ -315,6 +315,9 @@ class RENDER_PT_output_options(RenderOutputButtonsPanel, Panel):
         col.active = not rd.is_movie_format
         col.prop(rd, "use_placeholder")
         col = flow.column()
+        col.active = not rd.is_movie_format
+        col.prop(rd, "use_background_write")
+        col = flow.column()
         col.prop(rd, "use_file_extension")
         col = flow.column()
         col.prop(rd, "use_render_cache")
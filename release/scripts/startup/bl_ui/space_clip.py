@@ -1266,6 +1266,35 @@ class CLIP_PT_footage(CLIP_PT_clip_view_panel, Panel):
         col.template_movieclip_information(sc, "clip", sc.clip_user)
 
 
+class CLIP_PT_cache(CLIP_PT_clip_view_panel, Panel):
+    bl_space_type = 'CLIP_EDITOR'
+    bl_region_type = 'UI'
+    bl_category = "Footage"
+    bl_label = "Cache"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        stats = context.space_data.clip.cache_statistics
+
+        col = layout.column(align=True)
+        col.prop(stats, "hits")
+        col.prop(stats, "misses")
+        col.prop(stats, "hit_ratio", slider=True)
+
+        col = layout.column(align=True)
+        col.prop(stats, "items")
+        col.prop(stats, "memory", text="Memory (MB)")
+        col.prop(stats, "evicted")
+
+        col = layout.column(align=True)
+        col.prop(stats, "average_cost", text="Average Cost (ms)")
+        col.prop(stats, "weight")
+
+
 class CLIP_PT_tools_scenesetup(Panel):
     bl_space_type = 'CLIP_EDITOR'
     bl_region_type = 'TOOLS'
@@ -1760,6 +1789,7 @@ classes = (
     CLIP_PT_marker,
     CLIP_PT_proxy,
     CLIP_PT_footage,
+    CLIP_PT_cache,
     CLIP_PT_stabilization,
     CLIP_PT_mask,
     CLIP_PT_mask_layers,
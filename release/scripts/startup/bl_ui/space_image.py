@@ -1119,6 +1119,40 @@ class IMAGE_PT_render_slots(Panel):
         col.operator("image.clear_render_slot", icon='X', text="")
 
 
+class IMAGE_PT_image_cache(Panel):
+    bl_space_type = 'IMAGE_EDITOR'
+    bl_region_type = 'UI'
+    bl_category = "Image"
+    bl_label = "Cache"
+    bl_options = {'DEFAULT_CLOSED'}
+
+    @classmethod
+    def poll(cls, context):
+        sima = context.space_data
+        return (sima and sima.image)
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        stats = context.space_data.image.cache_statistics
+
+        col = layout.column(align=True)
+        col.prop(stats, "hits")
+        col.prop(stats, "misses")
+        col.prop(stats, "hit_ratio", slider=True)
+
+        col = layout.column(align=True)
+        col.prop(stats, "items")
+        col.prop(stats, "memory", text="Memory (MB)")
+        col.prop(stats, "evicted")
+
+        col = layout.column(align=True)
+        col.prop(stats, "average_cost", text="Average Cost (ms)")
+        col.prop(stats, "weight")
+
+
 class IMAGE_PT_paint(Panel, ImagePaintPanel):
     bl_label = "Brush"
     bl_context = ".paint_common_2d"
@@ -1888,6 +1922,7 @@ classes = (
     IMAGE_PT_image_properties,
     IMAGE_UL_render_slots,
     IMAGE_PT_render_slots,
+    IMAGE_PT_image_cache,
     IMAGE_PT_view_display,
     IMAGE_PT_view_display_uv_edit_overlays,
     IMAGE_PT_view_display_uv_edit_overlays_stretch,
@@ -265,6 +265,7 @@ class SEQUENCER_MT_view(Menu):
             layout.prop(st, "show_frame_indicator")
             layout.prop(st, "show_strip_offset")
             layout.prop(st, "show_marker_lines")
+            layout.prop(st, "show_strip_render_time")
 
             layout.separator()
 
@@ -1628,6 +1629,9 @@ class SEQUENCER_PT_cache_settings(SequencerButtonsPanel, Panel):
         layout.prop(ed, "use_cache_composite")
         layout.prop(ed, "use_cache_final")
         layout.separator()
+        layout.prop(ed, "use_prefetch")
+        layout.prop(ed, "use_disk_cache")
+        layout.prop(context.scene.render, "use_sequencer_parallel_render")
         layout.prop(ed, "recycle_max_cost")
 
 
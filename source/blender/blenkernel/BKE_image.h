@@ -35,6 +35,7 @@ struct ImageFormatData;
 struct ImagePool;
 struct ImbFormatOptions;
 struct Main;
+struct MovieCacheStats;
 struct Object;
 struct RenderResult;
 struct ReportList;
@@ -248,6 +249,7 @@ bool BKE_image_is_multilayer(struct Image *ima);
 bool BKE_image_is_multiview(struct Image *ima);
 bool BKE_image_is_stereo(struct Image *ima);
 struct RenderResult *BKE_image_acquire_renderresult(struct Scene *scene, struct Image *ima);
+void BKE_image_multilayer_load_passes(struct Image *ima);
 void BKE_image_release_renderresult(struct Scene *scene, struct Image *ima);
 
 /* for multilayer images as well as for singlelayer */
@@ -331,6 +333,7 @@ void BKE_image_file_format_set(struct Image *image,
                                int ftype,
                                const struct ImbFormatOptions *options);
 bool BKE_image_has_loaded_ibuf(struct Image *image);
+bool BKE_image_get_cache_stats(struct Image *image, struct MovieCacheStats *r_stats);
 struct ImBuf *BKE_image_get_ibuf_with_name(struct Image *image, const char *name);
 struct ImBuf *BKE_image_get_first_ibuf(struct Image *image);
 
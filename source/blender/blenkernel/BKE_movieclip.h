@@ -27,6 +27,7 @@
 struct Depsgraph;
 struct ImBuf;
 struct Main;
+struct MovieCacheStats;
 struct MovieClip;
 struct MovieClipScopes;
 struct MovieClipUser;
@@ -49,6 +50,7 @@ struct MovieClip *BKE_movieclip_file_add_exists(struct Main *bmain, const char *
 void BKE_movieclip_reload(struct Main *bmain, struct MovieClip *clip);
 void BKE_movieclip_clear_cache(struct MovieClip *clip);
 void BKE_movieclip_clear_proxy_cache(struct MovieClip *clip);
+bool BKE_movieclip_get_cache_stats(struct MovieClip *clip, struct MovieCacheStats *r_stats);
 
 void BKE_movieclip_convert_multilayer_ibuf(struct ImBuf *ibuf);
 
@@ -96,7 +96,10 @@ typedef struct SeqRenderData {
   float motion_blur_shutter;
   bool skip_cache;
   bool is_proxy_render;
+  bool is_prefetch_render;
   int view_id;
+  /* ID of task for assigning temp cache entries to particular task(thread, etc.) */
+  int task_id;
 
   /* special case for OpenGL render */
   struct GPUOffScreen *gpu_offscreen;
@@ -104,6 +107,12 @@ typedef struct SeqRenderData {
   // bool gpu_full_samples;
 } SeqRenderData;
 
+/* SeqRenderData.task_id */
+enum {
+  SEQ_TASK_MAIN_RENDER = 0,
+  SEQ_TASK_PREFETCH_RENDER = 1,
+};
+
 void BKE_sequencer_new_render_data(struct Main *bmain,
                                    struct Depsgraph *depsgraph,
                                    struct Scene *scene,
@@ -327,11 +336,29 @@ void BKE_sequencer_cache_cleanup_sequence(struct Scene *scene,
                                           struct Sequence *seq,
                                           struct Sequence *seq_changed,
                                           int invalidate_types);
+bool BKE_sequencer_cache_is_full(struct Scene *scene);
+void BKE_sequencer_disk_cache_free(void);
 void BKE_sequencer_cache_iterate(
     struct Scene *scene,
     void *userdata,
     bool callback(void *userdata, struct Sequence *seq, int cfra, int cache_type, float cost));
 
+/* **********************************************************************
+ * seqprefetch.c
+ *
+ * Sequencer frame prefetching
+ * ********************************************************************** */
+
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, float cost);
+void BKE_sequencer_prefetch_stop(struct Scene *scene);
+void BKE_sequencer_prefetch_stop_all(struct Main *bmain);
+void BKE_sequencer_prefetch_free(struct Scene *scene);
+bool BKE_sequencer_prefetch_need_redraw(struct Main *bmain, struct Scene *scene);
+struct Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context);
+struct Sequence *BKE_sequencer_prefetch_get_original_sequence(struct Sequence *seq,
+                                                              struct Scene *scene);
+SeqRenderData *BKE_sequencer_prefetch_get_original_context(const SeqRenderData *context);
+
 /* **********************************************************************
  * seqeffects.c
  *
@@ -52,7 +52,7 @@ typedef struct bMovieHandle {
                       int recty,
                       const char *suffix,
                       struct ReportList *reports);
-  void (*end_movie)(void *context_v);
+  void (*end_movie)(void *context_v, struct ReportList *reports);
   void (*get_movie_path)(char *string,
                          struct RenderData *rd,
                          bool preview,
@@ -68,7 +68,7 @@ int BKE_ffmpeg_start(void *context_v,
                      struct ReportList *reports,
                      bool preview,
                      const char *suffix);
-void BKE_ffmpeg_end(void *context_v);
+void BKE_ffmpeg_end(void *context_v, struct ReportList *reports);
 int BKE_ffmpeg_append(void *context_v,
                       struct RenderData *rd,
                       int start_frame,
@@ -99,9 +99,19 @@
 static CLG_LogRef LOG = {"bke.image"};
 static SpinLock image_spin;
 
+/* Passes of lazily loaded multilayer files are read without holding image_spin,
+ * one at a time. While reading, the exrhandle is taken out of the render result
+ * so freeing the image buffers doesn't close the file under the reader. */
+static ThreadMutex image_multilayer_read_lock = BLI_MUTEX_INITIALIZER;
+static RenderResult *image_multilayer_read_rr = NULL;
+
 /* prototypes */
 static int image_num_files(struct Image *ima);
 static ImBuf *image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock);
+static RenderPass *image_multilayer_pending_pass(Image *ima,
+                                                 ImageUser *iuser,
+                                                 RenderLayer **r_rl);
+static bool image_multilayer_read_pass(Image *ima, ImageUser *iuser);
 static void image_update_views_format(Image *ima, ImageUser *iuser);
 static void image_add_view(Image *ima, const char *viewname, const char *filepath);
 
@@ -242,6 +252,9 @@ void BKE_image_free_buffers_ex(Image *ima, bool do_lock)
   image_free_anims(ima);
 
   if (ima->rr) {
+    if (ima->rr == image_multilayer_read_rr) {
+      image_multilayer_read_rr = NULL;
+    }
     RE_FreeRenderResult(ima->rr);
     ima->rr = NULL;
   }
@@ -3462,6 +3475,20 @@ RenderResult *BKE_image_acquire_renderresult(Scene *scene, Image *ima)
   return rr;
 }
 
+/* Read all passes of a lazily loaded multilayer image which aren't read yet,
+ * waits for passes read by other threads, see image_multilayer_read_pass. */
+void BKE_image_multilayer_load_passes(Image *ima)
+{
+  if (ima->type != IMA_TYPE_MULTILAYER || ima->rr == NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&image_multilayer_read_lock);
+  RE_MultilayerLoadPasses(
+      ima->rr, ima->colorspace_settings.name, ima->alpha_mode == IMA_ALPHA_PREMUL);
+  BLI_mutex_unlock(&image_multilayer_read_lock);
+}
+
 void BKE_image_release_renderresult(Scene *scene, Image *ima)
 {
   if (ima->rr) {
@@ -3558,7 +3585,42 @@ static void image_add_view(Image *ima, const char *viewname, const char *filepat
 /* after imbuf load, openexr type can return with a exrhandle open */
 /* in that case we have to build a render-result */
 #ifdef WITH_OPENEXR
-static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
+static int imbuf_alpha_flags_for_image(Image *ima);
+
+/* Load a multilayer file with all its passes, used when a file loaded with
+ * IB_multilayer_lazy can't be opened again to read the passes on demand. */
+static RenderResult *image_load_multilayer_full(Image *ima, const char *filepath)
+{
+  RenderResult *rr = NULL;
+  ImBuf *ibuf;
+  int flag;
+
+  flag = IB_rect | IB_multilayer;
+  flag |= imbuf_alpha_flags_for_image(ima);
+
+  ibuf = IMB_loadiffname(filepath, flag, ima->colorspace_settings.name);
+  if (ibuf == NULL) {
+    return NULL;
+  }
+
+  if (ibuf->ftype == IMB_FTYPE_OPENEXR && ibuf->userdata) {
+    if (IMB_exr_has_multilayer(ibuf->userdata)) {
+      rr = RE_MultilayerConvert(ibuf->userdata,
+                                ima->colorspace_settings.name,
+                                ima->alpha_mode == IMA_ALPHA_PREMUL,
+                                ibuf->x,
+                                ibuf->y);
+    }
+    IMB_exr_close(ibuf->userdata);
+    ibuf->userdata = NULL;
+  }
+
+  IMB_freeImBuf(ibuf);
+
+  return rr;
+}
+
+static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr, const char *filepath)
 {
   const char *colorspace = ima->colorspace_settings.name;
   bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
@@ -3566,9 +3628,24 @@ static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
   /* only load rr once for multiview */
   if (!ima->rr) {
     ima->rr = RE_MultilayerConvert(ibuf->userdata, colorspace, predivide, ibuf->x, ibuf->y);
+
+    /* loaded with IB_multilayer_lazy, keep the file open to read passes when they're used */
+    if (ima->rr && filepath) {
+      if (IMB_exr_reopen_file(ibuf->userdata, filepath)) {
+        ima->rr->exrhandle = ibuf->userdata;
+        ibuf->userdata = NULL;
+      }
+      else {
+        /* the passes can't be read later on, read all of them now */
+        RE_FreeRenderResult(ima->rr);
+        ima->rr = image_load_multilayer_full(ima, filepath);
+      }
+    }
   }
 
-  IMB_exr_close(ibuf->userdata);
+  if (ibuf->userdata) {
+    IMB_exr_close(ibuf->userdata);
+  }
 
   ibuf->userdata = NULL;
   if (ima->rr != NULL) {
@@ -3649,7 +3726,7 @@ static ImBuf *load_sequence_single(
   iuser_t.view = view_id;
   BKE_image_user_file_path(&iuser_t, ima, name);
 
-  flag = IB_rect | IB_multilayer | IB_metadata;
+  flag = IB_rect | IB_multilayer | IB_multilayer_lazy | IB_metadata;
   flag |= imbuf_alpha_flags_for_image(ima);
 
   /* read ibuf */
@@ -3670,7 +3747,7 @@ static ImBuf *load_sequence_single(
       /* Handle multilayer and multiview cases, don't assign ibuf here.
        * will be set layer in BKE_image_acquire_ibuf from ima->rr. */
       if (IMB_exr_has_multilayer(ibuf->userdata)) {
-        image_create_multilayer(ima, ibuf, frame);
+        image_create_multilayer(ima, ibuf, frame, name);
         ima->type = IMA_TYPE_MULTILAYER;
         IMB_freeImBuf(ibuf);
         ibuf = NULL;
@@ -3754,6 +3831,9 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int f
        * with dead links after freeing the render result.
        */
       image_free_cached_frames(ima);
+      if (ima->rr == image_multilayer_read_rr) {
+        image_multilayer_read_rr = NULL;
+      }
       RE_FreeRenderResult(ima->rr);
       ima->rr = NULL;
     }
@@ -3768,6 +3848,14 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int f
   if (ima->rr) {
     RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+    /* pass is read by the caller without holding the lock, see image_multilayer_read_pass */
+    if (rpass && rpass->rect == NULL) {
+      if (image_multilayer_pending_pass(ima, iuser, NULL)) {
+        return NULL;
+      }
+      rpass = NULL;
+    }
+
     if (rpass) {
       // printf("load from pass %s\n", rpass->name);
       /* since we free  render results, we copy the rect */
@@ -3949,9 +4037,13 @@ static ImBuf *load_image_single(Image *ima,
   else {
     ImageUser iuser_t;
 
-    flag = IB_rect | IB_multilayer | IB_metadata;
+    flag = IB_rect | IB_multilayer | IB_multilayer_lazy | IB_metadata;
     flag |= imbuf_alpha_flags_for_image(ima);
 
+    if (ima->flag & IMA_USE_TILE_CACHE) {
+      flag |= IB_tilecache;
+    }
+
     /* get the correct filepath */
     BKE_image_user_frame_calc(iuser, cfra);
 
@@ -3976,7 +4068,7 @@ static ImBuf *load_image_single(Image *ima,
       /* Handle multilayer and multiview cases, don't assign ibuf here.
        * will be set layer in BKE_image_acquire_ibuf from ima->rr. */
       if (IMB_exr_has_multilayer(ibuf->userdata)) {
-        image_create_multilayer(ima, ibuf, cfra);
+        image_create_multilayer(ima, ibuf, cfra, has_packed ? NULL : filepath);
         ima->type = IMA_TYPE_MULTILAYER;
         IMB_freeImBuf(ibuf);
         ibuf = NULL;
@@ -4093,6 +4185,15 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
   if (ima->rr) {
     RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
+    /* passes of multilayer files are only read when used, by the caller
+     * without holding the lock, see image_multilayer_read_pass */
+    if (rpass && rpass->rect == NULL) {
+      if (image_multilayer_pending_pass(ima, iuser, NULL)) {
+        return NULL;
+      }
+      rpass = NULL;
+    }
+
     if (rpass) {
       ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
 
@@ -4118,6 +4219,131 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
   return ibuf;
 }
 
+/* Pass of a lazily loaded multilayer image which still has to be read from the
+ * file by image_multilayer_read_pass. Needs image_spin to be locked. */
+static RenderPass *image_multilayer_pending_pass(Image *ima,
+                                                 ImageUser *iuser,
+                                                 RenderLayer **r_rl)
+{
+  RenderResult *rr = ima->rr;
+  RenderLayer *rl;
+  RenderPass *rpass;
+  ImageUser iuser_t;
+
+  if (ima->type != IMA_TYPE_MULTILAYER || rr == NULL) {
+    return NULL;
+  }
+  if (!ELEM(ima->source, IMA_SRC_FILE, IMA_SRC_SEQUENCE)) {
+    return NULL;
+  }
+  if (rr->exrhandle == NULL && rr != image_multilayer_read_rr) {
+    return NULL;
+  }
+
+  /* don't change the multi_index of the caller's image user */
+  if (iuser) {
+    iuser_t = *iuser;
+  }
+
+  rpass = BKE_image_multilayer_index(rr, iuser ? &iuser_t : NULL);
+  if (rpass == NULL || rpass->rect) {
+    return NULL;
+  }
+
+  for (rl = rr->layers.first; rl; rl = rl->next) {
+    if (BLI_findindex(&rl->passes, rpass) != -1) {
+      break;
+    }
+  }
+
+  if (r_rl) {
+    *r_rl = rl;
+  }
+
+  return rl ? rpass : NULL;
+}
+
+/* Read the pass used by the image user from the file of a lazily loaded
+ * multilayer image, without holding image_spin while reading.
+ * Returns true when the image buffer should be acquired again. */
+static bool image_multilayer_read_pass(Image *ima, ImageUser *iuser)
+{
+#ifdef WITH_OPENEXR
+  RenderResult *rr;
+  RenderLayer *rl, rl_t;
+  RenderPass *rpass, rpass_t;
+  char colorspace[sizeof(ima->colorspace_settings.name)];
+  void *exrhandle;
+  float *rect;
+  bool predivide;
+
+  if (ima == NULL || ima->type != IMA_TYPE_MULTILAYER) {
+    return false;
+  }
+
+  BLI_mutex_lock(&image_multilayer_read_lock);
+  BLI_spin_lock(&image_spin);
+
+  rpass = image_multilayer_pending_pass(ima, iuser, &rl);
+  if (rpass == NULL) {
+    /* another thread may have read it while waiting for the lock */
+    BLI_spin_unlock(&image_spin);
+    BLI_mutex_unlock(&image_multilayer_read_lock);
+    return true;
+  }
+
+  /* take the file, the render result may be freed while reading */
+  rr = ima->rr;
+  exrhandle = rr->exrhandle;
+  rr->exrhandle = NULL;
+  image_multilayer_read_rr = rr;
+
+  rl_t = *rl;
+  rpass_t = *rpass;
+  STRNCPY(colorspace, ima->colorspace_settings.name);
+  predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
+
+  BLI_spin_unlock(&image_spin);
+
+  rect = RE_MultilayerReadPass(exrhandle, &rl_t, &rpass_t, colorspace, predivide);
+
+  BLI_spin_lock(&image_spin);
+
+  if (image_multilayer_read_rr == rr) {
+    rr->exrhandle = exrhandle;
+    exrhandle = NULL;
+
+    if (rect == NULL) {
+      ima->ok = 0;
+      if (iuser) {
+        iuser->ok = 0;
+      }
+    }
+    else if (rpass->rect == NULL) {
+      rpass->rect = rect;
+      rect = NULL;
+    }
+  }
+  image_multilayer_read_rr = NULL;
+
+  BLI_spin_unlock(&image_spin);
+  BLI_mutex_unlock(&image_multilayer_read_lock);
+
+  /* render result was freed while reading */
+  if (exrhandle) {
+    IMB_exr_close(exrhandle);
+  }
+  if (rect) {
+    MEM_freeN(rect);
+  }
+
+  return true;
+#else
+  UNUSED_VARS(ima, iuser);
+  return false;
+#endif
+}
+
 /* showing RGBA result itself (from compo/sequence) or
  * like exr, using layers etc */
 /* always returns a single ibuf, also during render progress */
@@ -4587,6 +4813,13 @@ ImBuf *BKE_image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
 
   BLI_spin_unlock(&image_spin);
 
+  /* passes of multilayer files are read without holding the lock */
+  if (ibuf == NULL && image_multilayer_read_pass(ima, iuser)) {
+    BLI_spin_lock(&image_spin);
+    ibuf = image_acquire_ibuf(ima, iuser, r_lock);
+    BLI_spin_unlock(&image_spin);
+  }
+
   return ibuf;
 }
 
@@ -4630,6 +4863,12 @@ bool BKE_image_has_ibuf(Image *ima, ImageUser *iuser)
 
   BLI_spin_unlock(&image_spin);
 
+  if (ibuf == NULL && image_multilayer_read_pass(ima, iuser)) {
+    BLI_spin_lock(&image_spin);
+    ibuf = image_acquire_ibuf(ima, iuser, NULL);
+    BLI_spin_unlock(&image_spin);
+  }
+
   IMB_freeImBuf(ibuf);
 
   return ibuf != NULL;
@@ -4716,14 +4955,28 @@ ImBuf *BKE_image_pool_acquire_ibuf(Image *ima, ImageUser *iuser, ImagePool *pool
 
   ibuf = image_pool_find_entry(pool, ima, frame, index, &found);
 
+  if (!found) {
+    ibuf = image_acquire_ibuf(ima, iuser, NULL);
+
+    /* passes of multilayer files are read without holding the lock */
+    if (ibuf == NULL && image_multilayer_pending_pass(ima, iuser, NULL)) {
+      BLI_spin_unlock(&image_spin);
+      image_multilayer_read_pass(ima, iuser);
+      BLI_spin_lock(&image_spin);
+
+      ibuf = image_pool_find_entry(pool, ima, frame, index, &found);
+      if (!found) {
+        ibuf = image_acquire_ibuf(ima, iuser, NULL);
+      }
+    }
+  }
+
   /* will also create entry even in cases image buffer failed to load,
    * prevents trying to load the same buggy file multiple times
    */
   if (!found) {
     ImagePoolEntry *entry;
 
-    ibuf = image_acquire_ibuf(ima, iuser, NULL);
-
     entry = BLI_mempool_alloc(pool->memory_pool);
     entry->image = ima;
     entry->frame = frame;
@@ -5166,6 +5419,25 @@ bool BKE_image_has_loaded_ibuf(Image *image)
   return has_loaded_ibuf;
 }
 
+/* Statistics of the buffer cache of the image, false when nothing was cached yet. */
+bool BKE_image_get_cache_stats(Image *image, MovieCacheStats *r_stats)
+{
+  bool has_cache = false;
+
+  BLI_spin_lock(&image_spin);
+  if (image->cache != NULL) {
+    IMB_moviecache_get_stats(image->cache, r_stats);
+    has_cache = true;
+  }
+  BLI_spin_unlock(&image_spin);
+
+  if (!has_cache) {
+    memset(r_stats, 0, sizeof(*r_stats));
+  }
+
+  return has_cache;
+}
+
 /**
  * References the result, #BKE_image_release_ibuf is to be called to de-reference.
  * Use lock=NULL when calling #BKE_image_release_ibuf().
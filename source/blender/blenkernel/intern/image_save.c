@@ -183,6 +183,11 @@ bool BKE_image_save(
 
   /* we need renderresult for exr and rendered multiview */
   rr = BKE_image_acquire_renderresult(opts->scene, ima);
+
+  /* passes of multilayer files are read on demand, saving needs all of them */
+  if (rr && ima->type == IMA_TYPE_MULTILAYER) {
+    BKE_image_multilayer_load_passes(ima);
+  }
   bool is_mono = rr ? BLI_listbase_count_at_most(&rr->views, 2) < 2 :
                       BLI_listbase_count_at_most(&ima->views, 2) < 2;
   bool is_exr_rr = rr && ELEM(imf->imtype, R_IMF_IMTYPE_OPENEXR, R_IMF_IMTYPE_MULTILAYER) &&
@@ -593,6 +593,7 @@ static bool put_imbuf_cache(
                                          moviecache_getprioritydata,
                                          moviecache_getitempriority,
                                          moviecache_prioritydeleter);
+    IMB_moviecache_set_use_compression(moviecache, true);
 
     clip->cache->moviecache = moviecache;
     clip->cache->sequence_offset = -1;
@@ -1368,6 +1369,18 @@ void BKE_movieclip_clear_proxy_cache(MovieClip *clip)
   }
 }
 
+/* Statistics of the frame cache of the clip, false when nothing was cached yet. */
+bool BKE_movieclip_get_cache_stats(MovieClip *clip, MovieCacheStats *r_stats)
+{
+  if (clip->cache && clip->cache->moviecache) {
+    IMB_moviecache_get_stats(clip->cache->moviecache, r_stats);
+    return true;
+  }
+
+  memset(r_stats, 0, sizeof(*r_stats));
+  return false;
+}
+
 void BKE_movieclip_reload(Main *bmain, MovieClip *clip)
 {
   /* clear cache */
@@ -23,19 +23,33 @@
 #include <stddef.h>
 #include <memory.h>
 
+#include "zlib.h"
+
 #include "MEM_guardedalloc.h"
 
+#include "DNA_color_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+#include "DNA_vfont_types.h"
 
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
 
+#include "BKE_appdir.h"
+#include "BKE_global.h"
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
 #include "BKE_main.h"
@@ -67,6 +81,27 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ *
+ * Disk cache:
+ * Images that are stored permanently in memory can also be written to disk, so they survive
+ * file reload. Memory cache is always checked first, images read from disk are put into memory
+ * cache with zero cost, so they are recycled first. Each image is stored in its own file:
+ *
+ *   <cache dir>/<blend file name>_seq_cache/<scene name>/<strip name>/<hash>-<type>-<frame>.dcf
+ *
+ * Hash is computed from settings of all strips that contribute to the image and from render
+ * context, so files of changed strips simply stop matching. Some changes are not covered by the
+ * hash (data that lives outside of strips, for example), so files are removed by invalidation
+ * as well, same as memory cache entries.
+ *
+ * Files are compressed with zlib. Least recently used files are removed when size of all cache
+ * directories exceeds the limit set in user preferences. Read files are touched, so the order
+ * is preserved across sessions.
+ *
+ * Hashes of individual strips are kept in memory cache until it is invalidated, so strip data
+ * and source file modification time are not read again for every frame. Files are written by
+ * a background thread, images which don't fit into its queue are simply not written.
  */
 
 typedef struct SeqCache {
@@ -76,11 +111,19 @@ typedef struct SeqCache {
   struct BLI_mempool *items_pool;
   struct SeqCacheKey *last_key;
   size_t memory_used;
+  /* Last decompressed image and the data it came from, both referenced. Consecutive lookups of
+   * the same compressed item, like redrawing a paused frame, don't decompress it again. */
+  struct ImBufCompressed *last_compressed;
+  struct ImBuf *last_decompressed;
+  /* Sequence -> DiskCacheStripHash, cleared when cache is invalidated. */
+  struct GHash *disk_strip_hashes;
 } SeqCache;
 
 typedef struct SeqCacheItem {
   struct SeqCache *cache_owner;
+  /* Permanently cached images are stored compressed when enabled in user preferences. */
   struct ImBuf *ibuf;
+  struct ImBufCompressed *compressed;
 } SeqCacheItem;
 
 typedef struct SeqCacheKey {
@@ -99,6 +142,67 @@ typedef struct SeqCacheKey {
 
 static ThreadMutex cache_create_lock = BLI_MUTEX_INITIALIZER;
 
+#define DCACHE_FNAME_EXT ".dcf"
+#define DCACHE_DIR_SUFFIX "_seq_cache"
+#define DCACHE_FILE_VERSION 1
+#define DCACHE_MAX_STRIP_DEPTH 32
+/* Number of images which can wait to be written to disk. */
+#define DCACHE_WRITE_QUEUE_SIZE 8
+
+typedef struct DiskCacheFile {
+  struct DiskCacheFile *next, *prev;
+  char path[FILE_MAX];
+  size_t size;
+  int64_t mtime;
+} DiskCacheFile;
+
+typedef struct DiskCacheHeader {
+  char magic[4];
+  int version;
+  int x, y;
+  int planes;
+  int channels;
+  int is_float;
+  char colorspace[64];
+} DiskCacheHeader;
+
+/* All cache files, shared by all scenes and files, ordered from least recently used. */
+typedef struct SeqDiskCache {
+  ListBase files;
+  /* Path -> DiskCacheFile. */
+  struct GHash *files_hash;
+  size_t size_total;
+  char root_dir[FILE_MAX];
+} SeqDiskCache;
+
+typedef struct DiskCacheStripHash {
+  unsigned int hash;
+  /* False when image of the strip can't be cached on disk. */
+  bool is_valid;
+} DiskCacheStripHash;
+
+typedef struct DiskCacheWrite {
+  struct DiskCacheWrite *next, *prev;
+  char path[FILE_MAX];
+  ImBuf *ibuf;
+} DiskCacheWrite;
+
+/* Background thread writing cache files, so rendering doesn't wait for compression and disk. */
+typedef struct SeqDiskCacheWriter {
+  ListBase threads;
+  ListBase queue;
+  int queue_len;
+  ThreadCondition cond;
+  bool running;
+  bool stop;
+} SeqDiskCacheWriter;
+
+static ThreadMutex disk_cache_lock = BLI_MUTEX_INITIALIZER;
+static SeqDiskCache *disk_cache = NULL;
+
+static ThreadMutex disk_cache_writer_lock = BLI_MUTEX_INITIALIZER;
+static SeqDiskCacheWriter disk_cache_writer = {{NULL}};
+
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
   return ((a->preview_render_size != b->preview_render_size) || (a->rectx != b->rectx) ||
@@ -176,46 +280,110 @@ static void seq_cache_keyfree(void *val)
   BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+static void seq_cache_last_decompressed_clear(SeqCache *cache)
+{
+  if (cache->last_compressed) {
+    IMB_compressed_free(cache->last_compressed);
+    IMB_freeImBuf(cache->last_decompressed);
+    cache->last_compressed = NULL;
+    cache->last_decompressed = NULL;
+  }
+}
+
 static void seq_cache_valfree(void *val)
 {
   SeqCacheItem *item = (SeqCacheItem *)val;
   SeqCache *cache = item->cache_owner;
 
+  if (item->compressed && item->compressed == cache->last_compressed) {
+    seq_cache_last_decompressed_clear(cache);
+  }
+
   if (item->ibuf) {
     cache->memory_used -= IMB_get_size_in_memory(item->ibuf);
     IMB_freeImBuf(item->ibuf);
   }
+  if (item->compressed) {
+    cache->memory_used -= IMB_compressed_get_size_in_memory(item->compressed);
+    IMB_compressed_free(item->compressed);
+  }
 
   BLI_mempool_free(item->cache_owner->items_pool, item);
 }
 
-static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Compressed image is stored instead of ibuf when given. */
+static void seq_cache_put(SeqCache *cache,
+                          SeqCacheKey *key,
+                          ImBuf *ibuf,
+                          struct ImBufCompressed *compressed)
 {
   SeqCacheItem *item;
   item = BLI_mempool_alloc(cache->items_pool);
   item->cache_owner = cache;
-  item->ibuf = ibuf;
+  item->ibuf = compressed ? NULL : ibuf;
+  item->compressed = compressed;
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
-    IMB_refImBuf(ibuf);
     cache->last_key = key;
-    cache->memory_used += IMB_get_size_in_memory(ibuf);
+    if (compressed) {
+      cache->memory_used += IMB_compressed_get_size_in_memory(compressed);
+    }
+    else {
+      IMB_refImBuf(ibuf);
+      cache->memory_used += IMB_get_size_in_memory(ibuf);
+    }
   }
 }
 
-static ImBuf *seq_cache_get(SeqCache *cache, void *key)
+/* Compressed images are not decompressed here, since the cache is locked. Instead r_compressed
+ * is set with a reference taken, to be decompressed by the caller after unlocking. */
+static ImBuf *seq_cache_get(SeqCache *cache, void *key, struct ImBufCompressed **r_compressed)
 {
   SeqCacheItem *item = BLI_ghash_lookup(cache->hash, key);
 
+  *r_compressed = NULL;
+
   if (item && item->ibuf) {
     IMB_refImBuf(item->ibuf);
 
     return item->ibuf;
   }
+  if (item && item->compressed) {
+    if (item->compressed == cache->last_compressed) {
+      IMB_refImBuf(cache->last_decompressed);
+      return cache->last_decompressed;
+    }
+
+    IMB_compressed_ref(item->compressed);
+    *r_compressed = item->compressed;
+  }
 
   return NULL;
 }
 
+static ImBuf *seq_cache_decompress(Scene *scene, struct ImBufCompressed *compressed)
+{
+  ImBuf *ibuf = IMB_compressed_to_imbuf(compressed);
+
+  if (ibuf) {
+    seq_cache_lock(scene);
+    SeqCache *cache = seq_cache_get_from_scene(scene);
+
+    if (cache) {
+      seq_cache_last_decompressed_clear(cache);
+      IMB_compressed_ref(compressed);
+      IMB_refImBuf(ibuf);
+      cache->last_compressed = compressed;
+      cache->last_decompressed = ibuf;
+    }
+    seq_cache_unlock(scene);
+  }
+
+  IMB_compressed_free(compressed);
+
+  return ibuf;
+}
+
 static void seq_cache_relink_keys(SeqCacheKey *link_next, SeqCacheKey *link_prev)
 {
   if (link_next) {
@@ -305,7 +473,7 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
     BLI_ghashIterator_step(&gh_iter);
 
     /* this shouldn't happen, but better be safe than sorry */
-    if (!item->ibuf) {
+    if (!item->ibuf && !item->compressed) {
       seq_cache_recycle_linked(scene, key);
       /* can not continue iterating after linked remove */
       BLI_ghashIterator_init(&gh_iter, cache->hash);
@@ -346,9 +514,18 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 /* Find only "base" keys
  * Sources(other types) for a frame must be freed all at once
  */
+static size_t seq_cache_memory_limit(void)
+{
+  return ((size_t)U.memcachelimit) * 1024 * 1024;
+}
+
+static bool seq_cache_is_full(SeqCache *cache)
+{
+  return cache->memory_used > seq_cache_memory_limit();
+}
+
 static bool seq_cache_recycle_item(Scene *scene)
 {
-  size_t memory_total = ((size_t)U.memcachelimit) * 1024 * 1024;
   SeqCache *cache = seq_cache_get_from_scene(scene);
   if (!cache) {
     return false;
@@ -356,7 +533,7 @@ static bool seq_cache_recycle_item(Scene *scene)
 
   seq_cache_lock(scene);
 
-  while (cache->memory_used > memory_total) {
+  while (seq_cache_is_full(cache)) {
     SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
 
     if (finalkey) {
@@ -395,6 +572,884 @@ static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
+/* ***************************** Disk cache ****************************** */
+
+/* Strip flags which change rendered image. */
+#define DCACHE_SEQ_FLAG_MASK \
+  (SEQ_FILTERY | SEQ_MUTE | SEQ_REVERSE_FRAMES | SEQ_FLIPX | SEQ_FLIPY | SEQ_MAKE_FLOAT | \
+   SEQ_USE_PROXY | SEQ_USE_TRANSFORM | SEQ_USE_CROP | SEQ_USE_EFFECT_DEFAULT_FADE | \
+   SEQ_USE_LINEAR_MODIFIERS | SEQ_USE_VIEWS)
+
+static void seq_disk_cache_hash_data(BLI_HashMurmur2A *mm2, const void *data, size_t len)
+{
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)data, len);
+}
+
+static void seq_disk_cache_hash_str(BLI_HashMurmur2A *mm2, const char *str)
+{
+  seq_disk_cache_hash_data(mm2, str, strlen(str));
+}
+
+static void seq_disk_cache_hash_curve_mapping(BLI_HashMurmur2A *mm2, const CurveMapping *cumap)
+{
+  BLI_hash_mm2a_add_int(mm2, cumap->flag);
+  seq_disk_cache_hash_data(mm2, &cumap->clipr, sizeof(cumap->clipr));
+  seq_disk_cache_hash_data(mm2, cumap->black, sizeof(cumap->black));
+  seq_disk_cache_hash_data(mm2, cumap->white, sizeof(cumap->white));
+
+  for (int i = 0; i < CM_TOT; i++) {
+    const CurveMap *cuma = &cumap->cm[i];
+
+    BLI_hash_mm2a_add_int(mm2, cuma->totpoint);
+    if (cuma->curve) {
+      seq_disk_cache_hash_data(mm2, cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+    }
+  }
+}
+
+static bool seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2,
+                                      Main *bmain,
+                                      Sequence *seq,
+                                      int depth);
+
+static bool seq_disk_cache_hash_modifiers(BLI_HashMurmur2A *mm2,
+                                          Main *bmain,
+                                          Sequence *seq,
+                                          int depth)
+{
+  for (SequenceModifierData *smd = seq->modifiers.first; smd; smd = smd->next) {
+    const SequenceModifierTypeInfo *smti = BKE_sequence_modifier_type_info_get(smd->type);
+
+    /* Mask data-block can change without invalidating the strip. */
+    if (smd->mask_id != NULL) {
+      return false;
+    }
+
+    BLI_hash_mm2a_add_int(mm2, smd->type);
+    BLI_hash_mm2a_add_int(mm2, smd->flag);
+    BLI_hash_mm2a_add_int(mm2, smd->mask_input_type);
+    BLI_hash_mm2a_add_int(mm2, smd->mask_time);
+
+    if (smd->mask_sequence &&
+        !seq_disk_cache_hash_strip(mm2, bmain, smd->mask_sequence, depth + 1)) {
+      return false;
+    }
+
+    if (smti == NULL) {
+      continue;
+    }
+
+    switch (smd->type) {
+      case seqModifierType_Curves:
+        seq_disk_cache_hash_curve_mapping(mm2, &((CurvesModifierData *)smd)->curve_mapping);
+        break;
+      case seqModifierType_HueCorrect:
+        seq_disk_cache_hash_curve_mapping(mm2, &((HueCorrectModifierData *)smd)->curve_mapping);
+        break;
+      default:
+        /* Other modifiers store plain values after the common header. */
+        seq_disk_cache_hash_data(mm2,
+                                 (const char *)smd + sizeof(SequenceModifierData),
+                                 smti->struct_size - sizeof(SequenceModifierData));
+        break;
+    }
+  }
+
+  return true;
+}
+
+static void seq_disk_cache_hash_effect(BLI_HashMurmur2A *mm2, Sequence *seq)
+{
+  if (seq->effectdata == NULL) {
+    return;
+  }
+
+  switch (seq->type) {
+    case SEQ_TYPE_SPEED: {
+      SpeedControlVars *v = seq->effectdata;
+      seq_disk_cache_hash_data(mm2, &v->globalSpeed, sizeof(v->globalSpeed));
+      BLI_hash_mm2a_add_int(mm2, v->flags);
+      break;
+    }
+    case SEQ_TYPE_TEXT: {
+      TextVars *data = seq->effectdata;
+      seq_disk_cache_hash_str(mm2, data->text);
+      if (data->text_font) {
+        seq_disk_cache_hash_str(mm2, data->text_font->name);
+      }
+      BLI_hash_mm2a_add_int(mm2, data->text_size);
+      seq_disk_cache_hash_data(mm2, data->color, sizeof(data->color));
+      seq_disk_cache_hash_data(mm2, data->shadow_color, sizeof(data->shadow_color));
+      seq_disk_cache_hash_data(mm2, data->loc, sizeof(data->loc));
+      seq_disk_cache_hash_data(mm2, &data->wrap_width, sizeof(data->wrap_width));
+      BLI_hash_mm2a_add_int(mm2, data->flag);
+      BLI_hash_mm2a_add_int(mm2, data->align);
+      BLI_hash_mm2a_add_int(mm2, data->align_y);
+      break;
+    }
+    default:
+      /* Other effects store plain values only. */
+      seq_disk_cache_hash_data(mm2, seq->effectdata, MEM_allocN_len(seq->effectdata));
+      break;
+  }
+}
+
+static void seq_disk_cache_hash_source_file(BLI_HashMurmur2A *mm2, Main *bmain, Sequence *seq)
+{
+  Strip *strip = seq->strip;
+  char path[FILE_MAX];
+  BLI_stat_t st;
+
+  /* Image sequences are not checked, that would mean stat for every frame. */
+  if (seq->type != SEQ_TYPE_MOVIE || strip->stripdata == NULL) {
+    return;
+  }
+
+  BLI_join_dirfile(path, sizeof(path), strip->dir, strip->stripdata->name);
+  BLI_path_abs(path, BKE_main_blendfile_path(bmain));
+
+  if (BLI_stat(path, &st) == 0) {
+    int64_t mtime = (int64_t)st.st_mtime;
+    seq_disk_cache_hash_data(mm2, &mtime, sizeof(mtime));
+  }
+}
+
+/* Returns false when image of the strip can't be cached on disk. */
+static bool seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2,
+                                      Main *bmain,
+                                      Sequence *seq,
+                                      int depth)
+{
+  Strip *strip = seq->strip;
+
+  if (depth > DCACHE_MAX_STRIP_DEPTH) {
+    return false;
+  }
+
+  /* Content of these depends on other data-blocks. */
+  if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_MASK)) {
+    return false;
+  }
+
+  seq_disk_cache_hash_str(mm2, seq->name);
+  BLI_hash_mm2a_add_int(mm2, seq->type);
+  BLI_hash_mm2a_add_int(mm2, seq->flag & DCACHE_SEQ_FLAG_MASK);
+  BLI_hash_mm2a_add_int(mm2, seq->len);
+  BLI_hash_mm2a_add_int(mm2, seq->start);
+  BLI_hash_mm2a_add_int(mm2, seq->startofs);
+  BLI_hash_mm2a_add_int(mm2, seq->endofs);
+  BLI_hash_mm2a_add_int(mm2, seq->startstill);
+  BLI_hash_mm2a_add_int(mm2, seq->endstill);
+  BLI_hash_mm2a_add_int(mm2, seq->machine);
+  BLI_hash_mm2a_add_int(mm2, seq->anim_startofs);
+  BLI_hash_mm2a_add_int(mm2, seq->anim_endofs);
+  BLI_hash_mm2a_add_int(mm2, seq->blend_mode);
+  BLI_hash_mm2a_add_int(mm2, seq->streamindex);
+  BLI_hash_mm2a_add_int(mm2, seq->multicam_source);
+  BLI_hash_mm2a_add_int(mm2, seq->alpha_mode);
+  BLI_hash_mm2a_add_int(mm2, seq->views_format);
+  seq_disk_cache_hash_data(mm2, &seq->sat, sizeof(seq->sat));
+  seq_disk_cache_hash_data(mm2, &seq->mul, sizeof(seq->mul));
+  seq_disk_cache_hash_data(mm2, &seq->effect_fader, sizeof(seq->effect_fader));
+  seq_disk_cache_hash_data(mm2, &seq->speed_fader, sizeof(seq->speed_fader));
+  seq_disk_cache_hash_data(mm2, &seq->blend_opacity, sizeof(seq->blend_opacity));
+
+  if (seq->stereo3d_format) {
+    seq_disk_cache_hash_data(mm2, seq->stereo3d_format, sizeof(*seq->stereo3d_format));
+  }
+
+  if (strip) {
+    seq_disk_cache_hash_str(mm2, strip->dir);
+    seq_disk_cache_hash_str(mm2, strip->colorspace_settings.name);
+    if (strip->stripdata) {
+      seq_disk_cache_hash_data(mm2, strip->stripdata, MEM_allocN_len(strip->stripdata));
+    }
+    if (strip->crop) {
+      seq_disk_cache_hash_data(mm2, strip->crop, sizeof(*strip->crop));
+    }
+    if (strip->transform) {
+      seq_disk_cache_hash_data(mm2, strip->transform, sizeof(*strip->transform));
+    }
+  }
+
+  seq_disk_cache_hash_source_file(mm2, bmain, seq);
+  seq_disk_cache_hash_effect(mm2, seq);
+
+  if (!seq_disk_cache_hash_modifiers(mm2, bmain, seq, depth)) {
+    return false;
+  }
+
+  Sequence *inputs[3] = {seq->seq1, seq->seq2, seq->seq3};
+  for (int i = 0; i < ARRAY_SIZE(inputs); i++) {
+    if (inputs[i] && !seq_disk_cache_hash_strip(mm2, bmain, inputs[i], depth + 1)) {
+      return false;
+    }
+  }
+
+  for (Sequence *seq_child = seq->seqbase.first; seq_child; seq_child = seq_child->next) {
+    if (!seq_disk_cache_hash_strip(mm2, bmain, seq_child, depth + 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static ListBase *seq_disk_cache_find_seqbase(ListBase *seqbase, Sequence *seq)
+{
+  for (Sequence *iseq = seqbase->first; iseq; iseq = iseq->next) {
+    if (iseq == seq) {
+      return seqbase;
+    }
+    if (iseq->type == SEQ_TYPE_META) {
+      ListBase *lb = seq_disk_cache_find_seqbase(&iseq->seqbase, seq);
+      if (lb) {
+        return lb;
+      }
+    }
+  }
+  return NULL;
+}
+
+static void seq_disk_cache_strip_hashes_clear(SeqCache *cache)
+{
+  BLI_ghash_clear(cache->disk_strip_hashes, NULL, MEM_freeN);
+}
+
+/* Hash of strip settings, stored in memory cache of the scene until it's invalidated. */
+static bool seq_disk_cache_strip_hash_get(Scene *scene,
+                                          Main *bmain,
+                                          Sequence *seq,
+                                          unsigned int *r_hash)
+{
+  DiskCacheStripHash *strip_hash = NULL;
+  DiskCacheStripHash strip_hash_new;
+  BLI_HashMurmur2A mm2;
+
+  seq_cache_lock(scene);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (cache) {
+    strip_hash = BLI_ghash_lookup(cache->disk_strip_hashes, seq);
+    if (strip_hash) {
+      strip_hash_new = *strip_hash;
+    }
+  }
+  seq_cache_unlock(scene);
+
+  if (strip_hash == NULL) {
+    BLI_hash_mm2a_init(&mm2, DCACHE_FILE_VERSION);
+    strip_hash_new.is_valid = seq_disk_cache_hash_strip(&mm2, bmain, seq, 0);
+    strip_hash_new.hash = BLI_hash_mm2a_end(&mm2);
+
+    seq_cache_lock(scene);
+    cache = seq_cache_get_from_scene(scene);
+    if (cache && !BLI_ghash_haskey(cache->disk_strip_hashes, seq)) {
+      strip_hash = MEM_mallocN(sizeof(DiskCacheStripHash), "DiskCacheStripHash");
+      *strip_hash = strip_hash_new;
+      BLI_ghash_insert(cache->disk_strip_hashes, seq, strip_hash);
+    }
+    seq_cache_unlock(scene);
+  }
+
+  *r_hash = strip_hash_new.hash;
+  return strip_hash_new.is_valid;
+}
+
+/* Hash of everything that contributes to image stored in cache, returns false when image can't
+ * be cached on disk. */
+static bool seq_disk_cache_hash(const SeqRenderData *context,
+                                Sequence *seq,
+                                int cfra,
+                                int type,
+                                unsigned int *r_hash)
+{
+  Scene *scene = context->scene;
+  BLI_HashMurmur2A mm2;
+  unsigned int context_hash, strip_hash, hash = 0;
+
+  BLI_hash_mm2a_init(&mm2, DCACHE_FILE_VERSION);
+  BLI_hash_mm2a_add_int(&mm2, context->rectx);
+  BLI_hash_mm2a_add_int(&mm2, context->recty);
+  BLI_hash_mm2a_add_int(&mm2, context->preview_render_size);
+  BLI_hash_mm2a_add_int(&mm2, context->view_id);
+  BLI_hash_mm2a_add_int(&mm2, context->motion_blur_samples);
+  seq_disk_cache_hash_data(&mm2, &context->motion_blur_shutter, sizeof(float));
+  BLI_hash_mm2a_add_int(&mm2, scene->r.frs_sec);
+  seq_disk_cache_hash_data(&mm2, &scene->r.frs_sec_base, sizeof(float));
+  BLI_hash_mm2a_add_int(&mm2, scene->r.views_format);
+  seq_disk_cache_hash_str(&mm2, scene->sequencer_colorspace_settings.name);
+  context_hash = BLI_hash_mm2a_end(&mm2);
+
+  if (ELEM(type, SEQ_CACHE_STORE_RAW, SEQ_CACHE_STORE_PREPROCESSED)) {
+    if (!seq_disk_cache_strip_hash_get(scene, context->bmain, seq, &strip_hash)) {
+      return false;
+    }
+    BLI_hash_mm2a_init(&mm2, context_hash);
+    BLI_hash_mm2a_add_int(&mm2, (int)strip_hash);
+    *r_hash = BLI_hash_mm2a_end(&mm2);
+    return true;
+  }
+
+  /* Composite and final images depend on all strips below. Combine hashes of individual strips
+   * regardless of their order in the list. */
+  ListBase *seqbase = seq_disk_cache_find_seqbase(&scene->ed->seqbase, seq);
+  if (seqbase == NULL) {
+    return false;
+  }
+
+  for (Sequence *iseq = seqbase->first; iseq; iseq = iseq->next) {
+    if (iseq->machine > seq->machine || cfra < iseq->startdisp || cfra >= iseq->enddisp ||
+        (iseq->flag & SEQ_MUTE) || ELEM(iseq->type, SEQ_TYPE_SOUND_RAM, SEQ_TYPE_SOUND_HD)) {
+      continue;
+    }
+
+    if (!seq_disk_cache_strip_hash_get(scene, context->bmain, iseq, &strip_hash)) {
+      return false;
+    }
+    BLI_hash_mm2a_init(&mm2, context_hash);
+    BLI_hash_mm2a_add_int(&mm2, (int)strip_hash);
+    hash ^= BLI_hash_mm2a_end(&mm2);
+  }
+
+  BLI_hash_mm2a_init(&mm2, context_hash);
+  BLI_hash_mm2a_add_int(&mm2, (int)hash);
+  *r_hash = BLI_hash_mm2a_end(&mm2);
+  return true;
+}
+
+static void seq_disk_cache_get_root_dir(char *r_path)
+{
+  if (U.sequencer_disk_cache_dir[0] != '\0') {
+    BLI_strncpy(r_path, U.sequencer_disk_cache_dir, FILE_MAX);
+    BLI_path_abs(r_path, BKE_main_blendfile_path_from_global());
+  }
+  else {
+    BLI_strncpy(r_path, BKE_tempdir_base(), FILE_MAX);
+  }
+}
+
+/* Directory of cache files of a scene, or a strip when `seq` is given. */
+static bool seq_disk_cache_get_dir(Main *bmain, Scene *scene, Sequence *seq, char *r_path)
+{
+  const char *blendfile_path = BKE_main_blendfile_path(bmain);
+  char root_dir[FILE_MAX];
+  char project_dir[FILE_MAXFILE];
+  char scene_dir[MAX_ID_NAME];
+  char strip_dir[SEQ_NAME_MAXSTR];
+
+  /* Unsaved files have no stable identity. */
+  if (blendfile_path[0] == '\0') {
+    return false;
+  }
+
+  seq_disk_cache_get_root_dir(root_dir);
+
+  BLI_split_file_part(blendfile_path, project_dir, sizeof(project_dir));
+  BLI_path_extension_replace(project_dir, sizeof(project_dir), DCACHE_DIR_SUFFIX);
+  BLI_filename_make_safe(project_dir);
+
+  BLI_strncpy(scene_dir, scene->id.name + 2, sizeof(scene_dir));
+  BLI_filename_make_safe(scene_dir);
+
+  if (seq == NULL) {
+    BLI_path_join(r_path, FILE_MAX, root_dir, project_dir, scene_dir, NULL);
+  }
+  else {
+    BLI_strncpy(strip_dir, seq->name + 2, sizeof(strip_dir));
+    BLI_filename_make_safe(strip_dir);
+    BLI_path_join(r_path, FILE_MAX, root_dir, project_dir, scene_dir, strip_dir, NULL);
+  }
+  BLI_add_slash(r_path);
+
+  return true;
+}
+
+static bool seq_disk_cache_is_enabled(const SeqRenderData *context)
+{
+  Scene *scene = context->scene;
+
+  return (scene->ed->cache_flag & SEQ_CACHE_DISK_CACHE_ENABLE) && !context->for_render &&
+         !context->is_proxy_render && !context->skip_cache;
+}
+
+static bool seq_disk_cache_get_file_path(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, char *r_path)
+{
+  char dir[FILE_MAX];
+  char filename[FILE_MAXFILE];
+  unsigned int hash;
+
+  /* Subframes are only used for motion blur, don't pollute disk with those. */
+  if (cfra != (float)(int)cfra) {
+    return false;
+  }
+
+  if (!seq_disk_cache_get_dir(context->bmain, context->scene, seq, dir)) {
+    return false;
+  }
+
+  if (!seq_disk_cache_hash(context, seq, (int)cfra, type, &hash)) {
+    return false;
+  }
+
+  BLI_snprintf(filename, sizeof(filename), "%08x-%d-%d" DCACHE_FNAME_EXT, hash, type, (int)cfra);
+  BLI_join_dirfile(r_path, FILE_MAX, dir, filename);
+
+  return true;
+}
+
+static void seq_disk_cache_file_free(void *val)
+{
+  MEM_freeN(val);
+}
+
+static DiskCacheFile *seq_disk_cache_add_file(const char *path, size_t size, int64_t mtime)
+{
+  DiskCacheFile *file = BLI_ghash_lookup(disk_cache->files_hash, path);
+
+  if (file) {
+    disk_cache->size_total -= file->size;
+    BLI_remlink(&disk_cache->files, file);
+  }
+  else {
+    file = MEM_callocN(sizeof(DiskCacheFile), "DiskCacheFile");
+    BLI_strncpy(file->path, path, sizeof(file->path));
+    BLI_ghash_insert(disk_cache->files_hash, file->path, file);
+  }
+
+  file->size = size;
+  file->mtime = mtime;
+  disk_cache->size_total += size;
+  BLI_addtail(&disk_cache->files, file);
+
+  return file;
+}
+
+static void seq_disk_cache_delete_file(DiskCacheFile *file)
+{
+  BLI_delete(file->path, false, false);
+  disk_cache->size_total -= file->size;
+  BLI_remlink(&disk_cache->files, file);
+  BLI_ghash_remove(disk_cache->files_hash, file->path, NULL, seq_disk_cache_file_free);
+}
+
+static void seq_disk_cache_scan_dir(const char *dir)
+{
+  struct direntry *filelist;
+  unsigned int nbr = BLI_filelist_dir_contents(dir, &filelist);
+
+  for (unsigned int i = 0; i < nbr; i++) {
+    struct direntry *entry = &filelist[i];
+
+    if (FILENAME_IS_CURRPAR(entry->relname)) {
+      continue;
+    }
+
+    if (S_ISDIR(entry->type)) {
+      seq_disk_cache_scan_dir(entry->path);
+    }
+    else if (BLI_path_extension_check(entry->relname, DCACHE_FNAME_EXT)) {
+      seq_disk_cache_add_file(entry->path, (size_t)entry->s.st_size, (int64_t)entry->s.st_mtime);
+    }
+  }
+
+  BLI_filelist_free(filelist, nbr);
+}
+
+static int seq_disk_cache_file_cmp_mtime(const void *a_, const void *b_)
+{
+  const DiskCacheFile *a = a_;
+  const DiskCacheFile *b = b_;
+
+  return (a->mtime > b->mtime) - (a->mtime < b->mtime);
+}
+
+/* Must be called with disk_cache_lock held. */
+static void seq_disk_cache_free(void)
+{
+  if (disk_cache) {
+    BLI_ghash_free(disk_cache->files_hash, NULL, NULL);
+    BLI_freelistN(&disk_cache->files);
+    MEM_freeN(disk_cache);
+    disk_cache = NULL;
+  }
+}
+
+/* Must be called with disk_cache_lock held. Scans cache directories when the cache is used for
+ * the first time, or after root directory changed in preferences. */
+static void seq_disk_cache_ensure(void)
+{
+  char root_dir[FILE_MAX];
+  seq_disk_cache_get_root_dir(root_dir);
+
+  if (disk_cache && BLI_path_cmp(disk_cache->root_dir, root_dir) == 0) {
+    return;
+  }
+
+  seq_disk_cache_free();
+
+  disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
+  disk_cache->files_hash = BLI_ghash_str_new("SeqDiskCache files");
+  BLI_strncpy(disk_cache->root_dir, root_dir, sizeof(disk_cache->root_dir));
+
+  /* Only look into cache directories, root is likely shared with other files. */
+  struct direntry *filelist;
+  unsigned int nbr = BLI_filelist_dir_contents(root_dir, &filelist);
+
+  for (unsigned int i = 0; i < nbr; i++) {
+    struct direntry *entry = &filelist[i];
+
+    if (S_ISDIR(entry->type) && BLI_str_endswith(entry->relname, DCACHE_DIR_SUFFIX)) {
+      seq_disk_cache_scan_dir(entry->path);
+    }
+  }
+
+  BLI_filelist_free(filelist, nbr);
+
+  BLI_listbase_sort(&disk_cache->files, seq_disk_cache_file_cmp_mtime);
+}
+
+static void seq_disk_cache_enforce_limit(void)
+{
+  size_t size_limit = ((size_t)U.sequencer_disk_cache_size_limit) * 1024 * 1024 * 1024;
+
+  while (disk_cache->size_total > size_limit && disk_cache->files.first) {
+    seq_disk_cache_delete_file(disk_cache->files.first);
+  }
+}
+
+static int seq_disk_cache_compression_level(void)
+{
+  switch (U.sequencer_disk_cache_compression) {
+    case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
+      return 0;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
+      return 9;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+    default:
+      return 1;
+  }
+}
+
+/* Read or write pixels in chunks, zlib takes length as unsigned int. */
+static bool seq_disk_cache_gz_io(gzFile gz_file, void *data, size_t len, bool write)
+{
+  const size_t chunk_size = 64 * 1024 * 1024;
+  char *p = data;
+
+  while (len > 0) {
+    unsigned int chunk = (unsigned int)min_zz(len, chunk_size);
+    int done = write ? gzwrite(gz_file, p, chunk) : gzread(gz_file, p, chunk);
+
+    if (done != (int)chunk) {
+      return false;
+    }
+    p += chunk;
+    len -= chunk;
+  }
+
+  return true;
+}
+
+static size_t seq_disk_cache_ibuf_data_len(ImBuf *ibuf)
+{
+  if (ibuf->rect_float) {
+    return sizeof(float) * ibuf->channels * (size_t)ibuf->x * (size_t)ibuf->y;
+  }
+  return sizeof(unsigned int) * (size_t)ibuf->x * (size_t)ibuf->y;
+}
+
+static void seq_disk_cache_write(const char *path, ImBuf *ibuf)
+{
+  char dir[FILE_MAX];
+  char path_temp[FILE_MAX];
+  char mode[4];
+  DiskCacheHeader header = {{0}};
+  BLI_stat_t st;
+
+  if (ibuf->rect_float == NULL && ibuf->rect == NULL) {
+    return;
+  }
+
+  memcpy(header.magic, "BSDC", sizeof(header.magic));
+  header.version = DCACHE_FILE_VERSION;
+  header.x = ibuf->x;
+  header.y = ibuf->y;
+  header.planes = ibuf->planes;
+  header.channels = ibuf->channels;
+  header.is_float = (ibuf->rect_float != NULL);
+  const char *colorspace = header.is_float ? IMB_colormanagement_get_float_colorspace(ibuf) :
+                                             IMB_colormanagement_get_rect_colorspace(ibuf);
+  if (colorspace) {
+    BLI_strncpy(header.colorspace, colorspace, sizeof(header.colorspace));
+  }
+
+  BLI_split_dir_part(path, dir, sizeof(dir));
+  BLI_dir_create_recursive(dir);
+
+  /* Write to temporary file first, so other threads never read incomplete images. */
+  BLI_snprintf(path_temp, sizeof(path_temp), "%s.tmp", path);
+  BLI_snprintf(mode, sizeof(mode), "wb%d", seq_disk_cache_compression_level());
+
+  gzFile gz_file = BLI_gzopen(path_temp, mode);
+  if (gz_file == NULL) {
+    return;
+  }
+
+  void *data = header.is_float ? (void *)ibuf->rect_float : (void *)ibuf->rect;
+  bool ok = seq_disk_cache_gz_io(gz_file, &header, sizeof(header), true) &&
+            seq_disk_cache_gz_io(gz_file, data, seq_disk_cache_ibuf_data_len(ibuf), true);
+
+  if (gzclose(gz_file) != Z_OK || !ok || BLI_rename(path_temp, path) != 0 ||
+      BLI_stat(path, &st) != 0) {
+    BLI_delete(path_temp, false, false);
+    return;
+  }
+
+  BLI_mutex_lock(&disk_cache_lock);
+  seq_disk_cache_ensure();
+  seq_disk_cache_add_file(path, (size_t)st.st_size, (int64_t)st.st_mtime);
+  seq_disk_cache_enforce_limit();
+  BLI_mutex_unlock(&disk_cache_lock);
+}
+
+static bool seq_disk_cache_has_file(const char *path)
+{
+  bool has_file;
+
+  BLI_mutex_lock(&disk_cache_lock);
+  seq_disk_cache_ensure();
+  has_file = BLI_ghash_haskey(disk_cache->files_hash, path);
+  BLI_mutex_unlock(&disk_cache_lock);
+
+  return has_file;
+}
+
+static void *seq_disk_cache_writer_thread(void *UNUSED(data))
+{
+  SeqDiskCacheWriter *writer = &disk_cache_writer;
+
+  BLI_mutex_lock(&disk_cache_writer_lock);
+  while (true) {
+    DiskCacheWrite *write = BLI_pophead(&writer->queue);
+
+    if (write == NULL) {
+      if (writer->stop) {
+        break;
+      }
+      BLI_condition_wait(&writer->cond, &disk_cache_writer_lock);
+      continue;
+    }
+    BLI_mutex_unlock(&disk_cache_writer_lock);
+
+    if (!seq_disk_cache_has_file(write->path)) {
+      seq_disk_cache_write(write->path, write->ibuf);
+    }
+    IMB_freeImBuf(write->ibuf);
+    MEM_freeN(write);
+
+    BLI_mutex_lock(&disk_cache_writer_lock);
+    writer->queue_len--;
+  }
+  BLI_mutex_unlock(&disk_cache_writer_lock);
+
+  return NULL;
+}
+
+/* Queue image to be written by the background thread, which is started on first use. */
+static void seq_disk_cache_write_queue(const char *path, ImBuf *ibuf)
+{
+  SeqDiskCacheWriter *writer = &disk_cache_writer;
+
+  BLI_mutex_lock(&disk_cache_writer_lock);
+
+  if (!writer->running) {
+    BLI_listbase_clear(&writer->queue);
+    writer->queue_len = 0;
+    writer->stop = false;
+    BLI_condition_init(&writer->cond);
+    BLI_threadpool_init(&writer->threads, seq_disk_cache_writer_thread, 1);
+    BLI_threadpool_insert(&writer->threads, NULL);
+    writer->running = true;
+  }
+
+  /* Rather skip images than make rendering wait for the disk. */
+  if (writer->queue_len < DCACHE_WRITE_QUEUE_SIZE &&
+      BLI_findstring(&writer->queue, path, offsetof(DiskCacheWrite, path)) == NULL) {
+    DiskCacheWrite *write = MEM_callocN(sizeof(DiskCacheWrite), "DiskCacheWrite");
+    BLI_strncpy(write->path, path, sizeof(write->path));
+    IMB_refImBuf(ibuf);
+    write->ibuf = ibuf;
+
+    BLI_addtail(&writer->queue, write);
+    writer->queue_len++;
+    BLI_condition_notify_one(&writer->cond);
+  }
+
+  BLI_mutex_unlock(&disk_cache_writer_lock);
+}
+
+/* Drop queued images with path starting with given directory. */
+static void seq_disk_cache_write_queue_discard(const char *dir)
+{
+  SeqDiskCacheWriter *writer = &disk_cache_writer;
+  const size_t dir_len = strlen(dir);
+
+  BLI_mutex_lock(&disk_cache_writer_lock);
+  DiskCacheWrite *write = writer->queue.first;
+  while (write) {
+    DiskCacheWrite *write_next = write->next;
+
+    if (BLI_path_ncmp(write->path, dir, dir_len) == 0) {
+      BLI_remlink(&writer->queue, write);
+      writer->queue_len--;
+      IMB_freeImBuf(write->ibuf);
+      MEM_freeN(write);
+    }
+    write = write_next;
+  }
+  BLI_mutex_unlock(&disk_cache_writer_lock);
+}
+
+/* Write all queued images and stop the background thread. */
+static void seq_disk_cache_writer_end(void)
+{
+  SeqDiskCacheWriter *writer = &disk_cache_writer;
+
+  BLI_mutex_lock(&disk_cache_writer_lock);
+  if (!writer->running) {
+    BLI_mutex_unlock(&disk_cache_writer_lock);
+    return;
+  }
+  writer->stop = true;
+  BLI_condition_notify_all(&writer->cond);
+  BLI_mutex_unlock(&disk_cache_writer_lock);
+
+  BLI_threadpool_end(&writer->threads);
+  BLI_condition_end(&writer->cond);
+  writer->running = false;
+}
+
+static ImBuf *seq_disk_cache_read(const char *path)
+{
+  DiskCacheHeader header;
+  ImBuf *ibuf = NULL;
+
+  BLI_mutex_lock(&disk_cache_lock);
+  seq_disk_cache_ensure();
+  DiskCacheFile *file = BLI_ghash_lookup(disk_cache->files_hash, path);
+  if (file) {
+    /* Mark as most recently used. */
+    BLI_remlink(&disk_cache->files, file);
+    BLI_addtail(&disk_cache->files, file);
+  }
+  BLI_mutex_unlock(&disk_cache_lock);
+
+  if (file == NULL) {
+    return NULL;
+  }
+
+  gzFile gz_file = BLI_gzopen(path, "rb");
+  if (gz_file == NULL) {
+    return NULL;
+  }
+
+  if (!seq_disk_cache_gz_io(gz_file, &header, sizeof(header), false) ||
+      memcmp(header.magic, "BSDC", sizeof(header.magic)) != 0 ||
+      header.version != DCACHE_FILE_VERSION || header.x <= 0 || header.y <= 0 ||
+      header.channels <= 0 || header.channels > 4) {
+    gzclose(gz_file);
+    return NULL;
+  }
+
+  ibuf = IMB_allocImBuf(header.x, header.y, header.planes, 0);
+  if (header.is_float) {
+    ibuf->channels = header.channels;
+    imb_addrectfloatImBuf(ibuf);
+  }
+  else {
+    imb_addrectImBuf(ibuf);
+  }
+
+  void *data = header.is_float ? (void *)ibuf->rect_float : (void *)ibuf->rect;
+  bool ok = (data != NULL) &&
+            seq_disk_cache_gz_io(gz_file, data, seq_disk_cache_ibuf_data_len(ibuf), false);
+  gzclose(gz_file);
+
+  if (!ok) {
+    IMB_freeImBuf(ibuf);
+    return NULL;
+  }
+
+  header.colorspace[sizeof(header.colorspace) - 1] = '\0';
+  if (header.colorspace[0] != '\0') {
+    if (header.is_float) {
+      IMB_colormanagement_assign_float_colorspace(ibuf, header.colorspace);
+    }
+    else {
+      IMB_colormanagement_assign_rect_colorspace(ibuf, header.colorspace);
+    }
+  }
+
+  BLI_file_touch(path);
+
+  return ibuf;
+}
+
+/* Remove files of invalidated images, mirrors #BKE_sequencer_cache_cleanup_sequence. */
+static void seq_disk_cache_invalidate(Main *bmain,
+                                      Scene *scene,
+                                      Sequence *seq,
+                                      Sequence *seq_changed,
+                                      int range_start,
+                                      int range_end,
+                                      int invalidate_types)
+{
+  char scene_dir[FILE_MAX];
+  char strip_dir[FILE_MAX];
+
+  if (!seq_disk_cache_get_dir(bmain, scene, NULL, scene_dir) ||
+      !seq_disk_cache_get_dir(bmain, scene, seq, strip_dir)) {
+    return;
+  }
+
+  const size_t scene_dir_len = strlen(scene_dir);
+  const size_t strip_dir_len = strlen(strip_dir);
+
+  /* Queued images may be invalidated already. */
+  seq_disk_cache_write_queue_discard(scene_dir);
+
+  int invalidate_composite = invalidate_types & SEQ_CACHE_STORE_FINAL_OUT;
+  int invalidate_source = invalidate_types & (SEQ_CACHE_STORE_RAW | SEQ_CACHE_STORE_PREPROCESSED |
+                                              SEQ_CACHE_STORE_COMPOSITE);
+
+  BLI_mutex_lock(&disk_cache_lock);
+  seq_disk_cache_ensure();
+
+  DiskCacheFile *file = disk_cache->files.first;
+  while (file) {
+    DiskCacheFile *file_next = file->next;
+    unsigned int hash;
+    int type, cfra;
+
+    if (BLI_path_ncmp(file->path, scene_dir, scene_dir_len) == 0 &&
+        sscanf(BLI_path_basename(file->path), "%x-%d-%d", &hash, &type, &cfra) == 3) {
+      const bool is_strip_file = BLI_path_ncmp(file->path, strip_dir, strip_dir_len) == 0;
+
+      if ((type & invalidate_composite) && cfra >= range_start && cfra <= range_end) {
+        seq_disk_cache_delete_file(file);
+      }
+      else if ((type & invalidate_source) && is_strip_file && cfra >= seq_changed->startdisp &&
+               cfra <= seq_changed->enddisp) {
+        seq_disk_cache_delete_file(file);
+      }
+    }
+    file = file_next;
+  }
+
+  BLI_mutex_unlock(&disk_cache_lock);
+}
+
 static void BKE_sequencer_cache_create(Scene *scene)
 {
   BLI_mutex_lock(&cache_create_lock);
@@ -403,6 +1458,7 @@ static void BKE_sequencer_cache_create(Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
+    cache->disk_strip_hashes = BLI_ghash_ptr_new("SeqCache disk strip hashes");
     cache->last_key = NULL;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
@@ -410,6 +1466,29 @@ static void BKE_sequencer_cache_create(Scene *scene)
   BLI_mutex_unlock(&cache_create_lock);
 }
 
+static int seq_cache_flag_get(Scene *scene, Sequence *seq)
+{
+  int flag;
+
+  if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
+    flag = seq->cache_flag;
+    flag |= scene->ed->cache_flag & SEQ_CACHE_STORE_FINAL_OUT;
+  }
+  else {
+    flag = scene->ed->cache_flag;
+  }
+
+  return flag;
+}
+
+static void seq_cache_put_ex(const SeqRenderData *context,
+                             Sequence *seq,
+                             float cfra,
+                             int type,
+                             ImBuf *i,
+                             float cost,
+                             bool skip_disk_cache);
+
 /* ***************************** API ****************************** */
 
 void BKE_sequencer_cache_free_temp_cache(Scene *scene, short id, int cfra)
@@ -442,6 +1521,8 @@ void BKE_sequencer_cache_destruct(Scene *scene)
   }
 
   BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
+  BLI_ghash_free(cache->disk_strip_hashes, NULL, MEM_freeN);
+  seq_cache_last_decompressed_clear(cache);
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mutex_end(&cache->iterator_mutex);
@@ -457,6 +1538,8 @@ void BKE_sequencer_cache_cleanup_all(Main *bmain)
 }
 void BKE_sequencer_cache_cleanup(Scene *scene)
 {
+  BKE_sequencer_prefetch_stop(scene);
+
   SeqCache *cache = seq_cache_get_from_scene(scene);
   if (!cache) {
     return;
@@ -473,6 +1556,7 @@ void BKE_sequencer_cache_cleanup(Scene *scene)
     BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
   }
   cache->last_key = NULL;
+  seq_disk_cache_strip_hashes_clear(cache);
   seq_cache_unlock(scene);
 }
 
@@ -481,12 +1565,7 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
                                           Sequence *seq_changed,
                                           int invalidate_types)
 {
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
-    return;
-  }
-
-  seq_cache_lock(scene);
+  BKE_sequencer_prefetch_stop(scene);
 
   int range_start = seq_changed->startdisp;
   int range_end = seq_changed->enddisp;
@@ -499,6 +1578,18 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
     range_end = seq->enddisp;
   }
 
+  if (scene->ed && (scene->ed->cache_flag & SEQ_CACHE_DISK_CACHE_ENABLE)) {
+    seq_disk_cache_invalidate(
+        G_MAIN, scene, seq, seq_changed, range_start, range_end, invalidate_types);
+  }
+
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return;
+  }
+
+  seq_cache_lock(scene);
+
   int invalidate_composite = invalidate_types & SEQ_CACHE_STORE_FINAL_OUT;
   int invalidate_source = invalidate_types & (SEQ_CACHE_STORE_RAW | SEQ_CACHE_STORE_PREPROCESSED |
                                               SEQ_CACHE_STORE_COMPOSITE);
@@ -530,16 +1621,43 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
     }
   }
   cache->last_key = NULL;
+  /* Hashes of effects using the changed strip are affected too, simply hash all again. */
+  seq_disk_cache_strip_hashes_clear(cache);
   seq_cache_unlock(scene);
 }
 
-struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
-                                      Sequence *seq,
-                                      float cfra,
-                                      int type)
+static bool seq_cache_has_key(
+    Scene *scene, const SeqRenderData *context, Sequence *seq, float cfra, int type)
+{
+  SeqCacheKey key;
+  bool has_key = false;
+
+  key.seq = seq;
+  key.context = *context;
+  key.nfra = cfra - seq->start;
+  key.type = type;
+
+  seq_cache_lock(scene);
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (cache) {
+    has_key = BLI_ghash_haskey(cache->hash, &key);
+  }
+  seq_cache_unlock(scene);
+
+  return has_key;
+}
+
+static ImBuf *seq_cache_get_ex(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, bool use_disk_cache)
 {
   Scene *scene = context->scene;
 
+  if (context->is_prefetch_render) {
+    context = BKE_sequencer_prefetch_get_original_context(context);
+    scene = context->scene;
+    seq = BKE_sequencer_prefetch_get_original_sequence(seq, scene);
+  }
+
   if (!scene->ed->cache) {
     BKE_sequencer_cache_create(scene);
     return NULL;
@@ -548,6 +1666,7 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
   seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   ImBuf *ibuf = NULL;
+  struct ImBufCompressed *compressed = NULL;
 
   if (cache && seq) {
     SeqCacheKey key;
@@ -557,17 +1676,54 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
     key.nfra = cfra - seq->start;
     key.type = type;
 
-    ibuf = seq_cache_get(cache, &key);
+    ibuf = seq_cache_get(cache, &key, &compressed);
   }
   seq_cache_unlock(scene);
 
+  /* Decompress outside of cache lock, so other threads are not blocked. */
+  if (compressed) {
+    ibuf = seq_cache_decompress(scene, compressed);
+  }
+
+  /* Only images that would be stored permanently are looked up on disk. */
+  if (ibuf == NULL && seq && use_disk_cache && seq_disk_cache_is_enabled(context) &&
+      (seq_cache_flag_get(scene, seq) & type)) {
+    char path[FILE_MAX];
+
+    if (seq_disk_cache_get_file_path(context, seq, cfra, type, path)) {
+      ibuf = seq_disk_cache_read(path);
+    }
+
+    if (ibuf) {
+      /* Image is cheap to get again, so store it with zero cost to be recycled first. */
+      if (!seq_cache_is_full(scene->ed->cache) || seq_cache_recycle_item(scene)) {
+        seq_cache_put_ex(context, seq, cfra, type, ibuf, 0.0f, true);
+      }
+    }
+  }
+
   return ibuf;
 }
 
+struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
+                                      Sequence *seq,
+                                      float cfra,
+                                      int type)
+{
+  return seq_cache_get_ex(context, seq, cfra, type, true);
+}
+
 bool BKE_sequencer_cache_put_if_possible(
     const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *ibuf, float cost)
 {
-  Scene *scene = context->scene;
+  Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+
+  /* Prefetching must not push out frames that are already cached. */
+  if (context->is_prefetch_render && BKE_sequencer_cache_is_full(scene)) {
+    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
+    scene->ed->cache->last_key = NULL;
+    return false;
+  }
 
   if (seq_cache_recycle_item(scene)) {
     BKE_sequencer_cache_put(context, seq, cfra, type, ibuf, cost);
@@ -580,40 +1736,52 @@ bool BKE_sequencer_cache_put_if_possible(
   }
 }
 
-void BKE_sequencer_cache_put(
-    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *i, float cost)
+static void seq_cache_put_ex(const SeqRenderData *context,
+                             Sequence *seq,
+                             float cfra,
+                             int type,
+                             ImBuf *i,
+                             float cost,
+                             bool skip_disk_cache)
 {
-  Scene *scene = context->scene;
-  short creator_id = 0;
-
   if (i == NULL || context->skip_cache || context->is_proxy_render || !seq) {
     return;
   }
 
-  /* Prevent reinserting, it breaks cache key linking */
-  ImBuf *test = BKE_sequencer_cache_get(context, seq, cfra, type);
-  if (test) {
-    IMB_freeImBuf(test);
-    return;
+  Scene *scene = context->scene;
+  short creator_id = context->task_id;
+
+  if (context->is_prefetch_render) {
+    context = BKE_sequencer_prefetch_get_original_context(context);
+    scene = context->scene;
+    seq = BKE_sequencer_prefetch_get_original_sequence(seq, scene);
+    if (!seq) {
+      return;
+    }
   }
 
   if (!scene->ed->cache) {
     BKE_sequencer_cache_create(scene);
   }
 
-  seq_cache_lock(scene);
+  /* Prevent reinserting, it breaks cache key linking */
+  if (seq_cache_has_key(scene, context, seq, cfra, type)) {
+    return;
+  }
 
-  SeqCache *cache = seq_cache_get_from_scene(scene);
-  int flag;
+  int flag = seq_cache_flag_get(scene, seq);
 
-  if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
-    flag = seq->cache_flag;
-    flag |= scene->ed->cache_flag & SEQ_CACHE_STORE_FINAL_OUT;
-  }
-  else {
-    flag = scene->ed->cache_flag;
+  /* Compress outside of cache lock. Only images kept permanently are compressed, temporary
+   * ones are needed again right away while rendering the frame. */
+  struct ImBufCompressed *compressed = NULL;
+  if (flag & type) {
+    compressed = IMB_compressed_from_imbuf(i, U.cache_compression);
   }
 
+  seq_cache_lock(scene);
+
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+
   if (cost > SEQ_CACHE_COST_MAX) {
     cost = SEQ_CACHE_COST_MAX;
   }
@@ -639,7 +1807,7 @@ void BKE_sequencer_cache_put(
   }
 
   SeqCacheKey *temp_last_key = cache->last_key;
-  seq_cache_put(cache, key, i);
+  seq_cache_put(cache, key, i, compressed);
 
   /* Restore pointer to previous item as this one will be freed when stack is rendered */
   if (key->is_temp_cache) {
@@ -659,6 +1827,39 @@ void BKE_sequencer_cache_put(
   }
 
   seq_cache_unlock(scene);
+
+  if ((flag & type) && !skip_disk_cache && seq_disk_cache_is_enabled(context)) {
+    char path[FILE_MAX];
+
+    if (seq_disk_cache_get_file_path(context, seq, cfra, type, path)) {
+      seq_disk_cache_write_queue(path, i);
+    }
+  }
+}
+
+void BKE_sequencer_cache_put(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *i, float cost)
+{
+  seq_cache_put_ex(context, seq, cfra, type, i, cost, false);
+}
+
+void BKE_sequencer_disk_cache_free(void)
+{
+  seq_disk_cache_writer_end();
+
+  BLI_mutex_lock(&disk_cache_lock);
+  seq_disk_cache_free();
+  BLI_mutex_unlock(&disk_cache_lock);
+}
+
+bool BKE_sequencer_cache_is_full(Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return false;
+  }
+
+  return seq_cache_is_full(cache);
 }
 
 void BKE_sequencer_cache_iterate(
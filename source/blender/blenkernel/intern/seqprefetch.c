@@ -0,0 +1,486 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_screen_types.h"
+#include "DNA_sequence_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "BKE_global.h"
+#include "BKE_layer.h"
+#include "BKE_main.h"
+#include "BKE_sequencer.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+#include "DEG_depsgraph_query.h"
+
+/* ***************************** Sequencer prefetch design notes ******************************
+ *
+ * Prefetching renders frames ahead of the playhead in a background thread and stores final
+ * images in the sequencer cache of the original scene, so playback can pick them up directly.
+ *
+ * The prefetch thread never touches original data while rendering. It evaluates its own copy
+ * of the scene through a private dependency graph, which is rebuilt every time prefetching is
+ * (re)started. Images are stored in the cache of the original scene, keyed by the original
+ * strips, which are looked up by name (see #BKE_sequencer_prefetch_get_original_sequence).
+ *
+ * The evaluated copy of the scene references the job through `ed->prefetch_job` only while the
+ * job runs, so cache functions can resolve the original scene from a prefetch render context.
+ *
+ * Any cache invalidation stops the job. It is restarted by the next render request from the
+ * main thread. When the cache is full, the job is suspended until memory is available again.
+ */
+
+typedef struct PrefetchJob {
+  struct Main *bmain;
+  struct Main *bmain_eval;
+  struct Scene *scene;
+  struct Scene *scene_eval;
+  struct Depsgraph *depsgraph;
+
+  ThreadMutex prefetch_suspend_mutex;
+  ThreadCondition prefetch_suspend_cond;
+
+  ListBase threads;
+
+  /* Context used by the main thread, with original data. */
+  SeqRenderData context;
+  /* Context used for rendering, with evaluated data. */
+  SeqRenderData context_cpy;
+
+  /* Prefetch area. */
+  float cfra;
+  int num_frames_prefetched;
+
+  /* Control. */
+  bool running;
+  bool waiting;
+  bool stop;
+  /* Job reached the end of the frame range without being stopped. */
+  bool finished;
+} PrefetchJob;
+
+static PrefetchJob *seq_prefetch_job_get(Scene *scene)
+{
+  if (scene && scene->ed) {
+    return scene->ed->prefetch_job;
+  }
+  return NULL;
+}
+
+static bool seq_prefetch_job_is_running(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (!pfjob) {
+    return false;
+  }
+
+  return pfjob->running;
+}
+
+static bool seq_prefetch_job_is_waiting(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (!pfjob) {
+    return false;
+  }
+
+  return pfjob->waiting;
+}
+
+static Sequence *seq_prefetch_get_original_sequence(Sequence *seq, ListBase *seqbase)
+{
+  for (Sequence *seq_orig = seqbase->first; seq_orig; seq_orig = seq_orig->next) {
+    if (STREQ(seq->name, seq_orig->name)) {
+      return seq_orig;
+    }
+
+    if (seq_orig->type == SEQ_TYPE_META) {
+      Sequence *match = seq_prefetch_get_original_sequence(seq, &seq_orig->seqbase);
+      if (match != NULL) {
+        return match;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/* For cache context swapping. */
+Sequence *BKE_sequencer_prefetch_get_original_sequence(Sequence *seq, Scene *scene)
+{
+  Editing *ed = scene->ed;
+  return seq_prefetch_get_original_sequence(seq, &ed->seqbase);
+}
+
+/* For cache context swapping. */
+SeqRenderData *BKE_sequencer_prefetch_get_original_context(const SeqRenderData *context)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+
+  return &pfjob->context;
+}
+
+Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context)
+{
+  Scene *scene = context->scene;
+
+  if (context->is_prefetch_render) {
+    PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+    scene = pfjob->scene;
+  }
+
+  return scene;
+}
+
+static bool seq_prefetch_is_playing(Main *bmain)
+{
+  for (bScreen *sc = bmain->screens.first; sc; sc = sc->id.next) {
+    if (sc->animtimer) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static float seq_prefetch_cfra(PrefetchJob *pfjob)
+{
+  return pfjob->cfra + pfjob->num_frames_prefetched;
+}
+
+static void seq_prefetch_update_area(PrefetchJob *pfjob)
+{
+  int cfra = pfjob->scene->r.cfra;
+
+  /* Rebase when the playhead moves forward. */
+  if (cfra > pfjob->cfra) {
+    int delta = cfra - pfjob->cfra;
+    pfjob->cfra = cfra;
+    pfjob->num_frames_prefetched -= delta;
+
+    if (pfjob->num_frames_prefetched <= 1) {
+      pfjob->num_frames_prefetched = 1;
+    }
+  }
+
+  /* Reset when the playhead moves backward. */
+  if (cfra < pfjob->cfra) {
+    pfjob->cfra = cfra;
+    pfjob->num_frames_prefetched = 1;
+  }
+}
+
+/* Strips that must not be rendered outside of the main thread.
+ * Scene strips use the render pipeline or OpenGL, text strips use the global font state. */
+static bool seq_prefetch_must_skip_frame(ListBase *seqbase, int cfra)
+{
+  for (Sequence *seq = seqbase->first; seq; seq = seq->next) {
+    if (cfra < seq->startdisp || cfra >= seq->enddisp) {
+      continue;
+    }
+    if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_TEXT)) {
+      return true;
+    }
+    if (seq->type == SEQ_TYPE_META && seq_prefetch_must_skip_frame(&seq->seqbase, cfra)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void seq_prefetch_resume(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (pfjob && pfjob->waiting) {
+    BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+    BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+  }
+}
+
+/* Stop the prefetch job and wait until its thread finished. */
+void BKE_sequencer_prefetch_stop(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (!pfjob) {
+    return;
+  }
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  pfjob->stop = true;
+  BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  BLI_threadpool_clear(&pfjob->threads);
+
+  pfjob->running = false;
+  pfjob->finished = false;
+}
+
+void BKE_sequencer_prefetch_stop_all(Main *bmain)
+{
+  for (Scene *scene = bmain->scenes.first; scene; scene = scene->id.next) {
+    BKE_sequencer_prefetch_stop(scene);
+  }
+}
+
+static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+{
+  DEG_evaluate_on_framechange(pfjob->bmain_eval, pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+}
+
+static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+{
+  Main *bmain = pfjob->bmain_eval;
+  Scene *scene = pfjob->scene;
+  ViewLayer *view_layer = BKE_view_layer_default_render(scene);
+
+  pfjob->depsgraph = DEG_graph_new(scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+
+  /* Make sure there is a correct evaluated scene pointer. */
+  DEG_graph_build_for_render_pipeline(pfjob->depsgraph, bmain, scene, view_layer);
+
+  /* Update immediately so we have proper evaluated scene. */
+  seq_prefetch_update_depsgraph(pfjob);
+
+  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
+  pfjob->scene_eval->ed->cache_flag = 0;
+}
+
+static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+{
+  if (pfjob->depsgraph != NULL) {
+    DEG_graph_free(pfjob->depsgraph);
+  }
+  pfjob->depsgraph = NULL;
+  pfjob->scene_eval = NULL;
+}
+
+static void seq_prefetch_update_scene(PrefetchJob *pfjob, Scene *scene)
+{
+  pfjob->scene = scene;
+  seq_prefetch_free_depsgraph(pfjob);
+  seq_prefetch_init_depsgraph(pfjob);
+}
+
+static void seq_prefetch_update_context(PrefetchJob *pfjob, const SeqRenderData *context)
+{
+  BKE_sequencer_new_render_data(pfjob->bmain_eval,
+                                pfjob->depsgraph,
+                                pfjob->scene_eval,
+                                context->rectx,
+                                context->recty,
+                                context->preview_render_size,
+                                false,
+                                &pfjob->context_cpy);
+  pfjob->context_cpy.view_id = context->view_id;
+  pfjob->context_cpy.is_prefetch_render = true;
+  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+
+  BKE_sequencer_new_render_data(pfjob->bmain,
+                                context->depsgraph,
+                                pfjob->scene,
+                                context->rectx,
+                                context->recty,
+                                context->preview_render_size,
+                                false,
+                                &pfjob->context);
+  pfjob->context.view_id = context->view_id;
+  pfjob->context.is_prefetch_render = false;
+  /* Same ID as prefetch context, because the contexts are swapped when accessing cache, but
+   * entries created by this thread must still be tagged with it for temp cache to work. */
+  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+}
+
+void BKE_sequencer_prefetch_free(Scene *scene)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (!pfjob) {
+    return;
+  }
+
+  BKE_sequencer_prefetch_stop(scene);
+
+  BLI_threadpool_end(&pfjob->threads);
+  BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
+  BLI_condition_end(&pfjob->prefetch_suspend_cond);
+  seq_prefetch_free_depsgraph(pfjob);
+  BKE_main_free(pfjob->bmain_eval);
+  MEM_freeN(pfjob);
+  scene->ed->prefetch_job = NULL;
+}
+
+static void *seq_prefetch_frames(void *job)
+{
+  PrefetchJob *pfjob = (PrefetchJob *)job;
+
+  while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
+    float cfra = seq_prefetch_cfra(pfjob);
+
+    if (!seq_prefetch_must_skip_frame(pfjob->scene_eval->ed->seqbasep, (int)cfra)) {
+      seq_prefetch_update_depsgraph(pfjob);
+
+      /* The evaluated scene must not reference the job outside of this function, since the
+       * dependency graph would try to free it with the scene copy. */
+      pfjob->scene_eval->ed->prefetch_job = pfjob;
+
+      ImBuf *ibuf = BKE_sequencer_give_ibuf(&pfjob->context_cpy, cfra, 0);
+      BKE_sequencer_cache_free_temp_cache(pfjob->scene, SEQ_TASK_PREFETCH_RENDER, cfra);
+      IMB_freeImBuf(ibuf);
+
+      pfjob->scene_eval->ed->prefetch_job = NULL;
+    }
+
+    /* Suspend thread if cache is full. */
+    BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+    while (BKE_sequencer_cache_is_full(pfjob->scene) && !pfjob->stop) {
+      pfjob->waiting = true;
+      BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+      seq_prefetch_update_area(pfjob);
+    }
+    pfjob->waiting = false;
+    BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+    if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
+      break;
+    }
+
+    /* Avoid "collision" with main thread, but make sure to fetch at least few frames. */
+    if (pfjob->num_frames_prefetched > 5 &&
+        (seq_prefetch_cfra(pfjob) - pfjob->scene->r.cfra) < 2) {
+      break;
+    }
+
+    seq_prefetch_update_area(pfjob);
+    pfjob->num_frames_prefetched++;
+  }
+
+  if (!pfjob->stop && seq_prefetch_cfra(pfjob) > pfjob->scene->r.efra) {
+    pfjob->finished = true;
+  }
+
+  BKE_sequencer_cache_free_temp_cache(
+      pfjob->scene, SEQ_TASK_PREFETCH_RENDER, seq_prefetch_cfra(pfjob));
+  pfjob->running = false;
+
+  return NULL;
+}
+
+static void seq_prefetch_start(const SeqRenderData *context, float cfra)
+{
+  Scene *scene = context->scene;
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+
+  if (!pfjob) {
+    pfjob = MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
+    scene->ed->prefetch_job = pfjob;
+
+    BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+    BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
+    BLI_condition_init(&pfjob->prefetch_suspend_cond);
+
+    pfjob->bmain_eval = BKE_main_new();
+  }
+  else {
+    /* Join the thread of previous run, if any. */
+    BLI_threadpool_clear(&pfjob->threads);
+  }
+
+  pfjob->bmain = context->bmain;
+  pfjob->cfra = cfra;
+  pfjob->num_frames_prefetched = 1;
+  pfjob->waiting = false;
+  pfjob->stop = false;
+  pfjob->finished = false;
+  pfjob->running = true;
+
+  seq_prefetch_update_scene(pfjob, scene);
+  seq_prefetch_update_context(pfjob, context);
+
+  BLI_threadpool_insert(&pfjob->threads, pfjob);
+}
+
+/* Start or resume prefetching, called after the main thread rendered a frame.
+ * `cost` is render cost of the frame, see #BKE_sequencer_cache_put. */
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, float cost)
+{
+  Scene *scene = context->scene;
+  Editing *ed = scene->ed;
+
+  if (context->is_prefetch_render || context->is_proxy_render || context->for_render) {
+    return;
+  }
+
+  seq_prefetch_resume(scene);
+
+  if ((ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) == 0 ||
+      (ed->cache_flag & SEQ_CACHE_ALL_TYPES) == 0 || ed->seqbasep->first == NULL ||
+      G.is_rendering) {
+    return;
+  }
+
+  if (seq_prefetch_job_is_running(scene)) {
+    return;
+  }
+
+  /* Don't compete with playback of frames that are expensive to render. */
+  if (seq_prefetch_is_playing(context->bmain) && cost > 0.9f) {
+    return;
+  }
+
+  /* Nothing changed since prefetching reached the end of the frame range. */
+  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
+  if (pfjob && pfjob->finished && cfra >= pfjob->cfra) {
+    return;
+  }
+
+  seq_prefetch_start(context, cfra);
+}
+
+/* Timeline has to be redrawn while the job runs to show cached frames. */
+bool BKE_sequencer_prefetch_need_redraw(Main *bmain, Scene *scene)
+{
+  bool playing = seq_prefetch_is_playing(bmain);
+  bool running = seq_prefetch_job_is_running(scene);
+  bool suspended = seq_prefetch_job_is_waiting(scene);
+
+  return running && !playing && !suspended && (scene->ed->cache_flag & SEQ_CACHE_VIEW_ENABLE);
+}
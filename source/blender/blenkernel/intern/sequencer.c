@@ -46,6 +46,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -57,6 +58,8 @@
 
 #include "BLT_translation.h"
 
+#include "PIL_time.h"
+
 #include "BKE_animsys.h"
 #include "BKE_global.h"
 #include "BKE_image.h"
@@ -483,6 +486,7 @@ void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
     return;
   }
 
+  BKE_sequencer_prefetch_free(scene);
   BKE_sequencer_cache_destruct(scene);
 
   SEQ_BEGIN (ed, seq) {
@@ -633,8 +637,10 @@ void BKE_sequencer_new_render_data(Main *bmain,
   r_context->motion_blur_shutter = 0;
   r_context->skip_cache = false;
   r_context->is_proxy_render = false;
+  r_context->is_prefetch_render = false;
   r_context->view_id = 0;
   r_context->gpu_offscreen = NULL;
+  r_context->task_id = SEQ_TASK_MAIN_RENDER;
 }
 
 /* ************************* iterator ************************** */
@@ -3834,6 +3840,21 @@ static float seq_estimate_render_cost_end(Scene *scene, clock_t begin)
   }
 }
 
+/* Remember how long rendering of the strip took, for display in the timeline. */
+static void seq_render_strip_time_store(const SeqRenderData *context,
+                                        Sequence *seq,
+                                        double time_begin)
+{
+  if (context->is_prefetch_render) {
+    Scene *scene = BKE_sequencer_prefetch_get_original_scene(context);
+    seq = BKE_sequencer_prefetch_get_original_sequence(seq, scene);
+  }
+
+  if (seq) {
+    seq->render_time = (float)((PIL_check_seconds_timer() - time_begin) * 1000.0);
+  }
+}
+
 static ImBuf *seq_render_strip(const SeqRenderData *context,
                                SeqRenderState *state,
                                Sequence *seq,
@@ -3849,6 +3870,7 @@ static ImBuf *seq_render_strip(const SeqRenderData *context,
       type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP);
 
   clock_t begin = seq_estimate_render_cost_begin();
+  double time_begin = PIL_check_seconds_timer();
 
   ibuf = BKE_sequencer_cache_get(context, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED);
 
@@ -3897,6 +3919,8 @@ static ImBuf *seq_render_strip(const SeqRenderData *context,
 
     float cost = seq_estimate_render_cost_end(context->scene, begin);
     BKE_sequencer_cache_put(context, seq, cfra, SEQ_CACHE_STORE_PREPROCESSED, ibuf, cost);
+
+    seq_render_strip_time_store(context, seq, time_begin);
   }
   return ibuf;
 }
@@ -3968,6 +3992,133 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/* Strips that only read their own data and can be rendered from multiple threads at once.
+ * Modifier masks render another strip or evaluate a mask, so those strips are not. */
+static bool seq_render_strip_is_independent(Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE, SEQ_TYPE_COLOR)) {
+    return false;
+  }
+
+  for (SequenceModifierData *smd = seq->modifiers.first; smd; smd = smd->next) {
+    if (smd->mask_sequence || smd->mask_id) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+typedef struct RenderStripInputsData {
+  const SeqRenderData *context;
+  SeqRenderState *state;
+  Sequence **seq_arr;
+  ImBuf **ibuf_arr;
+  float cfra;
+} RenderStripInputsData;
+
+static void seq_render_strip_stack_inputs_cb(void *__restrict userdata,
+                                             const int i,
+                                             const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+  RenderStripInputsData *data = userdata;
+
+  data->ibuf_arr[i] = seq_render_strip(data->context, data->state, data->seq_arr[i], data->cfra);
+}
+
+/* Render inputs of the blend stack in parallel, before they are composited.
+ * Walks the stack the same way as #seq_render_strip_stack does, stopping at the first strip
+ * that replaces everything below it. */
+static void seq_render_strip_stack_inputs(const SeqRenderData *context,
+                                          SeqRenderState *state,
+                                          Sequence **seq_arr,
+                                          int count,
+                                          float cfra,
+                                          ImBuf **r_ibuf_arr)
+{
+  Sequence *seq_render[MAXSEQ + 1];
+  ImBuf *ibuf_render[MAXSEQ + 1];
+  int render_index[MAXSEQ + 1];
+  int render_count = 0;
+
+  for (int i = count - 1; i >= 0; i--) {
+    Sequence *seq = seq_arr[i];
+    ImBuf *composite = BKE_sequencer_cache_get(context, seq, cfra, SEQ_CACHE_STORE_COMPOSITE);
+    bool is_base = false;
+
+    if (composite) {
+      IMB_freeImBuf(composite);
+      break;
+    }
+
+    if (seq->blend_mode == SEQ_BLEND_REPLACE) {
+      is_base = true;
+    }
+    else {
+      switch (seq_get_early_out_for_blend_mode(seq)) {
+        case EARLY_NO_INPUT:
+        case EARLY_USE_INPUT_2:
+          is_base = true;
+          break;
+        case EARLY_USE_INPUT_1:
+          continue;
+        case EARLY_DO_EFFECT:
+          break;
+      }
+    }
+
+    if (seq_render_strip_is_independent(seq)) {
+      seq_render[render_count] = seq;
+      render_index[render_count] = i;
+      render_count++;
+    }
+
+    if (is_base) {
+      break;
+    }
+  }
+
+  /* Nothing to gain from threading. */
+  if (render_count < 2) {
+    return;
+  }
+
+  RenderStripInputsData data = {
+      .context = context,
+      .state = state,
+      .seq_arr = seq_render,
+      .ibuf_arr = ibuf_render,
+      .cfra = cfra,
+  };
+
+  ParallelRangeSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  BLI_task_parallel_range(0, render_count, &data, seq_render_strip_stack_inputs_cb, &settings);
+
+  for (int i = 0; i < render_count; i++) {
+    r_ibuf_arr[render_index[i]] = ibuf_render[i];
+  }
+}
+
+/* Use image rendered by #seq_render_strip_stack_inputs if there is one. */
+static ImBuf *seq_render_strip_stack_input_get(const SeqRenderData *context,
+                                               SeqRenderState *state,
+                                               Sequence *seq,
+                                               float cfra,
+                                               ImBuf **ibuf_arr,
+                                               int i)
+{
+  ImBuf *ibuf = ibuf_arr[i];
+
+  if (ibuf) {
+    ibuf_arr[i] = NULL;
+    return ibuf;
+  }
+
+  return seq_render_strip(context, state, seq, cfra);
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *seqbasep,
@@ -3975,6 +4126,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      int chanshown)
 {
   Sequence *seq_arr[MAXSEQ + 1];
+  ImBuf *ibuf_arr[MAXSEQ + 1] = {NULL};
   int count;
   int i;
   ImBuf *out = NULL;
@@ -3986,6 +4138,10 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  if (context->scene->r.seq_flag & R_SEQ_PARALLEL_RENDER) {
+    seq_render_strip_stack_inputs(context, state, seq_arr, count, cfra, ibuf_arr);
+  }
+
   for (i = count - 1; i >= 0; i--) {
     int early_out;
     Sequence *seq = seq_arr[i];
@@ -3996,7 +4152,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, cfra);
+      out = seq_render_strip_stack_input_get(context, state, seq, cfra, ibuf_arr, i);
       break;
     }
 
@@ -4005,7 +4161,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     switch (early_out) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, cfra);
+        out = seq_render_strip_stack_input_get(context, state, seq, cfra, ibuf_arr, i);
         break;
       case EARLY_USE_INPUT_1:
         if (i == 0) {
@@ -4017,7 +4173,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
           begin = seq_estimate_render_cost_begin();
 
           ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+          ImBuf *ibuf2 = seq_render_strip_stack_input_get(
+              context, state, seq, cfra, ibuf_arr, i);
 
           out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -4041,7 +4198,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+      ImBuf *ibuf2 = seq_render_strip_stack_input_get(context, state, seq, cfra, ibuf_arr, i);
 
       out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -4053,6 +4210,14 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     BKE_sequencer_cache_put(context, seq_arr[i], cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost);
   }
 
+  /* Images rendered ahead are unused when composite image was cached by another thread
+   * in the meantime. */
+  for (i = 0; i < count; i++) {
+    if (ibuf_arr[i]) {
+      IMB_freeImBuf(ibuf_arr[i]);
+    }
+  }
+
   return out;
 }
 
@@ -4092,7 +4257,8 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
     out = BKE_sequencer_cache_get(context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT);
   }
 
-  BKE_sequencer_cache_free_temp_cache(context->scene, 0, cfra);
+  BKE_sequencer_cache_free_temp_cache(
+      BKE_sequencer_prefetch_get_original_scene(context), context->task_id, cfra);
 
   clock_t begin = seq_estimate_render_cost_begin();
   float cost = 0;
@@ -4104,6 +4270,10 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
         context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT, out, cost);
   }
 
+  if (chanshown == 0) {
+    BKE_sequencer_prefetch_start(context, cfra, cost);
+  }
+
   return out;
 }
 
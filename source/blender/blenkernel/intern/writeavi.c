@@ -54,7 +54,7 @@ static int start_stub(void *UNUSED(context_v),
   return 0;
 }
 
-static void end_stub(void *UNUSED(context_v))
+static void end_stub(void *UNUSED(context_v), ReportList *UNUSED(reports))
 {
 }
 
@@ -92,7 +92,7 @@ static int start_avi(void *context_v,
                      ReportList *reports,
                      bool preview,
                      const char *suffix);
-static void end_avi(void *context_v);
+static void end_avi(void *context_v, ReportList *reports);
 static int append_avi(void *context_v,
                       RenderData *rd,
                       int start_frame,
@@ -288,7 +288,7 @@ static int append_avi(void *context_v,
   return 1;
 }
 
-static void end_avi(void *context_v)
+static void end_avi(void *context_v, ReportList *UNUSED(reports))
 {
   AviMovie *avi = context_v;
 
@@ -43,6 +43,8 @@
 #  endif
 
 #  include "BLI_utildefines.h"
+#  include "BLI_task.h"
+#  include "BLI_threads.h"
 
 #  include "BKE_global.h"
 #  include "BKE_idprop.h"
@@ -59,6 +61,15 @@
 
 struct StampData;
 
+/* Frame waiting in the queue to be encoded. */
+typedef struct FFMpegEncodeFrame {
+  struct FFMpegEncodeFrame *next, *prev;
+  /* Flipped BGR32 pixels, ready for color conversion. */
+  uint8_t *pixels;
+  int frame;
+  double audio_pts;
+} FFMpegEncodeFrame;
+
 typedef struct FFMpegContext {
   int ffmpeg_type;
   int ffmpeg_codec;
@@ -96,10 +107,33 @@ typedef struct FFMpegContext {
 #  ifdef WITH_AUDASPACE
   AUD_Device *audio_mixdown_device;
 #  endif
+
+  /* Frames are encoded in a background thread, so rendering of the next frame overlaps with
+   * encoding. Everything that touches the output file is done by that thread. */
+  ListBase encode_threads;
+  ListBase encode_queue;
+  int encode_queue_len;
+  ThreadMutex encode_mutex;
+  ThreadCondition encode_cond;
+  bool encode_running;
+  bool encode_stop;
+  bool encode_failed;
+  /* Encode errors already reported to the user by #BKE_ffmpeg_append. */
+  bool encode_failed_reported;
+
+  /* Settings needed to start a new file on autosplit. The caller thread only reads these,
+   * never the streams, which are re-created by the encode thread on autosplit. */
+  RenderData *encode_rd;
+  bool encode_video;
+  int encode_rectx, encode_recty;
+  char encode_suffix[64];
 } FFMpegContext;
 
 #  define FFMPEG_AUTOSPLIT_SIZE 2000000000
 
+/* Number of rendered frames which can wait for encoding. */
+#  define FFMPEG_ENCODE_QUEUE_SIZE 4
+
 #  define PRINT \
     if (G.debug & G_DEBUG_FFMPEG) \
     printf
@@ -109,6 +143,8 @@ static void ffmpeg_dict_set_float(AVDictionary **dict, const char *key, float va
 static void ffmpeg_set_expert_options(RenderData *rd);
 static void ffmpeg_filepath_get(
     FFMpegContext *context, char *string, struct RenderData *rd, bool preview, const char *suffix);
+static void ffmpeg_encode_thread_start(
+    FFMpegContext *context, RenderData *rd, int rectx, int recty, const char *suffix);
 
 /* Delete a picture buffer */
 
@@ -367,68 +403,71 @@ static int write_video_frame(
   return success;
 }
 
-/* read and encode a frame of audio from the buffer */
-static AVFrame *generate_video_frame(FFMpegContext *context, uint8_t *pixels, ReportList *reports)
-{
-  uint8_t *rendered_frame;
-
-  AVCodecContext *c = context->video_stream->codec;
-  int width = c->width;
-  int height = c->height;
-  AVFrame *rgb_frame;
-
-  if (c->pix_fmt != AV_PIX_FMT_BGR32) {
-    rgb_frame = alloc_picture(AV_PIX_FMT_BGR32, width, height);
-    if (!rgb_frame) {
-      BKE_report(reports, RPT_ERROR, "Could not allocate temporary frame");
-      return NULL;
-    }
-  }
-  else {
-    rgb_frame = context->current_frame;
-  }
+typedef struct FlipFrameData {
+  const uint8_t *src;
+  uint8_t *dst;
+  int width, height;
+} FlipFrameData;
 
-  rendered_frame = pixels;
+static void flip_frame_row_cb(void *__restrict userdata,
+                              const int y,
+                              const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+  const FlipFrameData *data = userdata;
+  const int width = data->width;
+  uint8_t *target = data->dst + width * 4 * (data->height - y - 1);
+  const uint8_t *src = data->src + width * 4 * y;
+  const uint8_t *end = src + width * 4;
 
   /* Do RGBA-conversion and flipping in one step depending
    * on CPU-Endianess */
 
   if (ENDIAN_ORDER == L_ENDIAN) {
-    int y;
-    for (y = 0; y < height; y++) {
-      uint8_t *target = rgb_frame->data[0] + width * 4 * (height - y - 1);
-      uint8_t *src = rendered_frame + width * 4 * y;
-      uint8_t *end = src + width * 4;
-      while (src != end) {
-        target[3] = src[3];
-        target[2] = src[2];
-        target[1] = src[1];
-        target[0] = src[0];
-
-        target += 4;
-        src += 4;
-      }
-    }
+    memcpy(target, src, width * 4);
   }
   else {
-    int y;
-    for (y = 0; y < height; y++) {
-      uint8_t *target = rgb_frame->data[0] + width * 4 * (height - y - 1);
-      uint8_t *src = rendered_frame + width * 4 * y;
-      uint8_t *end = src + width * 4;
-      while (src != end) {
-        target[3] = src[0];
-        target[2] = src[1];
-        target[1] = src[2];
-        target[0] = src[3];
-
-        target += 4;
-        src += 4;
-      }
+    while (src != end) {
+      target[3] = src[0];
+      target[2] = src[1];
+      target[1] = src[2];
+      target[0] = src[3];
+
+      target += 4;
+      src += 4;
     }
   }
+}
+
+/* Copy rendered pixels into a new BGR32 buffer in the layout FFmpeg expects, rows are
+ * converted in parallel. The copy is owned by the encode queue. */
+static uint8_t *flip_video_frame(const uint8_t *pixels, int width, int height)
+{
+  uint8_t *flipped = MEM_mallocN((size_t)width * height * 4, "ffmpeg flipped frame");
+  FlipFrameData data = {pixels, flipped, width, height};
+
+  ParallelRangeSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (height > 64);
+  settings.min_iter_per_thread = 16;
+  BLI_task_parallel_range(0, height, &data, flip_frame_row_cb, &settings);
+
+  return flipped;
+}
+
+/* Convert flipped BGR32 pixels to the pixel format of the codec. */
+static AVFrame *generate_video_frame(FFMpegContext *context, uint8_t *pixels)
+{
+  AVCodecContext *c = context->video_stream->codec;
+  int width = c->width;
+  int height = c->height;
 
   if (c->pix_fmt != AV_PIX_FMT_BGR32) {
+    AVFrame *rgb_frame = av_frame_alloc();
+    if (!rgb_frame) {
+      return NULL;
+    }
+
+    avpicture_fill((AVPicture *)rgb_frame, pixels, AV_PIX_FMT_BGR32, width, height);
     sws_scale(context->img_convert_ctx,
               (const uint8_t *const *)rgb_frame->data,
               rgb_frame->linesize,
@@ -436,7 +475,10 @@ static AVFrame *generate_video_frame(FFMpegContext *context, uint8_t *pixels, Re
               c->height,
               context->current_frame->data,
               context->current_frame->linesize);
-    delete_picture(rgb_frame);
+    av_free(rgb_frame);
+  }
+  else {
+    memcpy(context->current_frame->data[0], pixels, (size_t)width * height * 4);
   }
 
   context->current_frame->format = AV_PIX_FMT_BGR32;
@@ -1315,6 +1357,11 @@ int BKE_ffmpeg_start(void *context_v,
 #    endif
   }
 #  endif
+
+  if (success) {
+    ffmpeg_encode_thread_start(context, rd, rectx, recty, suffix);
+  }
+
   return success;
 }
 
@@ -1333,6 +1380,114 @@ static void write_audio_frames(FFMpegContext *context, double to_pts)
 }
 #  endif
 
+/* Encode one frame from the queue, runs in the encode thread. */
+static bool ffmpeg_encode_frame(FFMpegContext *context, FFMpegEncodeFrame *encode_frame)
+{
+  RenderData *rd = context->encode_rd;
+  bool success = true;
+
+  if (context->video_stream) {
+    AVFrame *avframe = generate_video_frame(context, encode_frame->pixels);
+    success = (avframe &&
+               write_video_frame(context, rd, encode_frame->frame, avframe, NULL));
+
+    if (context->ffmpeg_autosplit) {
+      if (avio_tell(context->outfile->pb) > FFMPEG_AUTOSPLIT_SIZE) {
+        end_ffmpeg_impl(context, true);
+        context->ffmpeg_autosplit_count++;
+        success &= start_ffmpeg_impl(context,
+                                     rd,
+                                     context->encode_rectx,
+                                     context->encode_recty,
+                                     context->encode_suffix,
+                                     NULL);
+      }
+    }
+  }
+
+#  ifdef WITH_AUDASPACE
+  write_audio_frames(context, encode_frame->audio_pts);
+#  endif
+
+  return success;
+}
+
+static void *ffmpeg_encode_thread(void *context_v)
+{
+  FFMpegContext *context = context_v;
+
+  BLI_mutex_lock(&context->encode_mutex);
+  while (true) {
+    FFMpegEncodeFrame *encode_frame = BLI_pophead(&context->encode_queue);
+
+    if (encode_frame == NULL) {
+      if (context->encode_stop) {
+        break;
+      }
+      BLI_condition_wait(&context->encode_cond, &context->encode_mutex);
+      continue;
+    }
+    BLI_mutex_unlock(&context->encode_mutex);
+
+    bool success = context->encode_failed || ffmpeg_encode_frame(context, encode_frame);
+
+    MEM_SAFE_FREE(encode_frame->pixels);
+    MEM_freeN(encode_frame);
+
+    BLI_mutex_lock(&context->encode_mutex);
+    context->encode_queue_len--;
+    if (!success) {
+      context->encode_failed = true;
+    }
+    BLI_condition_notify_all(&context->encode_cond);
+  }
+  BLI_mutex_unlock(&context->encode_mutex);
+
+  return NULL;
+}
+
+static void ffmpeg_encode_thread_start(
+    FFMpegContext *context, RenderData *rd, int rectx, int recty, const char *suffix)
+{
+  context->encode_rd = rd;
+  context->encode_video = (context->video_stream != NULL);
+  context->encode_rectx = rectx;
+  context->encode_recty = recty;
+  BLI_strncpy(context->encode_suffix, suffix, sizeof(context->encode_suffix));
+
+  BLI_listbase_clear(&context->encode_queue);
+  context->encode_queue_len = 0;
+  context->encode_stop = false;
+  context->encode_failed = false;
+  context->encode_failed_reported = false;
+
+  BLI_mutex_init(&context->encode_mutex);
+  BLI_condition_init(&context->encode_cond);
+  BLI_threadpool_init(&context->encode_threads, ffmpeg_encode_thread, 1);
+  BLI_threadpool_insert(&context->encode_threads, context);
+  context->encode_running = true;
+}
+
+/* Wait for all queued frames to be encoded, returns false when any of them failed. */
+static bool ffmpeg_encode_thread_end(FFMpegContext *context)
+{
+  if (!context->encode_running) {
+    return true;
+  }
+
+  BLI_mutex_lock(&context->encode_mutex);
+  context->encode_stop = true;
+  BLI_condition_notify_all(&context->encode_cond);
+  BLI_mutex_unlock(&context->encode_mutex);
+
+  BLI_threadpool_end(&context->encode_threads);
+  BLI_condition_end(&context->encode_cond);
+  BLI_mutex_end(&context->encode_mutex);
+  context->encode_running = false;
+
+  return !context->encode_failed;
+}
+
 int BKE_ffmpeg_append(void *context_v,
                       RenderData *rd,
                       int start_frame,
@@ -1340,35 +1495,54 @@ int BKE_ffmpeg_append(void *context_v,
                       int *pixels,
                       int rectx,
                       int recty,
-                      const char *suffix,
+                      const char *UNUSED(suffix),
                       ReportList *reports)
 {
   FFMpegContext *context = context_v;
-  AVFrame *avframe;
-  int success = 1;
+  FFMpegEncodeFrame *encode_frame;
+  bool success;
 
   PRINT("Writing frame %i, render width=%d, render height=%d\n", frame, rectx, recty);
 
   /* why is this done before writing the video frame and again at end_ffmpeg? */
   //  write_audio_frames(frame / (((double)rd->frs_sec) / rd->frs_sec_base));
 
-  if (context->video_stream) {
-    avframe = generate_video_frame(context, (unsigned char *)pixels, reports);
-    success = (avframe && write_video_frame(context, rd, frame - start_frame, avframe, reports));
+  if (!context->encode_running) {
+    return 0;
+  }
 
-    if (context->ffmpeg_autosplit) {
-      if (avio_tell(context->outfile->pb) > FFMPEG_AUTOSPLIT_SIZE) {
-        end_ffmpeg_impl(context, true);
-        context->ffmpeg_autosplit_count++;
-        success &= start_ffmpeg_impl(context, rd, rectx, recty, suffix, reports);
-      }
-    }
+  encode_frame = MEM_callocN(sizeof(FFMpegEncodeFrame), "FFMpegEncodeFrame");
+  encode_frame->frame = frame - start_frame;
+  encode_frame->audio_pts = (frame - start_frame) /
+                            (((double)rd->frs_sec) / (double)rd->frs_sec_base);
+
+  if (context->encode_video) {
+    encode_frame->pixels = flip_video_frame(
+        (const uint8_t *)pixels, context->encode_rectx, context->encode_recty);
+  }
+
+  BLI_mutex_lock(&context->encode_mutex);
+  /* Limit memory used by frames waiting for the encoder. */
+  while (context->encode_queue_len >= FFMPEG_ENCODE_QUEUE_SIZE && !context->encode_failed) {
+    BLI_condition_wait(&context->encode_cond, &context->encode_mutex);
+  }
+  success = !context->encode_failed;
+  if (success) {
+    BLI_addtail(&context->encode_queue, encode_frame);
+    context->encode_queue_len++;
+    BLI_condition_notify_all(&context->encode_cond);
+  }
+  else {
+    context->encode_failed_reported = true;
+  }
+  BLI_mutex_unlock(&context->encode_mutex);
+
+  if (!success) {
+    MEM_SAFE_FREE(encode_frame->pixels);
+    MEM_freeN(encode_frame);
+    BKE_report(reports, RPT_ERROR, "Error writing frame");
   }
 
-#  ifdef WITH_AUDASPACE
-  write_audio_frames(context,
-                     (frame - start_frame) / (((double)rd->frs_sec) / (double)rd->frs_sec_base));
-#  endif
   return success;
 }
 
@@ -1443,9 +1617,14 @@ static void end_ffmpeg_impl(FFMpegContext *context, int is_autosplit)
   }
 }
 
-void BKE_ffmpeg_end(void *context_v)
+void BKE_ffmpeg_end(void *context_v, ReportList *reports)
 {
   FFMpegContext *context = context_v;
+
+  /* Frames still in the queue may fail after the last append, report those here. */
+  if (!ffmpeg_encode_thread_end(context) && !context->encode_failed_reported) {
+    BKE_report(reports, RPT_ERROR, "Error writing frame");
+  }
   end_ffmpeg_impl(context, false);
 }
 
@@ -1868,6 +2047,7 @@ void BKE_ffmpeg_context_free(void *context_v)
   if (context == NULL) {
     return;
   }
+  ffmpeg_encode_thread_end(context);
   if (context->stamp_data) {
     MEM_freeN(context->stamp_data);
   }
@@ -6734,6 +6734,7 @@ static void direct_link_scene(FileData *fd, Scene *sce)
 
     ed->act_seq = newdataadr(fd, ed->act_seq);
     ed->cache = NULL;
+    ed->prefetch_job = NULL;
 
     /* recursive link sequences, lb will be correctly initialized */
     link_recurs_seq(fd, &ed->seqbase);
@@ -6797,6 +6798,8 @@ static void direct_link_scene(FileData *fd, Scene *sce)
       }
 
       direct_link_sequence_modifiers(fd, &seq->modifiers);
+
+      seq->render_time = 0.0f;
     }
     SEQ_END;
 
@@ -611,7 +611,14 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
    * Include next version bump.
    */
   {
-    /* pass */
+    /* Zero is below the allowed range, so this only initializes older preferences. */
+    if (userdef->sequencer_disk_cache_size_limit == 0) {
+      userdef->sequencer_disk_cache_size_limit = 100;
+      userdef->sequencer_disk_cache_compression = USER_SEQ_DISK_CACHE_COMPRESSION_LOW;
+    }
+    if (userdef->tile_cache_limit == 0) {
+      userdef->tile_cache_limit = 1024;
+    }
   }
 
   if (userdef->pixelsize == 0.0f) {
@@ -358,6 +358,7 @@ static int screen_render_exec(bContext *C, wmOperator *op)
    * otherwise, invalidated cache entries can make their way into
    * the output rendering. We can't put that into RE_RenderFrame,
    * since sequence rendering can call that recursively... (peter) */
+  BKE_sequencer_prefetch_stop_all(mainp);
   BKE_sequencer_cache_cleanup(scene);
 
   RE_SetReports(re, op->reports);
@@ -977,6 +978,7 @@ static int screen_render_invoke(bContext *C, wmOperator *op, const wmEvent *even
    * otherwise, invalidated cache entries can make their way into
    * the output rendering. We can't put that into RE_RenderFrame,
    * since sequence rendering can call that recursively... (peter) */
+  BKE_sequencer_prefetch_stop_all(bmain);
   BKE_sequencer_cache_cleanup(scene);
 
   // store spare
@@ -723,7 +723,7 @@ static void screen_opengl_render_end(bContext *C, OGLRender *oglrender)
   if (oglrender->mh) {
     if (BKE_imtype_is_movie(scene->r.im_format.imtype)) {
       for (i = 0; i < oglrender->totvideos; i++) {
-        oglrender->mh->end_movie(oglrender->movie_ctx_arr[i]);
+        oglrender->mh->end_movie(oglrender->movie_ctx_arr[i], oglrender->reports);
         oglrender->mh->context_free(oglrender->movie_ctx_arr[i]);
       }
     }
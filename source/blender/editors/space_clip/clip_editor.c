@@ -35,12 +35,14 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_mask_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_fileops.h"
 #include "BLI_math.h"
 #include "BLI_rect.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_context.h"
 #include "BKE_global.h"
@@ -719,6 +721,7 @@ typedef struct PrefetchJob {
 } PrefetchJob;
 
 typedef struct PrefetchQueue {
+  MovieClip *clip;
   int initial_frame, current_frame, start_frame, end_frame;
   short render_size, render_flag;
 
@@ -729,11 +732,28 @@ typedef struct PrefetchQueue {
 
   SpinLock spin;
 
+  /* Files which were read by I/O threads and are waiting to be decoded. */
+  ThreadQueue *read_frames;
+
+  /* Bounds the number of frames which were read but not yet decoded, so I/O threads do not
+   * run too far ahead of decoding and keep lots of encoded files in memory. */
+  ThreadMutex read_ahead_mutex;
+  ThreadCondition read_ahead_cond;
+  int read_ahead, num_read_ahead;
+  int num_active_readers;
+
   short *stop;
   short *do_update;
   float *progress;
 } PrefetchQueue;
 
+/* File read by an I/O thread, decoded and put to the cache by a decode task. */
+typedef struct PrefetchReadFrame {
+  int framenr;
+  size_t size;
+  unsigned char *mem;
+} PrefetchReadFrame;
+
 /* check whether pre-fetching is allowed */
 static bool check_prefetch_break(void)
 {
@@ -769,10 +789,16 @@ static unsigned char *prefetch_read_file_to_memory(
     return NULL;
   }
 
-  if (read(file, mem, size) != size) {
-    close(file);
-    MEM_freeN(mem);
-    return NULL;
+  /* Network file systems may return less than requested, keep reading until done. */
+  size_t offset = 0;
+  while (offset < size) {
+    const ssize_t num_read = read(file, mem + offset, size - offset);
+    if (num_read <= 0) {
+      close(file);
+      MEM_freeN(mem);
+      return NULL;
+    }
+    offset += (size_t)num_read;
   }
 
   *r_size = size;
@@ -818,13 +844,13 @@ static int prefetch_find_uncached_frame(MovieClip *clip,
   return current_frame;
 }
 
-/* get memory buffer for first uncached frame within prefetch frame range */
-static unsigned char *prefetch_thread_next_frame(PrefetchQueue *queue,
-                                                 MovieClip *clip,
-                                                 size_t *r_size,
-                                                 int *r_current_frame)
+/* get first uncached frame within prefetch frame range, returns false if there is nothing
+ * left to prefetch */
+static bool prefetch_thread_next_frame(PrefetchQueue *queue,
+                                       MovieClip *clip,
+                                       int *r_current_frame)
 {
-  unsigned char *mem = NULL;
+  bool found = false;
 
   BLI_spin_lock(&queue->spin);
   if (!*queue->stop && !check_prefetch_break() &&
@@ -857,10 +883,8 @@ static unsigned char *prefetch_thread_next_frame(PrefetchQueue *queue,
     if (IN_RANGE_INCL(current_frame, queue->start_frame, queue->end_frame)) {
       int frames_processed;
 
-      mem = prefetch_read_file_to_memory(
-          clip, current_frame, queue->render_size, queue->render_flag, r_size);
-
       *r_current_frame = current_frame;
+      found = true;
 
       queue->current_frame = current_frame;
 
@@ -878,27 +902,99 @@ static unsigned char *prefetch_thread_next_frame(PrefetchQueue *queue,
   }
   BLI_spin_unlock(&queue->spin);
 
-  return mem;
+  return found;
+}
+
+static bool prefetch_queue_is_stopped(PrefetchQueue *queue)
+{
+  return *queue->stop || check_prefetch_break();
+}
+
+/* Wait until there is room for one more read ahead frame, returns false when prefetching
+ * was stopped while waiting. */
+static bool prefetch_read_ahead_acquire(PrefetchQueue *queue)
+{
+  bool result;
+
+  BLI_mutex_lock(&queue->read_ahead_mutex);
+  while (queue->num_read_ahead >= queue->read_ahead && !prefetch_queue_is_stopped(queue)) {
+    BLI_condition_wait(&queue->read_ahead_cond, &queue->read_ahead_mutex);
+  }
+  result = !prefetch_queue_is_stopped(queue);
+  if (result) {
+    queue->num_read_ahead++;
+  }
+  BLI_mutex_unlock(&queue->read_ahead_mutex);
+
+  return result;
+}
+
+static void prefetch_read_ahead_release(PrefetchQueue *queue)
+{
+  BLI_mutex_lock(&queue->read_ahead_mutex);
+  queue->num_read_ahead--;
+  BLI_condition_notify_all(&queue->read_ahead_cond);
+  BLI_mutex_unlock(&queue->read_ahead_mutex);
+}
+
+/* I/O thread: reads files of uncached frames into memory, so the latency of the storage is
+ * hidden behind decoding of previously read frames. */
+static void *prefetch_read_thread(void *queue_v)
+{
+  PrefetchQueue *queue = (PrefetchQueue *)queue_v;
+  MovieClip *clip = queue->clip;
+  int current_frame;
+
+  while (prefetch_read_ahead_acquire(queue)) {
+    PrefetchReadFrame *read_frame;
+    unsigned char *mem;
+    size_t size;
+
+    if (!prefetch_thread_next_frame(queue, clip, &current_frame)) {
+      prefetch_read_ahead_release(queue);
+      break;
+    }
+
+    mem = prefetch_read_file_to_memory(
+        clip, current_frame, queue->render_size, queue->render_flag, &size);
+    if (mem == NULL) {
+      prefetch_read_ahead_release(queue);
+      continue;
+    }
+
+    read_frame = MEM_mallocN(sizeof(PrefetchReadFrame), "movieclip prefetch read frame");
+    read_frame->framenr = current_frame;
+    read_frame->size = size;
+    read_frame->mem = mem;
+    BLI_thread_queue_push(queue->read_frames, read_frame);
+  }
+
+  /* Last reader lets decode tasks know no more frames will arrive. */
+  BLI_mutex_lock(&queue->read_ahead_mutex);
+  if (--queue->num_active_readers == 0) {
+    BLI_thread_queue_nowait(queue->read_frames);
+  }
+  BLI_mutex_unlock(&queue->read_ahead_mutex);
+
+  return NULL;
 }
 
+/* Decode task: decodes files read by I/O threads and puts them straight to the clip cache. */
 static void prefetch_task_func(TaskPool *__restrict pool, void *task_data, int UNUSED(threadid))
 {
   PrefetchQueue *queue = (PrefetchQueue *)BLI_task_pool_userdata(pool);
   MovieClip *clip = (MovieClip *)task_data;
-  unsigned char *mem;
-  size_t size;
-  int current_frame;
+  PrefetchReadFrame *read_frame;
 
-  while ((mem = prefetch_thread_next_frame(queue, clip, &size, &current_frame))) {
-    ImBuf *ibuf;
+  while ((read_frame = BLI_thread_queue_pop(queue->read_frames))) {
+    ImBuf *ibuf = NULL;
     MovieClipUser user = {0};
     int flag = IB_rect | IB_multilayer | IB_alphamode_detect | IB_metadata;
-    int result;
     char *colorspace_name = NULL;
     const bool use_proxy = (clip->flag & MCLIP_USE_PROXY) &&
                            (queue->render_size != MCLIP_PROXY_RENDER_SIZE_FULL);
 
-    user.framenr = current_frame;
+    user.framenr = read_frame->framenr;
     user.render_size = queue->render_size;
     user.render_flag = queue->render_flag;
 
@@ -907,23 +1003,27 @@ static void prefetch_task_func(TaskPool *__restrict pool, void *task_data, int U
       colorspace_name = clip->colorspace_settings.name;
     }
 
-    ibuf = IMB_ibImageFromMemory(mem, size, flag, colorspace_name, "prefetch frame");
-    if (ibuf == NULL) {
-      continue;
+    /* Keep draining the queue once stopped, so all read files are freed. */
+    if (!prefetch_queue_is_stopped(queue)) {
+      ibuf = IMB_ibImageFromMemory(
+          read_frame->mem, read_frame->size, flag, colorspace_name, "prefetch frame");
     }
-    BKE_movieclip_convert_multilayer_ibuf(ibuf);
 
-    result = BKE_movieclip_put_frame_if_possible(clip, &user, ibuf);
+    MEM_freeN(read_frame->mem);
+    MEM_freeN(read_frame);
 
-    IMB_freeImBuf(ibuf);
+    if (ibuf) {
+      BKE_movieclip_convert_multilayer_ibuf(ibuf);
 
-    MEM_freeN(mem);
+      if (!BKE_movieclip_put_frame_if_possible(clip, &user, ibuf)) {
+        /* no more space in the cache, stop reading frames */
+        *queue->stop = 1;
+      }
 
-    if (!result) {
-      /* no more space in the cache, stop reading frames */
-      *queue->stop = 1;
-      break;
+      IMB_freeImBuf(ibuf);
     }
+
+    prefetch_read_ahead_release(queue);
   }
 }
 
@@ -940,11 +1040,21 @@ static void start_prefetch_threads(MovieClip *clip,
   PrefetchQueue queue;
   TaskScheduler *task_scheduler = BLI_task_scheduler_get();
   TaskPool *task_pool;
+  ListBase read_threads;
   int i, tot_thread = BLI_task_scheduler_num_threads(task_scheduler);
+  int tot_read_thread = U.clip_prefetch_read_threads;
+
+  /* Read threads mostly wait for the storage and run next to the decoding workers, which
+   * already use all cores. By default use half as many, but at least 4, so a few requests
+   * are always in flight to hide the latency of network storage. */
+  if (tot_read_thread <= 0) {
+    tot_read_thread = max_ii(4, tot_thread / 2);
+  }
 
   /* initialize queue */
   BLI_spin_init(&queue.spin);
 
+  queue.clip = clip;
   queue.current_frame = current_frame;
   queue.initial_frame = current_frame;
   queue.start_frame = start_frame;
@@ -953,10 +1063,26 @@ static void start_prefetch_threads(MovieClip *clip,
   queue.render_flag = render_flag;
   queue.forward = 1;
 
+  queue.read_frames = BLI_thread_queue_init();
+  BLI_mutex_init(&queue.read_ahead_mutex);
+  BLI_condition_init(&queue.read_ahead_cond);
+  queue.read_ahead = U.clip_prefetch_read_ahead > 0 ? U.clip_prefetch_read_ahead :
+                                                      2 * tot_thread;
+  queue.read_ahead = max_ii(queue.read_ahead, tot_read_thread);
+  queue.num_read_ahead = 0;
+  queue.num_active_readers = tot_read_thread;
+
   queue.stop = stop;
   queue.do_update = do_update;
   queue.progress = progress;
 
+  /* I/O threads are plain threads, so blocking reads do not occupy task scheduler workers
+   * which are decoding frames. */
+  BLI_threadpool_init(&read_threads, prefetch_read_thread, tot_read_thread);
+  for (i = 0; i < tot_read_thread; i++) {
+    BLI_threadpool_insert(&read_threads, &queue);
+  }
+
   task_pool = BLI_task_pool_create(task_scheduler, &queue);
   for (i = 0; i < tot_thread; i++) {
     BLI_task_pool_push(task_pool, prefetch_task_func, clip, false, TASK_PRIORITY_LOW);
@@ -964,6 +1090,12 @@ static void start_prefetch_threads(MovieClip *clip,
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
 
+  BLI_threadpool_end(&read_threads);
+
+  BLI_condition_end(&queue.read_ahead_cond);
+  BLI_mutex_end(&queue.read_ahead_mutex);
+  BLI_thread_queue_free(queue.read_frames);
+
   BLI_spin_end(&queue.spin);
 }
 
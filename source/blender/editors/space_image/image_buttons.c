@@ -982,6 +982,10 @@ void uiTemplateImage(uiLayout *layout,
       }
 
       uiItemR(col, &imaptr, "use_view_as_render", 0, NULL, ICON_NONE);
+
+      if (ima->source == IMA_SRC_FILE) {
+        uiItemR(col, &imaptr, "use_tile_cache", 0, NULL, ICON_NONE);
+      }
     }
   }
 
@@ -665,6 +665,13 @@ static void draw_seq_text(View2D *v2d,
     str_len = BLI_snprintf(str, sizeof(str), "%s | %d", name, seq->len);
   }
 
+  if ((sseq->flag & SEQ_SHOW_RENDER_TIME) && seq->render_time > 0.0f) {
+    /* Returned length can exceed the buffer when the text above was truncated. */
+    str_len = strlen(str);
+    str_len += BLI_snprintf_rlen(
+        str + str_len, sizeof(str) - str_len, " | %.1f ms", seq->render_time);
+  }
+
   if (seq->flag & SELECT) {
     col[0] = col[1] = col[2] = 255;
   }
@@ -2038,6 +2045,11 @@ void draw_timeline_seq(const bContext *C, ARegion *ar)
     draw_seq_strips(C, ed, ar);
     draw_cache_view(C);
 
+    /* Keep the cache overlay up to date while frames are prefetched. */
+    if (BKE_sequencer_prefetch_need_redraw(CTX_data_main(C), scene)) {
+      ED_area_tag_redraw(CTX_wm_area(C));
+    }
+
     /* text draw cached (for sequence names), in pixelspace now */
     UI_view2d_text_cache_draw(ar);
   }
@@ -405,13 +405,38 @@ void IMB_makemipmap(struct ImBuf *ibuf, int use_filter);
 void IMB_remakemipmap(struct ImBuf *ibuf, int use_filter);
 struct ImBuf *IMB_getmipmap(struct ImBuf *ibuf, int level);
 
+/**
+ *
+ * \attention Defined in compress.c
+ */
+
+/* Values match #eUserpref_CacheCompression. */
+enum {
+  IMB_COMPRESSION_NONE = 0,
+  /** Exact pixels. */
+  IMB_COMPRESSION_LOSSLESS = 1,
+  /** Float pixels are stored as half floats, byte pixels are exact. */
+  IMB_COMPRESSION_HALF_FLOAT = 2,
+};
+
+struct ImBufCompressed;
+
+struct ImBufCompressed *IMB_compressed_from_imbuf(struct ImBuf *ibuf, int method);
+struct ImBuf *IMB_compressed_to_imbuf(const struct ImBufCompressed *cbuf);
+size_t IMB_compressed_get_size_in_memory(const struct ImBufCompressed *cbuf);
+void IMB_compressed_ref(struct ImBufCompressed *cbuf);
+void IMB_compressed_free(struct ImBufCompressed *cbuf);
+
 /**
  *
  * \attention Defined in cache.c
  */
 
 void IMB_tile_cache_params(int totthread, int maxmem);
+void IMB_tile_cache_set_limit(int maxmem);
 unsigned int *IMB_gettile(struct ImBuf *ibuf, int tx, int ty, int thread);
+void IMB_tile_cache_get_pixel(struct ImBuf *ibuf, int x, int y, unsigned char r_col[4]);
+void IMB_tile_cache_get_pixel_float(struct ImBuf *ibuf, int x, int y, float r_col[4]);
 void IMB_tiles_to_rect(struct ImBuf *ibuf);
 
 /**
@@ -180,6 +180,8 @@ typedef struct ImBuf {
   int tilex, tiley;
   int xtiles, ytiles;
   unsigned int **tiles;
+  /** open file to read tiles from, shared by all mipmap levels */
+  struct ImTileFile *tile_file;
 
   /* zbuffer */
   /** z buffer data, original zbuffer */
@@ -291,6 +293,10 @@ enum {
   IB_alphamode_ignore = 1 << 15,
   IB_thumbnail = 1 << 16,
   IB_multiview = 1 << 17,
+  /** don't read passes of multilayer files on load, see #IMB_exr_read_pass */
+  IB_multilayer_lazy = 1 << 18,
+  /** tiles of #IB_tilecache buffers hold premultiplied float RGBA instead of bytes */
+  IB_tilecache_float = 1 << 19,
 };
 
 /** \} */
@@ -40,6 +40,21 @@ typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
 typedef int (*MovieCacheGetItemPriorityFP)(void *last_userkey, void *priority_data);
 typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 
+/* Statistics of a single cache, used to tune the cache limiter. */
+typedef struct MovieCacheStats {
+  /* Lookups which did and did not find a buffer. */
+  int hits, misses;
+  /* Buffers freed by the cache limiter to stay within memory limit. */
+  int evicted;
+  /* Buffers currently in the cache and memory used by them. */
+  int totitem;
+  size_t mem_in_use;
+  /* Average time in seconds it took to produce a buffer after a miss. */
+  float avg_cost;
+  /* Relative importance of the cache items when choosing what to evict. */
+  float weight;
+} MovieCacheStats;
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -49,6 +64,8 @@ struct MovieCache *IMB_moviecache_create(const char *name,
                                          GHashCmpFP cmpfp);
 void IMB_moviecache_set_getdata_callback(struct MovieCache *cache,
                                          MovieCacheGetKeyDataFP getdatafp);
+void IMB_moviecache_set_use_compression(struct MovieCache *cache, bool use_compression);
+void IMB_moviecache_set_compression(int method);
 void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCacheGetPriorityDataFP getprioritydatafp,
                                           MovieCacheGetItemPriorityFP getitempriorityfp,
@@ -66,6 +83,9 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
                                                    void *userdata),
                             void *userdata);
 
+void IMB_moviecache_get_stats(struct MovieCache *cache, MovieCacheStats *r_stats);
+void IMB_moviecache_print_stats(void);
+
 void IMB_moviecache_get_cache_segments(
     struct MovieCache *cache, int proxy, int render_flags, int *totseg_r, int **points_r);
 
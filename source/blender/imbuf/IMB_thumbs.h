@@ -53,6 +53,10 @@ typedef enum ThumbSource {
 
 #define PREVIEW_RENDER_DEFAULT_HEIGHT 128
 
+/* Images loaded with IB_thumbnail may be decoded at reduced resolution, but not smaller than
+ * this. The loader then stores the full size with IMB_thumb_set_original_size(). */
+#define THUMB_SIZE_LOAD (PREVIEW_RENDER_DEFAULT_HEIGHT * 2)
+
 /* Note this can also be used as versioning system,
  * to force refreshing all thumbnails if e.g. we change some thumb generating code or so.
  * Only used by fonts so far. */
@@ -73,6 +77,9 @@ ImBuf *IMB_thumb_manage(const char *path, ThumbSize size, ThumbSource source);
 /* create the necessary dirs to store the thumbnails */
 void IMB_thumb_makedirs(void);
 
+/* size of the source image, for images decoded at reduced resolution */
+void IMB_thumb_set_original_size(struct ImBuf *ibuf, int width, int height);
+
 /* special function for loading a thumbnail embedded into a blend file */
 ImBuf *IMB_thumb_load_blend(const char *blen_path, const char *blen_group, const char *blen_id);
 void IMB_thumb_overlay_blend(unsigned int *thumb, int width, int height, float aspect);
@@ -81,6 +81,12 @@
 
 #define MAXNUMSTREAMS 50
 
+/* Number of extra FFmpeg decoders opened for random access. */
+#define ANIM_FFMPEG_DECODER_POOL_SIZE 2
+/* Recently fetched FFmpeg frames, limited by count and total size. */
+#define ANIM_FFMPEG_FRAME_CACHE_SIZE 16
+#define ANIM_FFMPEG_FRAME_CACHE_MAX_BYTES (128 * 1024 * 1024)
+
 struct IDProperty;
 struct _AviMovie;
 struct anim_index;
@@ -137,6 +143,21 @@ struct anim {
   int64_t last_pts;
   int64_t next_pts;
   AVPacket next_packet;
+
+  /* Decoders of the same stream, so seeking does not interrupt sequential decoding. */
+  struct anim *decoders[ANIM_FFMPEG_DECODER_POOL_SIZE];
+  int decoder_clock;
+  int decoder_last_used;
+  /* Opening another decoder failed, only this one is used from then on. */
+  bool decoder_open_failed;
+
+  struct {
+    struct ImBuf *ibuf;
+    int position;
+    int tc;
+  } frame_cache[ANIM_FFMPEG_FRAME_CACHE_SIZE];
+  int frame_cache_next;
+  bool is_pooled_decoder;
 #endif
 
   char index_dir[768];
@@ -153,4 +174,6 @@ struct anim {
   struct IDProperty *metadata;
 };
 
+void imb_anim_timecode_index_changed(struct anim *anim);
+
 #endif
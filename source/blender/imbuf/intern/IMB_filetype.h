@@ -61,6 +61,18 @@ void imb_filetypes_exit(void);
 void imb_tile_cache_init(void);
 void imb_tile_cache_exit(void);
 
+/* File kept open by tile cached images, so tiles are read without opening
+ * and parsing the file again for every tile. Shared by all mipmap levels. */
+typedef struct ImTileFile {
+  void (*load_tile)(struct ImTileFile *tile_file,
+                    struct ImBuf *ibuf,
+                    int tx,
+                    int ty,
+                    unsigned int *rect);
+  void (*free)(struct ImTileFile *tile_file);
+  int users;
+} ImTileFile;
+
 void imb_loadtile(struct ImBuf *ibuf, int tx, int ty, unsigned int *rect);
 void imb_tile_cache_tile_free(struct ImBuf *ibuf, int tx, int ty);
 
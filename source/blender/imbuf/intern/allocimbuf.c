@@ -149,6 +149,19 @@ void imb_freetilesImBuf(ImBuf *ibuf)
     MEM_freeN(ibuf->tiles);
   }
 
+  if (ibuf->tile_file) {
+    bool needs_free;
+
+    BLI_spin_lock(&refcounter_spin);
+    needs_free = (--ibuf->tile_file->users == 0);
+    BLI_spin_unlock(&refcounter_spin);
+
+    if (needs_free) {
+      ibuf->tile_file->free(ibuf->tile_file);
+    }
+    ibuf->tile_file = NULL;
+  }
+
   ibuf->tiles = NULL;
   ibuf->mall &= ~IB_tiles;
 }
@@ -613,6 +626,12 @@ ImBuf *IMB_dupImBuf(const ImBuf *ibuf1)
   tbuf.display_buffer_flags = NULL;
   tbuf.colormanage_cache = NULL;
 
+  if (tbuf.tile_file) {
+    BLI_spin_lock(&refcounter_spin);
+    tbuf.tile_file->users++;
+    BLI_spin_unlock(&refcounter_spin);
+  }
+
   *ibuf2 = tbuf;
 
   return (ibuf2);
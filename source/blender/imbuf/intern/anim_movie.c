@@ -59,8 +59,10 @@
 #endif
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -205,6 +207,8 @@ static void free_anim_avi(struct anim *anim)
 
 #ifdef WITH_FFMPEG
 static void free_anim_ffmpeg(struct anim *anim);
+static void ffmpeg_frame_cache_free(struct anim *anim);
+static void ffmpeg_decoder_pool_free(struct anim *anim);
 #endif
 
 void IMB_free_anim(struct anim *anim)
@@ -229,6 +233,18 @@ void IMB_free_anim(struct anim *anim)
   MEM_freeN(anim);
 }
 
+/* Frame positions depend on the timecode index, drop frames fetched with a previous index.
+ * Pooled decoders have their own copy of the index, they are opened again when needed. */
+void imb_anim_timecode_index_changed(struct anim *anim)
+{
+#ifdef WITH_FFMPEG
+  ffmpeg_frame_cache_free(anim);
+  ffmpeg_decoder_pool_free(anim);
+#else
+  UNUSED_VARS(anim);
+#endif
+}
+
 void IMB_close_anim(struct anim *anim)
 {
   if (anim == NULL) {
@@ -557,6 +573,17 @@ static int startffmpeg(struct anim *anim)
 
   pCodecCtx->workaround_bugs = 1;
 
+  /* Only slice threading, frame threading delays output by a frame per thread, which the seek
+   * and scan logic relying on the first decoded frame after a seek does not handle. Pooled
+   * decoders are only used for scrubbing, they share the cores so a movie doesn't start
+   * several threads per core. */
+  pCodecCtx->thread_count = BLI_system_thread_count();
+  if (anim->is_pooled_decoder) {
+    pCodecCtx->thread_count = max_ii(
+        1, pCodecCtx->thread_count / (ANIM_FFMPEG_DECODER_POOL_SIZE + 1));
+  }
+  pCodecCtx->thread_type = FF_THREAD_SLICE;
+
   if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
     avformat_close_input(&pFormatCtx);
     return -1;
@@ -1188,12 +1215,178 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   return anim->last_frame;
 }
 
+/* Recently fetched frames, so stepping back and forth while scrubbing does not need to seek
+ * and decode the GOP again. */
+
+static ImBuf *ffmpeg_frame_cache_get(struct anim *anim, int position, IMB_Timecode_Type tc)
+{
+  for (int i = 0; i < ANIM_FFMPEG_FRAME_CACHE_SIZE; i++) {
+    ImBuf *ibuf = anim->frame_cache[i].ibuf;
+
+    /* Shared the same way as anim->last_frame, callers use IMB_makeSingleUser() to modify. */
+    if (ibuf && anim->frame_cache[i].position == position && anim->frame_cache[i].tc == tc) {
+      IMB_refImBuf(ibuf);
+      return ibuf;
+    }
+  }
+
+  return NULL;
+}
+
+static void ffmpeg_frame_cache_put(struct anim *anim,
+                                   int position,
+                                   IMB_Timecode_Type tc,
+                                   ImBuf *ibuf)
+{
+  int max_frames = (int)(ANIM_FFMPEG_FRAME_CACHE_MAX_BYTES / max_zz(anim->framesize, 1));
+  CLAMP(max_frames, 0, ANIM_FFMPEG_FRAME_CACHE_SIZE);
+
+  if (max_frames == 0) {
+    return;
+  }
+
+  if (anim->frame_cache_next >= max_frames) {
+    anim->frame_cache_next = 0;
+  }
+
+  int i = anim->frame_cache_next++;
+
+  if (anim->frame_cache[i].ibuf) {
+    IMB_freeImBuf(anim->frame_cache[i].ibuf);
+  }
+
+  /* Decoders allocate a new buffer for every frame, so the stored one is never overwritten. */
+  IMB_refImBuf(ibuf);
+  anim->frame_cache[i].ibuf = ibuf;
+  anim->frame_cache[i].position = position;
+  anim->frame_cache[i].tc = tc;
+}
+
+static void ffmpeg_frame_cache_free(struct anim *anim)
+{
+  for (int i = 0; i < ANIM_FFMPEG_FRAME_CACHE_SIZE; i++) {
+    if (anim->frame_cache[i].ibuf) {
+      IMB_freeImBuf(anim->frame_cache[i].ibuf);
+      anim->frame_cache[i].ibuf = NULL;
+    }
+  }
+  anim->frame_cache_next = 0;
+}
+
+static void ffmpeg_decoder_pool_free(struct anim *anim)
+{
+  for (int i = 0; i < ANIM_FFMPEG_DECODER_POOL_SIZE; i++) {
+    if (anim->decoders[i]) {
+      IMB_free_anim(anim->decoders[i]);
+      anim->decoders[i] = NULL;
+    }
+  }
+}
+
+/* Whether decoder can reach the position by decoding forward, without seeking. */
+static bool ffmpeg_decoder_is_sequential(struct anim *decoder, int position)
+{
+  if (decoder->curposition < 0) {
+    return false;
+  }
+
+  return position >= decoder->curposition &&
+         position <= decoder->curposition + max_ii(decoder->preseek, 1);
+}
+
+static struct anim *ffmpeg_decoder_open(struct anim *anim)
+{
+  struct anim *decoder = IMB_open_anim(
+      anim->name, anim->ib_flags, anim->streamindex, anim->colorspace);
+
+  if (decoder == NULL) {
+    return NULL;
+  }
+
+  BLI_strncpy(decoder->index_dir, anim->index_dir, sizeof(decoder->index_dir));
+  BLI_strncpy(decoder->suffix, anim->suffix, sizeof(decoder->suffix));
+
+  decoder->is_pooled_decoder = true;
+
+  if (startffmpeg(decoder) != 0) {
+    IMB_free_anim(decoder);
+    return NULL;
+  }
+  decoder->curtype = ANIM_FFMPEG;
+
+  return decoder;
+}
+
+/* Pick decoder for the position. Decoders which can continue forward are preferred, otherwise
+ * the least recently used one is seeked, so playback in one part of the file is not disturbed by
+ * scrubbing in another. */
+static struct anim *ffmpeg_decoder_get(struct anim *anim, int position)
+{
+  struct anim *decoder = NULL;
+
+  if (ffmpeg_decoder_is_sequential(anim, position) || anim->curposition == -1) {
+    decoder = anim;
+  }
+
+  for (int i = 0; i < ANIM_FFMPEG_DECODER_POOL_SIZE && decoder == NULL; i++) {
+    if (anim->decoders[i] && ffmpeg_decoder_is_sequential(anim->decoders[i], position)) {
+      decoder = anim->decoders[i];
+    }
+  }
+
+  if (decoder == NULL) {
+    decoder = anim;
+
+    for (int i = 0; i < ANIM_FFMPEG_DECODER_POOL_SIZE; i++) {
+      if (anim->decoders[i] == NULL) {
+        /* Seek with the decoders available, don't try to open the file again every time. */
+        if (anim->decoder_open_failed) {
+          break;
+        }
+        anim->decoders[i] = ffmpeg_decoder_open(anim);
+        if (anim->decoders[i]) {
+          decoder = anim->decoders[i];
+        }
+        else {
+          anim->decoder_open_failed = true;
+        }
+        break;
+      }
+      if (anim->decoders[i]->decoder_last_used < decoder->decoder_last_used) {
+        decoder = anim->decoders[i];
+      }
+    }
+  }
+
+  decoder->decoder_last_used = ++anim->decoder_clock;
+
+  return decoder;
+}
+
+static ImBuf *ffmpeg_fetchibuf_pooled(struct anim *anim, int position, IMB_Timecode_Type tc)
+{
+  ImBuf *ibuf = ffmpeg_frame_cache_get(anim, position, tc);
+
+  if (ibuf == NULL) {
+    ibuf = ffmpeg_fetchibuf(ffmpeg_decoder_get(anim, position), position, tc);
+
+    if (ibuf) {
+      ffmpeg_frame_cache_put(anim, position, tc, ibuf);
+    }
+  }
+
+  return ibuf;
+}
+
 static void free_anim_ffmpeg(struct anim *anim)
 {
   if (anim == NULL) {
     return;
   }
 
+  ffmpeg_frame_cache_free(anim);
+  ffmpeg_decoder_pool_free(anim);
+
   if (anim->pCodecCtx) {
     avcodec_close(anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
@@ -1374,10 +1567,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
-      ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
+      ibuf = ffmpeg_fetchibuf_pooled(anim, position, tc);
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1387,7 +1577,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return (ibuf);
 }
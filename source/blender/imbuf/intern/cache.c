@@ -43,6 +43,12 @@
 
 #define IB_THREAD_CACHE_SIZE 100
 
+/* Texture sampling has no thread index, so threads reading single pixels get
+ * a cache of their own assigned on first use. These threads are mostly long
+ * lived task scheduler workers, a smaller cache keeps the number of tiles they
+ * hold on to low. */
+#define IB_PIXEL_CACHE_SIZE 16
+
 typedef struct ImGlobalTile {
   struct ImGlobalTile *next, *prev;
 
@@ -65,6 +71,9 @@ typedef struct ImThreadTileCache {
   ListBase tiles;
   ListBase unused;
   GHash *tilehash;
+
+  /* tiles are looked up by ImBuf pointer, drop them all when buffers got freed */
+  unsigned int epoch;
 } ImThreadTileCache;
 
 typedef struct ImGlobalTileCache {
@@ -78,6 +87,12 @@ typedef struct ImGlobalTileCache {
   ImThreadTileCache thread_cache[BLENDER_MAX_THREADS + 1];
   int totthread;
 
+  ImThreadTileCache pixel_cache[BLENDER_MAX_THREADS];
+  int totpixelcache;
+
+  /* incremented when tiles of a freed ImBuf are removed */
+  volatile unsigned int epoch;
+
   ThreadMutex mutex;
 
   int initialized;
@@ -85,6 +100,14 @@ typedef struct ImGlobalTileCache {
 
 static ImGlobalTileCache GLOBAL_CACHE;
 
+/* Pixel cache of the calling thread, as generation << 16 | (index + 1). The
+ * generation changes when the cache is reinitialized, so stale assignments
+ * from before are not used. */
+static ThreadLocal(void *) imb_pixel_cache_slot;
+static intptr_t imb_pixel_cache_generation = 1;
+
+#define IB_PIXEL_CACHE_NONE 0xFFFF
+
 /***************************** Hash Functions ********************************/
 
 static unsigned int imb_global_tile_hash(const void *gtile_p)
@@ -119,13 +142,23 @@ static bool imb_thread_tile_cmp(const void *a_p, const void *b_p)
 
 /******************************** Load/Unload ********************************/
 
+static size_t imb_tile_pixel_size(const ImBuf *ibuf)
+{
+  return (ibuf->flags & IB_tilecache_float) ? sizeof(float[4]) : sizeof(unsigned int);
+}
+
+static uintptr_t imb_tile_mem_size(const ImBuf *ibuf)
+{
+  return imb_tile_pixel_size(ibuf) * ibuf->tilex * ibuf->tiley;
+}
+
 static void imb_global_cache_tile_load(ImGlobalTile *gtile)
 {
   ImBuf *ibuf = gtile->ibuf;
   int toffs = ibuf->xtiles * gtile->ty + gtile->tx;
   unsigned int *rect;
 
-  rect = MEM_callocN(sizeof(unsigned int) * ibuf->tilex * ibuf->tiley, "imb_tile");
+  rect = MEM_callocN(imb_tile_mem_size(ibuf), "imb_tile");
   imb_loadtile(ibuf, gtile->tx, gtile->ty, rect);
   ibuf->tiles[toffs] = rect;
 }
@@ -138,7 +171,7 @@ static void imb_global_cache_tile_unload(ImGlobalTile *gtile)
   MEM_freeN(ibuf->tiles[toffs]);
   ibuf->tiles[toffs] = NULL;
 
-  GLOBAL_CACHE.totmem -= sizeof(unsigned int) * ibuf->tilex * ibuf->tiley;
+  GLOBAL_CACHE.totmem -= imb_tile_mem_size(ibuf);
 }
 
 /* external free */
@@ -161,7 +194,20 @@ void imb_tile_cache_tile_free(ImBuf *ibuf, int tx, int ty)
 
     BLI_ghash_remove(GLOBAL_CACHE.tilehash, gtile, NULL, NULL);
     BLI_remlink(&GLOBAL_CACHE.tiles, gtile);
-    BLI_addtail(&GLOBAL_CACHE.unused, gtile);
+
+    /* tiles still referenced by thread caches get reused once released */
+    if (gtile->refcount == 0) {
+      BLI_addtail(&GLOBAL_CACHE.unused, gtile);
+    }
+    else {
+      gtile->ibuf = NULL;
+    }
+
+    /* tile memory itself is freed by the caller */
+    GLOBAL_CACHE.totmem -= imb_tile_mem_size(ibuf);
+
+    /* make thread caches drop their references to this buffer */
+    GLOBAL_CACHE.epoch++;
   }
 
   BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
@@ -169,7 +215,7 @@ void imb_tile_cache_tile_free(ImBuf *ibuf, int tx, int ty)
 
 /******************************* Init/Exit ***********************************/
 
-static void imb_thread_cache_init(ImThreadTileCache *cache)
+static void imb_thread_cache_init(ImThreadTileCache *cache, int size)
 {
   ImThreadTile *ttile;
   int a;
@@ -178,9 +224,10 @@ static void imb_thread_cache_init(ImThreadTileCache *cache)
 
   cache->tilehash = BLI_ghash_new(
       imb_thread_tile_hash, imb_thread_tile_cmp, "imb_thread_cache_init gh");
+  cache->epoch = GLOBAL_CACHE.epoch;
 
   /* pre-allocate all thread local tiles in unused list */
-  for (a = 0; a < IB_THREAD_CACHE_SIZE; a++) {
+  for (a = 0; a < size; a++) {
     ttile = BLI_memarena_alloc(GLOBAL_CACHE.memarena, sizeof(ImThreadTile));
     BLI_addtail(&cache->unused, ttile);
   }
@@ -196,6 +243,7 @@ void imb_tile_cache_init(void)
   memset(&GLOBAL_CACHE, 0, sizeof(ImGlobalTileCache));
 
   BLI_mutex_init(&GLOBAL_CACHE.mutex);
+  BLI_thread_local_create(imb_pixel_cache_slot);
 
   /* initialize for one thread, for places that access textures
    * outside of rendering (displace modifier, painting, ..) */
@@ -218,6 +266,10 @@ void imb_tile_cache_exit(void)
       imb_thread_cache_exit(&GLOBAL_CACHE.thread_cache[a]);
     }
 
+    for (a = 0; a < GLOBAL_CACHE.totpixelcache; a++) {
+      imb_thread_cache_exit(&GLOBAL_CACHE.pixel_cache[a]);
+    }
+
     if (GLOBAL_CACHE.memarena) {
       BLI_memarena_free(GLOBAL_CACHE.memarena);
     }
@@ -249,6 +301,9 @@ void IMB_tile_cache_params(int totthread, int maxmem)
 
   memset(&GLOBAL_CACHE, 0, sizeof(ImGlobalTileCache));
 
+  /* threads get a new pixel cache assigned on next use */
+  imb_pixel_cache_generation++;
+
   GLOBAL_CACHE.tilehash = BLI_ghash_new(
       imb_global_tile_hash, imb_global_tile_cmp, "tile_cache_params gh");
 
@@ -259,25 +314,65 @@ void IMB_tile_cache_params(int totthread, int maxmem)
 
   GLOBAL_CACHE.totthread = totthread;
   for (a = 0; a < totthread; a++) {
-    imb_thread_cache_init(&GLOBAL_CACHE.thread_cache[a]);
+    imb_thread_cache_init(&GLOBAL_CACHE.thread_cache[a], IB_THREAD_CACHE_SIZE);
   }
 
   BLI_mutex_init(&GLOBAL_CACHE.mutex);
 }
 
+/* unlike IMB_tile_cache_params this keeps loaded tiles, so it is safe to call
+ * while other threads are accessing the cache, tiles above the new limit are
+ * unloaded lazily as new tiles get loaded */
+void IMB_tile_cache_set_limit(int maxmem)
+{
+  if (!GLOBAL_CACHE.initialized) {
+    return;
+  }
+
+  BLI_mutex_lock(&GLOBAL_CACHE.mutex);
+  GLOBAL_CACHE.maxmem = (uintptr_t)maxmem * 1024 * 1024;
+  BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
+}
+
 /***************************** Global Cache **********************************/
 
+/* give up a reference to a tile, mutex must be locked */
+static void imb_global_cache_tile_release(ImGlobalTile *gtile)
+{
+  gtile->refcount--;
+
+  /* the buffer of this tile was freed while it was still referenced */
+  if (gtile->refcount == 0 && gtile->ibuf == NULL) {
+    BLI_addtail(&GLOBAL_CACHE.unused, gtile);
+  }
+}
+
+/* least recently used tile which is not in use by any thread */
+static ImGlobalTile *imb_global_cache_lru_tile(void)
+{
+  ImGlobalTile *gtile;
+
+  for (gtile = GLOBAL_CACHE.tiles.last; gtile; gtile = gtile->prev) {
+    if (gtile->refcount == 0 && gtile->loading == 0) {
+      return gtile;
+    }
+  }
+
+  return NULL;
+}
+
 static ImGlobalTile *imb_global_cache_get_tile(ImBuf *ibuf,
                                                int tx,
                                                int ty,
                                                ImGlobalTile *replacetile)
 {
   ImGlobalTile *gtile, lookuptile;
+  const uintptr_t tilemem = imb_tile_mem_size(ibuf);
 
   BLI_mutex_lock(&GLOBAL_CACHE.mutex);
 
   if (replacetile) {
-    replacetile->refcount--;
+    imb_global_cache_tile_release(replacetile);
   }
 
   /* find tile in global cache */
@@ -292,6 +387,12 @@ static ImGlobalTile *imb_global_cache_get_tile(ImBuf *ibuf,
      * for the other thread to load the tile */
     gtile->refcount++;
 
+    /* keep the list in least recently used order */
+    if (GLOBAL_CACHE.tiles.first != gtile) {
+      BLI_remlink(&GLOBAL_CACHE.tiles, gtile);
+      BLI_addhead(&GLOBAL_CACHE.tiles, gtile);
+    }
+
     BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
 
     while (gtile->loading) {
@@ -301,31 +402,29 @@ static ImGlobalTile *imb_global_cache_get_tile(ImBuf *ibuf,
   else {
     /* not found, let's load it from disk */
 
-    /* first check if we hit the memory limit */
-    if (GLOBAL_CACHE.maxmem && GLOBAL_CACHE.totmem > GLOBAL_CACHE.maxmem) {
-      /* find an existing tile to unload */
-      for (gtile = GLOBAL_CACHE.tiles.last; gtile; gtile = gtile->prev) {
-        if (gtile->refcount == 0 && gtile->loading == 0) {
-          break;
-        }
+    /* first check if we hit the memory limit, unload least recently used
+     * tiles until the new one fits (the limit may have been lowered) */
+    while (GLOBAL_CACHE.maxmem && GLOBAL_CACHE.totmem + tilemem > GLOBAL_CACHE.maxmem) {
+      ImGlobalTile *unloadtile = imb_global_cache_lru_tile();
+
+      if (unloadtile == NULL) {
+        /* all tiles are in use, go over the limit rather than fail */
+        break;
       }
+
+      imb_global_cache_tile_unload(unloadtile);
+      BLI_ghash_remove(GLOBAL_CACHE.tilehash, unloadtile, NULL, NULL);
+      BLI_remlink(&GLOBAL_CACHE.tiles, unloadtile);
+      BLI_addtail(&GLOBAL_CACHE.unused, unloadtile);
     }
 
-    if (gtile) {
-      /* found a tile to unload */
-      imb_global_cache_tile_unload(gtile);
-      BLI_ghash_remove(GLOBAL_CACHE.tilehash, gtile, NULL, NULL);
-      BLI_remlink(&GLOBAL_CACHE.tiles, gtile);
+    /* allocate a new tile or reuse unused */
+    if (GLOBAL_CACHE.unused.first) {
+      gtile = GLOBAL_CACHE.unused.first;
+      BLI_remlink(&GLOBAL_CACHE.unused, gtile);
     }
     else {
-      /* allocate a new tile or reuse unused */
-      if (GLOBAL_CACHE.unused.first) {
-        gtile = GLOBAL_CACHE.unused.first;
-        BLI_remlink(&GLOBAL_CACHE.unused, gtile);
-      }
-      else {
-        gtile = BLI_memarena_alloc(GLOBAL_CACHE.memarena, sizeof(ImGlobalTile));
-      }
+      gtile = BLI_memarena_alloc(GLOBAL_CACHE.memarena, sizeof(ImGlobalTile));
     }
 
     /* setup new tile */
@@ -339,7 +438,7 @@ static ImGlobalTile *imb_global_cache_get_tile(ImBuf *ibuf,
     BLI_addhead(&GLOBAL_CACHE.tiles, gtile);
 
     /* mark as being loaded and unlock to allow other threads to load too */
-    GLOBAL_CACHE.totmem += sizeof(unsigned int) * ibuf->tilex * ibuf->tiley;
+    GLOBAL_CACHE.totmem += tilemem;
 
     BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
 
@@ -355,6 +454,21 @@ static ImGlobalTile *imb_global_cache_get_tile(ImBuf *ibuf,
 
 /***************************** Per-Thread Cache ******************************/
 
+static void imb_thread_cache_flush(ImThreadTileCache *cache)
+{
+  ImThreadTile *ttile;
+
+  BLI_mutex_lock(&GLOBAL_CACHE.mutex);
+  for (ttile = cache->tiles.first; ttile; ttile = ttile->next) {
+    imb_global_cache_tile_release(ttile->global);
+  }
+  cache->epoch = GLOBAL_CACHE.epoch;
+  BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
+
+  BLI_movelisttolist(&cache->unused, &cache->tiles);
+  BLI_ghash_clear(cache->tilehash, NULL, NULL);
+}
+
 static unsigned int *imb_thread_cache_get_tile(ImThreadTileCache *cache,
                                                ImBuf *ibuf,
                                                int tx,
@@ -364,6 +478,10 @@ static unsigned int *imb_thread_cache_get_tile(ImThreadTileCache *cache,
   ImGlobalTile *gtile, *replacetile;
   int toffs = ibuf->xtiles * ty + tx;
 
+  if (cache->epoch != GLOBAL_CACHE.epoch) {
+    imb_thread_cache_flush(cache);
+  }
+
   /* test if it is already in our thread local cache */
   if ((ttile = cache->tiles.first)) {
     /* check last used tile before going to hash */
@@ -415,26 +533,113 @@ unsigned int *IMB_gettile(ImBuf *ibuf, int tx, int ty, int thread)
   return imb_thread_cache_get_tile(&GLOBAL_CACHE.thread_cache[thread + 1], ibuf, tx, ty);
 }
 
+/* Pixel cache of the calling thread, NULL when all caches are taken. */
+static ImThreadTileCache *imb_pixel_cache_get(void)
+{
+  intptr_t slot = (intptr_t)BLI_thread_local_get(imb_pixel_cache_slot);
+  int index;
+
+  if ((slot >> 16) != imb_pixel_cache_generation) {
+    BLI_mutex_lock(&GLOBAL_CACHE.mutex);
+    if (GLOBAL_CACHE.totpixelcache < BLENDER_MAX_THREADS) {
+      index = GLOBAL_CACHE.totpixelcache++;
+      imb_thread_cache_init(&GLOBAL_CACHE.pixel_cache[index], IB_PIXEL_CACHE_SIZE);
+    }
+    else {
+      index = IB_PIXEL_CACHE_NONE - 1;
+    }
+    BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
+
+    slot = (imb_pixel_cache_generation << 16) | (index + 1);
+    BLI_thread_local_set(imb_pixel_cache_slot, (void *)slot);
+  }
+
+  index = (int)(slot & 0xFFFF) - 1;
+  return (index == IB_PIXEL_CACHE_NONE - 1) ? NULL : &GLOBAL_CACHE.pixel_cache[index];
+}
+
+/* Copy a single pixel from a tiled image, for texture sampling code which
+ * has no thread index. Tiles are found through a cache owned by the calling
+ * thread without locking, the global cache is only locked on misses. */
+static void imb_tile_cache_copy_pixel(ImBuf *ibuf, int x, int y, void *r_col)
+{
+  ImThreadTileCache *cache = imb_pixel_cache_get();
+  ImGlobalTile *gtile;
+  const int tx = x / ibuf->tilex;
+  const int ty = y / ibuf->tiley;
+  const size_t pixel_size = imb_tile_pixel_size(ibuf);
+  const size_t offset = (size_t)(y - ty * ibuf->tiley) * ibuf->tilex + (x - tx * ibuf->tilex);
+  const char *tile;
+
+  if (cache) {
+    tile = (const char *)imb_thread_cache_get_tile(cache, ibuf, tx, ty);
+    memcpy(r_col, tile + offset * pixel_size, pixel_size);
+    return;
+  }
+
+  /* more threads than caches, load tile while holding a reference to it */
+  gtile = imb_global_cache_get_tile(ibuf, tx, ty, NULL);
+
+  tile = (const char *)ibuf->tiles[ibuf->xtiles * ty + tx];
+  memcpy(r_col, tile + offset * pixel_size, pixel_size);
+
+  BLI_mutex_lock(&GLOBAL_CACHE.mutex);
+  imb_global_cache_tile_release(gtile);
+  BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
+}
+
+void IMB_tile_cache_get_pixel(ImBuf *ibuf, int x, int y, unsigned char r_col[4])
+{
+  BLI_assert((ibuf->flags & IB_tilecache_float) == 0);
+  imb_tile_cache_copy_pixel(ibuf, x, y, r_col);
+}
+
+/* float tiles are premultiplied like float buffers */
+void IMB_tile_cache_get_pixel_float(ImBuf *ibuf, int x, int y, float r_col[4])
+{
+  BLI_assert(ibuf->flags & IB_tilecache_float);
+  imb_tile_cache_copy_pixel(ibuf, x, y, r_col);
+}
+
 void IMB_tiles_to_rect(ImBuf *ibuf)
 {
   ImBuf *mipbuf;
   ImGlobalTile *gtile;
-  unsigned int *to, *from;
+  char *to, *from, *rect;
+  size_t pixel_size;
   int a, tx, ty, y, w, h;
 
   for (a = 0; a < ibuf->miptot; a++) {
     mipbuf = IMB_getmipmap(ibuf, a);
+    pixel_size = imb_tile_pixel_size(mipbuf);
 
     /* don't call imb_addrectImBuf, it frees all mipmaps */
-    if (!mipbuf->rect) {
-      if ((mipbuf->rect = MEM_mapallocN(ibuf->x * ibuf->y * sizeof(unsigned int),
-                                        "imb_addrectImBuf"))) {
-        mipbuf->mall |= IB_rect;
-        mipbuf->flags |= IB_rect;
+    if (mipbuf->flags & IB_tilecache_float) {
+      if (!mipbuf->rect_float) {
+        if ((mipbuf->rect_float = MEM_mapallocN(mipbuf->x * mipbuf->y * pixel_size,
+                                                "imb_addrectfloatImBuf"))) {
+          mipbuf->mall |= IB_rectfloat;
+          mipbuf->flags |= IB_rectfloat;
+          mipbuf->channels = 4;
+        }
+        else {
+          break;
+        }
       }
-      else {
-        break;
+      rect = (char *)mipbuf->rect_float;
+    }
+    else {
+      if (!mipbuf->rect) {
+        if ((mipbuf->rect = MEM_mapallocN(mipbuf->x * mipbuf->y * pixel_size,
+                                          "imb_addrectImBuf"))) {
+          mipbuf->mall |= IB_rect;
+          mipbuf->flags |= IB_rect;
+        }
+        else {
+          break;
+        }
       }
+      rect = (char *)mipbuf->rect;
     }
 
     for (ty = 0; ty < mipbuf->ytiles; ty++) {
@@ -444,22 +649,22 @@ void IMB_tiles_to_rect(ImBuf *ibuf)
         gtile = imb_global_cache_get_tile(mipbuf, tx, ty, NULL);
 
         /* setup pointers */
-        from = mipbuf->tiles[mipbuf->xtiles * ty + tx];
-        to = mipbuf->rect + mipbuf->x * ty * mipbuf->tiley + tx * mipbuf->tilex;
+        from = (char *)mipbuf->tiles[mipbuf->xtiles * ty + tx];
+        to = rect + pixel_size * ((size_t)mipbuf->x * ty * mipbuf->tiley + tx * mipbuf->tilex);
 
         /* exception in tile width/height for tiles at end of image */
         w = (tx == mipbuf->xtiles - 1) ? mipbuf->x - tx * mipbuf->tilex : mipbuf->tilex;
         h = (ty == mipbuf->ytiles - 1) ? mipbuf->y - ty * mipbuf->tiley : mipbuf->tiley;
 
         for (y = 0; y < h; y++) {
-          memcpy(to, from, sizeof(unsigned int) * w);
-          from += mipbuf->tilex;
-          to += mipbuf->x;
+          memcpy(to, from, pixel_size * w);
+          from += pixel_size * mipbuf->tilex;
+          to += pixel_size * mipbuf->x;
         }
 
         /* decrease refcount for tile again */
         BLI_mutex_lock(&GLOBAL_CACHE.mutex);
-        gtile->refcount--;
+        imb_global_cache_tile_release(gtile);
         BLI_mutex_unlock(&GLOBAL_CACHE.mutex);
       }
     }
@@ -97,10 +97,46 @@ static float imbuf_linear_srgb_to_xyz[3][3] = {{0.0f}};
  */
 static pthread_mutex_t processor_lock = BLI_MUTEX_INITIALIZER;
 
+/* Display transform processors are expensive to build, and viewers request one for the same
+ * view settings on every redraw, so a few recently used ones are kept around. */
+#define DISPLAY_PROCESSOR_CACHE_SIZE 8
+
+typedef struct DisplayProcessorCacheItem {
+  struct DisplayProcessorCacheItem *next, *prev;
+
+  /* Settings the processor was created for. */
+  char look[MAX_COLORSPACE_NAME];
+  char view[MAX_COLORSPACE_NAME];
+  char display[MAX_COLORSPACE_NAME];
+  char from_colorspace[MAX_COLORSPACE_NAME];
+  float exposure, gamma;
+
+  OCIO_ConstProcessorRcPtr *processor;
+
+  /* Number of ColormanageProcessor using this item. */
+  int users;
+  /* Removed from the cache while still in use, freed when the last user releases it. */
+  bool is_orphan;
+} DisplayProcessorCacheItem;
+
+/* Most recently used items first, protected by processor_lock. */
+static ListBase global_display_processor_cache = {NULL, NULL};
+
+/* Transforms which are exactly the sRGB curve, evaluated without OCIO. */
+typedef enum eColormanageSRGBTransform {
+  COLORMANAGE_SRGB_NONE = 0,
+  COLORMANAGE_SRGB_TO_LINEAR,
+  COLORMANAGE_LINEAR_TO_SRGB,
+} eColormanageSRGBTransform;
+
 typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
   bool is_data_result;
+  /* Used instead of the OCIO processor when set. */
+  eColormanageSRGBTransform srgb_transform;
+  /* Set when processor is owned by the display processor cache. */
+  DisplayProcessorCacheItem *cache_item;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -581,11 +617,45 @@ static void colormanage_load_config(OCIO_ConstConfigRcPtr *config)
   invert_m3_m3(imbuf_linear_srgb_to_xyz, imbuf_xyz_to_linear_srgb);
 }
 
+static void display_processor_cache_item_free(DisplayProcessorCacheItem *item)
+{
+  if (item->processor) {
+    OCIO_processorRelease(item->processor);
+  }
+  MEM_freeN(item);
+}
+
+static void display_processor_cache_free(void)
+{
+  DisplayProcessorCacheItem *item, *item_next;
+
+  BLI_mutex_lock(&processor_lock);
+
+  for (item = global_display_processor_cache.first; item; item = item_next) {
+    item_next = item->next;
+
+    if (item->users == 0) {
+      display_processor_cache_item_free(item);
+    }
+    else {
+      /* Still used by a processor, which will free it on release. */
+      item->is_orphan = true;
+      item->next = item->prev = NULL;
+    }
+  }
+  BLI_listbase_clear(&global_display_processor_cache);
+
+  BLI_mutex_unlock(&processor_lock);
+}
+
 static void colormanage_free_config(void)
 {
   ColorSpace *colorspace;
   ColorManagedDisplay *display;
 
+  /* free cached display processors */
+  display_processor_cache_free();
+
   /* free color spaces */
   colorspace = global_colorspaces.first;
   while (colorspace) {
@@ -757,6 +827,100 @@ static bool colormanage_compatible_look(ColorManagedLook *look, const char *view
   return (look->view[0] == 0 || (view_name && STREQ(look->view, view_name)));
 }
 
+#ifdef __SSE2__
+/* The approximation of c^(1/2.4) used by linearrgb_to_srgb_v4_simd() is off by up to 6e-4,
+ * enough to change the rounding of one in fifty display bytes. One Newton step on y^2.4 = c
+ * brings it to the precision of powf(). */
+MALWAYS_INLINE __m128 colormanage_linearrgb_to_srgb_sse(const __m128 c)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 cmp = _mm_cmplt_ps(c, _mm_set1_ps(0.0031308f));
+  const __m128 lt = _mm_max_ps(_mm_mul_ps(c, _mm_set1_ps(12.92f)), _mm_setzero_ps());
+  __m128 y = _bli_math_fastpow512(c);
+  const __m128 y24 = _bli_math_fastpow24(y);
+  y = _mm_mul_ps(
+      y,
+      _mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(1.0f / 2.4f), _mm_sub_ps(one, _mm_div_ps(c, y24)))));
+  const __m128 gte = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.055f), y), _mm_set1_ps(0.055f));
+  return _bli_math_blend_sse(cmp, lt, gte);
+}
+#endif
+
+/* Apply the sRGB curve or its inverse to RGB of 3 or 4 channel pixels, alpha is kept as-is.
+ * This is what OCIO computes for color spaces IMB_colormanagement_space_is_srgb() is true for,
+ * with SSE2 on all channels of a pixel at once instead of going through the OCIO processor. */
+static void colormanage_srgb_transform_apply(float *buffer,
+                                             size_t num_pixels,
+                                             int channels,
+                                             bool predivide,
+                                             eColormanageSRGBTransform transform)
+{
+  BLI_assert(ELEM(channels, 3, 4));
+  BLI_assert(transform != COLORMANAGE_SRGB_NONE);
+
+  for (size_t i = 0; i < num_pixels; i++, buffer += channels) {
+    const float alpha = (channels == 4) ? buffer[3] : 1.0f;
+    const bool use_alpha = predivide && alpha != 0.0f && alpha != 1.0f;
+
+#ifdef __SSE2__
+    float result[4];
+    __m128 rgb = (channels == 4) ? _mm_loadu_ps(buffer) :
+                                   _mm_set_ps(1.0f, buffer[2], buffer[1], buffer[0]);
+
+    if (use_alpha) {
+      rgb = _mm_mul_ps(rgb, _mm_set1_ps(1.0f / alpha));
+    }
+
+    if (transform == COLORMANAGE_SRGB_TO_LINEAR) {
+      rgb = srgb_to_linearrgb_v4_simd(rgb);
+    }
+    else {
+      rgb = colormanage_linearrgb_to_srgb_sse(rgb);
+    }
+
+    if (use_alpha) {
+      rgb = _mm_mul_ps(rgb, _mm_set1_ps(alpha));
+    }
+
+    _mm_storeu_ps(result, rgb);
+    copy_v3_v3(buffer, result);
+#else
+    if (use_alpha) {
+      mul_v3_fl(buffer, 1.0f / alpha);
+    }
+
+    if (transform == COLORMANAGE_SRGB_TO_LINEAR) {
+      srgb_to_linearrgb_v3_v3(buffer, buffer);
+    }
+    else {
+      linearrgb_to_srgb_v3_v3(buffer, buffer);
+    }
+
+    if (use_alpha) {
+      mul_v3_fl(buffer, alpha);
+    }
+#endif
+  }
+}
+
+/* Transform between the two color spaces if it is the sRGB curve or its inverse. */
+static eColormanageSRGBTransform colormanage_srgb_transform_get(ColorSpace *from_colorspace,
+                                                                ColorSpace *to_colorspace)
+{
+  if (from_colorspace == NULL || to_colorspace == NULL) {
+    return COLORMANAGE_SRGB_NONE;
+  }
+  if (IMB_colormanagement_space_is_srgb(from_colorspace) &&
+      IMB_colormanagement_space_is_scene_linear(to_colorspace)) {
+    return COLORMANAGE_SRGB_TO_LINEAR;
+  }
+  if (IMB_colormanagement_space_is_scene_linear(from_colorspace) &&
+      IMB_colormanagement_space_is_srgb(to_colorspace)) {
+    return COLORMANAGE_LINEAR_TO_SRGB;
+  }
+  return COLORMANAGE_SRGB_NONE;
+}
+
 void colormanage_cache_free(ImBuf *ibuf)
 {
   if (ibuf->display_buffer_flags) {
@@ -850,7 +1014,8 @@ static OCIO_ConstProcessorRcPtr *create_display_buffer_processor(const char *loo
   OCIO_displayTransformSetView(dt, view_transform);
   OCIO_displayTransformSetDisplay(dt, display);
 
-  if (look_descr->is_noop == false && colormanage_compatible_look(look_descr, view_transform)) {
+  if (look_descr != NULL && look_descr->is_noop == false &&
+      colormanage_compatible_look(look_descr, view_transform)) {
     OCIO_displayTransformSetLooksOverrideEnabled(dt, true);
     OCIO_displayTransformSetLooksOverride(dt, look);
   }
@@ -891,6 +1056,80 @@ static OCIO_ConstProcessorRcPtr *create_display_buffer_processor(const char *loo
   return processor;
 }
 
+/* Get display processor from the cache, creating it when needed.
+ * Returned item is to be released with display_processor_cache_release(). */
+static DisplayProcessorCacheItem *display_processor_cache_acquire(const char *look,
+                                                                  const char *view_transform,
+                                                                  const char *display,
+                                                                  float exposure,
+                                                                  float gamma,
+                                                                  const char *from_colorspace)
+{
+  DisplayProcessorCacheItem *item;
+
+  BLI_mutex_lock(&processor_lock);
+
+  for (item = global_display_processor_cache.first; item; item = item->next) {
+    if (item->exposure == exposure && item->gamma == gamma && STREQ(item->look, look) &&
+        STREQ(item->view, view_transform) && STREQ(item->display, display) &&
+        STREQ(item->from_colorspace, from_colorspace)) {
+      break;
+    }
+  }
+
+  if (item) {
+    BLI_remlink(&global_display_processor_cache, item);
+  }
+  else {
+    DisplayProcessorCacheItem *item_iter, *item_prev;
+    int tot_items;
+
+    item = MEM_callocN(sizeof(DisplayProcessorCacheItem), "display processor cache item");
+    BLI_strncpy(item->look, look, sizeof(item->look));
+    BLI_strncpy(item->view, view_transform, sizeof(item->view));
+    BLI_strncpy(item->display, display, sizeof(item->display));
+    BLI_strncpy(item->from_colorspace, from_colorspace, sizeof(item->from_colorspace));
+    item->exposure = exposure;
+    item->gamma = gamma;
+    item->processor = create_display_buffer_processor(
+        look, view_transform, display, exposure, gamma, from_colorspace);
+
+    /* Make room for the new item, evicting least recently used items nobody is using. */
+    tot_items = BLI_listbase_count(&global_display_processor_cache);
+    for (item_iter = global_display_processor_cache.last;
+         item_iter && tot_items >= DISPLAY_PROCESSOR_CACHE_SIZE;
+         item_iter = item_prev) {
+      item_prev = item_iter->prev;
+      if (item_iter->users == 0) {
+        BLI_remlink(&global_display_processor_cache, item_iter);
+        display_processor_cache_item_free(item_iter);
+        tot_items--;
+      }
+    }
+  }
+
+  BLI_addhead(&global_display_processor_cache, item);
+  item->users++;
+
+  BLI_mutex_unlock(&processor_lock);
+
+  return item;
+}
+
+static void display_processor_cache_release(DisplayProcessorCacheItem *item)
+{
+  BLI_mutex_lock(&processor_lock);
+
+  BLI_assert(item->users > 0);
+  item->users--;
+
+  if (item->users == 0 && item->is_orphan) {
+    display_processor_cache_item_free(item);
+  }
+
+  BLI_mutex_unlock(&processor_lock);
+}
+
 static OCIO_ConstProcessorRcPtr *create_colorspace_transform_processor(const char *from_colorspace,
                                                                        const char *to_colorspace)
 {
@@ -1518,16 +1757,26 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
     size_t i;
 
     /* first convert byte buffer to float, keep in image space */
-    for (i = 0, fp = linear_buffer, cp = byte_buffer; i != i_last;
-         i++, fp += channels, cp += channels) {
-      if (channels == 3) {
-        rgb_uchar_to_float(fp, cp);
-      }
-      else if (channels == 4) {
-        rgba_uchar_to_float(fp, cp);
-      }
-      else {
-        BLI_assert(!"Buffers of 3 or 4 channels are only supported here");
+    if (channels == 4) {
+      IMB_buffer_float_from_byte(linear_buffer,
+                                 byte_buffer,
+                                 IB_PROFILE_SRGB,
+                                 IB_PROFILE_SRGB,
+                                 false,
+                                 width,
+                                 height,
+                                 width,
+                                 width);
+    }
+    else {
+      for (i = 0, fp = linear_buffer, cp = byte_buffer; i != i_last;
+           i++, fp += channels, cp += channels) {
+        if (channels == 3) {
+          rgb_uchar_to_float(fp, cp);
+        }
+        else {
+          BLI_assert(!"Buffers of 3 or 4 channels are only supported here");
+        }
       }
     }
 
@@ -2152,6 +2401,12 @@ void IMB_colormanagement_colorspace_to_scene_linear(float *buffer,
     return;
   }
 
+  if (ELEM(channels, 3, 4) && IMB_colormanagement_space_is_srgb(colorspace)) {
+    colormanage_srgb_transform_apply(
+        buffer, (size_t)width * height, channels, predivide, COLORMANAGE_SRGB_TO_LINEAR);
+    return;
+  }
+
   processor = colorspace_to_scene_linear_processor(colorspace);
 
   if (processor) {
@@ -3685,15 +3940,26 @@ ColormanageProcessor *IMB_colormanagement_display_processor_new(
 
   display_space = display_transform_get_colorspace(applied_view_settings, display_settings);
   if (display_space) {
+    /* The look may not exist in the current configuration, then it isn't known to be a no-op. */
+    const ColorManagedLook *look = colormanage_look_get_named(applied_view_settings->look);
+
     cm_processor->is_data_result = display_space->is_data;
+
+    /* Standard view transform to an sRGB display without any adjustments. */
+    if (applied_view_settings->exposure == 0.0f && applied_view_settings->gamma == 1.0f &&
+        look != NULL && look->is_noop && IMB_colormanagement_space_is_srgb(display_space)) {
+      cm_processor->srgb_transform = COLORMANAGE_LINEAR_TO_SRGB;
+    }
   }
 
-  cm_processor->processor = create_display_buffer_processor(applied_view_settings->look,
-                                                            applied_view_settings->view_transform,
-                                                            display_settings->display_device,
-                                                            applied_view_settings->exposure,
-                                                            applied_view_settings->gamma,
-                                                            global_role_scene_linear);
+  cm_processor->cache_item = display_processor_cache_acquire(
+      applied_view_settings->look,
+      applied_view_settings->view_transform,
+      display_settings->display_device,
+      applied_view_settings->exposure,
+      applied_view_settings->gamma,
+      global_role_scene_linear);
+  cm_processor->processor = cm_processor->cache_item->processor;
 
   if (applied_view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) {
     cm_processor->curve_mapping = curvemapping_copy(applied_view_settings->curve_mapping);
@@ -3714,6 +3980,8 @@ ColormanageProcessor *IMB_colormanagement_colorspace_processor_new(const char *f
   color_space = colormanage_colorspace_get_named(to_colorspace);
   cm_processor->is_data_result = color_space->is_data;
 
+  cm_processor->srgb_transform = colormanage_srgb_transform_get(
+      colormanage_colorspace_get_named(from_colorspace), color_space);
   cm_processor->processor = create_colorspace_transform_processor(from_colorspace, to_colorspace);
 
   return cm_processor;
@@ -3725,7 +3993,10 @@ void IMB_colormanagement_processor_apply_v4(ColormanageProcessor *cm_processor,
     curvemapping_evaluate_premulRGBF(cm_processor->curve_mapping, pixel, pixel);
   }
 
-  if (cm_processor->processor) {
+  if (cm_processor->srgb_transform != COLORMANAGE_SRGB_NONE) {
+    colormanage_srgb_transform_apply(pixel, 1, 4, false, cm_processor->srgb_transform);
+  }
+  else if (cm_processor->processor) {
     OCIO_processorApplyRGBA(cm_processor->processor, pixel);
   }
 }
@@ -3737,7 +4008,10 @@ void IMB_colormanagement_processor_apply_v4_predivide(ColormanageProcessor *cm_p
     curvemapping_evaluate_premulRGBF(cm_processor->curve_mapping, pixel, pixel);
   }
 
-  if (cm_processor->processor) {
+  if (cm_processor->srgb_transform != COLORMANAGE_SRGB_NONE) {
+    colormanage_srgb_transform_apply(pixel, 1, 4, true, cm_processor->srgb_transform);
+  }
+  else if (cm_processor->processor) {
     OCIO_processorApplyRGBA_predivide(cm_processor->processor, pixel);
   }
 }
@@ -3748,7 +4022,10 @@ void IMB_colormanagement_processor_apply_v3(ColormanageProcessor *cm_processor,
     curvemapping_evaluate_premulRGBF(cm_processor->curve_mapping, pixel, pixel);
   }
 
-  if (cm_processor->processor) {
+  if (cm_processor->srgb_transform != COLORMANAGE_SRGB_NONE) {
+    colormanage_srgb_transform_apply(pixel, 1, 3, false, cm_processor->srgb_transform);
+  }
+  else if (cm_processor->processor) {
     OCIO_processorApplyRGB(cm_processor->processor, pixel);
   }
 }
@@ -3794,7 +4071,11 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     }
   }
 
-  if (cm_processor->processor && channels >= 3) {
+  if (cm_processor->srgb_transform != COLORMANAGE_SRGB_NONE && ELEM(channels, 3, 4)) {
+    colormanage_srgb_transform_apply(
+        buffer, (size_t)width * height, channels, predivide, cm_processor->srgb_transform);
+  }
+  else if (cm_processor->processor && channels >= 3) {
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
@@ -3824,15 +4105,28 @@ void IMB_colormanagement_processor_apply_byte(
    * but for now it's not so important.
    */
   BLI_assert(channels == 4);
-  float pixel[4];
+
+  /* Convert one row at a time, so the processor is applied to packed pixels rather
+   * than going through OCIO pixel by pixel. */
+  float *row = MEM_mallocN(sizeof(float) * channels * width, "colormanagement byte row");
   for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      size_t offset = channels * (((size_t)y) * width + x);
-      rgba_uchar_to_float(pixel, buffer + offset);
-      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
-      rgba_float_to_uchar(buffer + offset, pixel);
-    }
+    unsigned char *row_byte = buffer + ((size_t)y) * width * channels;
+    IMB_buffer_float_from_byte(
+        row, row_byte, IB_PROFILE_SRGB, IB_PROFILE_SRGB, false, width, 1, width, width);
+    IMB_colormanagement_processor_apply(cm_processor, row, width, 1, channels, false);
+    IMB_buffer_byte_from_float(row_byte,
+                               row,
+                               channels,
+                               0.0f,
+                               IB_PROFILE_SRGB,
+                               IB_PROFILE_SRGB,
+                               false,
+                               width,
+                               1,
+                               width,
+                               width);
   }
+  MEM_freeN(row);
 }
 
 void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
@@ -3840,7 +4134,10 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->curve_mapping) {
     curvemapping_free(cm_processor->curve_mapping);
   }
-  if (cm_processor->processor) {
+  if (cm_processor->cache_item) {
+    display_processor_cache_release(cm_processor->cache_item);
+  }
+  else if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
 
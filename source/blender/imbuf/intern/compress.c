@@ -0,0 +1,586 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ *
+ * In-memory compression of image buffers, used by caches to fit more frames into memory.
+ *
+ * Pixels are split into chunks of rows which are compressed and decompressed in parallel.
+ * Every chunk is filtered before compression: each channel value is replaced by its
+ * difference to the same channel of the pixel on the left, and bytes of the values are
+ * grouped by significance. This turns image areas into mostly small numbers, and plain
+ * Huffman coding of those is both faster and smaller than full deflate here.
+ *
+ * Float buffers are stored as exact float bits, or converted to half floats which keeps
+ * 11 bits of precision and is visually lossless for display.
+ */
+
+#include <string.h>
+#include <zlib.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf_types.h"
+#include "IMB_imbuf.h"
+#include "IMB_metadata.h"
+
+/* Number of rows compressed together. */
+#define COMPRESS_CHUNK_ROWS 64
+
+/* Compressed data is only kept when it saves at least this much memory. */
+#define COMPRESS_MIN_RATIO 1.25f
+
+typedef struct ImBufCompressedChunk {
+  void *data;
+  size_t size;
+} ImBufCompressedChunk;
+
+typedef struct ImBufCompressed {
+  /* Buffer without pixels, holding all other properties of the original buffer. */
+  ImBuf *header;
+  int method;
+  int tot_chunk;
+  /* Chunks of the byte and float buffers, NULL when there is no such buffer. */
+  ImBufCompressedChunk *rect_chunks;
+  ImBufCompressedChunk *rect_float_chunks;
+  /* Memory used by all the compressed data. */
+  size_t size;
+  bool failed;
+  /* Extra users, like #ImBuf.refcounter. */
+  int refcounter;
+} ImBufCompressed;
+
+static ThreadMutex refcounter_lock = BLI_MUTEX_INITIALIZER;
+
+/* -------------------------------------------------------------------- */
+/** \name Half Float Conversion
+ * \{ */
+
+typedef union FloatBits {
+  float f;
+  unsigned int u;
+} FloatBits;
+
+/* Round to nearest even. Finite values out of half range are clamped to largest half. */
+static unsigned short float_to_half(float f)
+{
+  FloatBits v;
+  unsigned int sign, abs, h, rem;
+
+  v.f = f;
+  sign = (v.u >> 16) & 0x8000;
+  abs = v.u & 0x7fffffff;
+
+  if (abs >= 0x7f800000) {
+    /* Infinity or NaN. */
+    return (unsigned short)(sign | ((abs > 0x7f800000) ? 0x7e00 : 0x7c00));
+  }
+  if (abs >= 0x477ff000) {
+    /* Would round to infinity. */
+    return (unsigned short)(sign | 0x7bff);
+  }
+  if (abs < 0x33000000) {
+    /* Rounds to zero. */
+    return (unsigned short)sign;
+  }
+  if (abs < 0x38800000) {
+    /* Denormalized half. */
+    const unsigned int shift = 126 - (abs >> 23);
+    const unsigned int mantissa = (abs & 0x7fffff) | 0x800000;
+    const unsigned int halfway = 1u << (shift - 1);
+
+    h = mantissa >> shift;
+    rem = mantissa & ((1u << shift) - 1);
+    if (rem > halfway || (rem == halfway && (h & 1))) {
+      h++;
+    }
+    return (unsigned short)(sign | h);
+  }
+
+  h = (abs - 0x38000000) >> 13;
+  rem = abs & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) {
+    h++;
+  }
+  return (unsigned short)(sign | h);
+}
+
+static float half_to_float(unsigned short h)
+{
+  const unsigned int sign = ((unsigned int)h & 0x8000) << 16;
+  const unsigned int exponent = (h >> 10) & 0x1f;
+  const unsigned int mantissa = h & 0x3ff;
+  FloatBits v;
+
+  if (exponent == 0) {
+    v.f = (float)mantissa * (1.0f / 16777216.0f);
+    v.u |= sign;
+  }
+  else if (exponent == 31) {
+    v.u = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else {
+    v.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  return v.f;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Filtering
+ *
+ * Elements are channel values of 1, 2 or 4 bytes. Encoding writes differences of elements
+ * into byte planes of the destination, decoding does the reverse.
+ * \{ */
+
+#define DEFINE_FILTER_FUNCTIONS(suffix, type, esize) \
+  static void filter_encode_##suffix( \
+      unsigned char *dst, const type *src, size_t row_len, int rows, int channels) \
+  { \
+    const size_t tot = row_len * rows; \
+    for (int y = 0; y < rows; y++) { \
+      const type *row = src + row_len * y; \
+      for (size_t i = 0; i < row_len; i++) { \
+        const type value = (i < (size_t)channels) ? row[i] : \
+                                                    (type)(row[i] - row[i - channels]); \
+        const size_t index = row_len * y + i; \
+        for (int b = 0; b < esize; b++) { \
+          dst[tot * b + index] = (unsigned char)(value >> (8 * b)); \
+        } \
+      } \
+    } \
+  } \
+\
+  static void filter_decode_##suffix( \
+      type *dst, const unsigned char *src, size_t row_len, int rows, int channels) \
+  { \
+    const size_t tot = row_len * rows; \
+    for (int y = 0; y < rows; y++) { \
+      type *row = dst + row_len * y; \
+      for (size_t i = 0; i < row_len; i++) { \
+        const size_t index = row_len * y + i; \
+        type value = 0; \
+        for (int b = 0; b < esize; b++) { \
+          value |= (type)((type)src[tot * b + index] << (8 * b)); \
+        } \
+        row[i] = (i < (size_t)channels) ? value : (type)(value + row[i - channels]); \
+      } \
+    } \
+  }
+
+DEFINE_FILTER_FUNCTIONS(byte, unsigned char, 1)
+DEFINE_FILTER_FUNCTIONS(half, unsigned short, 2)
+DEFINE_FILTER_FUNCTIONS(float, unsigned int, 4)
+
+#undef DEFINE_FILTER_FUNCTIONS
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Compression
+ * \{ */
+
+static bool chunk_deflate(ImBufCompressedChunk *chunk, const unsigned char *src, size_t size)
+{
+  z_stream stream = {NULL};
+  bool ok = false;
+
+  if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, MAX_WBITS, 8, Z_HUFFMAN_ONLY) != Z_OK) {
+    return false;
+  }
+
+  size_t bound = deflateBound(&stream, size);
+  unsigned char *dst = MEM_mallocN(bound, "compressed imbuf chunk");
+
+  stream.next_in = (Bytef *)src;
+  stream.avail_in = (uInt)size;
+  stream.next_out = dst;
+  stream.avail_out = (uInt)bound;
+
+  if (deflate(&stream, Z_FINISH) == Z_STREAM_END) {
+    chunk->size = stream.total_out;
+    chunk->data = MEM_reallocN(dst, chunk->size);
+    ok = true;
+  }
+  else {
+    MEM_freeN(dst);
+  }
+
+  deflateEnd(&stream);
+
+  return ok;
+}
+
+static bool chunk_inflate(const ImBufCompressedChunk *chunk, unsigned char *dst, size_t size)
+{
+  uLongf dst_size = size;
+
+  if (uncompress(dst, &dst_size, chunk->data, chunk->size) != Z_OK) {
+    return false;
+  }
+
+  return dst_size == size;
+}
+
+static void compress_chunk(ImBuf *ibuf, ImBufCompressed *cbuf, int chunk)
+{
+  const int y = chunk * COMPRESS_CHUNK_ROWS;
+  const int rows = min_ii(COMPRESS_CHUNK_ROWS, ibuf->y - y);
+
+  if (ibuf->rect) {
+    const size_t row_len = (size_t)ibuf->x * 4;
+    const size_t size = row_len * rows;
+    unsigned char *planes = MEM_mallocN(size, __func__);
+
+    filter_encode_byte(planes, (unsigned char *)ibuf->rect + row_len * y, row_len, rows, 4);
+    if (!chunk_deflate(&cbuf->rect_chunks[chunk], planes, size)) {
+      cbuf->failed = true;
+    }
+
+    MEM_freeN(planes);
+  }
+
+  if (ibuf->rect_float) {
+    const size_t row_len = (size_t)ibuf->x * ibuf->channels;
+    const float *src = ibuf->rect_float + row_len * y;
+
+    if (cbuf->method == IMB_COMPRESSION_HALF_FLOAT) {
+      const size_t size = row_len * rows * sizeof(unsigned short);
+      unsigned short *half = MEM_mallocN(size, __func__);
+      unsigned char *planes = MEM_mallocN(size, __func__);
+
+      for (size_t i = 0; i < row_len * rows; i++) {
+        half[i] = float_to_half(src[i]);
+      }
+      filter_encode_half(planes, half, row_len, rows, ibuf->channels);
+      if (!chunk_deflate(&cbuf->rect_float_chunks[chunk], planes, size)) {
+        cbuf->failed = true;
+      }
+
+      MEM_freeN(half);
+      MEM_freeN(planes);
+    }
+    else {
+      const size_t size = row_len * rows * sizeof(float);
+      unsigned char *planes = MEM_mallocN(size, __func__);
+
+      filter_encode_float(planes, (const unsigned int *)src, row_len, rows, ibuf->channels);
+      if (!chunk_deflate(&cbuf->rect_float_chunks[chunk], planes, size)) {
+        cbuf->failed = true;
+      }
+
+      MEM_freeN(planes);
+    }
+  }
+}
+
+static void decompress_chunk(const ImBufCompressed *cbuf, ImBuf *ibuf, int chunk, bool *failed)
+{
+  const int y = chunk * COMPRESS_CHUNK_ROWS;
+  const int rows = min_ii(COMPRESS_CHUNK_ROWS, ibuf->y - y);
+
+  if (cbuf->rect_chunks) {
+    const size_t row_len = (size_t)ibuf->x * 4;
+    const size_t size = row_len * rows;
+    unsigned char *planes = MEM_mallocN(size, __func__);
+
+    if (chunk_inflate(&cbuf->rect_chunks[chunk], planes, size)) {
+      filter_decode_byte((unsigned char *)ibuf->rect + row_len * y, planes, row_len, rows, 4);
+    }
+    else {
+      *failed = true;
+    }
+
+    MEM_freeN(planes);
+  }
+
+  if (cbuf->rect_float_chunks) {
+    const size_t row_len = (size_t)ibuf->x * ibuf->channels;
+    float *dst = ibuf->rect_float + row_len * y;
+
+    if (cbuf->method == IMB_COMPRESSION_HALF_FLOAT) {
+      const size_t size = row_len * rows * sizeof(unsigned short);
+      unsigned short *half = MEM_mallocN(size, __func__);
+      unsigned char *planes = MEM_mallocN(size, __func__);
+
+      if (chunk_inflate(&cbuf->rect_float_chunks[chunk], planes, size)) {
+        filter_decode_half(half, planes, row_len, rows, ibuf->channels);
+        for (size_t i = 0; i < row_len * rows; i++) {
+          dst[i] = half_to_float(half[i]);
+        }
+      }
+      else {
+        *failed = true;
+      }
+
+      MEM_freeN(half);
+      MEM_freeN(planes);
+    }
+    else {
+      const size_t size = row_len * rows * sizeof(float);
+      unsigned char *planes = MEM_mallocN(size, __func__);
+
+      if (chunk_inflate(&cbuf->rect_float_chunks[chunk], planes, size)) {
+        filter_decode_float((unsigned int *)dst, planes, row_len, rows, ibuf->channels);
+      }
+      else {
+        *failed = true;
+      }
+
+      MEM_freeN(planes);
+    }
+  }
+}
+
+typedef struct ChunkThreadData {
+  ImBuf *ibuf;
+  ImBufCompressed *cbuf;
+  bool decompress_failed;
+} ChunkThreadData;
+
+/* Process chunks starting within the given scanlines. */
+static void compress_thread_do(void *data_v, int start_scanline, int num_scanlines)
+{
+  ChunkThreadData *data = (ChunkThreadData *)data_v;
+  const int end_scanline = start_scanline + num_scanlines;
+
+  for (int y = start_scanline; y < end_scanline; y++) {
+    if (y % COMPRESS_CHUNK_ROWS == 0) {
+      compress_chunk(data->ibuf, data->cbuf, y / COMPRESS_CHUNK_ROWS);
+    }
+  }
+}
+
+static void decompress_thread_do(void *data_v, int start_scanline, int num_scanlines)
+{
+  ChunkThreadData *data = (ChunkThreadData *)data_v;
+  const int end_scanline = start_scanline + num_scanlines;
+
+  for (int y = start_scanline; y < end_scanline; y++) {
+    if (y % COMPRESS_CHUNK_ROWS == 0) {
+      decompress_chunk(data->cbuf, data->ibuf, y / COMPRESS_CHUNK_ROWS, &data->decompress_failed);
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+static bool imb_can_compress(const ImBuf *ibuf)
+{
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return false;
+  }
+  if (ibuf->rect_float && (ibuf->channels < 1 || ibuf->channels > 4)) {
+    return false;
+  }
+  /* Buffers with data not covered by compression, or which must not change in memory. */
+  if (ibuf->zbuf || ibuf->zbuf_float || ibuf->tiles || ibuf->mipmap[0] || ibuf->encodedbuffer ||
+      ibuf->dds_data.data) {
+    return false;
+  }
+  if (ibuf->userflags & (IB_BITMAPDIRTY | IB_PERSISTENT)) {
+    return false;
+  }
+  return true;
+}
+
+static void imb_compressed_free_chunks(ImBufCompressedChunk *chunks, int tot_chunk)
+{
+  if (chunks == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < tot_chunk; i++) {
+    if (chunks[i].data) {
+      MEM_freeN(chunks[i].data);
+    }
+  }
+  MEM_freeN(chunks);
+}
+
+/* Keep the compressed buffer alive while decompressing it without holding the lock of the cache
+ * that owns it, released again with IMB_compressed_free(). */
+void IMB_compressed_ref(ImBufCompressed *cbuf)
+{
+  BLI_mutex_lock(&refcounter_lock);
+  cbuf->refcounter++;
+  BLI_mutex_unlock(&refcounter_lock);
+}
+
+void IMB_compressed_free(ImBufCompressed *cbuf)
+{
+  bool needs_free;
+
+  BLI_mutex_lock(&refcounter_lock);
+  needs_free = (cbuf->refcounter == 0);
+  if (!needs_free) {
+    cbuf->refcounter--;
+  }
+  BLI_mutex_unlock(&refcounter_lock);
+
+  if (!needs_free) {
+    return;
+  }
+
+  imb_compressed_free_chunks(cbuf->rect_chunks, cbuf->tot_chunk);
+  imb_compressed_free_chunks(cbuf->rect_float_chunks, cbuf->tot_chunk);
+
+  if (cbuf->header) {
+    IMB_freeImBuf(cbuf->header);
+  }
+
+  MEM_freeN(cbuf);
+}
+
+/* Compress pixels of the buffer with given IMB_COMPRESSION_ method.
+ * Returns NULL when the buffer can't be compressed or compression doesn't save enough memory,
+ * the buffer itself is not modified. */
+ImBufCompressed *IMB_compressed_from_imbuf(ImBuf *ibuf, int method)
+{
+  ImBufCompressed *cbuf;
+  ChunkThreadData data;
+  ImBuf tbuf;
+  size_t raw_size = 0;
+
+  if (method == IMB_COMPRESSION_NONE || !imb_can_compress(ibuf)) {
+    return NULL;
+  }
+
+  cbuf = MEM_callocN(sizeof(ImBufCompressed), "ImBufCompressed");
+  cbuf->method = method;
+  cbuf->tot_chunk = (ibuf->y + COMPRESS_CHUNK_ROWS - 1) / COMPRESS_CHUNK_ROWS;
+
+  if (ibuf->rect) {
+    cbuf->rect_chunks = MEM_callocN(sizeof(ImBufCompressedChunk) * cbuf->tot_chunk,
+                                    "ImBufCompressed byte chunks");
+    raw_size += (size_t)ibuf->x * ibuf->y * sizeof(unsigned int);
+  }
+  if (ibuf->rect_float) {
+    cbuf->rect_float_chunks = MEM_callocN(sizeof(ImBufCompressedChunk) * cbuf->tot_chunk,
+                                          "ImBufCompressed float chunks");
+    raw_size += (size_t)ibuf->x * ibuf->y * ibuf->channels * sizeof(float);
+  }
+
+  data.ibuf = ibuf;
+  data.cbuf = cbuf;
+  data.decompress_failed = false;
+  IMB_processor_apply_threaded_scanlines(ibuf->y, compress_thread_do, &data);
+
+  cbuf->size = sizeof(ImBufCompressed) + sizeof(ImBuf);
+  for (int i = 0; i < cbuf->tot_chunk; i++) {
+    if (cbuf->rect_chunks) {
+      cbuf->size += sizeof(ImBufCompressedChunk) + cbuf->rect_chunks[i].size;
+    }
+    if (cbuf->rect_float_chunks) {
+      cbuf->size += sizeof(ImBufCompressedChunk) + cbuf->rect_float_chunks[i].size;
+    }
+  }
+
+  if (cbuf->failed || (float)raw_size < (float)cbuf->size * COMPRESS_MIN_RATIO) {
+    IMB_compressed_free(cbuf);
+    return NULL;
+  }
+
+  /* Keep everything except pixels, same as IMB_dupImBuf(). */
+  cbuf->header = IMB_allocImBuf(ibuf->x, ibuf->y, ibuf->planes, 0);
+
+  tbuf = *ibuf;
+  tbuf.rect = NULL;
+  tbuf.rect_float = NULL;
+  tbuf.mall = 0;
+  tbuf.c_handle = NULL;
+  tbuf.refcounter = 0;
+  tbuf.metadata = NULL;
+  tbuf.display_buffer_flags = NULL;
+  tbuf.colormanage_cache = NULL;
+  *cbuf->header = tbuf;
+
+  IMB_metadata_copy(cbuf->header, ibuf);
+
+  return cbuf;
+}
+
+/* Create a new buffer with decompressed pixels, NULL when data turns out to be corrupted. */
+ImBuf *IMB_compressed_to_imbuf(const ImBufCompressed *cbuf)
+{
+  const ImBuf *header = cbuf->header;
+  ImBuf *ibuf, tbuf;
+  ChunkThreadData data;
+
+  ibuf = IMB_allocImBuf(header->x, header->y, header->planes, 0);
+  if (ibuf == NULL) {
+    return NULL;
+  }
+
+  if (cbuf->rect_chunks && !imb_addrectImBuf(ibuf)) {
+    IMB_freeImBuf(ibuf);
+    return NULL;
+  }
+
+  /* Not imb_addrectfloatImBuf(), it always allocates 4 channels. */
+  ibuf->channels = header->channels;
+  if (cbuf->rect_float_chunks) {
+    ibuf->rect_float = imb_alloc_pixels(
+        ibuf->x, ibuf->y, ibuf->channels, sizeof(float), "IMB_compressed_to_imbuf");
+    if (ibuf->rect_float == NULL) {
+      IMB_freeImBuf(ibuf);
+      return NULL;
+    }
+    ibuf->mall |= IB_rectfloat;
+    ibuf->flags |= IB_rectfloat;
+  }
+
+  data.ibuf = ibuf;
+  data.cbuf = (ImBufCompressed *)cbuf;
+  data.decompress_failed = false;
+  IMB_processor_apply_threaded_scanlines(ibuf->y, decompress_thread_do, &data);
+
+  if (data.decompress_failed) {
+    IMB_freeImBuf(ibuf);
+    return NULL;
+  }
+
+  tbuf = *header;
+  tbuf.rect = ibuf->rect;
+  tbuf.rect_float = ibuf->rect_float;
+  tbuf.mall = ibuf->mall;
+  tbuf.c_handle = NULL;
+  tbuf.refcounter = 0;
+  tbuf.metadata = NULL;
+  *ibuf = tbuf;
+
+  IMB_metadata_copy(ibuf, (ImBuf *)header);
+
+  return ibuf;
+}
+
+size_t IMB_compressed_get_size_in_memory(const ImBufCompressed *cbuf)
+{
+  return cbuf->size;
+}
+
+/** \} */
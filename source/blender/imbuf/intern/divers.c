@@ -35,6 +35,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /************************* Floyd-Steinberg dithering *************************/
 
 typedef struct DitherContext {
@@ -96,6 +100,111 @@ MINLINE void float_to_byte_dither_v4(
   b[3] = unit_float_to_uchar_clamp(f[3]);
 }
 
+/* Row conversions for the common case of RGBA buffers without color space conversion.
+ * The SSE2 versions give bit-identical results to rgba_uchar_to_float, rgba_float_to_uchar
+ * and premul_to_straight_v4_v4. */
+
+#ifdef __SSE2__
+
+MALWAYS_INLINE __m128 float_to_byte_scale_sse(const __m128 v)
+{
+  const __m128 scaled = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+  /* Max with zero as second operand also maps NaN to zero. */
+  return _mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+}
+
+MALWAYS_INLINE __m128 premul_to_straight_sse(const __m128 v)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128 mask = _mm_and_ps(_mm_cmpneq_ps(alpha, _mm_setzero_ps()),
+                                 _mm_cmpneq_ps(alpha, one));
+  /* Alpha itself is kept as-is. */
+  const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 factor = _bli_math_blend_sse(
+      _mm_and_ps(mask, rgb_mask), _mm_div_ps(one, alpha), one);
+  return _mm_mul_ps(v, factor);
+}
+
+#endif /* __SSE2__ */
+
+static void rgba_byte_to_float_row(float *to, const uchar *from, int width)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)from);
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+    _mm_storeu_ps(to + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(to + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    rgba_uchar_to_float(to, from);
+  }
+}
+
+static void rgba_float_to_byte_row(uchar *to,
+                                   const float *from,
+                                   int width,
+                                   bool predivide,
+                                   DitherContext *di,
+                                   float inv_width,
+                                   float t)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    __m128 p[4];
+
+    for (int i = 0; i < 4; i++) {
+      p[i] = _mm_loadu_ps(from + i * 4);
+      if (predivide) {
+        p[i] = premul_to_straight_sse(p[i]);
+      }
+      if (di) {
+        /* Noise stays scalar, vectorizing sinf() would change the pattern. */
+        const float dither_value = dither_random_value((float)(x + i) * inv_width, t) * 0.005f *
+                                   di->dither;
+        p[i] = _mm_add_ps(p[i], _mm_set_ps(0.0f, dither_value, dither_value, dither_value));
+      }
+      p[i] = float_to_byte_scale_sse(p[i]);
+    }
+
+    const __m128i lo = _mm_packs_epi32(_mm_cvttps_epi32(p[0]), _mm_cvttps_epi32(p[1]));
+    const __m128i hi = _mm_packs_epi32(_mm_cvttps_epi32(p[2]), _mm_cvttps_epi32(p[3]));
+    _mm_storeu_si128((__m128i *)to, _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    float straight[4];
+    const float *pixel = from;
+
+    if (predivide) {
+      premul_to_straight_v4_v4(straight, from);
+      pixel = straight;
+    }
+
+    if (di) {
+      float_to_byte_dither_v4(to, pixel, di, (float)x * inv_width, t);
+    }
+    else {
+      rgba_float_to_uchar(to, pixel);
+    }
+  }
+}
+
 /* Test if colorspace conversions of pixels in buffer need to take into account alpha. */
 bool IMB_alpha_affects_rgb(const ImBuf *ibuf)
 {
@@ -176,31 +285,8 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
       uchar *to = rect_to + ((size_t)stride_to) * y * 4;
 
       if (profile_to == profile_from) {
-        float straight[4];
-
         /* no color space conversion */
-        if (dither && predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            float_to_byte_dither_v4(to, straight, di, (float)x * inv_width, t);
-          }
-        }
-        else if (dither) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            float_to_byte_dither_v4(to, from, di, (float)x * inv_width, t);
-          }
-        }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            rgba_float_to_uchar(to, straight);
-          }
-        }
-        else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            rgba_float_to_uchar(to, from);
-          }
-        }
+        rgba_float_to_byte_row(to, from, width, predivide, di, inv_width, t);
       }
       else if (profile_to == IB_PROFILE_SRGB) {
         /* convert from linear to sRGB */
@@ -385,9 +471,7 @@ void IMB_buffer_float_from_byte(float *rect_to,
 
     if (profile_to == profile_from) {
       /* no color space conversion */
-      for (x = 0; x < width; x++, from += 4, to += 4) {
-        rgba_uchar_to_float(to, from);
-      }
+      rgba_byte_to_float_row(to, from, width);
     }
     else if (profile_to == IB_PROFILE_LINEAR_RGB) {
       /* convert sRGB to linear */
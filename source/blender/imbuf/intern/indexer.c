@@ -30,6 +30,8 @@
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -437,6 +439,11 @@ typedef struct IndexBuildContext {
 
 #ifdef WITH_FFMPEG
 
+/* Every proxy size is scaled and encoded in its own thread, so building several sizes at once
+ * takes about as long as building the largest one. The decoding thread hands each of them a copy
+ * of the decoded frame, only a few frames are queued per proxy. */
+#define PROXY_OUTPUT_QUEUE_SIZE 8
+
 struct proxy_output_ctx {
   AVFormatContext *of;
   AVStream *st;
@@ -448,8 +455,19 @@ struct proxy_output_ctx {
   int proxy_size;
   int orig_height;
   struct anim *anim;
+
+  /* Encoding thread and its queue of LinkData with AVFrame. */
+  ListBase threads;
+  ListBase queue;
+  int queue_len;
+  ThreadMutex queue_mutex;
+  ThreadCondition queue_cond;
+  bool queue_stop;
+  bool queue_cancel;
 };
 
+static int add_to_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, AVFrame *frame);
+
 // work around stupid swscaler 16 bytes alignment bug...
 
 static int round_up(int x, int mod)
@@ -457,6 +475,95 @@ static int round_up(int x, int mod)
   return x + ((mod - (x % mod)) % mod);
 }
 
+static void *proxy_output_thread(void *ctx_v)
+{
+  struct proxy_output_ctx *ctx = ctx_v;
+
+  BLI_mutex_lock(&ctx->queue_mutex);
+
+  while (true) {
+    LinkData *link = BLI_pophead(&ctx->queue);
+    AVFrame *frame;
+    bool cancel;
+
+    if (link == NULL) {
+      if (ctx->queue_stop) {
+        break;
+      }
+      BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+      continue;
+    }
+
+    ctx->queue_len--;
+    cancel = ctx->queue_cancel;
+    BLI_condition_notify_all(&ctx->queue_cond);
+    BLI_mutex_unlock(&ctx->queue_mutex);
+
+    frame = link->data;
+    if (!cancel) {
+      add_to_proxy_output_ffmpeg(ctx, frame);
+    }
+    av_frame_free(&frame);
+    MEM_freeN(link);
+
+    BLI_mutex_lock(&ctx->queue_mutex);
+  }
+
+  BLI_mutex_unlock(&ctx->queue_mutex);
+
+  return NULL;
+}
+
+static void proxy_output_thread_start(struct proxy_output_ctx *ctx)
+{
+  BLI_mutex_init(&ctx->queue_mutex);
+  BLI_condition_init(&ctx->queue_cond);
+
+  BLI_threadpool_init(&ctx->threads, proxy_output_thread, 1);
+  BLI_threadpool_insert(&ctx->threads, ctx);
+}
+
+/* Waits until queued frames are encoded, or drops them when rolling back. */
+static void proxy_output_thread_end(struct proxy_output_ctx *ctx, int rollback)
+{
+  BLI_mutex_lock(&ctx->queue_mutex);
+  ctx->queue_stop = true;
+  ctx->queue_cancel = rollback;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+
+  BLI_threadpool_end(&ctx->threads);
+
+  BLI_condition_end(&ctx->queue_cond);
+  BLI_mutex_end(&ctx->queue_mutex);
+}
+
+/* Queues a copy of the decoded frame, the decoder reuses its buffers for the next frame. */
+static void proxy_output_queue_frame(struct proxy_output_ctx *ctx, AVFrame *frame)
+{
+  LinkData *link;
+  AVFrame *frame_copy;
+
+  if (!ctx) {
+    return;
+  }
+
+  frame_copy = av_frame_clone(frame);
+  if (frame_copy == NULL) {
+    return;
+  }
+  link = BLI_genericNodeN(frame_copy);
+
+  BLI_mutex_lock(&ctx->queue_mutex);
+  while (ctx->queue_len >= PROXY_OUTPUT_QUEUE_SIZE) {
+    BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+  }
+  BLI_addtail(&ctx->queue, link);
+  ctx->queue_len++;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+}
+
 static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
     struct anim *anim, AVStream *st, int proxy_size, int width, int height, int quality)
 {
@@ -567,6 +674,8 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
     return 0;
   }
 
+  proxy_output_thread_start(rv);
+
   return rv;
 }
 
@@ -639,6 +748,8 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
     return;
   }
 
+  proxy_output_thread_end(ctx, rollback);
+
   if (!rollback) {
     while (add_to_proxy_output_ffmpeg(ctx, NULL)) {
     }
@@ -772,6 +883,11 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
 
   context->iCodecCtx->workaround_bugs = 1;
 
+  /* Only slice threading, frame threading delays the output by several frames, which breaks
+   * matching decoded frames with the keyframe they were decoded from. */
+  context->iCodecCtx->thread_count = BLI_system_thread_count();
+  context->iCodecCtx->thread_type = FF_THREAD_SLICE;
+
   if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
     avformat_close_input(&context->iFormatCtx);
     MEM_freeN(context);
@@ -841,7 +957,7 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
   for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+    proxy_output_queue_frame(context->proxy_ctx[i], in_frame);
   }
 
   if (!context->start_pts_set) {
@@ -1272,6 +1388,8 @@ void IMB_free_indices(struct anim *anim)
 
   anim->proxies_tried = 0;
   anim->indices_tried = 0;
+
+  imb_anim_timecode_index_changed(anim);
 }
 
 void IMB_anim_set_index_dir(struct anim *anim, const char *dir)
@@ -1326,6 +1444,11 @@ struct anim_index *IMB_anim_open_index(struct anim *anim, IMB_Timecode_Type tc)
 
   anim->indices_tried |= tc;
 
+  /* Frames fetched before the index was built map to other positions. */
+  if (anim->curr_idx[i]) {
+    imb_anim_timecode_index_changed(anim);
+  }
+
   return anim->curr_idx[i];
 }
 
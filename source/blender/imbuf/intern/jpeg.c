@@ -38,6 +38,7 @@
 #include "IMB_imbuf.h"
 #include "IMB_metadata.h"
 #include "IMB_filetype.h"
+#include "IMB_thumbs.h"
 #include "jpeglib.h"
 #include "jerror.h"
 
@@ -264,6 +265,7 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
   JSAMPLE *buffer = NULL;
   int row_stride;
   int x, y, depth, r, g, b, k;
+  int image_width, image_height;
   struct ImBuf *ibuf = NULL;
   uchar *rect;
   jpeg_saved_marker_ptr marker;
@@ -276,16 +278,32 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
   jpeg_save_markers(cinfo, JPEG_COM, 0xffff);
 
   if (jpeg_read_header(cinfo, false) == JPEG_HEADER_OK) {
-    x = cinfo->image_width;
-    y = cinfo->image_height;
+    /* x and y are reused as loop counters, keep the size of the image for thumbnails. */
+    image_width = x = cinfo->image_width;
+    image_height = y = cinfo->image_height;
     depth = cinfo->num_components;
 
     if (cinfo->jpeg_color_space == JCS_YCCK) {
       cinfo->out_color_space = JCS_CMYK;
     }
 
+    if (flags & IB_thumbnail) {
+      /* DCT scaling decodes at 1/2, 1/4 or 1/8 of the size for a fraction of the cost */
+      cinfo->scale_num = 1;
+      cinfo->scale_denom = 1;
+      while (cinfo->scale_denom < 8 &&
+             max_ii(x, y) / (int)(cinfo->scale_denom * 2) >= THUMB_SIZE_LOAD) {
+        cinfo->scale_denom *= 2;
+      }
+    }
+
     jpeg_start_decompress(cinfo);
 
+    if (flags & IB_thumbnail) {
+      x = cinfo->output_width;
+      y = cinfo->output_height;
+    }
+
     if (flags & IB_test) {
       jpeg_abort_decompress(cinfo);
       ibuf = IMB_allocImBuf(x, y, 8 * depth, 0);
@@ -414,6 +432,10 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
     if (ibuf) {
       ibuf->ftype = IMB_FTYPE_JPG;
       ibuf->foptions.quality = MIN2(ibuf_quality, 100);
+
+      if ((flags & IB_thumbnail) && (ibuf->x != image_width || ibuf->y != image_height)) {
+        IMB_thumb_set_original_size(ibuf, image_width, image_height);
+      }
     }
   }
 
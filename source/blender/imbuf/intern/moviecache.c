@@ -23,7 +23,9 @@
 
 #undef DEBUG_MESSAGES
 
+#include <limits.h>
 #include <stdlib.h> /* for qsort */
+#include <stdio.h>
 #include <memory.h>
 
 #include "MEM_guardedalloc.h"
@@ -32,14 +34,20 @@
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_threads.h"
 
+#include "PIL_time.h"
+
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 
+#include "atomic_ops.h"
+
 #ifdef DEBUG_MESSAGES
 #  if defined __GNUC__
 #    define PRINT(format, args...) printf(format, ##args)
@@ -50,10 +58,24 @@
 #  define PRINT(format, ...)
 #endif
 
+/* Limits of the weight given to items of a cache, relative to the items of other caches. */
+#define MOVIECACHE_MIN_WEIGHT 0.25f
+#define MOVIECACHE_MAX_WEIGHT 4.0f
+
 static MEM_CacheLimiterC *limitor = NULL;
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
+/* All existing caches, and a counter incremented on every access to a cached item.
+ * Both are protected by limitor_lock. */
+static ListBase global_caches = {NULL, NULL};
+static unsigned int global_access_tick = 0;
+
+/* IMB_COMPRESSION_ method used for caches which allow compression. */
+static int global_compression_method = IMB_COMPRESSION_NONE;
+
 typedef struct MovieCache {
+  struct MovieCache *next, *prev;
+
   char name[64];
 
   GHash *hash;
@@ -75,6 +97,23 @@ typedef struct MovieCache {
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
   int pad;
+
+  /* Statistics used to balance memory between caches, protected by limitor_lock.
+   * Cost of an item is measured as time from a lookup miss until the buffer for the
+   * missed key is put into the cache. Item count and memory in use are running counters,
+   * updated atomically since items are freed both with and without the lock held. */
+  MovieCacheStats stats;
+  void *last_miss_userkey;
+  double last_miss_time;
+  float avg_item_size;
+
+  /* Whether buffers may be stored compressed, see IMB_moviecache_set_use_compression(). */
+  bool use_compression;
+
+  /* Last decompressed buffer and the data it came from, both referenced and protected by
+   * limitor_lock. Consecutive lookups of the same frame don't decompress it again. */
+  struct ImBufCompressed *last_compressed;
+  ImBuf *last_decompressed;
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -84,9 +123,15 @@ typedef struct MovieCacheKey {
 
 typedef struct MovieCacheItem {
   MovieCache *cache_owner;
+  /* Either buffer or its compressed version is stored, both are NULL when the item was freed
+   * by the cache limiter. */
   ImBuf *ibuf;
+  struct ImBufCompressed *compressed;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  unsigned int last_access;
+  /* Size added to the memory in use of the cache statistics, 0 when not counted. */
+  size_t counted_size;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -113,6 +158,22 @@ static void moviecache_keyfree(void *val)
   BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+static void moviecache_stats_count_item(MovieCache *cache, MovieCacheItem *item, size_t size)
+{
+  item->counted_size = size;
+  atomic_add_and_fetch_int32(&cache->stats.totitem, 1);
+  atomic_add_and_fetch_z(&cache->stats.mem_in_use, size);
+}
+
+static void moviecache_stats_uncount_item(MovieCache *cache, MovieCacheItem *item)
+{
+  if (item->counted_size) {
+    atomic_sub_and_fetch_int32(&cache->stats.totitem, 1);
+    atomic_sub_and_fetch_z(&cache->stats.mem_in_use, item->counted_size);
+    item->counted_size = 0;
+  }
+}
+
 static void moviecache_valfree(void *val)
 {
   MovieCacheItem *item = (MovieCacheItem *)val;
@@ -120,10 +181,16 @@ static void moviecache_valfree(void *val)
 
   PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
-  if (item->ibuf) {
+  if (item->ibuf || item->compressed) {
     MEM_CacheLimiter_unmanage(item->c_handle);
+  }
+  moviecache_stats_uncount_item(cache, item);
+  if (item->ibuf) {
     IMB_freeImBuf(item->ibuf);
   }
+  if (item->compressed) {
+    IMB_compressed_free(item->compressed);
+  }
 
   if (item->priority_data && cache->prioritydeleterfp) {
     cache->prioritydeleterfp(item->priority_data);
@@ -145,7 +212,7 @@ static void check_unused_keys(MovieCache *cache)
 
     BLI_ghashIterator_step(&gh_iter);
 
-    remove = !item->ibuf;
+    remove = !item->ibuf && !item->compressed;
 
     if (remove) {
       PRINT("%s: cache '%s' remove item %p without buffer\n", __func__, cache->name, item);
@@ -168,16 +235,25 @@ static void IMB_moviecache_destructor(void *p)
 {
   MovieCacheItem *item = (MovieCacheItem *)p;
 
-  if (item && item->ibuf) {
+  if (item && (item->ibuf || item->compressed)) {
     MovieCache *cache = item->cache_owner;
 
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
-    IMB_freeImBuf(item->ibuf);
+    if (item->ibuf) {
+      IMB_freeImBuf(item->ibuf);
+    }
+    if (item->compressed) {
+      IMB_compressed_free(item->compressed);
+    }
 
     item->ibuf = NULL;
+    item->compressed = NULL;
     item->c_handle = NULL;
 
+    moviecache_stats_uncount_item(cache, item);
+    cache->stats.evicted++;
+
     /* force cached segments to be updated */
     if (cache->points) {
       MEM_freeN(cache->points);
@@ -204,27 +280,66 @@ static size_t get_item_size(void *p)
   if (item->ibuf) {
     size += get_size_in_memory(item->ibuf);
   }
+  else if (item->compressed) {
+    size += IMB_compressed_get_size_in_memory(item->compressed);
+  }
 
   return size;
 }
 
-static int get_item_priority(void *item_v, int default_priority)
+/* Update relative weights of the caches from their statistics. Caches which hit often and
+ * whose items are slow to produce compared to their size get a larger share of memory.
+ * Called with limitor_lock held. */
+static void moviecache_update_weights(void)
+{
+  MovieCache *cache;
+  double tot_benefit = 0.0;
+  int tot_measured = 0;
+
+  for (cache = global_caches.first; cache; cache = cache->next) {
+    if (cache->stats.avg_cost > 0.0f && cache->avg_item_size > 0.0f) {
+      const MovieCacheStats *stats = &cache->stats;
+      const double hit_rate = (stats->hits + 1.0) / (stats->hits + stats->misses + 2.0);
+
+      tot_benefit += hit_rate * stats->avg_cost / cache->avg_item_size;
+      tot_measured++;
+    }
+  }
+
+  for (cache = global_caches.first; cache; cache = cache->next) {
+    cache->stats.weight = 1.0f;
+
+    if (tot_benefit > 0.0 && cache->stats.avg_cost > 0.0f && cache->avg_item_size > 0.0f) {
+      const MovieCacheStats *stats = &cache->stats;
+      const double hit_rate = (stats->hits + 1.0) / (stats->hits + stats->misses + 2.0);
+      const double benefit = hit_rate * stats->avg_cost / cache->avg_item_size;
+
+      cache->stats.weight = (float)(benefit * tot_measured / tot_benefit);
+      CLAMP(cache->stats.weight, MOVIECACHE_MIN_WEIGHT, MOVIECACHE_MAX_WEIGHT);
+    }
+  }
+}
+
+static int get_item_priority(void *item_v, int UNUSED(default_priority))
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
   MovieCache *cache = item->cache_owner;
   int priority;
 
-  if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
-          __func__,
-          cache->name,
-          item,
-          default_priority);
-
-    return default_priority;
+  if (cache->getitempriorityfp) {
+    priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  }
+  else {
+    /* Least recently used items go first. The limiter's default priority is based on
+     * insertion order, since it doesn't reorder its queue when priority callback is used. */
+    const unsigned int age = global_access_tick - item->last_access;
+    priority = -(int)MIN2(age, (unsigned int)INT_MAX);
   }
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
+  /* Items of more valuable caches are treated as if they were more recent. */
+  if (priority < 0) {
+    priority = (int)(priority / cache->stats.weight);
+  }
 
   PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
 
@@ -237,8 +352,11 @@ static bool get_item_destroyable(void *item_v)
   /* IB_BITMAPDIRTY means image was modified from inside blender and
    * changes are not saved to disk.
    *
-   * Such buffers are never to be freed.
+   * Such buffers are never to be freed. They are never compressed either.
    */
+  if (item->ibuf == NULL) {
+    return true;
+  }
   if ((item->ibuf->userflags & IB_BITMAPDIRTY) || (item->ibuf->userflags & IB_PERSISTENT)) {
     return false;
   }
@@ -284,6 +402,13 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->cmpfp = cmpfp;
   cache->proxy = -1;
 
+  cache->last_miss_userkey = MEM_mallocN(keysize, "movie cache last miss user key");
+  cache->stats.weight = 1.0f;
+
+  BLI_mutex_lock(&limitor_lock);
+  BLI_addtail(&global_caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   return cache;
 }
 
@@ -292,6 +417,22 @@ void IMB_moviecache_set_getdata_callback(MovieCache *cache, MovieCacheGetKeyData
   cache->getdatafp = getdatafp;
 }
 
+/* Allow buffers of the cache to be stored compressed, when compression is enabled with
+ * IMB_moviecache_set_compression(). Only to be used for caches which don't rely on getting
+ * the same buffer back or on iterating over buffers, since only the most recently
+ * decompressed buffer is kept and iterators and cleanup callbacks get NULL for compressed
+ * buffers. */
+void IMB_moviecache_set_use_compression(MovieCache *cache, bool use_compression)
+{
+  cache->use_compression = use_compression;
+}
+
+/* Set IMB_COMPRESSION_ method used for newly stored buffers. */
+void IMB_moviecache_set_compression(int method)
+{
+  global_compression_method = method;
+}
+
 void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCacheGetPriorityDataFP getprioritydatafp,
                                           MovieCacheGetItemPriorityFP getitempriorityfp,
@@ -304,7 +445,21 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+/* Compressed version of the buffer to be stored instead of it, or NULL. */
+static struct ImBufCompressed *moviecache_compress(MovieCache *cache, ImBuf *ibuf)
+{
+  if (!cache->use_compression || global_compression_method == IMB_COMPRESSION_NONE) {
+    return NULL;
+  }
+
+  return IMB_compressed_from_imbuf(ibuf, global_compression_method);
+}
+
+static void do_moviecache_put(MovieCache *cache,
+                              void *userkey,
+                              ImBuf *ibuf,
+                              struct ImBufCompressed *compressed,
+                              bool need_lock)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
@@ -313,7 +468,9 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     IMB_moviecache_init();
   }
 
-  IMB_refImBuf(ibuf);
+  if (compressed == NULL) {
+    IMB_refImBuf(ibuf);
+  }
 
   key = BLI_mempool_alloc(cache->keys_pool);
   key->cache_owner = cache;
@@ -324,10 +481,13 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
   PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache->name, ibuf, item);
 
-  item->ibuf = ibuf;
+  item->ibuf = compressed ? NULL : ibuf;
+  item->compressed = compressed;
   item->cache_owner = cache;
   item->c_handle = NULL;
   item->priority_data = NULL;
+  item->last_access = 0;
+  item->counted_size = 0;
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
@@ -343,6 +503,27 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     BLI_mutex_lock(&limitor_lock);
   }
 
+  item->last_access = ++global_access_tick;
+
+  if (cache->last_miss_time != 0.0 && !cache->cmpfp(cache->last_miss_userkey, userkey)) {
+    const float cost = (float)(PIL_check_seconds_timer() - cache->last_miss_time);
+    const float size = (float)get_item_size(item);
+
+    if (cache->stats.avg_cost == 0.0f) {
+      cache->stats.avg_cost = cost;
+      cache->avg_item_size = size;
+    }
+    else {
+      cache->stats.avg_cost = interpf(cost, cache->stats.avg_cost, 0.1f);
+      cache->avg_item_size = interpf(size, cache->avg_item_size, 0.1f);
+    }
+
+    cache->last_miss_time = 0.0;
+  }
+
+  moviecache_update_weights();
+
+  moviecache_stats_count_item(cache, item, get_item_size(item));
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
 
   MEM_CacheLimiter_ref(item->c_handle);
@@ -364,27 +545,35 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-  do_moviecache_put(cache, userkey, ibuf, true);
+  struct ImBufCompressed *compressed = moviecache_compress(cache, ibuf);
+
+  do_moviecache_put(cache, userkey, ibuf, compressed, true);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
+  struct ImBufCompressed *compressed = moviecache_compress(cache, ibuf);
   size_t mem_in_use, mem_limit, elem_size;
   bool result = false;
 
-  elem_size = get_size_in_memory(ibuf);
+  elem_size = compressed ? IMB_compressed_get_size_in_memory(compressed) :
+                           get_size_in_memory(ibuf);
   mem_limit = MEM_CacheLimiter_get_maximum();
 
   BLI_mutex_lock(&limitor_lock);
   mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
   if (mem_in_use + elem_size <= mem_limit) {
-    do_moviecache_put(cache, userkey, ibuf, false);
+    do_moviecache_put(cache, userkey, ibuf, compressed, false);
     result = true;
   }
 
   BLI_mutex_unlock(&limitor_lock);
 
+  if (!result && compressed) {
+    IMB_compressed_free(compressed);
+  }
+
   return result;
 }
 
@@ -398,17 +587,73 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
   item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
   if (item) {
-    if (item->ibuf) {
-      BLI_mutex_lock(&limitor_lock);
+    struct ImBufCompressed *compressed = NULL, *old_compressed;
+    ImBuf *ibuf, *old_ibuf;
+
+    /* The limiter may free the pixels or compressed data of the item from another thread,
+     * so read both once while holding the lock. */
+    BLI_mutex_lock(&limitor_lock);
+    ibuf = item->ibuf;
+    if (ibuf == NULL) {
+      compressed = item->compressed;
+      if (compressed && compressed == cache->last_compressed) {
+        ibuf = cache->last_decompressed;
+      }
+    }
+
+    if (ibuf || compressed) {
       MEM_CacheLimiter_touch(item->c_handle);
+      item->last_access = ++global_access_tick;
+      cache->stats.hits++;
+    }
+
+    if (ibuf) {
+      IMB_refImBuf(ibuf);
       BLI_mutex_unlock(&limitor_lock);
 
-      IMB_refImBuf(item->ibuf);
+      return ibuf;
+    }
+
+    if (compressed) {
+      /* Keep the data from being freed by the limiter while decompressing. */
+      IMB_compressed_ref(compressed);
+    }
+    BLI_mutex_unlock(&limitor_lock);
+
+    if (compressed) {
+      ibuf = IMB_compressed_to_imbuf(compressed);
+
+      if (ibuf) {
+        IMB_refImBuf(ibuf);
+        IMB_compressed_ref(compressed);
+
+        BLI_mutex_lock(&limitor_lock);
+        old_compressed = cache->last_compressed;
+        old_ibuf = cache->last_decompressed;
+        cache->last_compressed = compressed;
+        cache->last_decompressed = ibuf;
+        BLI_mutex_unlock(&limitor_lock);
+
+        if (old_compressed) {
+          IMB_compressed_free(old_compressed);
+          IMB_freeImBuf(old_ibuf);
+        }
+      }
+
+      IMB_compressed_free(compressed);
 
-      return item->ibuf;
+      if (ibuf) {
+        return ibuf;
+      }
     }
   }
 
+  BLI_mutex_lock(&limitor_lock);
+  cache->stats.misses++;
+  memcpy(cache->last_miss_userkey, userkey, cache->keysize);
+  cache->last_miss_time = PIL_check_seconds_timer();
+  BLI_mutex_unlock(&limitor_lock);
+
   return NULL;
 }
 
@@ -428,8 +673,17 @@ void IMB_moviecache_free(MovieCache *cache)
 {
   PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
+  BLI_mutex_lock(&limitor_lock);
+  BLI_remlink(&global_caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
 
+  if (cache->last_compressed) {
+    IMB_compressed_free(cache->last_compressed);
+    IMB_freeImBuf(cache->last_decompressed);
+  }
+
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mempool_destroy(cache->userkeys_pool);
@@ -442,6 +696,8 @@ void IMB_moviecache_free(MovieCache *cache)
     MEM_freeN(cache->last_userkey);
   }
 
+  MEM_freeN(cache->last_miss_userkey);
+
   MEM_freeN(cache);
 }
 
@@ -469,6 +725,55 @@ void IMB_moviecache_cleanup(MovieCache *cache,
   }
 }
 
+/* Called with limitor_lock held. Cheap enough to be called on every redraw, the item count
+ * and memory in use are kept up to date on put and free. Memory in use is the size of items
+ * at the time they were put into the cache. */
+static void moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  *r_stats = cache->stats;
+}
+
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  BLI_mutex_lock(&limitor_lock);
+  moviecache_get_stats(cache, r_stats);
+  BLI_mutex_unlock(&limitor_lock);
+}
+
+/* Print statistics of all caches, for tuning of cache limits. */
+void IMB_moviecache_print_stats(void)
+{
+  MovieCache *cache;
+  size_t mem_limit = MEM_CacheLimiter_get_maximum();
+
+  printf("Movie cache statistics (limit %.2f MB):\n", (double)mem_limit / (1024.0 * 1024.0));
+
+  BLI_mutex_lock(&limitor_lock);
+
+  for (cache = global_caches.first; cache; cache = cache->next) {
+    MovieCacheStats stats;
+    int lookups;
+
+    moviecache_get_stats(cache, &stats);
+    lookups = stats.hits + stats.misses;
+
+    printf(
+        "  %s: %d items, %.2f MB, %d hits, %d misses (%.1f%% hit rate), %d evicted, "
+        "%.2f ms avg cost, weight %.2f\n",
+        cache->name,
+        stats.totitem,
+        (double)stats.mem_in_use / (1024.0 * 1024.0),
+        stats.hits,
+        stats.misses,
+        lookups ? 100.0 * stats.hits / lookups : 0.0,
+        stats.evicted,
+        stats.avg_cost * 1000.0,
+        stats.weight);
+  }
+
+  BLI_mutex_unlock(&limitor_lock);
+}
+
 /* get segments of cached frames. useful for debugging cache policies */
 void IMB_moviecache_get_cache_segments(
     MovieCache *cache, int proxy, int render_flags, int *totseg_r, int **points_r)
@@ -504,7 +809,7 @@ void IMB_moviecache_get_cache_segments(
       MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
       int framenr, curproxy, curflags;
 
-      if (item->ibuf) {
+      if (item->ibuf || item->compressed) {
         cache->getdatafp(key->userkey, &framenr, &curproxy, &curflags);
 
         if (curproxy == proxy && curflags == render_flags) {
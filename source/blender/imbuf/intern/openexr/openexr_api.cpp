@@ -54,6 +54,7 @@
 #include <ImfOutputPart.h>
 #include <ImfMultiPartOutputFile.h>
 #include <ImfTiledOutputPart.h>
+#include <ImfTiledInputPart.h>
 #include <ImfPartType.h>
 #include <ImfPartHelper.h>
 
@@ -77,7 +78,9 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #include "MEM_guardedalloc.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
+#include "BLI_math_vector.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -86,7 +89,9 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 #include "IMB_allocimbuf.h"
+#include "IMB_filetype.h"
 #include "IMB_metadata.h"
+#include "IMB_thumbs.h"
 
 #include "openexr_multi.h"
 }
@@ -102,6 +107,7 @@ using namespace Imath;
 extern "C" {
 /* prototype */
 static struct ExrPass *imb_exr_get_pass(ListBase *lb, char *passname);
+static void imb_exr_pass_setup(struct ExrPass *pass, int width, int height, bool alloc);
 static bool exr_has_multiview(MultiPartInputFile &file);
 static bool exr_has_multipart_file(MultiPartInputFile &file);
 static bool exr_has_alpha(MultiPartInputFile &file);
@@ -1207,9 +1213,11 @@ void IMB_exrtile_write_channels(
   }
 }
 
-void IMB_exr_read_channels(void *handle)
+/* Reads all channels which have memory assigned. Parts without any such
+ * channel are skipped, which is what makes reading single passes cheap
+ * for multipart files. */
+static bool imb_exr_read_channels_ex(ExrHandle *data, const bool warn_missing)
 {
-  ExrHandle *data = (ExrHandle *)handle;
   int numparts = data->ifile->parts();
 
   /* check if exr was saved with previous versions of blender which flipped images */
@@ -1236,6 +1244,7 @@ void IMB_exr_read_channels(void *handle)
     /* Insert all matching channel into framebuffer. */
     FrameBuffer frameBuffer;
     ExrChannel *echan;
+    bool has_channels = false;
 
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
       if (echan->m->part_number != i) {
@@ -1267,12 +1276,17 @@ void IMB_exr_read_channels(void *handle)
 
         frameBuffer.insert(echan->m->internal_name,
                            Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+        has_channels = true;
       }
-      else {
+      else if (warn_missing) {
         printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
       }
     }
 
+    if (!has_channels) {
+      continue;
+    }
+
     /* Read pixels. */
     try {
       in.setFrameBuffer(frameBuffer);
@@ -1281,9 +1295,104 @@ void IMB_exr_read_channels(void *handle)
     }
     catch (const std::exception &exc) {
       std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void IMB_exr_read_channels(void *handle)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  imb_exr_read_channels_ex(data, true);
+}
+
+/* Open the file again for a handle which was created from memory without
+ * reading any passes, so they can be read on demand with IMB_exr_read_pass. */
+bool IMB_exr_reopen_file(void *handle, const char *filename)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  delete data->ifile;
+  delete data->ifile_stream;
+
+  data->ifile = NULL;
+  data->ifile_stream = NULL;
+
+  try {
+    data->ifile_stream = new IFileStream(filename);
+    data->ifile = new MultiPartInputFile(*(data->ifile_stream));
+
+    /* the file may have changed on disk since it was loaded */
+    Box2i dw = data->ifile->header(0).dataWindow();
+    if (dw.max.x - dw.min.x + 1 != data->width || dw.max.y - dw.min.y + 1 != data->height) {
+      throw Iex::InputExc("Image size changed since loading.");
+    }
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-reopen: ERROR: " << exc.what() << std::endl;
+
+    delete data->ifile;
+    delete data->ifile_stream;
+
+    data->ifile = NULL;
+    data->ifile_stream = NULL;
+
+    return false;
+  }
+
+  return true;
+}
+
+/* Read a single pass, the returned buffer is owned by the caller.
+ * Only the channels of this pass are read from the file. */
+float *IMB_exr_read_pass(void *handle,
+                         const char *layname,
+                         const char *passname,
+                         const char *viewname)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  ExrLayer *lay;
+  ExrPass *pass;
+  float *rect;
+  bool ok;
+
+  if (data->ifile == NULL) {
+    return NULL;
+  }
+
+  lay = (ExrLayer *)BLI_findstring(&data->layers, layname, offsetof(ExrLayer, name));
+  if (lay == NULL) {
+    return NULL;
+  }
+
+  for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+    if (STREQ(pass->internal_name, passname) && STREQ(pass->view, viewname)) {
       break;
     }
   }
+
+  if (pass == NULL || pass->totchan == 0) {
+    return NULL;
+  }
+
+  imb_exr_pass_setup(pass, data->width, data->height, true);
+
+  ok = imb_exr_read_channels_ex(data, false);
+
+  /* hand over the buffer, unassign it so other reads don't write into it */
+  rect = pass->rect;
+  pass->rect = NULL;
+  imb_exr_pass_setup(pass, data->width, data->height, false);
+
+  if (!ok) {
+    MEM_freeN(rect);
+    return NULL;
+  }
+
+  return rect;
 }
 
 void IMB_exr_multilayer_convert(void *handle,
@@ -1527,17 +1636,80 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
   return pass;
 }
 
+/* Assigns channels to the pass buffer, allocating it when requested.
+ * Without allocation only the channel order is set up, so passes can be
+ * read later on demand. */
+static void imb_exr_pass_setup(ExrPass *pass, int width, int height, bool alloc)
+{
+  ExrChannel *echan;
+  int a;
+
+  if (alloc && pass->rect == NULL) {
+    pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float),
+                                        "pass rect");
+  }
+
+  if (pass->totchan == 1) {
+    echan = pass->chan[0];
+    echan->rect = pass->rect;
+    echan->xstride = 1;
+    echan->ystride = width;
+    pass->chan_id[0] = echan->chan_id;
+  }
+  else {
+    char lookup[256];
+
+    memset(lookup, 0, sizeof(lookup));
+
+    /* we can have RGB(A), XYZ(W), UVA */
+    if (pass->totchan == 3 || pass->totchan == 4) {
+      if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+          pass->chan[2]->chan_id == 'B') {
+        lookup[(unsigned int)'R'] = 0;
+        lookup[(unsigned int)'G'] = 1;
+        lookup[(unsigned int)'B'] = 2;
+        lookup[(unsigned int)'A'] = 3;
+      }
+      else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+               pass->chan[2]->chan_id == 'Y') {
+        lookup[(unsigned int)'X'] = 0;
+        lookup[(unsigned int)'Y'] = 1;
+        lookup[(unsigned int)'Z'] = 2;
+        lookup[(unsigned int)'W'] = 3;
+      }
+      else {
+        lookup[(unsigned int)'U'] = 0;
+        lookup[(unsigned int)'V'] = 1;
+        lookup[(unsigned int)'A'] = 2;
+      }
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = pass->rect ? pass->rect + lookup[(unsigned int)echan->chan_id] : NULL;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
+      }
+    }
+    else { /* unknown */
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = pass->rect ? pass->rect + a : NULL;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[a] = echan->chan_id;
+      }
+    }
+  }
+}
+
 /* creates channels, makes a hierarchy and assigns memory to channels */
-static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
-                                         MultiPartInputFile &file,
-                                         int width,
-                                         int height)
+static ExrHandle *imb_exr_begin_read_mem(
+    IStream &file_stream, MultiPartInputFile &file, int width, int height, bool alloc_passes)
 {
   ExrLayer *lay;
   ExrPass *pass;
   ExrChannel *echan;
   ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
-  int a;
   char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
   data->ifile_stream = &file_stream;
@@ -1602,59 +1774,7 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
       if (pass->totchan) {
-        pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float),
-                                            "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (pass->totchan == 3 || pass->totchan == 4) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
-        }
+        imb_exr_pass_setup(pass, width, height, alloc_passes);
       }
     }
   }
@@ -1885,9 +2005,297 @@ static bool imb_exr_is_multi(MultiPartInputFile &file)
 bool IMB_exr_has_multilayer(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
+
+  /* lazily loaded handles have no file open, they are only created for multilayer files */
+  if (data->ifile == NULL) {
+    return true;
+  }
+
   return imb_exr_is_multi(*data->ifile);
 }
 
+/* Tiled single part files can be read on demand through the tile cache.
+ * Ripmaps have separate levels per axis, which ImBuf mipmaps can't represent. */
+static bool exr_is_tiled_texture(MultiPartInputFile &file)
+{
+  const Header &header = file.header(0);
+
+  if (file.parts() != 1 || !header.hasTileDescription()) {
+    return false;
+  }
+
+  return header.tileDescription().mode != RIPMAP_LEVELS;
+}
+
+static void exr_tile_file_load_tile(
+    ImTileFile *tile_file, ImBuf *ibuf, int tx, int ty, unsigned int *rect);
+static void exr_tile_file_free(ImTileFile *tile_file);
+
+/* Tiled file kept open for reading tiles, opened on first use. */
+struct ExrTileFile {
+  ImTileFile base;
+
+  /* reading tiles goes through the frame buffer of the part, one thread at a time */
+  ThreadMutex mutex;
+  IStream *stream;
+  MultiPartInputFile *file;
+  TiledInputPart *part;
+  bool failed;
+};
+
+/* Create empty mipmap levels with tiles, pixels are loaded by the tile cache. */
+static void imb_exr_setup_tilecache(ImBuf *ibuf, MultiPartInputFile &file)
+{
+  TiledInputPart in(file, 0);
+  int numlevel = (in.levelMode() == MIPMAP_LEVELS) ? in.numLevels() : 1;
+  ExrTileFile *tile_file = new ExrTileFile();
+
+  CLAMP_MAX(numlevel, IMB_MIPMAP_LEVELS + 1);
+
+  tile_file->base.load_tile = exr_tile_file_load_tile;
+  tile_file->base.free = exr_tile_file_free;
+  tile_file->base.users = numlevel;
+  BLI_mutex_init(&tile_file->mutex);
+  tile_file->stream = NULL;
+  tile_file->file = NULL;
+  tile_file->part = NULL;
+  tile_file->failed = false;
+
+  for (int level = 0; level < numlevel; level++) {
+    ImBuf *hbuf;
+
+    if (level > 0) {
+      hbuf = IMB_allocImBuf(in.levelWidth(level), in.levelHeight(level), ibuf->planes, 0);
+      hbuf->miplevel = level;
+      hbuf->ftype = ibuf->ftype;
+      ibuf->mipmap[level - 1] = hbuf;
+    }
+    else {
+      hbuf = ibuf;
+    }
+
+    /* tiles keep the full float precision of the file */
+    hbuf->flags |= IB_tilecache | IB_tilecache_float;
+    hbuf->channels = 4;
+    hbuf->tile_file = &tile_file->base;
+
+    hbuf->tilex = in.tileXSize();
+    hbuf->tiley = in.tileYSize();
+    hbuf->xtiles = in.numXTiles(level);
+    hbuf->ytiles = in.numYTiles(level);
+
+    imb_addtilesImBuf(hbuf);
+
+    ibuf->miptot++;
+  }
+}
+
+/* Smallest mipmap level that is still large enough for a thumbnail, 0 when the file has no
+ * mipmaps. */
+static int exr_thumbnail_level(MultiPartInputFile &file)
+{
+  if (!exr_is_tiled_texture(file)) {
+    return 0;
+  }
+
+  TiledInputPart in(file, 0);
+  int level = 0;
+
+  if (in.levelMode() != MIPMAP_LEVELS) {
+    return 0;
+  }
+
+  while (level + 1 < in.numLevels() &&
+         max_ii(in.levelWidth(level + 1), in.levelHeight(level + 1)) >= THUMB_SIZE_LOAD) {
+    level++;
+  }
+
+  return level;
+}
+
+/* Read a whole mipmap level into the float buffer, used for thumbnails. */
+static void imb_exr_read_level(ImBuf *ibuf, MultiPartInputFile &file, int level)
+{
+  TiledInputPart in(file, 0);
+  Box2i dw = in.dataWindowForLevel(level);
+  const int width = in.levelWidth(level);
+  const int height = in.levelHeight(level);
+  const bool has_rgb = exr_has_rgb(file);
+  FrameBuffer frameBuffer;
+  int xstride = sizeof(float) * 4;
+  int ystride = -xstride * width;
+  float *first;
+
+  ibuf->x = width;
+  ibuf->y = height;
+  imb_addrectfloatImBuf(ibuf);
+
+  /* same y-flipped layout as reading the full resolution image */
+  first = ibuf->rect_float - 4 * (dw.min.x - dw.min.y * width);
+  first += 4 * (height - 1) * width;
+
+  if (has_rgb) {
+    frameBuffer.insert(exr_rgba_channelname(file, "R"),
+                       Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+    frameBuffer.insert(exr_rgba_channelname(file, "G"),
+                       Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride));
+    frameBuffer.insert(exr_rgba_channelname(file, "B"),
+                       Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride));
+  }
+  else {
+    /* luminance only, chroma is ignored for tiled reading */
+    frameBuffer.insert(exr_rgba_channelname(file, "Y"),
+                       Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+  }
+
+  frameBuffer.insert(exr_rgba_channelname(file, "A"),
+                     Slice(Imf::FLOAT, (char *)(first + 3), xstride, ystride, 1, 1, 1.0f));
+
+  in.setFrameBuffer(frameBuffer);
+  in.readTiles(0, in.numXTiles(level) - 1, 0, in.numYTiles(level) - 1, level);
+
+  if (!has_rgb) {
+    for (size_t a = 0; a < (size_t)ibuf->x * ibuf->y; ++a) {
+      float *color = ibuf->rect_float + a * 4;
+      color[1] = color[2] = color[0];
+    }
+  }
+}
+
+static void exr_tile_file_free(ImTileFile *tile_file_p)
+{
+  ExrTileFile *tile_file = (ExrTileFile *)tile_file_p;
+
+  delete tile_file->part;
+  delete tile_file->file;
+  delete tile_file->stream;
+  BLI_mutex_end(&tile_file->mutex);
+  delete tile_file;
+}
+
+/* Open the file on first use, mutex must be locked. */
+static bool exr_tile_file_open(ExrTileFile *tile_file, const char *filepath)
+{
+  if (tile_file->part || tile_file->failed) {
+    return !tile_file->failed;
+  }
+
+  try {
+    tile_file->stream = new IFileStream(filepath);
+    tile_file->file = new MultiPartInputFile(*tile_file->stream);
+    tile_file->part = new TiledInputPart(*tile_file->file, 0);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << exc.what() << std::endl;
+
+    delete tile_file->part;
+    delete tile_file->file;
+    delete tile_file->stream;
+    tile_file->part = NULL;
+    tile_file->file = NULL;
+    tile_file->stream = NULL;
+    tile_file->failed = true;
+  }
+
+  return !tile_file->failed;
+}
+
+static void exr_tile_file_load_tile(
+    ImTileFile *tile_file_p, ImBuf *ibuf, int tx, int ty, unsigned int *rect)
+{
+  ExrTileFile *tile_file = (ExrTileFile *)tile_file_p;
+  float *buffer = NULL;
+  bool has_rgb = true;
+  bool ok = false;
+
+  /* ImBuf tiles start at the bottom of the image, file tiles at the top,
+   * so an ImBuf tile may overlap two rows of file tiles */
+  const int tile_y_min = ty * ibuf->tiley;
+  const int tile_y_max = min_ii((ty + 1) * ibuf->tiley, ibuf->y) - 1;
+  const int tile_h = tile_y_max - tile_y_min + 1;
+  const int tile_w = min_ii((tx + 1) * ibuf->tilex, ibuf->x) - tx * ibuf->tilex;
+  const int dy_min = (ibuf->y - 1 - tile_y_max) / ibuf->tiley;
+  const int dy_max = (ibuf->y - 1 - tile_y_min) / ibuf->tiley;
+  const size_t buffer_h = (size_t)(dy_max - dy_min + 1) * ibuf->tiley;
+
+  buffer = (float *)MEM_mallocN(sizeof(float) * 4 * ibuf->tilex * buffer_h, __func__);
+
+  BLI_mutex_lock(&tile_file->mutex);
+
+  if (exr_tile_file_open(tile_file, ibuf->cachename)) {
+    try {
+      MultiPartInputFile &file = *tile_file->file;
+      TiledInputPart &in = *tile_file->part;
+      const int level = (in.levelMode() == MIPMAP_LEVELS) ? ibuf->miplevel : 0;
+
+      if (level >= in.numLevels() || in.levelWidth(level) != ibuf->x ||
+          in.levelHeight(level) != ibuf->y) {
+        printf("%s: mipmap level %d has unexpected size\n", __func__, ibuf->miplevel);
+      }
+      else {
+        Box2i dw = in.dataWindowForLevel(level);
+        FrameBuffer frameBuffer;
+        const int xstride = sizeof(float) * 4;
+        const int ystride = xstride * ibuf->tilex;
+
+        /* offset so the first pixel of the tile column lands at the start of the buffer */
+        float *first = buffer - 4 * ((ptrdiff_t)(dw.min.x + tx * ibuf->tilex) +
+                                     (ptrdiff_t)(dw.min.y + dy_min * ibuf->tiley) * ibuf->tilex);
+
+        has_rgb = exr_has_rgb(file);
+
+        if (has_rgb) {
+          frameBuffer.insert(exr_rgba_channelname(file, "R"),
+                             Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+          frameBuffer.insert(exr_rgba_channelname(file, "G"),
+                             Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride));
+          frameBuffer.insert(exr_rgba_channelname(file, "B"),
+                             Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride));
+        }
+        else {
+          /* luminance only, chroma is ignored for tiled reading */
+          frameBuffer.insert(exr_rgba_channelname(file, "Y"),
+                             Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+        }
+
+        frameBuffer.insert(exr_rgba_channelname(file, "A"),
+                           Slice(Imf::FLOAT, (char *)(first + 3), xstride, ystride, 1, 1, 1.0f));
+
+        in.setFrameBuffer(frameBuffer);
+        in.readTiles(tx, tx, dy_min, dy_max, level);
+        ok = true;
+      }
+    }
+    catch (const std::exception &exc) {
+      std::cerr << exc.what() << std::endl;
+    }
+  }
+
+  BLI_mutex_unlock(&tile_file->mutex);
+
+  if (ok) {
+    /* flip rows into the tile, floats stay premultiplied as in the file */
+    for (int y = 0; y < tile_h; y++) {
+      /* row in the file, relative to the first tile row we read */
+      const int row = ibuf->y - 1 - (tile_y_min + y) - dy_min * ibuf->tiley;
+      const float *from = buffer + 4 * (size_t)row * ibuf->tilex;
+      float *to = (float *)rect + 4 * (size_t)y * ibuf->tilex;
+
+      if (has_rgb) {
+        memcpy(to, from, sizeof(float) * 4 * tile_w);
+      }
+      else {
+        for (int x = 0; x < tile_w; x++, from += 4, to += 4) {
+          to[0] = to[1] = to[2] = from[0];
+          to[3] = from[3];
+        }
+      }
+    }
+  }
+
+  MEM_freeN(buffer);
+}
+
 struct ImBuf *imb_load_openexr(const unsigned char *mem,
                                size_t size,
                                int flags,
@@ -1957,12 +2365,38 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
           }
         }
 
-        if (is_multi &&
-            ((flags & IB_thumbnail) == 0)) { /* only enters with IB_multilayer flag set */
+        if ((flags & IB_tilecache) && !is_multi && exr_is_tiled_texture(*file)) {
+          /* pixels are read on demand by the tile cache, see exr_tile_file_load_tile */
+          imb_exr_setup_tilecache(ibuf, *file);
+
+          delete membuf;
+          delete file;
+        }
+        else if ((flags & IB_thumbnail) && !is_multi && exr_thumbnail_level(*file) > 0) {
+          /* a mipmap level is enough for a thumbnail */
+          imb_exr_read_level(ibuf, *file, exr_thumbnail_level(*file));
+          IMB_thumb_set_original_size(ibuf, width, height);
+
+          delete membuf;
+          delete file;
+        }
+        else if (is_multi &&
+                 ((flags & IB_thumbnail) == 0)) { /* only enters with IB_multilayer flag set */
           /* constructs channels for reading, allocates memory in channels */
-          ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height);
+          const bool lazy = (flags & IB_multilayer_lazy) != 0;
+          ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height, !lazy);
           if (handle) {
-            IMB_exr_read_channels(handle);
+            if (lazy) {
+              /* passes are read on demand, memory isn't valid after loading,
+               * the caller has to use IMB_exr_reopen_file */
+              delete membuf;
+              delete file;
+              handle->ifile = NULL;
+              handle->ifile_stream = NULL;
+            }
+            else {
+              IMB_exr_read_channels(handle);
+            }
             ibuf->userdata = handle; /* potential danger, the caller has to check for this! */
           }
         }
@@ -88,6 +88,17 @@ float *IMB_exr_channel_rect(void * /*handle*/,
 void IMB_exr_read_channels(void * /*handle*/)
 {
 }
+bool IMB_exr_reopen_file(void * /*handle*/, const char * /*filename*/)
+{
+  return false;
+}
+float *IMB_exr_read_pass(void * /*handle*/,
+                         const char * /*layname*/,
+                         const char * /*passname*/,
+                         const char * /*viewname*/)
+{
+  return NULL;
+}
 void IMB_exr_write_channels(void * /*handle*/)
 {
 }
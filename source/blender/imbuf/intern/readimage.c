@@ -50,7 +50,8 @@ static void imb_handle_alpha(ImBuf *ibuf,
                              char effective_colorspace[IM_MAX_SPACE])
 {
   if (colorspace) {
-    if (ibuf->rect != NULL && ibuf->rect_float == NULL) {
+    if ((ibuf->rect != NULL || (ibuf->flags & IB_tilecache)) && ibuf->rect_float == NULL &&
+        (ibuf->flags & IB_tilecache_float) == 0) {
       /* byte buffer is never internally converted to some standard space,
        * store pointer to it's color space descriptor instead
        */
@@ -318,6 +319,11 @@ void imb_loadtile(ImBuf *ibuf, int tx, int ty, unsigned int *rect)
 {
   int file;
 
+  if (ibuf->tile_file) {
+    ibuf->tile_file->load_tile(ibuf->tile_file, ibuf, tx, ty, rect);
+    return;
+  }
+
   file = BLI_open(ibuf->cachename, O_BINARY | O_RDONLY, 0);
   if (file == -1) {
     return;
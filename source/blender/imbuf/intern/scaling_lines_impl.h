@@ -0,0 +1,338 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Line kernels of #IMB_scaleImBuf and the pixel operations they're built from.
+ *
+ * Included by scaling.c, and by its tests once with and once without SCALE_LINES_NO_SIMD
+ * defined, to check the SSE2 and scalar versions give identical results.
+ * So there is no include guard, and everything here is static.
+ */
+
+#include <string.h>
+
+#include "BLI_math_inline.h"
+#include "BLI_sys_types.h"
+#include "BLI_utildefines.h"
+
+#if defined(__SSE2__) && !defined(SCALE_LINES_NO_SIMD)
+#  include <emmintrin.h>
+#endif
+
+/* Operations on a single RGBA pixel, using SSE2 when available. The scalar fallback performs the
+ * same operations in the same order, so both give identical results. */
+
+#if defined(__SSE2__) && !defined(SCALE_LINES_NO_SIMD)
+
+typedef __m128 ScalePixel;
+
+MINLINE ScalePixel scale_pixel_zero(void)
+{
+  return _mm_setzero_ps();
+}
+
+MINLINE ScalePixel scale_pixel_load_uchar(const uchar *p)
+{
+  const __m128i zero = _mm_setzero_si128();
+  int32_t packed;
+  __m128i v;
+
+  memcpy(&packed, p, sizeof(packed));
+  v = _mm_cvtsi32_si128(packed);
+  v = _mm_unpacklo_epi8(v, zero);
+  v = _mm_unpacklo_epi16(v, zero);
+  return _mm_cvtepi32_ps(v);
+}
+
+MINLINE ScalePixel scale_pixel_load_float(const float *p)
+{
+  return _mm_loadu_ps(p);
+}
+
+/* Truncates like a float to uchar cast, clamped to the 0..255 range. */
+MINLINE void scale_pixel_store_uchar(uchar *p, const ScalePixel v)
+{
+  __m128i i = _mm_cvttps_epi32(v);
+  int32_t packed;
+
+  i = _mm_packs_epi32(i, i);
+  i = _mm_packus_epi16(i, i);
+  packed = _mm_cvtsi128_si32(i);
+  memcpy(p, &packed, sizeof(packed));
+}
+
+MINLINE void scale_pixel_store_float(float *p, const ScalePixel v)
+{
+  _mm_storeu_ps(p, v);
+}
+
+MINLINE ScalePixel scale_pixel_add(const ScalePixel a, const ScalePixel b)
+{
+  return _mm_add_ps(a, b);
+}
+
+MINLINE ScalePixel scale_pixel_sub(const ScalePixel a, const ScalePixel b)
+{
+  return _mm_sub_ps(a, b);
+}
+
+MINLINE ScalePixel scale_pixel_add_f(const ScalePixel a, const float f)
+{
+  return _mm_add_ps(a, _mm_set1_ps(f));
+}
+
+MINLINE ScalePixel scale_pixel_mul_f(const ScalePixel a, const float f)
+{
+  return _mm_mul_ps(a, _mm_set1_ps(f));
+}
+
+MINLINE ScalePixel scale_pixel_div_f(const ScalePixel a, const float f)
+{
+  return _mm_div_ps(a, _mm_set1_ps(f));
+}
+
+/* a + b * f */
+MINLINE ScalePixel scale_pixel_madd_f(const ScalePixel a, const ScalePixel b, const float f)
+{
+  return _mm_add_ps(a, _mm_mul_ps(b, _mm_set1_ps(f)));
+}
+
+#else /* __SSE2__ && !SCALE_LINES_NO_SIMD */
+
+typedef struct ScalePixel {
+  float v[4];
+} ScalePixel;
+
+MINLINE ScalePixel scale_pixel_zero(void)
+{
+  ScalePixel r = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_load_uchar(const uchar *p)
+{
+  ScalePixel r = {{(float)p[0], (float)p[1], (float)p[2], (float)p[3]}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_load_float(const float *p)
+{
+  ScalePixel r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+/* Truncates like a float to uchar cast, clamped to the 0..255 range. */
+MINLINE void scale_pixel_store_uchar(uchar *p, const ScalePixel v)
+{
+  p[0] = (uchar)CLAMPIS(v.v[0], 0.0f, 255.0f);
+  p[1] = (uchar)CLAMPIS(v.v[1], 0.0f, 255.0f);
+  p[2] = (uchar)CLAMPIS(v.v[2], 0.0f, 255.0f);
+  p[3] = (uchar)CLAMPIS(v.v[3], 0.0f, 255.0f);
+}
+
+MINLINE void scale_pixel_store_float(float *p, const ScalePixel v)
+{
+  memcpy(p, v.v, sizeof(v.v));
+}
+
+MINLINE ScalePixel scale_pixel_add(const ScalePixel a, const ScalePixel b)
+{
+  ScalePixel r = {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_sub(const ScalePixel a, const ScalePixel b)
+{
+  ScalePixel r = {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_add_f(const ScalePixel a, const float f)
+{
+  ScalePixel r = {{a.v[0] + f, a.v[1] + f, a.v[2] + f, a.v[3] + f}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_mul_f(const ScalePixel a, const float f)
+{
+  ScalePixel r = {{a.v[0] * f, a.v[1] * f, a.v[2] * f, a.v[3] * f}};
+  return r;
+}
+
+MINLINE ScalePixel scale_pixel_div_f(const ScalePixel a, const float f)
+{
+  ScalePixel r = {{a.v[0] / f, a.v[1] / f, a.v[2] / f, a.v[3] / f}};
+  return r;
+}
+
+/* a + b * f */
+MINLINE ScalePixel scale_pixel_madd_f(const ScalePixel a, const ScalePixel b, const float f)
+{
+  ScalePixel r = {
+      {a.v[0] + b.v[0] * f, a.v[1] + b.v[1] * f, a.v[2] + b.v[2] * f, a.v[3] + b.v[3] * f}};
+  return r;
+}
+
+#endif /* __SSE2__ && !SCALE_LINES_NO_SIMD */
+
+typedef struct ScaleLinesData {
+  const uchar *rect;
+  const float *rectf;
+  uchar *newrect;
+  float *newrectf;
+
+  /* Offsets in channels between the first pixels of two lines, in the old and new buffers. */
+  int line_step, newline_step;
+  /* Offset in channels between two pixels of a line, the same for the old and new buffers. */
+  int pixel_step;
+  /* Number of pixels in a line, before and after scaling. */
+  int len, newlen;
+  float add;
+} ScaleLinesData;
+
+static void scaledown_line_byte(const uchar *rect, uchar *newrect, const ScaleLinesData *data)
+{
+  const uchar *rect_begin = rect;
+  const int step = data->pixel_step;
+  const float add = data->add;
+  ScalePixel val = scale_pixel_zero(), nval;
+  float sample = 0.0f;
+  int x;
+
+  for (x = data->newlen; x > 0; x--) {
+    nval = scale_pixel_mul_f(val, -sample);
+
+    sample += add;
+
+    while (sample >= 1.0f) {
+      sample -= 1.0f;
+      nval = scale_pixel_add(nval, scale_pixel_load_uchar(rect));
+      rect += step;
+    }
+
+    val = scale_pixel_load_uchar(rect);
+    rect += step;
+
+    scale_pixel_store_uchar(
+        newrect,
+        scale_pixel_add_f(scale_pixel_div_f(scale_pixel_madd_f(nval, val, sample), add), 0.5f));
+    newrect += step;
+
+    sample -= 1.0f;
+  }
+
+  BLI_assert(rect - rect_begin == (ptrdiff_t)data->len * step); /* see bug [#26502] */
+  UNUSED_VARS_NDEBUG(rect_begin);
+}
+
+static void scaledown_line_float(const float *rectf, float *newrectf, const ScaleLinesData *data)
+{
+  const float *rectf_begin = rectf;
+  const int step = data->pixel_step;
+  const float add = data->add;
+  ScalePixel val = scale_pixel_zero(), nval;
+  float sample = 0.0f;
+  int x;
+
+  for (x = data->newlen; x > 0; x--) {
+    nval = scale_pixel_mul_f(val, -sample);
+
+    sample += add;
+
+    while (sample >= 1.0f) {
+      sample -= 1.0f;
+      nval = scale_pixel_add(nval, scale_pixel_load_float(rectf));
+      rectf += step;
+    }
+
+    val = scale_pixel_load_float(rectf);
+    rectf += step;
+
+    scale_pixel_store_float(newrectf,
+                            scale_pixel_div_f(scale_pixel_madd_f(nval, val, sample), add));
+    newrectf += step;
+
+    sample -= 1.0f;
+  }
+
+  BLI_assert(rectf - rectf_begin == (ptrdiff_t)data->len * step); /* see bug [#26502] */
+  UNUSED_VARS_NDEBUG(rectf_begin);
+}
+
+static void scaleup_line_byte(const uchar *rect, uchar *newrect, const ScaleLinesData *data)
+{
+  const int step = data->pixel_step;
+  const float add = data->add;
+  ScalePixel val, nval, diff;
+  float sample = 0.0f;
+  int x;
+
+  /* A line of a single pixel has no next pixel to blend with, don't read past its end. */
+  val = scale_pixel_load_uchar(rect);
+  nval = (data->len > 1) ? scale_pixel_load_uchar(rect + step) : val;
+  diff = scale_pixel_sub(nval, val);
+  val = scale_pixel_add_f(val, 0.5f);
+  rect += 2 * step;
+
+  for (x = data->newlen; x > 0; x--) {
+    if (sample >= 1.0f) {
+      sample -= 1.0f;
+
+      val = nval;
+      nval = scale_pixel_load_uchar(rect);
+      diff = scale_pixel_sub(nval, val);
+      val = scale_pixel_add_f(val, 0.5f);
+      rect += step;
+    }
+
+    scale_pixel_store_uchar(newrect, scale_pixel_madd_f(val, diff, sample));
+    newrect += step;
+
+    sample += add;
+  }
+}
+
+static void scaleup_line_float(const float *rectf, float *newrectf, const ScaleLinesData *data)
+{
+  const int step = data->pixel_step;
+  const float add = data->add;
+  ScalePixel val, nval, diff;
+  float sample = 0.0f;
+  int x;
+
+  val = scale_pixel_load_float(rectf);
+  nval = (data->len > 1) ? scale_pixel_load_float(rectf + step) : val;
+  diff = scale_pixel_sub(nval, val);
+  rectf += 2 * step;
+
+  for (x = data->newlen; x > 0; x--) {
+    if (sample >= 1.0f) {
+      sample -= 1.0f;
+
+      val = nval;
+      nval = scale_pixel_load_float(rectf);
+      diff = scale_pixel_sub(nval, val);
+      rectf += step;
+    }
+
+    scale_pixel_store_float(newrectf, scale_pixel_madd_f(val, diff, sample));
+    newrectf += step;
+
+    sample += add;
+  }
+}
@@ -397,6 +397,17 @@ void IMB_thumb_makedirs(void)
   }
 }
 
+void IMB_thumb_set_original_size(ImBuf *ibuf, int width, int height)
+{
+  char value[40];
+
+  IMB_metadata_ensure(&ibuf->metadata);
+  BLI_snprintf(value, sizeof(value), "%d", width);
+  IMB_metadata_set_field(ibuf->metadata, "Thumb::Image::Width", value);
+  BLI_snprintf(value, sizeof(value), "%d", height);
+  IMB_metadata_set_field(ibuf->metadata, "Thumb::Image::Height", value);
+}
+
 /* create thumbnail for file and returns new imbuf for thumbnail */
 static ImBuf *thumb_create_ex(const char *file_path,
                               const char *uri,
@@ -463,7 +474,8 @@ static ImBuf *thumb_create_ex(const char *file_path,
         if (img == NULL) {
           switch (source) {
             case THB_SOURCE_IMAGE:
-              img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
+              /* formats that support it decode at a reduced resolution */
+              img = IMB_loadiffname(file_path, IB_rect | IB_metadata | IB_thumbnail, NULL);
               break;
             case THB_SOURCE_BLEND:
               img = IMB_thumb_load_blend(file_path, blen_group, blen_id);
@@ -480,8 +492,14 @@ static ImBuf *thumb_create_ex(const char *file_path,
           if (BLI_stat(file_path, &info) != -1) {
             BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
           }
-          BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
-          BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+          if (!(img->metadata &&
+                IMB_metadata_get_field(
+                    img->metadata, "Thumb::Image::Width", cwidth, sizeof(cwidth)) &&
+                IMB_metadata_get_field(
+                    img->metadata, "Thumb::Image::Height", cheight, sizeof(cheight)))) {
+            BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
+            BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+          }
         }
       }
       else if (THB_SOURCE_MOVIE == source) {
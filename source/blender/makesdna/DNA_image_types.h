@@ -183,6 +183,8 @@ enum {
   IMA_USE_VIEWS = (1 << 14),
   IMA_FLAG_UNUSED_15 = (1 << 15), /* cleared */
   IMA_FLAG_UNUSED_16 = (1 << 16), /* cleared */
+  /** Load tiled files on demand through the image tile cache. */
+  IMA_USE_TILE_CACHE = (1 << 17),
 };
 
 /* Image.gpuflag */
@@ -1805,6 +1805,7 @@ typedef struct Scene {
 #define R_EDGE_FRS (1 << 25)        /* R_EDGE reserved for Freestyle */
 #define R_PERSISTENT_DATA (1 << 26) /* keep data around for re-render */
 #define R_MODE_UNUSED_27 (1 << 27)  /* cleared */
+#define R_BACKGROUND_WRITE (1 << 28) /* write image files in a background thread */
 
 /** #RenderData.seq_flag */
 enum {
@@ -1814,6 +1815,7 @@ enum {
   R_SEQ_UNUSED_3 = (1 << 3), /* cleared */
   R_SEQ_UNUSED_4 = (1 << 4), /* cleared */
   R_SEQ_OVERRIDE_SCENE_SETTINGS = (1 << 5),
+  R_SEQ_PARALLEL_RENDER = (1 << 6),
 };
 
 /** #RenderData.displaymode */
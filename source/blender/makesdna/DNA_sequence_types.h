@@ -231,7 +231,9 @@ typedef struct Sequence {
   ListBase modifiers;
 
   int cache_flag;
-  int _pad2[3];
+  /** Time it took to render the strip last time, in milliseconds (runtime only). */
+  float render_time;
+  int _pad2[2];
 } Sequence;
 
 typedef struct MetaStack {
@@ -267,6 +269,8 @@ typedef struct Editing {
   /* Cache control */
   float recycle_max_cost;
   int cache_flag;
+
+  struct PrefetchJob *prefetch_job;
 } Editing;
 
 /* ************* Effect Variable Structs ********* */
@@ -671,6 +675,12 @@ enum {
   SEQ_CACHE_VIEW_PREPROCESSED = (1 << 7),
   SEQ_CACHE_VIEW_COMPOSITE = (1 << 8),
   SEQ_CACHE_VIEW_FINAL_OUT = (1 << 9),
+
+  /* render frames ahead of the playhead in background */
+  SEQ_CACHE_PREFETCH_ENABLE = (1 << 10),
+
+  /* store images on disk, so they persist between sessions */
+  SEQ_CACHE_DISK_CACHE_ENABLE = (1 << 11),
 };
 
 #endif /* __DNA_SEQUENCE_TYPES_H__ */
@@ -586,6 +586,7 @@ typedef enum eSpaceSeq_Flag {
   SEQ_SHOW_SAFE_CENTER = (1 << 9),
   SEQ_SHOW_METADATA = (1 << 10),
   SEQ_SHOW_MARKER_LINES = (1 << 11),
+  SEQ_SHOW_RENDER_TIME = (1 << 12),
 } eSpaceSeq_Flag;
 
 /* SpaceSeq.view */
@@ -672,7 +672,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Memory limit for the image tile cache (in megabytes). */
+  int tile_cache_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -791,6 +792,19 @@ typedef struct UserDef {
 
   char _pad5[2];
 
+  /** Directory of the sequencer disk cache, temporary directory when empty. */
+  char sequencer_disk_cache_dir[1024];
+  /** #eUserpref_SeqDiskCacheCompression. */
+  int sequencer_disk_cache_compression;
+  /** Size limit of the sequencer disk cache in GB. */
+  int sequencer_disk_cache_size_limit;
+  /** #eUserpref_CacheCompression, for images in sequencer and movie clip memory caches. */
+  int cache_compression;
+  /** Number of threads reading image sequence files when prefetching movie clips, 0 for auto. */
+  short clip_prefetch_read_threads;
+  /** Number of read files waiting to be decoded when prefetching movie clips, 0 for auto. */
+  short clip_prefetch_read_ahead;
+
   /** Runtime data (keep last). */
   UserDef_Runtime runtime;
 } UserDef;
@@ -1167,6 +1181,20 @@ typedef enum eUserpref_FactorDisplay {
   USER_FACTOR_AS_PERCENTAGE = 1,
 } eUserpref_FactorDisplay;
 
+/** #UserDef.cache_compression */
+typedef enum eUserpref_CacheCompression {
+  USER_CACHE_COMPRESSION_NONE = 0,
+  USER_CACHE_COMPRESSION_LOSSLESS = 1,
+  USER_CACHE_COMPRESSION_HALF_FLOAT = 2,
+} eUserpref_CacheCompression;
+
+/** #UserDef.sequencer_disk_cache_compression */
+typedef enum eUserpref_SeqDiskCacheCompression {
+  USER_SEQ_DISK_CACHE_COMPRESSION_NONE = 0,
+  USER_SEQ_DISK_CACHE_COMPRESSION_LOW = 1,
+  USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 2,
+} eUserpref_SeqDiskCacheCompression;
+
 #ifdef __cplusplus
 }
 #endif
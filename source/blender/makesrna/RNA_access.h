@@ -423,6 +423,7 @@ extern StructRNA RNA_Modifier;
 extern StructRNA RNA_MotionPath;
 extern StructRNA RNA_MotionPathVert;
 extern StructRNA RNA_MouseSensor;
+extern StructRNA RNA_MovieCacheStatistics;
 extern StructRNA RNA_MovieClipSequence;
 extern StructRNA RNA_MovieSequence;
 extern StructRNA RNA_MovieTracking;
@@ -19,6 +19,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "DNA_image_types.h"
 #include "DNA_node_types.h"
@@ -65,12 +66,14 @@ static const EnumPropertyItem image_source_items[] = {
 #  include "BLI_math_base.h"
 
 #  include "BKE_global.h"
+#  include "BKE_movieclip.h"
 
 #  include "GPU_draw.h"
 #  include "GPU_texture.h"
 
 #  include "IMB_imbuf.h"
 #  include "IMB_imbuf_types.h"
+#  include "IMB_moviecache.h"
 
 #  include "ED_node.h"
 
@@ -517,6 +520,85 @@ static void rna_render_slots_active_index_range(
   *max = max_ii(0, BLI_listbase_count(&image->renderslots) - 1);
 }
 
+/* Statistics are shared by images and movie clips, read from the cache of the owner ID. */
+static void rna_MovieCacheStatistics_stats(PointerRNA *ptr, MovieCacheStats *r_stats)
+{
+  ID *id = ptr->id.data;
+
+  switch (GS(id->name)) {
+    case ID_IM:
+      BKE_image_get_cache_stats((Image *)id, r_stats);
+      break;
+    case ID_MC:
+      BKE_movieclip_get_cache_stats((MovieClip *)id, r_stats);
+      break;
+    default:
+      memset(r_stats, 0, sizeof(*r_stats));
+      break;
+  }
+}
+
+static PointerRNA rna_ID_cache_statistics_get(PointerRNA *ptr)
+{
+  return rna_pointer_inherit_refine(ptr, &RNA_MovieCacheStatistics, ptr->id.data);
+}
+
+static int rna_MovieCacheStatistics_hits_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.hits;
+}
+
+static int rna_MovieCacheStatistics_misses_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.misses;
+}
+
+static float rna_MovieCacheStatistics_hit_ratio_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return (stats.hits + stats.misses) ? (float)stats.hits / (stats.hits + stats.misses) : 0.0f;
+}
+
+static int rna_MovieCacheStatistics_evicted_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.evicted;
+}
+
+static int rna_MovieCacheStatistics_items_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.totitem;
+}
+
+static float rna_MovieCacheStatistics_memory_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return (float)((double)stats.mem_in_use / (1024.0 * 1024.0));
+}
+
+static float rna_MovieCacheStatistics_average_cost_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.avg_cost * 1000.0f;
+}
+
+static float rna_MovieCacheStatistics_weight_get(PointerRNA *ptr)
+{
+  MovieCacheStats stats;
+  rna_MovieCacheStatistics_stats(ptr, &stats);
+  return stats.weight;
+}
+
 #else
 
 static void rna_def_imageuser(BlenderRNA *brna)
@@ -666,6 +748,83 @@ static void rna_def_render_slots(BlenderRNA *brna, PropertyRNA *cprop)
   RNA_def_function_return(func, parm);
 }
 
+static void rna_def_movie_cache_statistics(BlenderRNA *brna)
+{
+  StructRNA *srna;
+  PropertyRNA *prop;
+
+  srna = RNA_def_struct(brna, "MovieCacheStatistics", NULL);
+  RNA_def_struct_ui_text(srna,
+                         "Movie Cache Statistics",
+                         "Usage statistics of the buffer cache of an image or clip, not "
+                         "including frames of its strips in the sequencer cache");
+
+  prop = RNA_def_property(srna, "hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieCacheStatistics_hits_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Hits", "Number of lookups which found a cached buffer");
+
+  prop = RNA_def_property(srna, "misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieCacheStatistics_misses_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Misses", "Number of lookups which had to load or compute the buffer");
+
+  prop = RNA_def_property(srna, "hit_ratio", PROP_FLOAT, PROP_FACTOR);
+  RNA_def_property_float_funcs(prop, "rna_MovieCacheStatistics_hit_ratio_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Hit Ratio", "Fraction of lookups which found a cached buffer");
+
+  prop = RNA_def_property(srna, "evicted", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieCacheStatistics_evicted_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Evicted", "Number of buffers freed to keep the cache within the memory limit");
+
+  prop = RNA_def_property(srna, "items", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_int_funcs(prop, "rna_MovieCacheStatistics_items_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Items", "Number of buffers currently in the cache");
+
+  prop = RNA_def_property(srna, "memory", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_MovieCacheStatistics_memory_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Memory",
+      "Memory used by the buffers currently in the cache when they were cached, in megabytes");
+
+  prop = RNA_def_property(srna, "average_cost", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_MovieCacheStatistics_average_cost_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Average Cost",
+                           "Average time in milliseconds it took to produce a buffer "
+                           "which was not in the cache");
+
+  prop = RNA_def_property(srna, "weight", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_MovieCacheStatistics_weight_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Weight",
+                           "Importance of the cached buffers relative to other caches when "
+                           "choosing what to free, higher values keep buffers longer");
+}
+
+void rna_def_movie_cache_statistics_common(StructRNA *srna)
+{
+  PropertyRNA *prop;
+
+  prop = RNA_def_property(srna, "cache_statistics", PROP_POINTER, PROP_NONE);
+  RNA_def_property_flag(prop, PROP_NEVER_NULL);
+  RNA_def_property_struct_type(prop, "MovieCacheStatistics");
+  RNA_def_property_pointer_funcs(prop, "rna_ID_cache_statistics_get", NULL, NULL, NULL);
+  RNA_def_property_ui_text(prop,
+                           "Cache Statistics",
+                           "Usage statistics of the cache holding the loaded buffers, the "
+                           "sequencer has its own cache which is not included");
+}
+
 static void rna_def_image(BlenderRNA *brna)
 {
   StructRNA *srna;
@@ -767,6 +926,15 @@ static void rna_def_image(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Deinterlace", "Deinterlace movie file on load");
   RNA_def_property_update(prop, NC_IMAGE | ND_DISPLAY, "rna_Image_reload_update");
 
+  prop = RNA_def_property(srna, "use_tile_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_override_flag(prop, PROPOVERRIDE_OVERRIDABLE_STATIC);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", IMA_USE_TILE_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Tile Cache",
+                           "Load tiles and mipmap levels of tiled TIFF and OpenEXR files on demand "
+                           "when rendering, instead of reading the whole image into memory");
+  RNA_def_property_update(prop, NC_IMAGE | ND_DISPLAY, "rna_Image_reload_update");
+
   prop = RNA_def_property(srna, "use_multiview", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_override_flag(prop, PROPOVERRIDE_OVERRIDABLE_STATIC);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", IMA_USE_VIEWS);
@@ -938,12 +1106,15 @@ static void rna_def_image(BlenderRNA *brna)
   RNA_def_property_struct_type(prop, "Stereo3dFormat");
   RNA_def_property_ui_text(prop, "Stereo 3D Format", "Settings for stereo 3d");
 
+  rna_def_movie_cache_statistics_common(srna);
+
   RNA_api_image(srna);
 }
 
 void RNA_def_image(BlenderRNA *brna)
 {
   rna_def_render_slot(brna);
+  rna_def_movie_cache_statistics(brna);
   rna_def_image(brna);
   rna_def_imageuser(brna);
   rna_def_image_packed_files(brna);
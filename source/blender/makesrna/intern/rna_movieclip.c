@@ -435,6 +435,9 @@ static void rna_def_movieclip(BlenderRNA *brna)
   RNA_def_parameter_flags(parm, 0, PARM_RNAPTR);
   RNA_def_function_return(func, parm);
 
+  /* cache */
+  rna_def_movie_cache_statistics_common(srna);
+
   rna_def_animdata_common(srna);
 }
 
@@ -5902,6 +5902,16 @@ static void rna_def_scene_render_data(BlenderRNA *brna)
       prop, "Overwrite", "Overwrite\nOverwrite existing files while rendering");
   RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
 
+  prop = RNA_def_property(srna, "use_background_write", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "mode", R_BACKGROUND_WRITE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+  RNA_def_property_ui_text(prop,
+                           "Background Write",
+                           "Background Write\nSave animation frames in a background thread while "
+                           "the next frame renders (render write handlers may run before the file "
+                           "is complete)");
+  RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
+
   prop = RNA_def_property(srna, "use_compositing", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "scemode", R_DOCOMP);
   RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
@@ -6261,6 +6271,14 @@ static void rna_def_scene_render_data(BlenderRNA *brna)
                            "each individual scene used in the strip");
   RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, "rna_SceneSequencer_update");
 
+  prop = RNA_def_property(srna, "use_sequencer_parallel_render", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "seq_flag", R_SEQ_PARALLEL_RENDER);
+  RNA_def_property_ui_text(prop,
+                           "Parallel Strip Rendering",
+                           "Parallel Strip Rendering\nRender image and movie strips of the "
+                           "channel stack in parallel before they are blended together");
+  RNA_def_property_update(prop, NC_SCENE | ND_SEQUENCER, NULL);
+
   prop = RNA_def_property(srna, "use_single_layer", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "scemode", R_SINGLE_LAYER);
   RNA_def_property_ui_text(
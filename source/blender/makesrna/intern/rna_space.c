@@ -4626,6 +4626,14 @@ static void rna_def_space_sequencer(BlenderRNA *brna)
       "Show Marker Lines\nShow Marker Lines\nShow a vertical line for every marker");
   RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, NULL);
 
+  prop = RNA_def_property(srna, "show_strip_render_time", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", SEQ_SHOW_RENDER_TIME);
+  RNA_def_property_ui_text(prop,
+                           "Show Render Time",
+                           "Show Render Time\nShow how long the last rendered frame of each "
+                           "strip took to render");
+  RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, NULL);
+
   prop = RNA_def_property(srna, "show_annotation", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", SEQ_SHOW_GPENCIL);
   RNA_def_property_ui_text(
@@ -161,6 +161,9 @@ static const EnumPropertyItem rna_enum_userdef_viewport_aa_items[] = {
 #  include "GPU_draw.h"
 #  include "GPU_select.h"
 
+#  include "IMB_imbuf.h"
+#  include "IMB_moviecache.h"
+
 #  include "BLF_api.h"
 
 #  include "MEM_guardedalloc.h"
@@ -456,6 +459,22 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain),
   USERDEF_TAG_DIRTY;
 }
 
+static void rna_Userdef_tile_cache_update(Main *UNUSED(bmain),
+                                          Scene *UNUSED(scene),
+                                          PointerRNA *UNUSED(ptr))
+{
+  IMB_tile_cache_set_limit(U.tile_cache_limit);
+  USERDEF_TAG_DIRTY;
+}
+
+static void rna_Userdef_cache_compression_update(Main *UNUSED(bmain),
+                                                 Scene *UNUSED(scene),
+                                                 PointerRNA *UNUSED(ptr))
+{
+  IMB_moviecache_set_compression(U.cache_compression);
+  USERDEF_TAG_DIRTY;
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
   Object *ob;
@@ -4968,6 +4987,99 @@ static void rna_def_userdef_system(BlenderRNA *brna)
       prop, "Memory Cache Limit", "Memory Cache Limit\nMemory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "clip_prefetch_read_threads", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "clip_prefetch_read_threads");
+  RNA_def_property_range(prop, 0, 64);
+  RNA_def_property_ui_text(prop,
+                           "Clip Prefetch Read Threads",
+                           "Clip Prefetch Read Threads\nNumber of threads reading image sequence "
+                           "files when prefetching movie clips, more threads help with slow "
+                           "network storage (0 for automatic)");
+
+  prop = RNA_def_property(srna, "clip_prefetch_read_ahead", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "clip_prefetch_read_ahead");
+  RNA_def_property_range(prop, 0, 1024);
+  RNA_def_property_ui_text(prop,
+                           "Clip Prefetch Read Ahead",
+                           "Clip Prefetch Read Ahead\nMaximum number of files read ahead and "
+                           "waiting to be decoded when prefetching movie clips (0 for automatic)");
+
+  prop = RNA_def_property(srna, "tile_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "tile_cache_limit");
+  RNA_def_property_range(prop, 64, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(prop,
+                           "Tile Cache Limit",
+                           "Tile Cache Limit\nMemory limit for image tiles loaded on demand when "
+                           "rendering tiled textures (in megabytes)");
+  RNA_def_property_update(prop, 0, "rna_Userdef_tile_cache_update");
+
+  static const EnumPropertyItem cache_compression_items[] = {
+      {USER_CACHE_COMPRESSION_NONE,
+       "NONE",
+       0,
+       "None",
+       "None\nKeep cached images uncompressed, fastest but uses the most memory"},
+      {USER_CACHE_COMPRESSION_LOSSLESS,
+       "LOSSLESS",
+       0,
+       "Lossless",
+       "Lossless\nCompress cached images without any loss of quality"},
+      {USER_CACHE_COMPRESSION_HALF_FLOAT,
+       "HALF_FLOAT",
+       0,
+       "Half Float",
+       "Half Float\nStore float images at half precision before compressing them, "
+       "uses less memory at a small loss of precision"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
+  prop = RNA_def_property(srna, "cache_compression", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_items(prop, cache_compression_items);
+  RNA_def_property_enum_sdna(prop, NULL, "cache_compression");
+  RNA_def_property_ui_text(
+      prop,
+      "Cache Compression",
+      "Cache Compression\nCompression of images kept in the sequencer and movie clip memory "
+      "caches, allows more frames to be cached at the cost of extra work when storing and "
+      "reading them");
+  RNA_def_property_update(prop, 0, "rna_Userdef_cache_compression_update");
+
+  static const EnumPropertyItem seq_disk_cache_compression_levels[] = {
+      {USER_SEQ_DISK_CACHE_COMPRESSION_NONE,
+       "NONE",
+       0,
+       "None",
+       "None\nStore images uncompressed, fastest but uses a lot of disk space"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_LOW,
+       "LOW",
+       0,
+       "Low",
+       "Low\nFast compression with reasonable reduction of file size"},
+      {USER_SEQ_DISK_CACHE_COMPRESSION_HIGH,
+       "HIGH",
+       0,
+       "High",
+       "High\nBest compression, slow to write"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
+  prop = RNA_def_property(srna, "sequencer_disk_cache_compression", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_items(prop, seq_disk_cache_compression_levels);
+  RNA_def_property_enum_sdna(prop, NULL, "sequencer_disk_cache_compression");
+  RNA_def_property_ui_text(
+      prop,
+      "Disk Cache Compression Level",
+      "Disk Cache Compression Level\nCompression of images stored in sequencer disk cache, "
+      "higher compression saves disk space but takes longer to read and write");
+
+  prop = RNA_def_property(srna, "sequencer_disk_cache_size_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_size_limit");
+  RNA_def_property_range(prop, 1, INT_MAX);
+  RNA_def_property_ui_text(prop,
+                           "Disk Cache Limit",
+                           "Disk Cache Limit\nDisk space used by sequencer disk cache (in GB), "
+                           "least recently used images are removed when exceeded");
+
   prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_int_sdna(prop, NULL, "scrollback");
   RNA_def_property_range(prop, 32, 32768);
@@ -5738,6 +5850,13 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Render Cache Path", "Render Cache Path\nWhere to cache raw render results");
 
+  prop = RNA_def_property(srna, "sequencer_disk_cache_directory", PROP_STRING, PROP_DIRPATH);
+  RNA_def_property_string_sdna(prop, NULL, "sequencer_disk_cache_dir");
+  RNA_def_property_ui_text(prop,
+                           "Sequencer Disk Cache Path",
+                           "Sequencer Disk Cache Path\nWhere to store sequencer images cached on "
+                           "disk, temporary directory is used when empty");
+
   prop = RNA_def_property(srna, "image_editor", PROP_STRING, PROP_FILEPATH);
   RNA_def_property_string_sdna(prop, NULL, "image_editor");
   RNA_def_property_ui_text(prop, "Image Editor", "Image Editor\nPath to an image editor");
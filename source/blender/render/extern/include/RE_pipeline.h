@@ -165,6 +165,9 @@ typedef struct RenderResult {
   char *error;
 
   struct StampData *stamp_data;
+
+  /* multilayer images, file handle to read passes on demand */
+  void *exrhandle;
 } RenderResult;
 
 typedef struct RenderStats {
@@ -328,6 +331,16 @@ bool RE_WriteRenderResult(struct ReportList *reports,
                           int layer);
 struct RenderResult *RE_MultilayerConvert(
     void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+float *RE_MultilayerReadPass(void *exrhandle,
+                             const struct RenderLayer *rl,
+                             const struct RenderPass *rpass,
+                             const char *colorspace,
+                             bool predivide);
+bool RE_MultilayerLoadPass(struct RenderResult *rr,
+                           struct RenderPass *rpass,
+                           const char *colorspace,
+                           bool predivide);
+void RE_MultilayerLoadPasses(struct RenderResult *rr, const char *colorspace, bool predivide);
 
 /* display and event callbacks */
 void RE_display_init_cb(struct Render *re,
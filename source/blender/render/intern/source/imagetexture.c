@@ -63,12 +63,31 @@ static void boxsample(ImBuf *ibuf,
 
 /* *********** IMAGEWRAPPING ****************** */
 
+/* tiled images loaded with IB_tilecache have no rect, pixels come from the tile cache */
+static bool ibuf_has_pixels(const ImBuf *ibuf)
+{
+  return (ibuf->rect || ibuf->rect_float || (ibuf->flags & IB_tilecache));
+}
+
+static const char *ibuf_get_rect_pixel(ImBuf *ibuf, int x, int y, unsigned char tile_col[4])
+{
+  if (ibuf->rect == NULL && (ibuf->flags & IB_tilecache)) {
+    IMB_tile_cache_get_pixel(ibuf, x, y, tile_col);
+    return (const char *)tile_col;
+  }
+
+  return (const char *)(ibuf->rect + x + y * ibuf->x);
+}
+
 /* x and y have to be checked for image size */
 static void ibuf_get_color(float col[4], struct ImBuf *ibuf, int x, int y)
 {
   int ofs = y * ibuf->x + x;
 
-  if (ibuf->rect_float) {
+  if (ibuf->rect_float == NULL && (ibuf->flags & IB_tilecache_float)) {
+    IMB_tile_cache_get_pixel_float(ibuf, x, y, col);
+  }
+  else if (ibuf->rect_float) {
     if (ibuf->channels == 4) {
       const float *fp = ibuf->rect_float + 4 * ofs;
       copy_v4_v4(col, fp);
@@ -84,7 +103,8 @@ static void ibuf_get_color(float col[4], struct ImBuf *ibuf, int x, int y)
     }
   }
   else {
-    const char *rect = (char *)(ibuf->rect + ofs);
+    unsigned char tile_col[4];
+    const char *rect = ibuf_get_rect_pixel(ibuf, x, y, tile_col);
 
     col[0] = ((float)rect[0]) * (1.0f / 255.0f);
     col[1] = ((float)rect[1]) * (1.0f / 255.0f);
@@ -130,7 +150,7 @@ int imagewrap(Tex *tex,
 
     ima->flag |= IMA_USED_FOR_RENDER;
   }
-  if (ibuf == NULL || (ibuf->rect == NULL && ibuf->rect_float == NULL)) {
+  if (ibuf == NULL || !ibuf_has_pixels(ibuf)) {
     if (ima) {
       BKE_image_pool_release_ibuf(ima, ibuf, pool);
     }
@@ -781,7 +801,13 @@ static int ibuf_get_color_clip(float col[4], ImBuf *ibuf, int x, int y, int extf
     }
   }
 
-  if (ibuf->rect_float) {
+  if (ibuf->rect_float == NULL && (ibuf->flags & IB_tilecache_float)) {
+    IMB_tile_cache_get_pixel_float(ibuf, x, y, col);
+    if (clip) {
+      col[3] = 0.0f;
+    }
+  }
+  else if (ibuf->rect_float) {
     const float *fp = ibuf->rect_float + (x + y * ibuf->x) * ibuf->channels;
     if (ibuf->channels == 1) {
       col[0] = col[1] = col[2] = col[3] = *fp;
@@ -794,7 +820,8 @@ static int ibuf_get_color_clip(float col[4], ImBuf *ibuf, int x, int y, int extf
     }
   }
   else {
-    const char *rect = (char *)(ibuf->rect + x + y * ibuf->x);
+    unsigned char tile_col[4];
+    const char *rect = ibuf_get_rect_pixel(ibuf, x, y, tile_col);
     float inv_alpha_fac = (1.0f / 255.0f) * rect[3] * (1.0f / 255.0f);
     col[0] = rect[0] * inv_alpha_fac;
     col[1] = rect[1] * inv_alpha_fac;
@@ -972,6 +999,14 @@ static void alpha_clip_aniso(
 
 static void image_mipmap_test(Tex *tex, ImBuf *ibuf)
 {
+  if (ibuf->flags & IB_tilecache) {
+    /* mipmap levels are read from the file on demand, they can't be generated */
+    if ((tex->imaflag & TEX_MIPMAP) && ibuf->mipmap[0] == NULL) {
+      tex->imaflag &= ~TEX_MIPMAP;
+    }
+    return;
+  }
+
   if (tex->imaflag & TEX_MIPMAP) {
     if (ibuf->mipmap[0] && (ibuf->userflags & IB_MIPMAP_INVALID)) {
       BLI_thread_lock(LOCK_IMAGE);
@@ -1041,7 +1076,7 @@ static int imagewraposa_aniso(Tex *tex,
     ibuf = BKE_image_pool_acquire_ibuf(ima, &tex->iuser, pool);
   }
 
-  if ((ibuf == NULL) || ((ibuf->rect == NULL) && (ibuf->rect_float == NULL))) {
+  if ((ibuf == NULL) || !ibuf_has_pixels(ibuf)) {
     if (ima) {
       BKE_image_pool_release_ibuf(ima, ibuf, pool);
     }
@@ -1501,7 +1536,7 @@ int imagewraposa(Tex *tex,
 
     ima->flag |= IMA_USED_FOR_RENDER;
   }
-  if (ibuf == NULL || (ibuf->rect == NULL && ibuf->rect_float == NULL)) {
+  if (ibuf == NULL || !ibuf_has_pixels(ibuf)) {
     if (ima) {
       BKE_image_pool_release_ibuf(ima, ibuf, pool);
     }
@@ -136,12 +136,15 @@ static struct {
 
 /* ********* alloc and free ******** */
 
+struct RenderWriteQueue;
+
 static int do_write_image_or_movie(Render *re,
                                    Main *bmain,
                                    Scene *scene,
                                    bMovieHandle *mh,
                                    const int totvideos,
-                                   const char *name_override);
+                                   const char *name_override,
+                                   struct RenderWriteQueue *write_queue);
 
 /* default callbacks, set in each new render */
 static void result_nothing(void *UNUSED(arg), RenderResult *UNUSED(rr))
@@ -2139,7 +2142,7 @@ void RE_RenderFrame(Render *re,
                                      NULL);
 
         /* reports only used for Movie */
-        do_write_image_or_movie(re, bmain, scene, NULL, 0, name);
+        do_write_image_or_movie(re, bmain, scene, NULL, 0, name, NULL);
       }
     }
 
@@ -2391,12 +2394,227 @@ bool RE_WriteRenderViewsMovie(ReportList *reports,
   return ok;
 }
 
+/* Remove the empty placeholder files of a frame created by the R_TOUCH option. */
+static void render_remove_touched_files(RenderData *rd,
+                                        const char *name,
+                                        const bool is_multiview_name)
+{
+  if (!is_multiview_name) {
+    if ((BLI_file_size(name) == 0)) {
+      /* BLI_exists(name) is implicit */
+      BLI_delete(name, false, false);
+    }
+  }
+  else {
+    SceneRenderView *srv;
+    char filepath[FILE_MAX];
+
+    for (srv = rd->views.first; srv; srv = srv->next) {
+      if (!BKE_scene_multiview_is_render_view_active(rd, srv)) {
+        continue;
+      }
+
+      BKE_scene_multiview_filepath_get(srv, name, filepath);
+
+      if ((BLI_file_size(filepath) == 0)) {
+        /* BLI_exists(filepath) is implicit */
+        BLI_delete(filepath, false, false);
+      }
+    }
+  }
+}
+
+/* ********* background image writing ******** */
+
+/* Animation frames can be saved by a single writer thread, so that compression and disk I/O of
+ * one frame overlap with rendering of the next one. Every queued frame holds a full copy of the
+ * render result, so only a few frames are allowed in flight. */
+#define RENDER_WRITE_QUEUE_SIZE 2
+
+typedef struct RenderWriteJob {
+  struct RenderWriteJob *next, *prev;
+
+  RenderResult *rr;
+  /* The original may change for the next frame while this one is written. Shallow copy, except
+   * for the color management settings and views, which are owned by the job. */
+  Scene scene;
+  char name[FILE_MAX];
+
+  /* Reports are gathered here and moved to the render on the main thread. */
+  ReportList reports;
+  bool ok;
+} RenderWriteJob;
+
+typedef struct RenderWriteQueue {
+  ListBase threads;
+
+  ListBase todo;
+  ListBase done;
+  /* Jobs in the todo list plus the one being written. */
+  int totjob;
+
+  ThreadMutex mutex;
+  ThreadCondition cond;
+  bool stop;
+} RenderWriteQueue;
+
+static void *render_write_queue_thread(void *arg)
+{
+  RenderWriteQueue *wq = arg;
+  RenderWriteJob *job;
+
+  BLI_mutex_lock(&wq->mutex);
+
+  while (true) {
+    job = BLI_pophead(&wq->todo);
+
+    if (job == NULL) {
+      if (wq->stop) {
+        break;
+      }
+      BLI_condition_wait(&wq->cond, &wq->mutex);
+      continue;
+    }
+
+    BLI_mutex_unlock(&wq->mutex);
+
+    job->ok = RE_WriteRenderViewsImage(&job->reports, job->rr, &job->scene, true, job->name);
+    RE_FreeRenderResult(job->rr);
+    job->rr = NULL;
+
+    /* the placeholder is left empty when writing failed, remove it like a cancelled frame */
+    if (!job->ok && (job->scene.r.mode & R_TOUCH)) {
+      const bool is_multiview_name = ((job->scene.r.scemode & R_MULTIVIEW) != 0 &&
+                                      (job->scene.r.im_format.views_format ==
+                                       R_IMF_VIEWS_INDIVIDUAL));
+      render_remove_touched_files(&job->scene.r, job->name, is_multiview_name);
+    }
+
+    BKE_color_managed_view_settings_free(&job->scene.view_settings);
+    BKE_color_managed_view_settings_free(&job->scene.r.im_format.view_settings);
+    BLI_freelistN(&job->scene.r.views);
+
+    BLI_mutex_lock(&wq->mutex);
+    BLI_addtail(&wq->done, job);
+    wq->totjob--;
+    BLI_condition_notify_all(&wq->cond);
+  }
+
+  BLI_mutex_unlock(&wq->mutex);
+
+  return NULL;
+}
+
+static RenderWriteQueue *render_write_queue_start(void)
+{
+  RenderWriteQueue *wq = MEM_callocN(sizeof(RenderWriteQueue), "RenderWriteQueue");
+
+  BLI_mutex_init(&wq->mutex);
+  BLI_condition_init(&wq->cond);
+
+  BLI_threadpool_init(&wq->threads, render_write_queue_thread, 1);
+  BLI_threadpool_insert(&wq->threads, wq);
+
+  return wq;
+}
+
+/* Move reports of finished jobs to the render, returns false if any of them failed. */
+static bool render_write_queue_collect(Render *re, RenderWriteQueue *wq)
+{
+  ListBase done;
+  RenderWriteJob *job;
+  Report *report;
+  bool ok = true;
+
+  BLI_mutex_lock(&wq->mutex);
+  done = wq->done;
+  BLI_listbase_clear(&wq->done);
+  BLI_mutex_unlock(&wq->mutex);
+
+  while ((job = BLI_pophead(&done))) {
+    for (report = job->reports.list.first; report; report = report->next) {
+      BKE_report(re->reports, report->type, report->message);
+    }
+    BKE_reports_clear(&job->reports);
+
+    if (!job->ok) {
+      ok = false;
+    }
+    MEM_freeN(job);
+  }
+
+  return ok;
+}
+
+/* Takes ownership of the render result. */
+static bool render_write_queue_add(
+    Render *re, RenderWriteQueue *wq, RenderResult *rr, const Scene *scene, const char *name)
+{
+  RenderWriteJob *job = MEM_callocN(sizeof(RenderWriteJob), "RenderWriteJob");
+
+  job->rr = rr;
+  job->scene = *scene;
+  BKE_color_managed_view_settings_copy(&job->scene.view_settings, &scene->view_settings);
+  BKE_color_managed_view_settings_copy(&job->scene.r.im_format.view_settings,
+                                       &scene->r.im_format.view_settings);
+  BLI_duplicatelist(&job->scene.r.views, &scene->r.views);
+  BLI_strncpy(job->name, name, sizeof(job->name));
+  BKE_reports_init(&job->reports, RPT_STORE);
+
+  BLI_mutex_lock(&wq->mutex);
+  while (wq->totjob >= RENDER_WRITE_QUEUE_SIZE) {
+    BLI_condition_wait(&wq->cond, &wq->mutex);
+  }
+  BLI_addtail(&wq->todo, job);
+  wq->totjob++;
+  BLI_condition_notify_all(&wq->cond);
+  BLI_mutex_unlock(&wq->mutex);
+
+  /* Failures of earlier frames show up here, one or two frames late. */
+  return render_write_queue_collect(re, wq);
+}
+
+/* Waits until all queued frames are written, returns false if any of them failed. */
+static bool render_write_queue_flush(Render *re, RenderWriteQueue *wq)
+{
+  BLI_mutex_lock(&wq->mutex);
+  while (wq->totjob > 0) {
+    BLI_condition_wait(&wq->cond, &wq->mutex);
+  }
+  BLI_mutex_unlock(&wq->mutex);
+
+  return render_write_queue_collect(re, wq);
+}
+
+/* Stops the writer thread once all queued frames are written,
+ * returns false if any of them failed. */
+static bool render_write_queue_end(Render *re, RenderWriteQueue *wq)
+{
+  bool ok;
+
+  BLI_mutex_lock(&wq->mutex);
+  wq->stop = true;
+  BLI_condition_notify_all(&wq->cond);
+  BLI_mutex_unlock(&wq->mutex);
+
+  BLI_threadpool_end(&wq->threads);
+
+  ok = render_write_queue_collect(re, wq);
+
+  BLI_condition_end(&wq->cond);
+  BLI_mutex_end(&wq->mutex);
+  MEM_freeN(wq);
+
+  return ok;
+}
+
 static int do_write_image_or_movie(Render *re,
                                    Main *bmain,
                                    Scene *scene,
                                    bMovieHandle *mh,
                                    const int totvideos,
-                                   const char *name_override)
+                                   const char *name_override,
+                                   RenderWriteQueue *write_queue)
 {
   char name[FILE_MAX];
   RenderResult rres;
@@ -2426,7 +2644,13 @@ static int do_write_image_or_movie(Render *re,
     }
 
     /* write images as individual images or stereo */
-    ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+    if (write_queue) {
+      /* The next frame renders into the same buffers, so the writer gets its own copy. */
+      ok = render_write_queue_add(re, write_queue, RE_DuplicateRenderResult(&rres), scene, name);
+    }
+    else {
+      ok = RE_WriteRenderViewsImage(re->reports, &rres, scene, true, name);
+    }
   }
 
   RE_ReleaseResultImageViews(re, &rres);
@@ -2482,7 +2706,7 @@ static void re_movie_free_all(Render *re, bMovieHandle *mh, int totvideos)
   int i;
 
   for (i = 0; i < totvideos; i++) {
-    mh->end_movie(re->movie_ctx_arr[i]);
+    mh->end_movie(re->movie_ctx_arr[i], re->reports);
     mh->context_free(re->movie_ctx_arr[i]);
   }
 
@@ -2501,6 +2725,7 @@ void RE_RenderAnim(Render *re,
 {
   const RenderData rd = scene->r;
   bMovieHandle *mh = NULL;
+  RenderWriteQueue *write_queue = NULL;
   const int cfrao = rd.cfra;
   int nfra, totrendered = 0, totskipped = 0;
   const int totvideos = BKE_scene_multiview_num_videos_get(&rd);
@@ -2551,6 +2776,10 @@ void RE_RenderAnim(Render *re,
     }
   }
 
+  else if (rd.mode & R_BACKGROUND_WRITE) {
+    write_queue = render_write_queue_start();
+  }
+
   /* Ugly global still... is to prevent renderwin events and signal subsurfs etc to make full resol
    * is also set by caller renderwin.c */
   G.is_rendering = true;
@@ -2679,7 +2908,7 @@ void RE_RenderAnim(Render *re,
 
       if (re->test_break(re->tbh) == 0) {
         if (!G.is_break) {
-          if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL)) {
+          if (!do_write_image_or_movie(re, bmain, scene, mh, totvideos, NULL, write_queue)) {
             G.is_break = true;
           }
         }
@@ -2692,29 +2921,11 @@ void RE_RenderAnim(Render *re,
         /* remove touched file */
         if (is_movie == false) {
           if ((rd.mode & R_TOUCH)) {
-            if (!is_multiview_name) {
-              if ((BLI_file_size(name) == 0)) {
-                /* BLI_exists(name) is implicit */
-                BLI_delete(name, false, false);
-              }
-            }
-            else {
-              SceneRenderView *srv;
-              char filepath[FILE_MAX];
-
-              for (srv = scene->r.views.first; srv; srv = srv->next) {
-                if (!BKE_scene_multiview_is_render_view_active(&scene->r, srv)) {
-                  continue;
-                }
-
-                BKE_scene_multiview_filepath_get(srv, name, filepath);
-
-                if ((BLI_file_size(filepath) == 0)) {
-                  /* BLI_exists(filepath) is implicit */
-                  BLI_delete(filepath, false, false);
-                }
-              }
+            /* the frame may still be written in the background */
+            if (write_queue) {
+              render_write_queue_flush(re, write_queue);
             }
+            render_remove_touched_files(&scene->r, name, is_multiview_name);
           }
         }
 
@@ -2734,6 +2945,13 @@ void RE_RenderAnim(Render *re,
     re_movie_free_all(re, mh, totvideos);
   }
 
+  /* finish writing frames that are still queued, also when cancelled */
+  if (write_queue) {
+    if (!render_write_queue_end(re, write_queue)) {
+      G.is_break = true;
+    }
+  }
+
   if (totskipped && totrendered == 0) {
     BKE_report(re->reports, RPT_INFO, "No frames rendered, skipped to not overwrite");
   }
@@ -134,6 +134,10 @@ void render_result_free(RenderResult *res)
 
   BKE_stamp_data_free(res->stamp_data);
 
+  if (res->exrhandle) {
+    IMB_exr_close(res->exrhandle);
+  }
+
   MEM_freeN(res);
 }
 
@@ -774,7 +778,8 @@ RenderResult *render_result_new_from_exr(
       rpass->rectx = rectx;
       rpass->recty = recty;
 
-      if (rpass->channels >= 3) {
+      /* passes which are read on demand are converted when loaded */
+      if (rpass->rect && rpass->channels >= 3) {
         IMB_colormanagement_transform(rpass->rect,
                                       rpass->rectx,
                                       rpass->recty,
@@ -789,6 +794,79 @@ RenderResult *render_result_new_from_exr(
   return rr;
 }
 
+/* Read the pixels of a pass from the exrhandle of a multilayer file, without
+ * assigning them, so it can be done without holding locks on the render result.
+ * Returns NULL if reading failed, otherwise the buffer is owned by the caller. */
+float *RE_MultilayerReadPass(void *exrhandle,
+                             const RenderLayer *rl,
+                             const RenderPass *rpass,
+                             const char *colorspace,
+                             bool predivide)
+{
+  float *rect = IMB_exr_read_pass(exrhandle, rl->name, rpass->name, rpass->view);
+
+  if (rect == NULL) {
+    return NULL;
+  }
+
+  if (rpass->channels >= 3) {
+    const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(
+        COLOR_ROLE_SCENE_LINEAR);
+
+    IMB_colormanagement_transform(
+        rect, rpass->rectx, rpass->recty, rpass->channels, colorspace, to_colorspace, predivide);
+  }
+
+  return rect;
+}
+
+/* Read a pass of a multilayer file that was loaded without its passes,
+ * see IB_multilayer_lazy. */
+bool RE_MultilayerLoadPass(RenderResult *rr,
+                           RenderPass *rpass,
+                           const char *colorspace,
+                           bool predivide)
+{
+  RenderLayer *rl;
+
+  if (rpass->rect) {
+    return true;
+  }
+  if (rr->exrhandle == NULL) {
+    return false;
+  }
+
+  for (rl = rr->layers.first; rl; rl = rl->next) {
+    if (BLI_findindex(&rl->passes, rpass) != -1) {
+      break;
+    }
+  }
+  if (rl == NULL) {
+    return false;
+  }
+
+  rpass->rect = RE_MultilayerReadPass(rr->exrhandle, rl, rpass, colorspace, predivide);
+
+  return rpass->rect != NULL;
+}
+
+/* Read all passes which are not loaded yet, for saving for example. */
+void RE_MultilayerLoadPasses(RenderResult *rr, const char *colorspace, bool predivide)
+{
+  RenderLayer *rl;
+  RenderPass *rpass;
+
+  if (rr->exrhandle == NULL) {
+    return;
+  }
+
+  for (rl = rr->layers.first; rl; rl = rl->next) {
+    for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
+      RE_MultilayerLoadPass(rr, rpass, colorspace, predivide);
+    }
+  }
+}
+
 void render_result_view_new(RenderResult *rr, const char *viewname)
 {
   RenderView *rv = MEM_callocN(sizeof(RenderView), "new render view");
@@ -1710,5 +1788,7 @@ RenderResult *RE_DuplicateRenderResult(RenderResult *rr)
     new_rr->rectz = MEM_dupallocN(new_rr->rectz);
   }
   new_rr->stamp_data = BKE_stamp_data_copy(new_rr->stamp_data);
+  /* passes which were not read yet stay empty in the copy */
+  new_rr->exrhandle = NULL;
   return new_rr;
 }
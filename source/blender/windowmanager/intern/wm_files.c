@@ -83,6 +83,7 @@
 #include "BKE_sound.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
+#include "BKE_sequencer.h"
 #include "BKE_undo_system.h"
 #include "BKE_workspace.h"
 
@@ -95,6 +96,7 @@
 
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
 #include "IMB_thumbs.h"
 
 #include "ED_datafiles.h"
@@ -181,6 +183,9 @@ static void wm_window_match_init(bContext *C, ListBase *wmlist)
    * so for now just handling this specific case here. */
   CTX_wm_menu_set(C, NULL);
 
+  /* Prefetching renders from the old main database, which is about to be freed. */
+  BKE_sequencer_prefetch_stop_all(G_MAIN);
+
   ED_editors_exit(G_MAIN, true);
 }
 
@@ -373,6 +378,8 @@ static void wm_init_userdef(Main *bmain, const bool read_userdef_from_memory)
   }
 
   MEM_CacheLimiter_set_maximum(((size_t)U.memcachelimit) * 1024 * 1024);
+  IMB_tile_cache_set_limit(U.tile_cache_limit);
+  IMB_moviecache_set_compression(U.cache_compression);
   BKE_sound_init(bmain);
 
   /* update tempdir from user preferences */
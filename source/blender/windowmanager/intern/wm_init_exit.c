@@ -500,6 +500,7 @@ void WM_exit_ext(bContext *C, const bool do_python)
   /* all non-screen and non-space stuff editors did, like editmode */
   if (C) {
     Main *bmain = CTX_data_main(C);
+    BKE_sequencer_prefetch_stop_all(bmain);
     ED_editors_exit(bmain, true);
   }
 
@@ -521,6 +522,7 @@ void WM_exit_ext(bContext *C, const bool do_python)
   }
 
   BKE_sequencer_free_clipboard(); /* sequencer.c */
+  BKE_sequencer_disk_cache_free(); /* seqcache.c */
   BKE_tracking_clipboard_free();
   BKE_mask_clipboard_free();
   BKE_vfont_clipboard_free();
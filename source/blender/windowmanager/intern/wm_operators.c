@@ -88,6 +88,7 @@
 
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
+#include "IMB_moviecache.h"
 
 #include "ED_numinput.h"
 #include "ED_screen.h"
@@ -3233,6 +3234,7 @@ static void WM_OT_redraw_timer(wmOperatorType *ot)
 static int memory_statistics_exec(bContext *UNUSED(C), wmOperator *UNUSED(op))
 {
   MEM_printmemlist_stats();
+  IMB_moviecache_print_stats();
   return OPERATOR_FINISHED;
 }
 
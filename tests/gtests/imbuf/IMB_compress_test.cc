@@ -0,0 +1,121 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+class IMBCompressTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+/* Size not a multiple of the chunk rows, with runs of equal pixels so compression saves enough
+ * memory to be kept. All values are exact in half float as well. */
+static const int test_x = 67;
+static const int test_y = 131;
+
+static ImBuf *create_test_imbuf(int channels, bool use_byte, bool use_float)
+{
+  ImBuf *ibuf = IMB_allocImBuf(test_x, test_y, 32, 0);
+
+  if (use_byte) {
+    imb_addrectImBuf(ibuf);
+    unsigned char *rect = (unsigned char *)ibuf->rect;
+    for (int y = 0; y < test_y; y++) {
+      for (int x = 0; x < test_x; x++) {
+        for (int c = 0; c < 4; c++) {
+          rect[(y * test_x + x) * 4 + c] = (unsigned char)((x / 8) * 16 + y / 4 + c * 32);
+        }
+      }
+    }
+  }
+
+  if (use_float) {
+    ibuf->rect_float = (float *)MEM_mallocN(sizeof(float) * test_x * test_y * channels, __func__);
+    ibuf->channels = channels;
+    ibuf->mall |= IB_rectfloat;
+    ibuf->flags |= IB_rectfloat;
+    for (int y = 0; y < test_y; y++) {
+      for (int x = 0; x < test_x; x++) {
+        for (int c = 0; c < channels; c++) {
+          ibuf->rect_float[(y * test_x + x) * channels + c] = (float)((x / 8) + (y / 4) - c) *
+                                                              0.25f;
+        }
+      }
+    }
+  }
+
+  return ibuf;
+}
+
+static void compress_round_trip(int channels, bool use_byte, bool use_float, int method)
+{
+  ImBuf *ibuf = create_test_imbuf(channels, use_byte, use_float);
+  ImBufCompressed *cbuf = IMB_compressed_from_imbuf(ibuf, method);
+  ASSERT_TRUE(cbuf != NULL);
+
+  ImBuf *result = IMB_compressed_to_imbuf(cbuf);
+  ASSERT_TRUE(result != NULL);
+
+  EXPECT_EQ(result->x, ibuf->x);
+  EXPECT_EQ(result->y, ibuf->y);
+  EXPECT_EQ(result->channels, ibuf->channels);
+  EXPECT_EQ(result->rect != NULL, use_byte);
+  EXPECT_EQ(result->rect_float != NULL, use_float);
+
+  if (use_byte) {
+    EXPECT_EQ(memcmp(result->rect, ibuf->rect, sizeof(unsigned int) * test_x * test_y), 0);
+  }
+  if (use_float) {
+    EXPECT_EQ(memcmp(result->rect_float,
+                     ibuf->rect_float,
+                     sizeof(float) * test_x * test_y * channels),
+              0);
+  }
+
+  IMB_freeImBuf(result);
+  IMB_compressed_free(cbuf);
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(IMBCompressTest, Byte)
+{
+  compress_round_trip(4, true, false, IMB_COMPRESSION_LOSSLESS);
+}
+
+TEST_F(IMBCompressTest, FloatLossless)
+{
+  compress_round_trip(1, false, true, IMB_COMPRESSION_LOSSLESS);
+  compress_round_trip(3, false, true, IMB_COMPRESSION_LOSSLESS);
+  compress_round_trip(4, false, true, IMB_COMPRESSION_LOSSLESS);
+}
+
+TEST_F(IMBCompressTest, FloatHalf)
+{
+  compress_round_trip(1, false, true, IMB_COMPRESSION_HALF_FLOAT);
+  compress_round_trip(3, false, true, IMB_COMPRESSION_HALF_FLOAT);
+  compress_round_trip(4, false, true, IMB_COMPRESSION_HALF_FLOAT);
+}
+
+TEST_F(IMBCompressTest, ByteAndFloat)
+{
+  compress_round_trip(1, true, true, IMB_COMPRESSION_LOSSLESS);
+  compress_round_trip(3, true, true, IMB_COMPRESSION_HALF_FLOAT);
+}
@@ -0,0 +1,181 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <random>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "IMB_scaling_reference.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "intern/IMB_filter.h"
+}
+
+/* IMB_scaleImBuf and imb_onehalf_no_alloc have to give exactly the results of the
+ * implementation they replaced, on odd sizes, single rows and columns, and on images large
+ * enough to be scaled in threads. */
+
+class IMBScalingTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+static scale_reference::Image create_test_image(int x, int y, bool use_byte, bool use_float)
+{
+  scale_reference::Image image(x, y, use_byte, use_float);
+  std::mt19937 rng(x * 4096 + y);
+  std::uniform_int_distribution<int> dist_byte(0, 255);
+  /* Include values outside of the 0..1 range, float buffers aren't clamped. */
+  std::uniform_real_distribution<float> dist_float(-0.5f, 4.0f);
+
+  for (uchar &value : image.rect) {
+    value = (uchar)dist_byte(rng);
+  }
+  for (float &value : image.rectf) {
+    value = dist_float(rng);
+  }
+  return image;
+}
+
+static ImBuf *create_imbuf(const scale_reference::Image &image)
+{
+  ImBuf *ibuf = IMB_allocImBuf(image.x, image.y, 32, 0);
+
+  if (!image.rect.empty()) {
+    imb_addrectImBuf(ibuf);
+    memcpy(ibuf->rect, image.rect.data(), image.rect.size());
+  }
+  if (!image.rectf.empty()) {
+    imb_addrectfloatImBuf(ibuf);
+    memcpy(ibuf->rect_float, image.rectf.data(), image.rectf.size() * sizeof(float));
+  }
+  return ibuf;
+}
+
+static void expect_imbuf_eq(const ImBuf *ibuf, const scale_reference::Image &image)
+{
+  ASSERT_EQ(ibuf->x, image.x);
+  ASSERT_EQ(ibuf->y, image.y);
+
+  if (!image.rect.empty()) {
+    ASSERT_TRUE(ibuf->rect != NULL);
+    EXPECT_EQ(memcmp(ibuf->rect, image.rect.data(), image.rect.size()), 0);
+  }
+  if (!image.rectf.empty()) {
+    ASSERT_TRUE(ibuf->rect_float != NULL);
+    EXPECT_EQ(memcmp(ibuf->rect_float, image.rectf.data(), image.rectf.size() * sizeof(float)),
+              0);
+  }
+}
+
+static const int scale_sizes[][4] = {
+    /* Odd sizes, down and up in both axes and mixed. */
+    {67, 131, 33, 65},
+    {67, 131, 201, 263},
+    {67, 131, 30, 300},
+    {67, 131, 135, 17},
+    /* Single rows and columns. */
+    {1, 131, 1, 65},
+    {131, 1, 65, 1},
+    {1, 131, 7, 300},
+    {131, 1, 300, 7},
+    {1, 1, 9, 5},
+    /* Large enough to be scaled in threads. */
+    {517, 383, 301, 217},
+    {301, 217, 777, 555},
+    {640, 480, 1023, 97},
+};
+
+static void scale_compare(bool use_byte, bool use_float)
+{
+  for (const int *size : scale_sizes) {
+    SCOPED_TRACE(testing::Message() << "scaling " << size[0] << "x" << size[1] << " to "
+                                    << size[2] << "x" << size[3]);
+
+    scale_reference::Image image = create_test_image(size[0], size[1], use_byte, use_float);
+    ImBuf *ibuf = create_imbuf(image);
+
+    EXPECT_TRUE(IMB_scaleImBuf(ibuf, size[2], size[3]));
+    scale_reference::scale(image, size[2], size[3]);
+    expect_imbuf_eq(ibuf, image);
+
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+TEST_F(IMBScalingTest, ScaleByte)
+{
+  scale_compare(true, false);
+}
+
+TEST_F(IMBScalingTest, ScaleFloat)
+{
+  scale_compare(false, true);
+}
+
+TEST_F(IMBScalingTest, ScaleByteAndFloat)
+{
+  scale_compare(true, true);
+}
+
+static const int onehalf_sizes[][2] = {
+    {2, 2},
+    {67, 131},
+    {131, 67},
+    {1, 131},
+    {131, 1},
+    /* Large enough to be scaled in threads. */
+    {256, 256},
+    {517, 383},
+};
+
+static void onehalf_compare(bool use_byte, bool use_float)
+{
+  for (const int *size : onehalf_sizes) {
+    SCOPED_TRACE(testing::Message() << "halving " << size[0] << "x" << size[1]);
+
+    const int newx = (size[0] <= 1) ? size[0] : size[0] / 2;
+    const int newy = (size[0] > 1 && size[1] <= 1) ? size[1] : size[1] / 2;
+    scale_reference::Image image = create_test_image(size[0], size[1], use_byte, use_float);
+    scale_reference::Image half(newx, newy, use_byte, use_float);
+    ImBuf *ibuf = create_imbuf(image);
+    ImBuf *ibuf_half = create_imbuf(half);
+
+    imb_onehalf_no_alloc(ibuf_half, ibuf);
+    scale_reference::onehalf(image, half);
+    expect_imbuf_eq(ibuf_half, half);
+
+    IMB_freeImBuf(ibuf_half);
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+TEST_F(IMBScalingTest, OneHalfByte)
+{
+  onehalf_compare(true, false);
+}
+
+TEST_F(IMBScalingTest, OneHalfFloat)
+{
+  onehalf_compare(false, true);
+}
+
+TEST_F(IMBScalingTest, OneHalfByteAndFloat)
+{
+  onehalf_compare(true, true);
+}
@@ -0,0 +1,120 @@
+/* Apache License, Version 2.0 */
+
+/* Both versions of the line kernels used by IMB_scaleImBuf, the SSE2 one (when the build
+ * supports it) in scale_simd and the scalar fallback in scale_scalar. */
+
+#ifndef __IMB_SCALING_LINES_H__
+#define __IMB_SCALING_LINES_H__
+
+#include <string.h>
+#include <vector>
+
+#include "BLI_math_inline.h"
+#include "BLI_sys_types.h"
+#include "BLI_utildefines.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+namespace scale_simd {
+#include "intern/scaling_lines_impl.h"
+
+static void scale_line(const uchar *rect, uchar *newrect, const ScaleLinesData *data)
+{
+  if (data->newlen < data->len) {
+    scaledown_line_byte(rect, newrect, data);
+  }
+  else {
+    scaleup_line_byte(rect, newrect, data);
+  }
+}
+
+static void scale_line(const float *rectf, float *newrectf, const ScaleLinesData *data)
+{
+  if (data->newlen < data->len) {
+    scaledown_line_float(rectf, newrectf, data);
+  }
+  else {
+    scaleup_line_float(rectf, newrectf, data);
+  }
+}
+}  // namespace scale_simd
+
+namespace scale_scalar {
+#define SCALE_LINES_NO_SIMD
+#include "intern/scaling_lines_impl.h"
+#undef SCALE_LINES_NO_SIMD
+
+static void scale_line(const uchar *rect, uchar *newrect, const ScaleLinesData *data)
+{
+  if (data->newlen < data->len) {
+    scaledown_line_byte(rect, newrect, data);
+  }
+  else {
+    scaleup_line_byte(rect, newrect, data);
+  }
+}
+
+static void scale_line(const float *rectf, float *newrectf, const ScaleLinesData *data)
+{
+  if (data->newlen < data->len) {
+    scaledown_line_float(rectf, newrectf, data);
+  }
+  else {
+    scaleup_line_float(rectf, newrectf, data);
+  }
+}
+}  // namespace scale_scalar
+
+/* Lines of RGBA pixels scaled like the X pass of IMB_scaleImBuf does. */
+template<typename T> struct ScaleLinesTest {
+  scale_simd::ScaleLinesData data_simd;
+  scale_scalar::ScaleLinesData data_scalar;
+  int lines;
+  std::vector<T> rect;
+  std::vector<T> newrect_simd;
+  std::vector<T> newrect_scalar;
+
+  ScaleLinesTest(int len, int newlen, int lines) : lines(lines)
+  {
+    init_data(data_simd, len, newlen);
+    init_data(data_scalar, len, newlen);
+
+    rect.resize((size_t)4 * len * lines);
+    newrect_simd.resize((size_t)4 * newlen * lines);
+    newrect_scalar.resize((size_t)4 * newlen * lines);
+  }
+
+  template<typename D> static void init_data(D &data, int len, int newlen)
+  {
+    memset(&data, 0, sizeof(data));
+    data.line_step = 4 * len;
+    data.newline_step = 4 * newlen;
+    data.pixel_step = 4;
+    data.len = len;
+    data.newlen = newlen;
+    /* Same as scaledownx and scaleupx. */
+    data.add = (newlen < len) ? (len - 0.01) / newlen : (len - 1.001) / (newlen - 1.0);
+  }
+
+  void run_simd()
+  {
+    for (int line = 0; line < lines; line++) {
+      scale_simd::scale_line(&rect[(size_t)line * data_simd.line_step],
+                             &newrect_simd[(size_t)line * data_simd.newline_step],
+                             &data_simd);
+    }
+  }
+
+  void run_scalar()
+  {
+    for (int line = 0; line < lines; line++) {
+      scale_scalar::scale_line(&rect[(size_t)line * data_scalar.line_step],
+                               &newrect_scalar[(size_t)line * data_scalar.newline_step],
+                               &data_scalar);
+    }
+  }
+};
+
+#endif /* __IMB_SCALING_LINES_H__ */
@@ -0,0 +1,194 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "IMB_scaling_lines.h"
+#include "IMB_scaling_reference.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "intern/IMB_filter.h"
+}
+
+/* Times scaling a 4K image down to half size and up to double size: the SSE2 and scalar
+ * line kernels of IMB_scaleImBuf for the X pass, and the whole threaded IMB_scaleImBuf and
+ * imb_onehalf_no_alloc against the single threaded implementation they replaced. */
+
+class IMBScalingPerformanceTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+#define TESTCASE_WIDTH 3840
+#define TESTCASE_HEIGHT 2160
+
+template<typename T> static void scale_lines_timeit(const char *id, int len, int newlen)
+{
+  ScaleLinesTest<T> test(len, newlen, TESTCASE_HEIGHT);
+
+  for (size_t i = 0; i < test.rect.size(); i++) {
+    test.rect[i] = (T)(i % 251);
+  }
+
+  printf("\n========== %s: %d to %d pixels, %d lines ==========\n",
+         id,
+         len,
+         newlen,
+         TESTCASE_HEIGHT);
+
+  {
+    TIMEIT_START(simd);
+    test.run_simd();
+    TIMEIT_END(simd);
+  }
+
+  {
+    TIMEIT_START(scalar);
+    test.run_scalar();
+    TIMEIT_END(scalar);
+  }
+
+  EXPECT_EQ(test.newrect_simd, test.newrect_scalar);
+}
+
+TEST_F(IMBScalingPerformanceTest, LinesByteDown)
+{
+  scale_lines_timeit<uchar>("byte down", TESTCASE_WIDTH, TESTCASE_WIDTH / 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, LinesByteUp)
+{
+  scale_lines_timeit<uchar>("byte up", TESTCASE_WIDTH, TESTCASE_WIDTH * 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, LinesFloatDown)
+{
+  scale_lines_timeit<float>("float down", TESTCASE_WIDTH, TESTCASE_WIDTH / 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, LinesFloatUp)
+{
+  scale_lines_timeit<float>("float up", TESTCASE_WIDTH, TESTCASE_WIDTH * 2);
+}
+
+static scale_reference::Image create_test_image(bool use_byte, bool use_float)
+{
+  scale_reference::Image image(TESTCASE_WIDTH, TESTCASE_HEIGHT, use_byte, use_float);
+
+  for (size_t i = 0; i < image.rect.size(); i++) {
+    image.rect[i] = (uchar)(i % 251);
+  }
+  for (size_t i = 0; i < image.rectf.size(); i++) {
+    image.rectf[i] = (float)(i % 251) / 250.0f;
+  }
+  return image;
+}
+
+static ImBuf *create_imbuf(const scale_reference::Image &image)
+{
+  ImBuf *ibuf = IMB_allocImBuf(image.x, image.y, 32, 0);
+
+  if (!image.rect.empty()) {
+    imb_addrectImBuf(ibuf);
+    memcpy(ibuf->rect, image.rect.data(), image.rect.size());
+  }
+  if (!image.rectf.empty()) {
+    imb_addrectfloatImBuf(ibuf);
+    memcpy(ibuf->rect_float, image.rectf.data(), image.rectf.size() * sizeof(float));
+  }
+  return ibuf;
+}
+
+static void scale_imbuf_timeit(const char *id, bool use_float, int newx, int newy)
+{
+  scale_reference::Image image = create_test_image(!use_float, use_float);
+  ImBuf *ibuf = create_imbuf(image);
+
+  printf("\n========== %s: %dx%d to %dx%d ==========\n",
+         id,
+         TESTCASE_WIDTH,
+         TESTCASE_HEIGHT,
+         newx,
+         newy);
+
+  {
+    TIMEIT_START(IMB_scaleImBuf);
+    IMB_scaleImBuf(ibuf, newx, newy);
+    TIMEIT_END(IMB_scaleImBuf);
+  }
+
+  {
+    TIMEIT_START(reference);
+    scale_reference::scale(image, newx, newy);
+    TIMEIT_END(reference);
+  }
+
+  EXPECT_EQ(ibuf->x, image.x);
+  EXPECT_EQ(ibuf->y, image.y);
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(IMBScalingPerformanceTest, ImageByteDown)
+{
+  scale_imbuf_timeit("image byte down", false, TESTCASE_WIDTH / 2, TESTCASE_HEIGHT / 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, ImageByteUp)
+{
+  scale_imbuf_timeit("image byte up", false, TESTCASE_WIDTH * 2, TESTCASE_HEIGHT * 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, ImageFloatDown)
+{
+  scale_imbuf_timeit("image float down", true, TESTCASE_WIDTH / 2, TESTCASE_HEIGHT / 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, ImageFloatUp)
+{
+  scale_imbuf_timeit("image float up", true, TESTCASE_WIDTH * 2, TESTCASE_HEIGHT * 2);
+}
+
+TEST_F(IMBScalingPerformanceTest, ImageOneHalf)
+{
+  scale_reference::Image image = create_test_image(true, true);
+  scale_reference::Image half(TESTCASE_WIDTH / 2, TESTCASE_HEIGHT / 2, true, true);
+  ImBuf *ibuf = create_imbuf(image);
+  ImBuf *ibuf_half = create_imbuf(half);
+
+  printf("\n========== image one half: %dx%d, byte and float ==========\n",
+         TESTCASE_WIDTH,
+         TESTCASE_HEIGHT);
+
+  {
+    TIMEIT_START(imb_onehalf_no_alloc);
+    imb_onehalf_no_alloc(ibuf_half, ibuf);
+    TIMEIT_END(imb_onehalf_no_alloc);
+  }
+
+  {
+    TIMEIT_START(reference);
+    scale_reference::onehalf(image, half);
+    TIMEIT_END(reference);
+  }
+
+  EXPECT_EQ(memcmp(ibuf_half->rect, half.rect.data(), half.rect.size()), 0);
+  EXPECT_EQ(memcmp(ibuf_half->rect_float, half.rectf.data(), half.rectf.size() * sizeof(float)),
+            0);
+  IMB_freeImBuf(ibuf_half);
+  IMB_freeImBuf(ibuf);
+}
@@ -0,0 +1,385 @@
+/* Apache License, Version 2.0 */
+
+/* The scaling functions of imbuf as they were before IMB_scaleImBuf and imb_onehalf_no_alloc
+ * were split into line kernels and threaded, kept as reference for their results.
+ *
+ * The only change is that scaling up a line of a single pixel doesn't read the pixel after it,
+ * the old code read past the end of the line there. */
+
+#ifndef __IMB_SCALING_REFERENCE_H__
+#define __IMB_SCALING_REFERENCE_H__
+
+#include <vector>
+
+#include "BLI_sys_types.h"
+
+namespace scale_reference {
+
+/* RGBA image, with a byte buffer, a float buffer or both. */
+struct Image {
+  int x, y;
+  std::vector<uchar> rect;
+  std::vector<float> rectf;
+
+  Image(int x, int y, bool use_byte, bool use_float) : x(x), y(y)
+  {
+    if (use_byte) {
+      rect.resize((size_t)4 * x * y);
+    }
+    if (use_float) {
+      rectf.resize((size_t)4 * x * y);
+    }
+  }
+};
+
+static void scaledownx(Image &ibuf, int newx)
+{
+  const bool do_rect = !ibuf.rect.empty();
+  const bool do_float = !ibuf.rectf.empty();
+  std::vector<uchar> _newrect(do_rect ? (size_t)4 * newx * ibuf.y : 0);
+  std::vector<float> _newrectf(do_float ? (size_t)4 * newx * ibuf.y : 0);
+  const uchar *rect = ibuf.rect.data();
+  const float *rectf = ibuf.rectf.data();
+  uchar *newrect = _newrect.data();
+  float *newrectf = _newrectf.data();
+  float sample, add, val[4], nval[4], valf[4], nvalf[4];
+
+  add = (ibuf.x - 0.01) / newx;
+
+  for (int y = ibuf.y; y > 0; y--) {
+    sample = 0.0f;
+    val[0] = val[1] = val[2] = val[3] = 0.0f;
+    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+
+    for (int x = newx; x > 0; x--) {
+      for (int c = 0; c < 4; c++) {
+        nval[c] = -val[c] * sample;
+        nvalf[c] = -valf[c] * sample;
+      }
+
+      sample += add;
+
+      while (sample >= 1.0f) {
+        sample -= 1.0f;
+
+        if (do_rect) {
+          for (int c = 0; c < 4; c++) {
+            nval[c] += rect[c];
+          }
+          rect += 4;
+        }
+        if (do_float) {
+          for (int c = 0; c < 4; c++) {
+            nvalf[c] += rectf[c];
+          }
+          rectf += 4;
+        }
+      }
+
+      if (do_rect) {
+        for (int c = 0; c < 4; c++) {
+          val[c] = rect[c];
+          newrect[c] = ((nval[c] + sample * val[c]) / add + 0.5f);
+        }
+        rect += 4;
+        newrect += 4;
+      }
+      if (do_float) {
+        for (int c = 0; c < 4; c++) {
+          valf[c] = rectf[c];
+          newrectf[c] = ((nvalf[c] + sample * valf[c]) / add);
+        }
+        rectf += 4;
+        newrectf += 4;
+      }
+
+      sample -= 1.0f;
+    }
+  }
+
+  ibuf.rect.swap(_newrect);
+  ibuf.rectf.swap(_newrectf);
+  ibuf.x = newx;
+}
+
+static void scaledowny(Image &ibuf, int newy)
+{
+  const bool do_rect = !ibuf.rect.empty();
+  const bool do_float = !ibuf.rectf.empty();
+  std::vector<uchar> _newrect(do_rect ? (size_t)4 * ibuf.x * newy : 0);
+  std::vector<float> _newrectf(do_float ? (size_t)4 * ibuf.x * newy : 0);
+  const uchar *rect = NULL;
+  const float *rectf = NULL;
+  uchar *newrect = NULL;
+  float *newrectf = NULL;
+  float sample, add, val[4], nval[4], valf[4], nvalf[4];
+  const int skipx = 4 * ibuf.x;
+
+  add = (ibuf.y - 0.01) / newy;
+
+  for (int x = skipx - 4; x >= 0; x -= 4) {
+    if (do_rect) {
+      rect = ibuf.rect.data() + x;
+      newrect = _newrect.data() + x;
+    }
+    if (do_float) {
+      rectf = ibuf.rectf.data() + x;
+      newrectf = _newrectf.data() + x;
+    }
+
+    sample = 0.0f;
+    val[0] = val[1] = val[2] = val[3] = 0.0f;
+    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+
+    for (int y = newy; y > 0; y--) {
+      for (int c = 0; c < 4; c++) {
+        nval[c] = -val[c] * sample;
+        nvalf[c] = -valf[c] * sample;
+      }
+
+      sample += add;
+
+      while (sample >= 1.0f) {
+        sample -= 1.0f;
+
+        if (do_rect) {
+          for (int c = 0; c < 4; c++) {
+            nval[c] += rect[c];
+          }
+          rect += skipx;
+        }
+        if (do_float) {
+          for (int c = 0; c < 4; c++) {
+            nvalf[c] += rectf[c];
+          }
+          rectf += skipx;
+        }
+      }
+
+      if (do_rect) {
+        for (int c = 0; c < 4; c++) {
+          val[c] = rect[c];
+          newrect[c] = ((nval[c] + sample * val[c]) / add + 0.5f);
+        }
+        rect += skipx;
+        newrect += skipx;
+      }
+      if (do_float) {
+        for (int c = 0; c < 4; c++) {
+          valf[c] = rectf[c];
+          newrectf[c] = ((nvalf[c] + sample * valf[c]) / add);
+        }
+        rectf += skipx;
+        newrectf += skipx;
+      }
+
+      sample -= 1.0f;
+    }
+  }
+
+  ibuf.rect.swap(_newrect);
+  ibuf.rectf.swap(_newrectf);
+  ibuf.y = newy;
+}
+
+/* Scales up the line of \a len pixels starting at \a rect, \a step channels apart. */
+template<typename T>
+static void scaleup_line(const T *rect, T *newrect, int len, int newlen, int step, float add)
+{
+  const float offset = (sizeof(T) == 1) ? 0.5f : 0.0f;
+  float sample = 0.0f, val[4], nval[4], diff[4];
+
+  for (int c = 0; c < 4; c++) {
+    val[c] = rect[c];
+    nval[c] = (len > 1) ? rect[step + c] : rect[c];
+    diff[c] = nval[c] - val[c];
+    val[c] += offset;
+  }
+  rect += 2 * step;
+
+  for (int x = newlen; x > 0; x--) {
+    if (sample >= 1.0f) {
+      sample -= 1.0f;
+
+      for (int c = 0; c < 4; c++) {
+        val[c] = nval[c];
+        nval[c] = rect[c];
+        diff[c] = nval[c] - val[c];
+        val[c] += offset;
+      }
+      rect += step;
+    }
+    for (int c = 0; c < 4; c++) {
+      newrect[c] = val[c] + sample * diff[c];
+    }
+    newrect += step;
+    sample += add;
+  }
+}
+
+static void scaleupx(Image &ibuf, int newx)
+{
+  std::vector<uchar> _newrect(ibuf.rect.empty() ? 0 : (size_t)4 * newx * ibuf.y);
+  std::vector<float> _newrectf(ibuf.rectf.empty() ? 0 : (size_t)4 * newx * ibuf.y);
+  const float add = (ibuf.x - 1.001) / (newx - 1.0);
+
+  for (int y = 0; y < ibuf.y; y++) {
+    if (!ibuf.rect.empty()) {
+      scaleup_line(&ibuf.rect[(size_t)4 * ibuf.x * y],
+                   &_newrect[(size_t)4 * newx * y],
+                   ibuf.x,
+                   newx,
+                   4,
+                   add);
+    }
+    if (!ibuf.rectf.empty()) {
+      scaleup_line(&ibuf.rectf[(size_t)4 * ibuf.x * y],
+                   &_newrectf[(size_t)4 * newx * y],
+                   ibuf.x,
+                   newx,
+                   4,
+                   add);
+    }
+  }
+
+  ibuf.rect.swap(_newrect);
+  ibuf.rectf.swap(_newrectf);
+  ibuf.x = newx;
+}
+
+static void scaleupy(Image &ibuf, int newy)
+{
+  std::vector<uchar> _newrect(ibuf.rect.empty() ? 0 : (size_t)4 * ibuf.x * newy);
+  std::vector<float> _newrectf(ibuf.rectf.empty() ? 0 : (size_t)4 * ibuf.x * newy);
+  const float add = (ibuf.y - 1.001) / (newy - 1.0);
+  const int skipx = 4 * ibuf.x;
+
+  for (int x = 0; x < ibuf.x; x++) {
+    if (!ibuf.rect.empty()) {
+      scaleup_line(&ibuf.rect[(size_t)4 * x], &_newrect[(size_t)4 * x], ibuf.y, newy, skipx, add);
+    }
+    if (!ibuf.rectf.empty()) {
+      scaleup_line(
+          &ibuf.rectf[(size_t)4 * x], &_newrectf[(size_t)4 * x], ibuf.y, newy, skipx, add);
+    }
+  }
+
+  ibuf.rect.swap(_newrect);
+  ibuf.rectf.swap(_newrectf);
+  ibuf.y = newy;
+}
+
+static void scale(Image &ibuf, int newx, int newy)
+{
+  if (newx && (newx < ibuf.x)) {
+    scaledownx(ibuf, newx);
+  }
+  if (newy && (newy < ibuf.y)) {
+    scaledowny(ibuf, newy);
+  }
+  if (newx && (newx > ibuf.x)) {
+    scaleupx(ibuf, newx);
+  }
+  if (newy && (newy > ibuf.y)) {
+    scaleupy(ibuf, newy);
+  }
+}
+
+/* imb_half_x_no_alloc (\a pixel_step 8) and imb_half_y_no_alloc (\a pixel_step 4), averaging
+ * pairs of neighboring pixels in X or in Y, \a line_step is the offset between two output rows
+ * in the input buffer. */
+static void half_lines(const Image &ibuf1, Image &ibuf2, int pixel_step, int line_step)
+{
+  for (int y = 0; y < ibuf2.y; y++) {
+    for (int x = 0; x < ibuf2.x; x++) {
+      const size_t src = (size_t)y * line_step + (size_t)x * pixel_step;
+      const size_t other = (pixel_step == 8) ? src + 4 : src + (size_t)4 * ibuf1.x;
+      const size_t dest = ((size_t)y * ibuf2.x + x) * 4;
+
+      for (int c = 0; c < 4; c++) {
+        if (!ibuf1.rect.empty()) {
+          short a = ibuf1.rect[src + c];
+          a += ibuf1.rect[other + c];
+          ibuf2.rect[dest + c] = a >> 1;
+        }
+        if (!ibuf1.rectf.empty()) {
+          float af = ibuf1.rectf[src + c];
+          af += ibuf1.rectf[other + c];
+          ibuf2.rectf[dest + c] = 0.5f * af;
+        }
+      }
+    }
+  }
+}
+
+static unsigned char ushort_to_uchar(unsigned short val)
+{
+  return (unsigned char)(((val) >= 65535 - 128) ? 255 : ((val) + 128) >> 8);
+}
+
+static void onehalf(const Image &ibuf1, Image &ibuf2)
+{
+  if (ibuf1.x <= 1) {
+    half_lines(ibuf1, ibuf2, 4, 8 * ibuf1.x);
+    return;
+  }
+  if (ibuf1.y <= 1) {
+    half_lines(ibuf1, ibuf2, 8, 4 * ibuf1.x);
+    return;
+  }
+
+  for (int y = 0; y < ibuf2.y; y++) {
+    for (int x = 0; x < ibuf2.x; x++) {
+      const size_t p1 = ((size_t)2 * y * ibuf1.x + (size_t)2 * x) * 4;
+      const size_t p2 = p1 + (size_t)4 * ibuf1.x;
+      const size_t dest = ((size_t)y * ibuf2.x + x) * 4;
+
+      if (!ibuf1.rect.empty()) {
+        const uchar *cp[4] = {&ibuf1.rect[p1], &ibuf1.rect[p2], &ibuf1.rect[p1 + 4],
+                              &ibuf1.rect[p2 + 4]};
+        unsigned short desti[4];
+        unsigned int sum[4] = {0, 0, 0, 0};
+
+        /* straight_uchar_to_premul_ushort() of the four pixels, then averaged. */
+        for (int i = 0; i < 4; i++) {
+          unsigned short alpha = cp[i][3];
+          sum[0] += (unsigned short)(cp[i][0] * alpha);
+          sum[1] += (unsigned short)(cp[i][1] * alpha);
+          sum[2] += (unsigned short)(cp[i][2] * alpha);
+          sum[3] += (unsigned short)(alpha * 256);
+        }
+        for (int c = 0; c < 4; c++) {
+          desti[c] = sum[c] >> 2;
+        }
+
+        /* premul_ushort_to_straight_uchar() */
+        uchar *result = &ibuf2.rect[dest];
+        if (desti[3] <= 255) {
+          for (int c = 0; c < 4; c++) {
+            result[c] = ushort_to_uchar(desti[c]);
+          }
+        }
+        else {
+          unsigned short alpha = desti[3] / 256;
+
+          for (int c = 0; c < 3; c++) {
+            result[c] = ushort_to_uchar((ushort)(desti[c] / alpha * 256));
+          }
+          result[3] = ushort_to_uchar(desti[3]);
+        }
+      }
+
+      if (!ibuf1.rectf.empty()) {
+        const float *p1f = &ibuf1.rectf[p1];
+        const float *p2f = &ibuf1.rectf[p2];
+        for (int c = 0; c < 4; c++) {
+          ibuf2.rectf[dest + c] = 0.25f * (p1f[c] + p2f[c] + p1f[c + 4] + p2f[c + 4]);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace scale_reference
+
+#endif /* __IMB_SCALING_REFERENCE_H__ */
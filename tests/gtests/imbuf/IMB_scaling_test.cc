@@ -0,0 +1,90 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <random>
+
+#include "IMB_scaling_lines.h"
+
+/* The SSE2 kernels do the same operations in the same order as the scalar ones,
+ * so their results have to be identical, not only close. */
+
+static void fill_random(std::vector<uchar> &rect, std::mt19937 &rng)
+{
+  std::uniform_int_distribution<int> dist(0, 255);
+  for (uchar &value : rect) {
+    value = (uchar)dist(rng);
+  }
+}
+
+static void fill_random(std::vector<float> &rect, std::mt19937 &rng)
+{
+  /* Include values outside of the 0..1 range, float buffers aren't clamped. */
+  std::uniform_real_distribution<float> dist(-0.5f, 4.0f);
+  for (float &value : rect) {
+    value = dist(rng);
+  }
+}
+
+template<typename T> static void scale_lines_compare(int len, int newlen)
+{
+  ScaleLinesTest<T> test(len, newlen, 16);
+  std::mt19937 rng(len * 4096 + newlen);
+
+  fill_random(test.rect, rng);
+  test.run_simd();
+  test.run_scalar();
+
+  EXPECT_EQ(memcmp(test.newrect_simd.data(),
+                   test.newrect_scalar.data(),
+                   test.newrect_simd.size() * sizeof(T)),
+            0)
+      << "scaling " << len << " to " << newlen << " pixels";
+}
+
+static const int scale_sizes[][2] = {
+    {2, 1},
+    {3, 2},
+    {17, 5},
+    {64, 63},
+    {100, 33},
+    {1920, 1280},
+    {4096, 2048},
+    {4096, 7},
+    {1, 2},
+    {2, 3},
+    {5, 17},
+    {63, 64},
+    {33, 100},
+    {1280, 1920},
+    {2048, 4096},
+    {7, 4096},
+};
+
+TEST(imbuf_scaling, LinesByteSimdMatchesScalar)
+{
+  for (const int *size : scale_sizes) {
+    scale_lines_compare<uchar>(size[0], size[1]);
+  }
+}
+
+TEST(imbuf_scaling, LinesFloatSimdMatchesScalar)
+{
+  for (const int *size : scale_sizes) {
+    scale_lines_compare<float>(size[0], size[1]);
+  }
+}
+
+/* Byte values are clamped when stored, check both ends of the range. */
+TEST(imbuf_scaling, LinesByteExtremes)
+{
+  for (const int *size : scale_sizes) {
+    ScaleLinesTest<uchar> test(size[0], size[1], 2);
+    for (size_t i = 0; i < test.rect.size(); i++) {
+      test.rect[i] = ((i / 4) % 2) ? 255 : 0;
+    }
+    test.run_simd();
+    test.run_scalar();
+    EXPECT_EQ(test.newrect_simd, test.newrect_scalar);
+  }
+}